@@ -84,6 +84,70 @@ union Reg64Type {
     uint64_t val;
 };
 
+/**
+ * Atomic operations with the full memory barrier. Each function returns
+ * the previous value. RISCV_memory_barrier() orders the plain memory
+ * accesses.
+ */
+#if defined(_WIN32) || defined(__CYGWIN__)
+static inline int64_t RISCV_atomic_add64(volatile int64_t *p, int64_t v) {
+    return InterlockedExchangeAdd64(p, v);
+}
+static inline int64_t RISCV_atomic_xchg64(volatile int64_t *p, int64_t v) {
+    return InterlockedExchange64(p, v);
+}
+static inline int64_t RISCV_atomic_cmpxchg64(volatile int64_t *p,
+                                             int64_t cmp, int64_t v) {
+    return InterlockedCompareExchange64(p, v, cmp);
+}
+static inline int32_t RISCV_atomic_cmpxchg32(volatile int32_t *p,
+                                             int32_t cmp, int32_t v) {
+    return InterlockedCompareExchange(reinterpret_cast<volatile LONG *>(p),
+                                      v, cmp);
+}
+static inline void *RISCV_atomic_xchgptr(void *volatile *p, void *v) {
+    return InterlockedExchangePointer(p, v);
+}
+static inline void *RISCV_atomic_cmpxchgptr(void *volatile *p,
+                                            void *cmp, void *v) {
+    return InterlockedCompareExchangePointer(p, v, cmp);
+}
+static inline void RISCV_memory_barrier() {
+    MemoryBarrier();
+}
+#else /* Linux */
+static inline int64_t RISCV_atomic_add64(volatile int64_t *p, int64_t v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+static inline int64_t RISCV_atomic_xchg64(volatile int64_t *p, int64_t v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+static inline int64_t RISCV_atomic_cmpxchg64(volatile int64_t *p,
+                                             int64_t cmp, int64_t v) {
+    __atomic_compare_exchange_n(p, &cmp, v, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+static inline int32_t RISCV_atomic_cmpxchg32(volatile int32_t *p,
+                                             int32_t cmp, int32_t v) {
+    __atomic_compare_exchange_n(p, &cmp, v, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+static inline void *RISCV_atomic_xchgptr(void *volatile *p, void *v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+static inline void *RISCV_atomic_cmpxchgptr(void *volatile *p,
+                                            void *cmp, void *v) {
+    __atomic_compare_exchange_n(p, &cmp, v, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+static inline void RISCV_memory_barrier() {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+
 }  // namespace debugger
 
 #endif  // __DEBUGGER_API_TYPES_H__
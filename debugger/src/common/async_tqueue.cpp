@@ -5,84 +5,140 @@
  * @brief      Asynchronous queue with time markers.
  */
 
-#include "api_utils.h"
+#include <string.h>
+#include <algorithm>
 #include "async_tqueue.h"
 
 namespace debugger {
 
 AsyncTQueueType::AsyncTQueueType() {
-    preLen_ = 0;
-    curLen_ = 0;
-    stepPreQueued_.make_list(0);
-    stepQueue_.make_list(16);   /** it will be auto reallocated if needed */
-    item_.make_list(Queue_Total);
-    RISCV_mutex_init(&mutex_);
+    inbox_ = 0;
+    heapLen_ = 0;
+    heapSize_ = 16;     /** it will be auto reallocated if needed */
+    heap_ = new QueueItemType[heapSize_];
+    seqCnt_ = 0;
 }
 
 AsyncTQueueType::~AsyncTQueueType() {
-    RISCV_mutex_destroy(&mutex_);
+    QueueItemType *item = inbox_;
+    while (item) {
+        QueueItemType *next = item->next;
+        delete item;
+        item = next;
+    }
+    delete [] heap_;
 }
 
 void AsyncTQueueType::put(uint64_t time, IFace *cb) {
-    RISCV_mutex_lock(&mutex_);
-    item_[Queue_Time].make_uint64(time);
-    item_[Queue_IFace].make_iface(cb);
-    if (preLen_ == stepPreQueued_.size()) {
-        unsigned new_sz = 2 * stepPreQueued_.size();
-        if (new_sz == 0) {
-            new_sz = 1;
-        }
-        stepPreQueued_.realloc_list(new_sz);
-    }
-    stepPreQueued_[preLen_].attr_free();
-    stepPreQueued_[preLen_] = item_;
-    preLen_++;
-    RISCV_mutex_unlock(&mutex_);
+    QueueItemType *item = new QueueItemType;
+    QueueItemType *head;
+    item->time = time;
+    item->cb = cb;
+    do {
+        head = inbox_;
+        item->next = head;
+    } while (RISCV_atomic_cmpxchgptr(
+                reinterpret_cast<void *volatile *>(&inbox_),
+                head, item) != head);
 }
+
 void AsyncTQueueType::pushPreQueued() {
-    if (preLen_ == 0) {
+    if (inbox_ == 0) {
         return;
     }
-    RISCV_mutex_lock(&mutex_);
-    for (unsigned i = 0; i < preLen_; i++) {
-        if (curLen_ < stepQueue_.size()) {
-            stepQueue_[curLen_].attr_free();
-            stepQueue_[curLen_] = stepPreQueued_[i];
-        } else {
-            stepQueue_.add_to_list(&stepPreQueued_[i]);
-        }
-        curLen_++;
+    QueueItemType *item = static_cast<QueueItemType *>(RISCV_atomic_xchgptr(
+                reinterpret_cast<void *volatile *>(&inbox_), 0));
+
+    // Inbox is LIFO, restore the registration order:
+    QueueItemType *fifo = 0;
+    while (item) {
+        QueueItemType *next = item->next;
+        item->next = fifo;
+        fifo = item;
+        item = next;
+    }
+    while (fifo) {
+        item = fifo;
+        fifo = fifo->next;
+        item->seq = seqCnt_++;
+        heapPush(item);
+        delete item;
     }
-    preLen_= 0;
-    RISCV_mutex_unlock(&mutex_);
 }
 
-void AsyncTQueueType::initProc() {
-    curIdx_ = 0;
+IFace *AsyncTQueueType::getNext(uint64_t step_cnt) {
+    if (heapLen_ == 0 || step_cnt < heap_[0].time) {
+        return 0;
+    }
+    IFace *ret = heap_[0].cb;
+    heapPop();
+    return ret;
 }
 
-IFace *AsyncTQueueType::getNext(uint64_t step_cnt) {
-    IFace *ret = 0;
-    if (curIdx_ >= curLen_) {
-        return ret;
+void AsyncTQueueType::getItems(AttributeType *list) {
+    QueueItemType *t = new QueueItemType[heapLen_ + 1];
+    memcpy(t, heap_, heapLen_ * sizeof(QueueItemType));
+    std::sort(t, t + heapLen_, isLessRef);
+
+    list->make_list(heapLen_);
+    for (unsigned i = 0; i < heapLen_; i++) {
+        AttributeType &item = (*list)[i];
+        item.make_list(2);
+        item[0u].make_uint64(t[i].time);
+        item[1] = AttributeType(t[i].cb);
     }
-    for (unsigned i = curIdx_; i < curLen_; i++) {
-        uint64_t ev_time = stepQueue_[i][Queue_Time].to_uint64();
+    delete [] t;
+}
+
+void AsyncTQueueType::clear() {
+    QueueItemType *item = static_cast<QueueItemType *>(RISCV_atomic_xchgptr(
+                reinterpret_cast<void *volatile *>(&inbox_), 0));
+    while (item) {
+        QueueItemType *next = item->next;
+        delete item;
+        item = next;
+    }
+    heapLen_ = 0;
+}
 
-        if (step_cnt < ev_time) {
-            continue;
+void AsyncTQueueType::heapPush(QueueItemType *item) {
+    if (heapLen_ == heapSize_) {
+        QueueItemType *t = new QueueItemType[2 * heapSize_];
+        memcpy(t, heap_, heapLen_ * sizeof(QueueItemType));
+        delete [] heap_;
+        heap_ = t;
+        heapSize_ *= 2;
+    }
+    unsigned i = heapLen_++;
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+        if (!isLess(item, &heap_[parent])) {
+            break;
         }
-        ret = stepQueue_[i][Queue_IFace].to_iface();
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = *item;
+}
 
-        // remove item from list using swap function to avoid usage
-        // of allocation/deallocation calls.
-        stepQueue_.swap_list_item(i, curLen_ - 1);
-        curLen_--;
-        curIdx_--;
-        break;
+void AsyncTQueueType::heapPop() {
+    QueueItemType *last = &heap_[--heapLen_];
+    unsigned i = 0;
+    while (1) {
+        unsigned child = 2 * i + 1;
+        if (child >= heapLen_) {
+            break;
+        }
+        if (child + 1 < heapLen_ && isLess(&heap_[child + 1], &heap_[child])) {
+            child++;
+        }
+        if (!isLess(&heap_[child], last)) {
+            break;
+        }
+        heap_[i] = heap_[child];
+        i = child;
     }
-    return ret;
+    heap_[i] = *last;
 }
 
 }  // namespace debugger
-
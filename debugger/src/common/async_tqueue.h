@@ -3,6 +3,11 @@
  * @copyright  Copyright 2016 GNSS Sensor Ltd. All right reserved.
  * @author     Sergey Khabarov - sergeykhbr@gmail.com
  * @brief      Asynchronous queue with time markers.
+ *
+ * @details    Callbacks registered by any thread are pushed into lock-free
+ *             inbox (multiple producers, single consumer). The owner thread
+ *             moves them into the binary heap ordered by time marker and
+ *             by the registration order for the equal markers.
  */
 
 #ifndef __DEBUGGER_ASYNC_TQUEUE_H__
@@ -25,27 +30,53 @@ public:
     /** push registered to the main queue */
     void pushPreQueued();
 
-    /** Reset proccessed counter at the begining of each iteration */
-    void initProc();
-
     /**
      * Get next registered interface with counter less or equal to 'step_cnt'
      */
     IFace *getNext(uint64_t step_cnt);
 
+    /**
+     * Get minimal time marker of the main queue or ~0 when it's empty.
+     * Items that are still pre-queued aren't taken into account.
+     */
+    uint64_t getNextTime() {
+        return heapLen_ ? heap_[0].time : ~0ull;
+    }
+
+    /** New callbacks were registered since the last pushPreQueued() call */
+    bool isPreQueued() { return inbox_ != 0; }
+
+    /**
+     * List of [time, IFace] pairs of the main queue in the execution order.
+     * Used by the owner thread to save the queue into snapshot.
+     */
+    void getItems(AttributeType *list);
+
+    /** Remove all callbacks including pre-queued */
+    void clear();
+
 private:
-    enum QueueItemNames {
-        Queue_Time, 
-        Queue_IFace, 
-        Queue_Total
+    struct QueueItemType {
+        uint64_t time;
+        uint64_t seq;           // registration order
+        IFace *cb;
+        QueueItemType *next;    // inbox link
     };
-    AttributeType item_;
-    AttributeType stepQueue_;
-    AttributeType stepPreQueued_;
-    unsigned curIdx_;
-    unsigned preLen_;
-    unsigned curLen_;    // to avoid reallocation
-    mutex_def mutex_;
+
+    static bool isLess(const QueueItemType *a, const QueueItemType *b) {
+        return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+    }
+    static bool isLessRef(const QueueItemType &a, const QueueItemType &b) {
+        return isLess(&a, &b);
+    }
+    void heapPush(QueueItemType *item);
+    void heapPop();
+
+    QueueItemType *volatile inbox_;
+    QueueItemType *heap_;
+    unsigned heapLen_;
+    unsigned heapSize_;         // to avoid reallocation
+    uint64_t seqCnt_;
 };
 
 }  // namespace debugger
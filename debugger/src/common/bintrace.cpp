@@ -0,0 +1,457 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Compact binary execution trace.
+ */
+
+#include <string.h>
+#include "api_core.h"
+#include "bintrace.h"
+
+namespace debugger {
+
+/** Block header: raw size and packed size (0 means not compressed) */
+static const unsigned BLOCK_HEADER_SIZE = 8;
+
+BinTraceWriter::BinTraceWriter() : IThread() {
+    AttributeType t1;
+    fd_ = 0;
+    bufs_[0] = new uint8_t[BUF_SIZE];
+    bufs_[1] = new uint8_t[BUF_SIZE];
+    packed_ = new uint8_t[BLOCK_HEADER_SIZE + BUF_SIZE];
+    active_ = 0;
+    buf_ = bufs_[active_];
+    wcnt_ = 0;
+    pending_ = 0;
+    pendingSize_ = 0;
+    prevStep_ = 0;
+    prevPc_ = 0;
+    // Several writers may exist simultaneously, so use unique names:
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&eventReady_, t1.to_string());
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&eventDrained_, t1.to_string());
+    RISCV_event_set(&eventDrained_);
+}
+
+BinTraceWriter::~BinTraceWriter() {
+    close();
+    RISCV_event_close(&eventReady_);
+    RISCV_event_close(&eventDrained_);
+    delete [] bufs_[0];
+    delete [] bufs_[1];
+    delete [] packed_;
+}
+
+bool BinTraceWriter::open(const char *filename) {
+    fd_ = fopen(filename, "wb");
+    if (!fd_) {
+        RISCV_printf(NULL, LOG_ERROR, "Can't create trace file '%s'",
+                     filename);
+        return false;
+    }
+    fwrite(BINTRACE_MAGIC, 1, sizeof(BINTRACE_MAGIC), fd_);
+    fwrite(&BINTRACE_VERSION, 1, sizeof(BINTRACE_VERSION), fd_);
+    if (!run()) {
+        RISCV_printf(NULL, LOG_ERROR, "%s", "Can't create trace thread");
+        fclose(fd_);
+        fd_ = 0;
+        return false;
+    }
+    return true;
+}
+
+void BinTraceWriter::close() {
+    if (!fd_) {
+        return;
+    }
+    if (wcnt_) {
+        switchBuffer();
+    }
+    RISCV_event_wait(&eventDrained_);
+    stop();
+    fclose(fd_);
+    fd_ = 0;
+}
+
+void BinTraceWriter::writeRegs(uint64_t step, uint64_t pc, uint32_t instr,
+                               uint32_t mask, const uint64_t *regs) {
+    checkFree();
+    int64_t dpc = static_cast<int64_t>(pc - prevPc_);
+    put8(BinTrace_Regs);
+    putVarint(step - prevStep_);
+    // zigzag encoding of the signed delta:
+    putVarint((static_cast<uint64_t>(dpc) << 1)
+            ^ static_cast<uint64_t>(dpc >> 63));
+    put32(instr);
+    putVarint(mask);
+    for (int i = 0; mask; i++, mask >>= 1) {
+        if (mask & 0x1) {
+            put64(regs[i]);
+        }
+    }
+    prevStep_ = step;
+    prevPc_ = pc;
+}
+
+void BinTraceWriter::writeMem(uint64_t pc, uint64_t addr, bool write,
+                              uint64_t value) {
+    checkFree();
+    put8(write ? BinTrace_MemWrite : BinTrace_MemRead);
+    put32(static_cast<uint32_t>(pc));
+    put32(static_cast<uint32_t>(addr));
+    put64(value);
+}
+
+void BinTraceWriter::put32(uint32_t v) {
+    memcpy(&buf_[wcnt_], &v, sizeof(v));
+    wcnt_ += sizeof(v);
+}
+
+void BinTraceWriter::put64(uint64_t v) {
+    memcpy(&buf_[wcnt_], &v, sizeof(v));
+    wcnt_ += sizeof(v);
+}
+
+void BinTraceWriter::putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        buf_[wcnt_++] = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    buf_[wcnt_++] = static_cast<uint8_t>(v);
+}
+
+void BinTraceWriter::checkFree() {
+    if (wcnt_ + RECORD_MAX > BUF_SIZE) {
+        switchBuffer();
+    }
+}
+
+void BinTraceWriter::switchBuffer() {
+    // Wait while the previous buffer is being written:
+    RISCV_event_wait(&eventDrained_);
+    RISCV_event_clear(&eventDrained_);
+    pending_ = active_;
+    pendingSize_ = wcnt_;
+    RISCV_event_set(&eventReady_);
+
+    active_ ^= 1;
+    buf_ = bufs_[active_];
+    wcnt_ = 0;
+    // Each block is decoded independently:
+    prevStep_ = 0;
+    prevPc_ = 0;
+}
+
+void BinTraceWriter::busyLoop() {
+    uint32_t hdr[2];
+    while (isEnabled()) {
+        RISCV_event_wait_ms(&eventReady_, 100);
+        if (!RISCV_event_is_set(&eventReady_)) {
+            continue;
+        }
+        RISCV_event_clear(&eventReady_);
+
+        hdr[0] = pendingSize_;
+        hdr[1] = bintrace_compress(bufs_[pending_], pendingSize_,
+                                   &packed_[BLOCK_HEADER_SIZE]);
+        memcpy(packed_, hdr, sizeof(hdr));
+        if (hdr[1]) {
+            fwrite(packed_, 1, BLOCK_HEADER_SIZE + hdr[1], fd_);
+        } else {
+            fwrite(packed_, 1, BLOCK_HEADER_SIZE, fd_);
+            fwrite(bufs_[pending_], 1, pendingSize_, fd_);
+        }
+        RISCV_event_set(&eventDrained_);
+    }
+}
+
+
+BinTraceReader::BinTraceReader() {
+    fd_ = 0;
+    bufSize_ = 0;
+    packedSize_ = 0;
+    buf_ = 0;
+    packed_ = 0;
+    rcnt_ = 0;
+    total_ = 0;
+    prevStep_ = 0;
+    prevPc_ = 0;
+}
+
+BinTraceReader::~BinTraceReader() {
+    close();
+    delete [] buf_;
+    delete [] packed_;
+}
+
+bool BinTraceReader::open(const char *filename) {
+    char magic[sizeof(BINTRACE_MAGIC)];
+    uint32_t version;
+    fd_ = fopen(filename, "rb");
+    if (!fd_) {
+        return false;
+    }
+    if (fread(magic, 1, sizeof(magic), fd_) != sizeof(magic)
+        || memcmp(magic, BINTRACE_MAGIC, sizeof(magic)) != 0
+        || fread(&version, 1, sizeof(version), fd_) != sizeof(version)
+        || version != BINTRACE_VERSION) {
+        close();
+        return false;
+    }
+    rcnt_ = 0;
+    total_ = 0;
+    return true;
+}
+
+void BinTraceReader::close() {
+    if (fd_) {
+        fclose(fd_);
+        fd_ = 0;
+    }
+}
+
+bool BinTraceReader::readBlock() {
+    uint32_t hdr[2];
+    if (fread(hdr, 1, sizeof(hdr), fd_) != sizeof(hdr)) {
+        return false;
+    }
+    if (hdr[0] > bufSize_) {
+        delete [] buf_;
+        bufSize_ = hdr[0];
+        buf_ = new uint8_t[bufSize_];
+    }
+    if (hdr[1] == 0) {
+        total_ = static_cast<unsigned>(fread(buf_, 1, hdr[0], fd_));
+    } else {
+        if (hdr[1] > packedSize_) {
+            delete [] packed_;
+            packedSize_ = hdr[1];
+            packed_ = new uint8_t[packedSize_];
+        }
+        if (fread(packed_, 1, hdr[1], fd_) != hdr[1]) {
+            return false;
+        }
+        total_ = bintrace_decompress(packed_, hdr[1], buf_, hdr[0]);
+    }
+    rcnt_ = 0;
+    prevStep_ = 0;
+    prevPc_ = 0;
+    return total_ == hdr[0] && total_ != 0;
+}
+
+bool BinTraceReader::next(BinTraceRecordType *rec) {
+    if (!fd_) {
+        return false;
+    }
+    if (rcnt_ >= total_ && !readBlock()) {
+        return false;
+    }
+    rec->type = static_cast<EBinTraceRecord>(get8());
+    switch (rec->type) {
+    case BinTrace_Regs: {
+        uint64_t zz;
+        rec->step = prevStep_ + getVarint();
+        zz = getVarint();
+        rec->pc = prevPc_ + ((zz >> 1) ^ (~(zz & 1) + 1));
+        rec->instr = get32();
+        rec->mask = static_cast<uint32_t>(getVarint());
+        for (int i = 0; i < 32; i++) {
+            if ((rec->mask >> i) & 0x1) {
+                rec->regs[i] = get64();
+            }
+        }
+        prevStep_ = rec->step;
+        prevPc_ = rec->pc;
+        break;
+    }
+    case BinTrace_MemRead:
+    case BinTrace_MemWrite:
+        rec->pc = get32();
+        rec->addr = get32();
+        rec->value = get64();
+        break;
+    default:
+        return false;
+    }
+    return rcnt_ <= total_;
+}
+
+uint32_t BinTraceReader::get32() {
+    uint32_t v;
+    memcpy(&v, &buf_[rcnt_], sizeof(v));
+    rcnt_ += sizeof(v);
+    return v;
+}
+
+uint64_t BinTraceReader::get64() {
+    uint64_t v;
+    memcpy(&v, &buf_[rcnt_], sizeof(v));
+    rcnt_ += sizeof(v);
+    return v;
+}
+
+uint64_t BinTraceReader::getVarint() {
+    uint64_t v = 0;
+    int shift = 0;
+    uint8_t t;
+    do {
+        t = buf_[rcnt_++];
+        v |= static_cast<uint64_t>(t & 0x7f) << shift;
+        shift += 7;
+    } while ((t & 0x80) && rcnt_ < total_);
+    return v;
+}
+
+
+/**
+ * Sequence of the compressed stream: token (literals length in 4 MSB,
+ * match length in 4 LSB), extended literals length, literals, 16-bits
+ * match offset, extended match length. The last sequence has no match.
+ */
+static const unsigned LZ_MIN_MATCH = 4;
+static const unsigned LZ_HASH_BITS = 14;
+static const unsigned LZ_MAX_OFFSET = 0xFFFF;
+
+static inline uint32_t lz_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint8_t *lz_put_length(uint8_t *op, unsigned len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+unsigned bintrace_compress(const uint8_t *src, unsigned len, uint8_t *dst) {
+    static const unsigned HASH_SIZE = 1 << LZ_HASH_BITS;
+    unsigned *htbl = new unsigned[HASH_SIZE];
+    uint8_t *op = dst;
+    // reserve for the worst case token and length bytes of the tail
+    const uint8_t *op_limit = dst + len - (len / 255) - 16;
+    unsigned anchor = 0;
+    unsigned i = 0;
+    memset(htbl, 0, HASH_SIZE * sizeof(unsigned));
+
+    if (len < 32) {
+        delete [] htbl;
+        return 0;
+    }
+    while (i + LZ_MIN_MATCH + 8 <= len) {
+        uint32_t seq = lz_read32(&src[i]);
+        unsigned h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        unsigned ref = htbl[h];
+        htbl[h] = i;
+        if (ref >= i || (i - ref) > LZ_MAX_OFFSET
+            || lz_read32(&src[ref]) != seq) {
+            i++;
+            continue;
+        }
+        unsigned mlen = LZ_MIN_MATCH;
+        while (i + mlen < len && src[ref + mlen] == src[i + mlen]) {
+            mlen++;
+        }
+
+        unsigned lit = i - anchor;
+        unsigned m = mlen - LZ_MIN_MATCH;
+        if (op + lit + (lit / 255) + (m / 255) + 6 > op_limit) {
+            delete [] htbl;
+            return 0;
+        }
+        uint8_t *token = op++;
+        *token = static_cast<uint8_t>((lit < 15 ? lit : 15) << 4);
+        if (lit >= 15) {
+            op = lz_put_length(op, lit - 15);
+        }
+        memcpy(op, &src[anchor], lit);
+        op += lit;
+        *op++ = static_cast<uint8_t>(i - ref);
+        *op++ = static_cast<uint8_t>((i - ref) >> 8);
+        *token |= static_cast<uint8_t>(m < 15 ? m : 15);
+        if (m >= 15) {
+            op = lz_put_length(op, m - 15);
+        }
+        i += mlen;
+        anchor = i;
+    }
+    delete [] htbl;
+
+    unsigned lit = len - anchor;
+    if (op + lit + (lit / 255) + 2 > dst + len) {
+        return 0;
+    }
+    *op++ = static_cast<uint8_t>((lit < 15 ? lit : 15) << 4);
+    if (lit >= 15) {
+        op = lz_put_length(op, lit - 15);
+    }
+    memcpy(op, &src[anchor], lit);
+    op += lit;
+    return static_cast<unsigned>(op - dst);
+}
+
+unsigned bintrace_decompress(const uint8_t *src, unsigned len,
+                             uint8_t *dst, unsigned dst_size) {
+    const uint8_t *ip = src;
+    const uint8_t *ip_end = src + len;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + dst_size;
+    while (ip < ip_end) {
+        unsigned token = *ip++;
+        unsigned lit = token >> 4;
+        if (lit == 15) {
+            uint8_t t;
+            do {
+                if (ip >= ip_end) {
+                    return 0;
+                }
+                t = *ip++;
+                lit += t;
+            } while (t == 255);
+        }
+        if (ip + lit > ip_end || op + lit > op_end) {
+            return 0;
+        }
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip >= ip_end) {
+            break;
+        }
+
+        if (ip + 2 > ip_end) {
+            return 0;
+        }
+        unsigned off = ip[0] | (static_cast<unsigned>(ip[1]) << 8);
+        ip += 2;
+        unsigned mlen = (token & 0xF);
+        if (mlen == 15) {
+            uint8_t t;
+            do {
+                if (ip >= ip_end) {
+                    return 0;
+                }
+                t = *ip++;
+                mlen += t;
+            } while (t == 255);
+        }
+        mlen += LZ_MIN_MATCH;
+        if (off == 0 || off > static_cast<unsigned>(op - dst)
+            || op + mlen > op_end) {
+            return 0;
+        }
+        const uint8_t *ref = op - off;
+        for (unsigned k = 0; k < mlen; k++) {
+            op[k] = ref[k];
+        }
+        op += mlen;
+    }
+    return static_cast<unsigned>(op - dst);
+}
+
+}  // namespace debugger
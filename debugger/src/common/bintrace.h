@@ -0,0 +1,141 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Compact binary execution trace.
+ *
+ * @details    Trace file consists of the header and independent blocks.
+ *             Each block is compressed separately and contains records with
+ *             the delta-encoded step counter and PC. Register record stores
+ *             only modified registers selected by 32-bits mask, memory
+ *             access record has fixed size.
+ *             Records are collected into one of two buffers while the
+ *             filled one is compressed and written by the background thread.
+ *             Text representation is restored by 'trace_decoder' utility.
+ */
+
+#ifndef __DEBUGGER_BINTRACE_H__
+#define __DEBUGGER_BINTRACE_H__
+
+#include <stdio.h>
+#include "api_types.h"
+#include "coreservices/ithread.h"
+
+namespace debugger {
+
+static const char BINTRACE_MAGIC[4] = {'R', 'V', 'T', 'R'};
+static const uint32_t BINTRACE_VERSION = 1;
+
+enum EBinTraceRecord {
+    BinTrace_Regs = 1,
+    BinTrace_MemRead = 2,
+    BinTrace_MemWrite = 3
+};
+
+struct BinTraceRecordType {
+    EBinTraceRecord type;
+    uint64_t step;
+    uint64_t pc;
+    uint32_t instr;
+    uint32_t mask;          // modified registers
+    uint64_t regs[32];      // valid only for the marked in 'mask' registers
+    uint64_t addr;
+    uint64_t value;
+};
+
+class BinTraceWriter : public IThread {
+public:
+    BinTraceWriter();
+    virtual ~BinTraceWriter();
+
+    /** Create file and start writing thread */
+    bool open(const char *filename);
+
+    /** Write all pending records and close file */
+    void close();
+
+    /**
+     * @brief Executed instruction.
+     * @param[in] mask Modified registers mask.
+     * @param[in] regs Registers values, only masked values are saved.
+     */
+    void writeRegs(uint64_t step, uint64_t pc, uint32_t instr,
+                   uint32_t mask, const uint64_t *regs);
+
+    /** Memory access of the instruction with address 'pc' */
+    void writeMem(uint64_t pc, uint64_t addr, bool write, uint64_t value);
+
+protected:
+    /** IThread interface */
+    virtual void busyLoop();
+
+private:
+    void put8(uint8_t v) { buf_[wcnt_++] = v; }
+    void put32(uint32_t v);
+    void put64(uint64_t v);
+    void putVarint(uint64_t v);
+    void checkFree();
+    void switchBuffer();
+
+private:
+    static const unsigned BUF_SIZE = 1 << 20;
+    static const unsigned RECORD_MAX = 512;
+
+    FILE *fd_;
+    uint8_t *bufs_[2];
+    uint8_t *packed_;
+    uint8_t *buf_;          // active buffer
+    unsigned wcnt_;
+    int active_;
+    int pending_;           // buffer index to write by the thread
+    unsigned pendingSize_;
+    event_def eventReady_;
+    event_def eventDrained_;
+    uint64_t prevStep_;
+    uint64_t prevPc_;
+};
+
+class BinTraceReader {
+public:
+    BinTraceReader();
+    ~BinTraceReader();
+
+    bool open(const char *filename);
+    void close();
+
+    /** Read next record, returns false at the end of file */
+    bool next(BinTraceRecordType *rec);
+
+private:
+    bool readBlock();
+    uint8_t get8() { return buf_[rcnt_++]; }
+    uint32_t get32();
+    uint64_t get64();
+    uint64_t getVarint();
+
+private:
+    FILE *fd_;
+    uint8_t *buf_;
+    uint8_t *packed_;
+    unsigned bufSize_;
+    unsigned packedSize_;
+    unsigned rcnt_;
+    unsigned total_;
+    uint64_t prevStep_;
+    uint64_t prevPc_;
+};
+
+/**
+ * @brief LZ77 block compression.
+ * @return Size of the compressed data or 0 when data isn't compressible.
+ *         Output buffer must be at least 'len' bytes.
+ */
+unsigned bintrace_compress(const uint8_t *src, unsigned len, uint8_t *dst);
+
+/** @return Size of the decompressed data or 0 if stream is corrupted */
+unsigned bintrace_decompress(const uint8_t *src, unsigned len,
+                             uint8_t *dst, unsigned dst_size);
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_BINTRACE_H__
@@ -10,6 +10,7 @@
 #define __DEBUGGER_IBUS_PLUGIN_H__
 
 #include "iface.h"
+#include "attribute.h"
 #include <inttypes.h>
 #include "imemop.h"
 
@@ -36,6 +37,21 @@ public:
 
     virtual void map(IMemoryOperation *imemop) =0;
 
+    /**
+     * Register listener of the write transactions. It is used by the CPU
+     * models to track modification of the already decoded instructions.
+     */
+    virtual void registerBusListener(IFace *listener) =0;
+
+    /**
+     * Register per master counters of the transactions made by the master
+     * directly via DMI. The master updates them from its own thread
+     * without atomics, bus adds them to its counters on read. It must be
+     * called before the simulation starts.
+     * @param[in] cnt Array of CFG_NASTI_MASTER_TOTAL items.
+     */
+    virtual void registerUtilCounters(BusUtilType *cnt) =0;
+
     /**
      * Blocking transaction. It is used for functional modeling of devices.
      */
@@ -48,11 +64,38 @@ public:
     virtual ETransStatus nb_transport(Axi4TransactionType *trans,
                                       IAxi4NbResponse *cb) =0;
 
+    /**
+     * Burst transactions. Burst crossing slave boundary is split by bus,
+     * the part of the next slave is accessed after the previous one.
+     */
+    virtual ETransStatus b_transport_burst(Axi4BurstTransactionType *trans) =0;
+    virtual ETransStatus nb_transport_burst(Axi4BurstTransactionType *trans,
+                                            IAxi4NbResponse *cb) =0;
+
+    /**
+     * Direct memory interface request. Request is redirected to the slave
+     * device mapped on the specified address.
+     */
+    virtual bool get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi) =0;
+
+    /**
+     * Pointers granted by get_direct_mem_ptr() for the region are revoked,
+     * the request is forwarded to all registered listeners.
+     */
+    virtual void invalidate_direct_mem_ptr(uint64_t addr, uint64_t size) =0;
+
     /**
      * This method emulates connection between bus controller and DSU module.
      * It allows to read bus utilization statistic via mapped DSU registers.
+     * @param[out] util Array of CFG_NASTI_MASTER_TOTAL items.
+     */
+    virtual void bus_utilization(BusUtilType *util) =0;
+
+    /**
+     * Number of transactions routed to each mapped slave device.
+     * @param[out] list List of [base address, length, hits] items.
      */
-    virtual BusUtilType *bus_utilization() =0;
+    virtual void slave_hits(AttributeType *list) =0;
 };
 
 }  // namespace debugger
@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Bus write transactions listener interface.
+ */
+
+#ifndef __DEBUGGER_IBUS_LISTENER_H__
+#define __DEBUGGER_IBUS_LISTENER_H__
+
+#include "iface.h"
+#include <inttypes.h>
+
+namespace debugger {
+
+static const char *const IFACE_BUS_LISTENER = "IBusListener";
+
+class IBusListener : public IFace {
+public:
+    IBusListener() : IFace(IFACE_BUS_LISTENER) {}
+
+    /**
+     * @brief Memory was modified by any bus master.
+     * @param[in] addr First modified byte address.
+     * @param[in] size Number of modified bytes.
+     */
+    virtual void writeNotify(uint64_t addr, uint32_t size) =0;
+
+    /**
+     * @brief Direct memory pointers of the region were revoked.
+     * @details Pointers must be requested again before the next access.
+     *          Can be called from any thread.
+     */
+    virtual void invalidateDmi(uint64_t addr, uint64_t size) =0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_IBUS_LISTENER_H__
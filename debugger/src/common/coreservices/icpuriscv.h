@@ -45,6 +45,12 @@ public:
     virtual void lowerSignal(int idx) =0;
     virtual void nb_transport_debug_port(DebugPortTransactionType *trans,
                                          IDbgNbResponse *cb) =0;
+
+    /**
+     * Hart is halted by the debugger and doesn't modify the platform.
+     * Models that don't report their state are always running.
+     */
+    virtual bool isHalted() { return false; }
 };
 
 }  // namespace debugger
@@ -10,6 +10,7 @@
 
 #include "iface.h"
 #include <inttypes.h>
+#include <string.h>
 #include "isocinfo.h"
 
 namespace debugger {
@@ -46,6 +47,34 @@ typedef struct Axi4TransactionType {
     int source_idx;             // Need for bus utilization statistic
 } Axi4TransactionType;
 
+/**
+ * Burst transaction moves a block of data (cache line, EDCL frame) between
+ * the initiator buffer and slave device in a single call. Slave receives
+ * only its part of the block. Block is split into beats of xsize bytes
+ * with the consecutive addresses, all bytes are written.
+ */
+typedef struct Axi4BurstTransactionType {
+    EAxi4Action action;
+    EAxi4Response response;
+    uint32_t xsize;             // [Bytes] beat size, 4 or 8
+    uint32_t len;               // [Bytes] total size, multiple of xsize
+    uint64_t addr;
+    uint8_t *payload;           // Initiator buffer of len bytes
+    int source_idx;             // Need for bus utilization statistic
+} Axi4BurstTransactionType;
+
+/**
+ * Direct memory interface region (TLM-2 DMI like). Host pointer allows
+ * initiator to access memory without bus transactions.
+ */
+typedef struct DmiRegionType {
+    uint8_t *ptr;               // Host pointer on the first byte of region
+    uint64_t addr;              // Region base address
+    uint64_t length;            // Region size in bytes
+    bool read_allowed;
+    bool write_allowed;
+} DmiRegionType;
+
 /**
  * Non-blocking memory access response interface (Initiator/Master)
  */
@@ -54,6 +83,8 @@ public:
     IAxi4NbResponse() : IFace(IFACE_AXI4_NB_RESPONSE) {}
 
     virtual void nb_response(Axi4TransactionType *trans) =0;
+
+    virtual void nb_response_burst(Axi4BurstTransactionType *trans) {}
 };
 
 /**
@@ -82,6 +113,56 @@ public:
         cb->nb_response(trans);
     }
 
+    /**
+     * Blocking burst transaction
+     *
+     * Default implementation splits burst on single beat transactions, so
+     * devices with registers don't need to implement it.
+     */
+    virtual void b_transport_burst(Axi4BurstTransactionType *trans) {
+        Axi4TransactionType beat;
+        beat.action = trans->action;
+        beat.xsize = trans->xsize;
+        beat.wstrb = (1u << trans->xsize) - 1;
+        beat.source_idx = trans->source_idx;
+        trans->response = MemResp_Valid;
+        for (uint32_t off = 0; off < trans->len; off += trans->xsize) {
+            beat.addr = trans->addr + off;
+            beat.response = MemResp_Valid;
+            if (trans->action == MemAction_Write) {
+                memcpy(beat.wpayload.b8, &trans->payload[off], trans->xsize);
+            }
+            b_transport(&beat);
+            if (trans->action == MemAction_Read) {
+                memcpy(&trans->payload[off], beat.rpayload.b8, trans->xsize);
+            }
+            if (beat.response == MemResp_Error) {
+                trans->response = MemResp_Error;
+            }
+        }
+    }
+
+    /**
+     * Non-blocking burst transaction
+     *
+     * Default implementation re-direct to blocking burst transport
+     */
+    virtual void nb_transport_burst(Axi4BurstTransactionType *trans,
+                                    IAxi4NbResponse *cb) {
+        b_transport_burst(trans);
+        cb->nb_response_burst(trans);
+    }
+
+    /**
+     * Direct memory interface request
+     *
+     * Memory devices can provide host pointer on its storage. Default
+     * implementation denies direct access (registers of the peripheries).
+     */
+    virtual bool get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi) {
+        return false;
+    }
+
     virtual uint64_t getBaseAddress() =0;
 
     virtual uint64_t getLength() =0;
@@ -0,0 +1,62 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Tracking of the modified memory pages.
+ */
+
+#ifndef __DEBUGGER_PLUGIN_IMEMTRACKER_H__
+#define __DEBUGGER_PLUGIN_IMEMTRACKER_H__
+
+#include "iface.h"
+#include "imemop.h"
+
+namespace debugger {
+
+static const char *const IFACE_MEMORY_TRACKER = "IMemoryTracker";
+static const char *const IFACE_MEMORY_TRACK_LISTENER = "IMemoryTrackListener";
+
+static const unsigned TRACK_PAGE_BYTES = 1 << 12;
+
+class IMemoryTracker;
+
+class IMemoryTrackListener : public IFace {
+public:
+    IMemoryTrackListener() : IFace(IFACE_MEMORY_TRACK_LISTENER) {}
+
+    /**
+     * @brief The first write into the clean page.
+     * @details Called by the writing thread before the page is modified,
+     *          so the listener still sees the previous content.
+     * @param[in] imem Memory containing the page.
+     * @param[in] off Page offset from the beginning of the memory.
+     */
+    virtual void pageWrite(IMemoryTracker *imem, uint64_t off) =0;
+};
+
+/**
+ * Writable memory model that grants DMI write pointers only for the
+ * pages written since the last clearDirty(). The first write into the
+ * clean page goes via the bus and is reported to the listener.
+ */
+class IMemoryTracker : public IFace {
+public:
+    IMemoryTracker() : IFace(IFACE_MEMORY_TRACKER) {}
+
+    /** Whole memory array, false for the read-only memory */
+    virtual bool getMemory(DmiRegionType *dmi) =0;
+
+    /** Start tracking, all pages are dirty until clearDirty() is called */
+    virtual void setTrackListener(IMemoryTrackListener *listener) =0;
+
+    /**
+     * @brief Mark all pages clean.
+     * @details Write pointers granted earlier stay valid until the caller
+     *          invalidates them via IBus::invalidate_direct_mem_ptr().
+     */
+    virtual void clearDirty() =0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_PLUGIN_IMEMTRACKER_H__
@@ -0,0 +1,47 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Execution profiler interface of the CPU model.
+ */
+
+#ifndef __DEBUGGER_PLUGIN_IPROFILER_H__
+#define __DEBUGGER_PLUGIN_IPROFILER_H__
+
+#include "iface.h"
+#include "attribute.h"
+
+namespace debugger {
+
+static const char *const IFACE_PROFILER = "IProfiler";
+
+enum EProfileItem {
+    Profile_Histogram,      // [[pc, instructions, stalls], ...]
+    Profile_Stacks,         // [[weight, [frame0, frame1, ...]], ...]
+    Profile_Total
+};
+
+/**
+ * Requests are executed by the CPU thread, so the methods wait until the
+ * CPU model processes them.
+ */
+class IProfiler : public IFace {
+public:
+    IProfiler() : IFace(IFACE_PROFILER) {}
+
+    virtual void startProfiling() =0;
+    virtual void stopProfiling() =0;
+    virtual void resetProfiling() =0;
+    virtual bool isProfiling() =0;
+
+    /**
+     * Counters per entry address of the basic block and sampled call
+     * stacks. Stack frame is an address inside of the function, the
+     * outer function first.
+     */
+    virtual void getProfile(AttributeType *res) =0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_PLUGIN_IPROFILER_H__
@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Reverse execution interfaces: inputs log and replay.
+ */
+
+#ifndef __DEBUGGER_PLUGIN_IREPLAY_H__
+#define __DEBUGGER_PLUGIN_IREPLAY_H__
+
+#include "iface.h"
+#include "attribute.h"
+
+namespace debugger {
+
+static const char *const IFACE_REPLAY_INPUT = "IReplayInput";
+static const char *const IFACE_INPUT_RECORDER = "IInputRecorder";
+static const char *const IFACE_REPLAY_HART = "IReplayHart";
+static const char *const IFACE_REVERSE_CONTROL = "IReverseControl";
+
+/**
+ * Model receiving data from outside of the simulated platform (console,
+ * debug port, EDCL).
+ */
+class IReplayInput : public IFace {
+public:
+    IReplayInput() : IFace(IFACE_REPLAY_INPUT) {}
+
+    /** Apply logged input, called from the CPU thread */
+    virtual void replayInput(const AttributeType *data) =0;
+};
+
+/**
+ * Inputs are applied on the CPU thread and logged with the step counter,
+ * so they are applied at the same step when the history is replayed.
+ */
+class IInputRecorder : public IFace {
+public:
+    IInputRecorder() : IFace(IFACE_INPUT_RECORDER) {}
+
+    /**
+     * Apply input at the nearest step and log it. Can be called from any
+     * thread, 'dst' receives the data via replayInput().
+     */
+    virtual void putInput(IReplayInput *dst, const AttributeType *data) =0;
+
+    /** Log input that was already applied by the CPU thread */
+    virtual void recordInput(IReplayInput *dst, const AttributeType *data) =0;
+
+    /** Hart was reset, the logged history can't be replayed anymore */
+    virtual void resetHistory() =0;
+};
+
+/**
+ * Hart re-executing the history from the restored checkpoint. Methods are
+ * called from the CPU thread by step callbacks.
+ */
+class IReplayHart : public IFace {
+public:
+    IReplayHart() : IFace(IFACE_REPLAY_HART) {}
+
+    /**
+     * Resume execution. Breakpoints and watchpoints don't stop the hart,
+     * only the step of the latest hit before 'end' is kept.
+     */
+    virtual void startReplay(uint64_t end) =0;
+
+    /** Halt hart, returns false if there was no hit since startReplay() */
+    virtual bool stopReplay(uint64_t *hit) =0;
+};
+
+class IReverseControl : public IFace {
+public:
+    IReverseControl() : IFace(IFACE_REVERSE_CONTROL) {}
+
+    /** Move back on the specified number of steps and halt */
+    virtual bool reverseStep(uint64_t steps) =0;
+
+    /**
+     * Move back to the previous breakpoint or watchpoint hit, or to the
+     * oldest checkpoint when there's no hit.
+     */
+    virtual bool reverseContinue() =0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_PLUGIN_IREPLAY_H__
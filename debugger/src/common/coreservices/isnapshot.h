@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Platform snapshot interfaces.
+ */
+
+#ifndef __DEBUGGER_PLUGIN_ISNAPSHOT_H__
+#define __DEBUGGER_PLUGIN_ISNAPSHOT_H__
+
+#include "iface.h"
+#include "attribute.h"
+
+namespace debugger {
+
+static const char *const IFACE_SNAPSHOT = "ISnapshot";
+static const char *const IFACE_SNAPSHOT_CONTROL = "ISnapshotControl";
+
+/**
+ * Model with the internal state (registers, FIFOs, pending callbacks).
+ *
+ * Both methods are called from the CPU thread at the instruction boundary,
+ * memory arrays are saved by the snapshot service via DMI.
+ */
+class ISnapshot : public IFace {
+public:
+    ISnapshot() : IFace(IFACE_SNAPSHOT) {}
+
+    virtual void saveState(AttributeType *state) =0;
+
+    virtual void restoreState(const AttributeType *state) =0;
+};
+
+enum ESnapshotStatus {
+    Snapshot_Ok,
+    Snapshot_Busy,
+    Snapshot_Error
+};
+
+class ISnapshotControl : public IFace {
+public:
+    ISnapshotControl() : IFace(IFACE_SNAPSHOT_CONTROL) {}
+
+    /**
+     * Save platform state into file. With 'wait' = false the request is
+     * only queued, use getStatus() to check result.
+     */
+    virtual bool save(const char *filename, bool wait) =0;
+
+    /** Restore platform state from file */
+    virtual bool restore(const char *filename, bool wait) =0;
+
+    /** Result of the last request (ESnapshotStatus) */
+    virtual int getStatus() =0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_PLUGIN_ISNAPSHOT_H__
@@ -133,7 +133,9 @@ struct DsuMapType {
             uint64_t pc;            // index = 32
             uint64_t npc;           // index = 33
             uint64_t stack_trace_cnt; // index 34
-            uint64_t rsrv[128 - 35];
+            uint64_t rsrv1[64 - 35];
+            uint64_t fregs[32];     // index = 64
+            uint64_t rsrv2[128 - 96];
             uint64_t stack_trace_buf[1];
         } v;
     } ureg;
@@ -147,7 +149,7 @@ struct DsuMapType {
                     uint64_t halt     : 1;
                     uint64_t stepping : 1;
                     uint64_t breakpoint : 1;
-                    uint64_t rsv1     : 1;
+                    uint64_t watchpoint : 1;
                     uint64_t core_id  : 16;
                     uint64_t rsv2     : 12;
                     uint64_t istate   : 2;  // [33:32] icache state
@@ -172,6 +174,10 @@ struct DsuMapType {
                     uint64_t rsv1          : 63;
                 } bits;
             } br_ctrl;
+            /**
+             * Write address to add hardware breakpoint. Read value is the
+             * number of free hardware breakpoints (0 = not supported).
+             */
             uint64_t add_breakpoint;
             uint64_t remove_breakpoint;
             /**
@@ -184,6 +190,19 @@ struct DsuMapType {
              * instruction instead of memory.
              */
             uint64_t br_instr_fetch;
+            /** Start address and length of the data watchpoint */
+            uint64_t wp_address;
+            uint64_t wp_length;
+            /**
+             * Write access flags (bit 0 = read, bit 1 = write) to register
+             * watchpoint specified by wp_address and wp_length. Read value
+             * is the number of free watchpoints (0 = not supported).
+             */
+            uint64_t add_watchpoint;
+            /** Write start address of the watchpoint to remove it */
+            uint64_t remove_watchpoint;
+            /** Data address of the last watchpoint hit */
+            uint64_t wp_hit_address;
         } v;
     } udbg;
     // Base Address + 0x18000 (Region 3)
@@ -193,7 +212,9 @@ struct DsuMapType {
             uint64_t soft_reset;
             uint64_t miss_access_cnt;
             uint64_t miss_access_addr;
-            uint64_t rsrv[5];
+            uint64_t cpu_selector;  // hart index of the debug port
+            uint64_t snapshot;      // W: 1=save, 2=restore; R: status
+            uint64_t rsrv[3];
             // Bus utilization registers
             struct mst_bus_util_type {
                 uint64_t w_cnt;
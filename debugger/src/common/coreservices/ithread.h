@@ -28,10 +28,13 @@ public:
     virtual bool run() {
         threadInit_.func = reinterpret_cast<lib_thread_func>(runThread);
         threadInit_.args = this;
+        // Enable loop before the thread starts, otherwise the new thread
+        // may check isEnabled() first and exit immediately.
+        RISCV_event_set(&loopEnable_);
         RISCV_thread_create(&threadInit_);
 
-        if (threadInit_.Handle) {
-            RISCV_event_set(&loopEnable_);
+        if (!threadInit_.Handle) {
+            RISCV_event_clear(&loopEnable_);
         }
         return loopEnable_.state;
     }
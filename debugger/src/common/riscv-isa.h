@@ -181,7 +181,7 @@ union csr_mstatus_type {
         uint64_t FS     : 2;    // [14:13]: RW: FPU context status
         uint64_t XS     : 2;    // [16:15]: RW: extension context status
         uint64_t MPRV   : 1;    // [17] Memory privilege bit
-        uint64_t PUM    : 1;    // [18]
+        uint64_t SUM    : 1;    // [18] Supervisor access to User pages
         uint64_t MXR    : 1;    // [19]
         uint64_t rsrv1  : 4;    // [23:20]
         uint64_t VM     : 5;    // [28:24] Virtualization management field (WARL)
@@ -256,6 +256,12 @@ static const uint16_t CSR_marchid           = 0xf12;
 static const uint16_t CSR_mimplementationid = 0xf13;
 /** Thread id (the same as core). */
 static const uint16_t CSR_mhartid           = 0xf14;
+/** Floating-Point Accrued Exceptions. */
+static const uint16_t CSR_fflags        = 0x001;
+/** Floating-Point Dynamic Rounding Mode. */
+static const uint16_t CSR_frm           = 0x002;
+/** Floating-Point Control and Status Register (frm + fflags). */
+static const uint16_t CSR_fcsr          = 0x003;
 /** Machine wall-clock time */
 static const uint16_t CSR_mtime         = 0x701;
 
@@ -269,10 +275,16 @@ static const uint16_t CSR_mideleg       = 0x303;
 static const uint16_t CSR_mie           = 0x304;
 /** The base address of the M-mode trap vector. */
 static const uint16_t CSR_mtvec         = 0x305;
+/** Machine counter enable. */
+static const uint16_t CSR_mcounteren    = 0x306;
 /** Machine wall-clock timer compare value. */
 static const uint16_t CSR_mtimecmp      = 0x321;
 /** Scratch register for machine trap handlers. */
 static const uint16_t CSR_mscratch      = 0x340;
+/** The base address of the S-mode trap vector. */
+static const uint16_t CSR_stvec         = 0x105;
+/** Scratch register for supervisor trap handlers. */
+static const uint16_t CSR_sscratch      = 0x140;
 /** Exception program counters. */
 static const uint16_t CSR_uepc          = 0x041;
 static const uint16_t CSR_sepc          = 0x141;
@@ -283,6 +295,35 @@ static const uint16_t CSR_mcause        = 0x342;
 /** Machine bad address. */static const uint16_t CSR_mbadaddr      = 0x343;
 /** Machine interrupt pending */
 static const uint16_t CSR_mip           = 0x344;
+/** Supervisor address translation and protection. */
+static const uint16_t CSR_satp          = 0x180;
+/** Debug control and status, prv[1:0] is the halted hart privilege. */
+static const uint16_t CSR_dcsr          = 0x7b0;
+/// @}
+
+/**
+ * @name Sv39 virtual memory.
+ */
+/// @{
+/** satp[63:60] translation mode: Bare or Sv39 */
+static const int SATP_MODE_SHIFT        = 60;
+static const uint64_t SATP_MODE_BARE    = 0;
+static const uint64_t SATP_MODE_SV39    = 8;
+/** satp[43:0] physical page number of the root page table */
+static const uint64_t SATP_PPN_MASK     = (1ull << 44) - 1;
+/** Page table entry bits */
+static const uint64_t PTE_V             = 1ull << 0;
+static const uint64_t PTE_R             = 1ull << 1;
+static const uint64_t PTE_W             = 1ull << 2;
+static const uint64_t PTE_X             = 1ull << 3;
+static const uint64_t PTE_U             = 1ull << 4;
+static const uint64_t PTE_G             = 1ull << 5;
+static const uint64_t PTE_A             = 1ull << 6;
+static const uint64_t PTE_D             = 1ull << 7;
+static const int PTE_PPN_SHIFT          = 10;
+/** Number of the page table levels and VPN bits per level */
+static const int SV39_LEVELS            = 3;
+static const int SV39_VPN_BITS          = 9;
 /// @}
 
 /** Exceptions */
@@ -310,7 +351,13 @@ enum EExeption {
     // Environment call from H-mode
     EXCEPTION_CallFromHmode   = 10,
     // Environment call from M-mode
-    EXCEPTION_CallFromMmode   = 11
+    EXCEPTION_CallFromMmode   = 11,
+    // Instruction page fault
+    EXCEPTION_InstrPageFault  = 12,
+    // Load page fault
+    EXCEPTION_LoadPageFault   = 13,
+    // Store/AMO page fault
+    EXCEPTION_StorePageFault  = 15
 };
 
 enum EInterrupt {
@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Micro-benchmark of the functional model instruction handlers.
+ *
+ * @details    Handlers are called through the IInstruction interface the
+ *             same way as the interpreter does, so the result is the cost
+ *             of a single instruction without fetch and decoding:
+ *                 cpu_bench [calls]
+ *             'exec-old' line is the ADDI handler as it was before the
+ *             disassembly formatting was moved to ISourceCode::disasm,
+ *             called the same way, so 'exec' and 'exec-old' are the cost
+ *             per instruction after and before. 'csrrw' lines access the
+ *             CSR with a slot in the context and the one kept in the cold
+ *             table.
+ *             'profile' line is the profiler cost per executed block.
+ *
+ *             Context layout shows the data cache footprint of a step:
+ *             number of 64-bytes lines with the fields accessed on each
+ *             executed instruction. Cache misses per instruction are
+ *             measured on the hosts with performance counters, e.g.:
+ *                 perf stat -e instructions,L1-dcache-load-misses \
+ *                           cpu_bench.exe
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "api_utils.h"
+#include "riscv-isa.h"
+#include "instructions.h"
+#include "profiler.h"
+
+namespace debugger {
+void addIsaUserRV64I(CpuContextType *data, AttributeType *out);
+void addIsaPrivilegedRV64I(CpuContextType *data, AttributeType *out);
+}
+
+using namespace debugger;
+
+static const int INSTR_HASH_TABLE_SIZE = 1 << 5;
+
+/**
+ * ADDI handler before the formatting was removed. Context doesn't have
+ * the disassembly buffer anymore, so it is a member here.
+ */
+class ADDI_Old : public IsaProcessor {
+public:
+    ADDI_Old() : IsaProcessor("ADDI", "?????????????????000?????0010011") {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_I_type u;
+        u.value = payload[0];
+
+        uint64_t imm = u.bits.imm;
+        if (imm & 0x800) {
+            imm |= EXT_SIGN_12;
+        }
+        data->regs[u.bits.rd] = data->regs[u.bits.rs1] + imm;
+        data->npc = data->pc + 4;
+
+        if (u.bits.rs1 == 0) {
+            RISCV_sprintf(disasm_, sizeof(disasm_),
+                "li %s,%d", IREGS_NAMES[u.bits.rd], static_cast<uint32_t>(imm));
+        } else {
+            RISCV_sprintf(disasm_, sizeof(disasm_),
+                "addi %s,%s,%d", IREGS_NAMES[u.bits.rd],
+                                 IREGS_NAMES[u.bits.rs1],
+                                 static_cast<uint32_t>(imm));
+        }
+    }
+
+private:
+    char disasm_[64];
+};
+
+/** Handlers are stored in the table by opcode hash as in the CPU model */
+static IInstruction *findInstruction(AttributeType *table, uint32_t payload) {
+    AttributeType *list = &table[(payload >> 2) & 0x1f];
+    for (unsigned i = 0; i < list->size(); i++) {
+        IInstruction *instr =
+            static_cast<IInstruction *>((*list)[i].to_iface());
+        if (instr->parse(&payload)) {
+            return instr;
+        }
+    }
+    return NULL;
+}
+
+static void report(const char *name, uint64_t calls, uint64_t ms) {
+    printf("%-10s %12" RV_PRI64 "d calls %8" RV_PRI64 "d ms %8.2f ns/call\n",
+           name, calls, ms, 1000000.0 * static_cast<double>(ms)
+                                      / static_cast<double>(calls));
+}
+
+static const unsigned CACHE_LINE = 64;
+
+/** Fields used by the fetch and execute step of the interpreter */
+static void reportLayout() {
+    static const struct FieldType {
+        const char *name;
+        size_t offset;
+        size_t size;
+    } STEP_FIELDS[] = {
+        {"regs", offsetof(CpuContextType, regs),
+            sizeof(((CpuContextType *)0)->regs)},
+        {"pc", offsetof(CpuContextType, pc), 8},
+        {"npc", offsetof(CpuContextType, npc), 8},
+        {"step_cnt", offsetof(CpuContextType, step_cnt), 8},
+        {"cur_prv_level", offsetof(CpuContextType, cur_prv_level), 8},
+        {"exception", offsetof(CpuContextType, exception), 8},
+        {"interrupt", offsetof(CpuContextType, interrupt), 8},
+        {"interrupt_pending",
+            offsetof(CpuContextType, interrupt_pending), 8},
+        {"dmi", offsetof(CpuContextType, dmi), sizeof(void *)},
+        {"reset", offsetof(CpuContextType, reset), 1},
+        {"br_inject_fetch", offsetof(CpuContextType, br_inject_fetch), 1},
+        {"wfi", offsetof(CpuContextType, wfi), 1},
+    };
+    static const unsigned FIELDS_TOTAL =
+        sizeof(STEP_FIELDS) / sizeof(STEP_FIELDS[0]);
+    uint64_t lines = 0;     // bitmap of the first 64 lines
+    size_t end = 0;
+    printf("sizeof(CpuContextType) %d bytes\n",
+           static_cast<int>(sizeof(CpuContextType)));
+    for (unsigned i = 0; i < FIELDS_TOTAL; i++) {
+        const FieldType &f = STEP_FIELDS[i];
+        printf("    %-18s offset %5d size %3d\n", f.name,
+               static_cast<int>(f.offset), static_cast<int>(f.size));
+        for (size_t n = f.offset / CACHE_LINE;
+             n <= (f.offset + f.size - 1) / CACHE_LINE; n++) {
+            if (n < 64) {
+                lines |= 1ull << n;
+            }
+        }
+        if (f.offset + f.size > end) {
+            end = f.offset + f.size;
+        }
+    }
+    int cnt = 0;
+    for (int i = 0; i < 64; i++) {
+        cnt += static_cast<int>((lines >> i) & 1);
+    }
+    printf("step footprint %d lines of %d bytes (offsets 0..%d)\n",
+           cnt, CACHE_LINE, static_cast<int>(end - 1));
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t calls = 100000000;
+    if (argc > 1) {
+        calls = strtoull(argv[1], NULL, 0);
+    }
+
+    CpuContextType *ctx = new CpuContextType;
+    memset(ctx, 0, sizeof(CpuContextType));
+    ctx->cur_prv_level = PRV_M;
+    AttributeType listInstr[INSTR_HASH_TABLE_SIZE];
+    for (int i = 0; i < INSTR_HASH_TABLE_SIZE; i++) {
+        listInstr[i].make_list(0);
+    }
+    addIsaUserRV64I(ctx, listInstr);
+    addIsaPrivilegedRV64I(ctx, listInstr);
+    reportLayout();
+
+    // addi t0,t0,1
+    uint32_t payload = 0x00128293;
+    IInstruction *addi = findInstruction(listInstr, payload);
+    if (!addi) {
+        printf("ADDI handler not found\n");
+        return 1;
+    }
+
+    uint64_t t0 = RISCV_get_time_ms();
+    for (uint64_t i = 0; i < calls; i++) {
+        addi->exec(&payload, ctx);
+        ctx->pc = ctx->npc;
+    }
+    report("exec", calls, RISCV_get_time_ms() - t0);
+
+    IInstruction *addi_old = new ADDI_Old;
+    t0 = RISCV_get_time_ms();
+    for (uint64_t i = 0; i < calls; i++) {
+        addi_old->exec(&payload, ctx);
+        ctx->pc = ctx->npc;
+    }
+    report("exec-old", calls, RISCV_get_time_ms() - t0);
+    delete addi_old;
+
+    // csrrw t0,sscratch,t0 and csrrw t0,0x7c0,t0 (custom register)
+    static const uint32_t CSR_PAYLOAD[2] = {0x140292f3, 0x7c0292f3};
+    static const char *const CSR_NAME[2] = {"csrrw", "csrrw-cold"};
+    for (int n = 0; n < 2; n++) {
+        payload = CSR_PAYLOAD[n];
+        IInstruction *csrrw = findInstruction(listInstr, payload);
+        if (!csrrw) {
+            printf("CSRRW handler not found\n");
+            return 1;
+        }
+        t0 = RISCV_get_time_ms();
+        for (uint64_t i = 0; i < calls; i++) {
+            csrrw->exec(&payload, ctx);
+            ctx->pc = ctx->npc;
+        }
+        report(CSR_NAME[n], calls, RISCV_get_time_ms() - t0);
+    }
+
+    // Basic blocks of a small program: one histogram entry each
+    ProfileTableType profile;
+    t0 = RISCV_get_time_ms();
+    for (uint64_t i = 0; i < calls; i++) {
+        profile.add(0x10000000 + ((i & 0x3f) << 4), 4, 0);
+    }
+    report("profile", calls, RISCV_get_time_ms() - t0);
+
+    // Keep the result alive
+    printf("t0 = %" RV_PRI64 "d\n", ctx->regs[Reg_t0]);
+    delete ctx;
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Cache of the decoded basic blocks.
+ */
+
+#include <string.h>
+#include "blockcache.h"
+
+namespace debugger {
+
+BlockCacheType::BlockCacheType() {
+    memset(slots_, 0, sizeof(slots_));
+    memset(pageGen_, 0, sizeof(pageGen_));
+}
+
+BlockCacheType::~BlockCacheType() {
+    for (int i = 0; i < BLOCK_SLOTS; i++) {
+        if (slots_[i]) {
+            delete slots_[i];
+        }
+    }
+}
+
+DecodedBlockType *BlockCacheType::allocate(uint64_t pc) {
+    DecodedBlockType *blk = slots_[(pc >> 1) % BLOCK_SLOTS];
+    if (blk == 0) {
+        blk = new DecodedBlockType;
+        slots_[(pc >> 1) % BLOCK_SLOTS] = blk;
+    }
+    blk->pc = pc;
+    blk->gen = pageGen_[(pc >> PAGE_BITS) % PAGE_GEN_TOTAL];
+    blk->size = 0;
+    blk->chain_idx = 0;
+    blk->chain[0] = 0;
+    blk->chain[1] = 0;
+    return blk;
+}
+
+void BlockCacheType::invalidate(uint64_t addr, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+    uint64_t page = addr >> PAGE_BITS;
+    uint64_t page_end = (addr + size - 1) >> PAGE_BITS;
+    for (; page <= page_end; page++) {
+        pageGen_[page % PAGE_GEN_TOTAL]++;
+    }
+}
+
+void BlockCacheType::flush() {
+    for (int i = 0; i < PAGE_GEN_TOTAL; i++) {
+        pageGen_[i]++;
+    }
+}
+
+}  // namespace debugger
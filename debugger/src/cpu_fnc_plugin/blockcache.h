@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Cache of the decoded basic blocks.
+ *
+ * @details    Basic block is a sequence of the already decoded instructions
+ *             ended by a control transfer instruction (branch, jump,
+ *             system or fence instruction) or by the page boundary.
+ *             Blocks are chained with their successors so that the most
+ *             of the block switches don't require any table lookup.
+ *             Each block stores generation counter of its page. Any write
+ *             into the page increments this counter and invalidates all
+ *             blocks located in this page.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_BLOCKCACHE_H__
+#define __DEBUGGER_CPU_RISCV_BLOCKCACHE_H__
+
+#include <inttypes.h>
+#include "predecode.h"
+#include "hostcode.h"
+
+namespace debugger {
+
+static const int BLOCK_INSTR_MAX = 32;
+
+struct DecodedBlockType {
+    uint64_t pc;            // start address, ~0 when block is empty
+    uint32_t gen;           // page generation counter on decoding
+    int size;               // number of instructions
+    int chain_idx;          // next chain slot to replace
+    DecodedBlockType *chain[2];
+    PredecodedInstrType instr[BLOCK_INSTR_MAX];
+    HostCodeFunc host[BLOCK_INSTR_MAX];     // translated run started here
+    int host_len[BLOCK_INSTR_MAX];          // instructions in the run
+};
+
+class BlockCacheType {
+public:
+    BlockCacheType();
+    ~BlockCacheType();
+
+    /** Get valid decoded block started from the specified address */
+    DecodedBlockType *lookup(uint64_t pc) {
+        DecodedBlockType *blk = slots_[(pc >> 1) % BLOCK_SLOTS];
+        if (blk && blk->pc == pc && isValid(blk)) {
+            return blk;
+        }
+        return 0;
+    }
+
+    /** Allocate empty block, previous block in the same slot is evicted */
+    DecodedBlockType *allocate(uint64_t pc);
+
+    /** Block was decoded before and its page wasn't modified since */
+    bool isValid(DecodedBlockType *blk) {
+        return blk->gen == pageGen_[(blk->pc >> PAGE_BITS) % PAGE_GEN_TOTAL];
+    }
+
+    /** Memory modification: invalidate blocks of the modified pages */
+    void invalidate(uint64_t addr, uint32_t size);
+
+    /** Whole memory was replaced (snapshot restore) */
+    void flush();
+
+    /** Page boundary ends any basic block */
+    static bool isPageStart(uint64_t pc) {
+        return (pc & ((1ull << PAGE_BITS) - 1)) == 0;
+    }
+
+    /** Instruction crosses page boundary and can't be added to block */
+    static bool isPageCross(uint64_t pc, uint32_t size) {
+        return ((pc ^ (pc + size - 1)) >> PAGE_BITS) != 0;
+    }
+
+private:
+    static const int PAGE_BITS = 12;
+    static const int PAGE_GEN_TOTAL = 4096;
+    static const int BLOCK_SLOTS = 4096;
+
+    DecodedBlockType *slots_[BLOCK_SLOTS];
+    uint32_t pageGen_[PAGE_GEN_TOTAL];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_BLOCKCACHE_H__
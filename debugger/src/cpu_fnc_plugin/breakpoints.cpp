@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Breakpoints table of the functional CPU model.
+ */
+
+#include <string.h>
+#include "breakpoints.h"
+
+namespace debugger {
+
+BreakpointTableType::BreakpointTableType() {
+    memset(bitmap_, 0, sizeof(bitmap_));
+    total_ = 0;
+}
+
+bool BreakpointTableType::add(uint64_t addr) {
+    if (find(addr) >= 0) {
+        return true;
+    }
+    if (total_ == BREAKPOINTS_MAX) {
+        return false;
+    }
+    addr_[total_++] = addr;
+    updatePage(addr);
+    return true;
+}
+
+bool BreakpointTableType::remove(uint64_t addr) {
+    int idx = find(addr);
+    if (idx < 0) {
+        return false;
+    }
+    addr_[idx] = addr_[--total_];
+    updatePage(addr);
+    return true;
+}
+
+int BreakpointTableType::find(uint64_t addr) {
+    for (int i = 0; i < total_; i++) {
+        if (addr_[i] == addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/** Several pages share the same bit, so the bit is re-computed */
+void BreakpointTableType::updatePage(uint64_t addr) {
+    uint32_t idx = pageIndex(addr);
+    bitmap_[idx >> 5] &= ~(1u << (idx & 0x1f));
+    for (int i = 0; i < total_; i++) {
+        if (pageIndex(addr_[i]) == idx) {
+            bitmap_[idx >> 5] |= 1u << (idx & 0x1f);
+            break;
+        }
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Breakpoints table of the functional CPU model.
+ *
+ * @details    Breakpoints are checked on instruction fetch without memory
+ *             modification. Each memory page has a bit in the bitmap, so
+ *             fetch from the page without breakpoints costs one bit test.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_BREAKPOINTS_H__
+#define __DEBUGGER_CPU_RISCV_BREAKPOINTS_H__
+
+#include <inttypes.h>
+
+namespace debugger {
+
+class BreakpointTableType {
+public:
+    BreakpointTableType();
+
+    /** @return false if the table is full */
+    bool add(uint64_t addr);
+
+    /** @return false if breakpoint wasn't found */
+    bool remove(uint64_t addr);
+
+    /** Page of the specified address possibly contains breakpoints */
+    bool isPageMarked(uint64_t addr) {
+        uint32_t idx = pageIndex(addr);
+        return ((bitmap_[idx >> 5] >> (idx & 0x1f)) & 0x1) != 0;
+    }
+
+    bool isBreakpoint(uint64_t addr) {
+        return isPageMarked(addr) && find(addr) >= 0;
+    }
+
+    int getFreeTotal() { return BREAKPOINTS_MAX - total_; }
+
+private:
+    static const int PAGE_BITS = 12;
+    static const uint32_t PAGE_HASH_TOTAL = 1 << 16;
+    static const int BREAKPOINTS_MAX = 256;
+
+    static uint32_t pageIndex(uint64_t addr) {
+        return static_cast<uint32_t>(addr >> PAGE_BITS) & (PAGE_HASH_TOTAL - 1);
+    }
+    int find(uint64_t addr);
+    void updatePage(uint64_t addr);
+
+    uint32_t bitmap_[PAGE_HASH_TOTAL / 32];
+    uint64_t addr_[BREAKPOINTS_MAX];
+    int total_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_BREAKPOINTS_H__
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Code pages of the harts sharing memory.
+ */
+
+#include <string.h>
+#include "api_core.h"
+#include "codepages.h"
+
+namespace debugger {
+
+static CodePageTableType *tables_ = 0;
+
+CodePageTableType *CodePageTableType::attach(const char *name) {
+    CodePageTableType *p = tables_;
+    while (p) {
+        if (strcmp(p->name_, name) == 0) {
+            return p;
+        }
+        p = p->next_;
+    }
+    p = new CodePageTableType(name);
+    p->next_ = tables_;
+    tables_ = p;
+    return p;
+}
+
+CodePageTableType::CodePageTableType(const char *name) {
+    RISCV_sprintf(name_, sizeof(name_), "%s", name);
+    next_ = 0;
+    total_ = 0;
+    for (int i = 0; i < PAGE_TOTAL; i++) {
+        marked_[i] = 0;
+    }
+}
+
+bool CodePageTableType::registerHart(IBusListener *hart) {
+    if (total_ == HARTS_MAX) {
+        return false;
+    }
+    harts_[total_++] = hart;
+    return true;
+}
+
+/**
+ * Listeners are called from the writer thread as the bus does for the
+ * bus transactions.
+ */
+void CodePageTableType::notifyOthers(IBusListener *src, uint64_t paddr,
+                                     uint32_t size) {
+    for (int i = 0; i < total_; i++) {
+        if (harts_[i] != src) {
+            harts_[i]->writeNotify(paddr, size);
+        }
+    }
+}
+
+}  // namespace debugger
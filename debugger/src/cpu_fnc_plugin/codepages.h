@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Code pages of the harts sharing memory.
+ *
+ * @details    Bus transactions are reported to every hart by the bus, but
+ *             the direct memory writes are seen only by the writer. Pages
+ *             with the instructions decoded by any hart of the bus are
+ *             marked, and direct writes into the marked pages are passed
+ *             to the other harts, so their decoded instructions and
+ *             blocks are invalidated too. Marks are hashed by
+ *             the page number and never cleared, a false hit only costs
+ *             the extra notification.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_CODEPAGES_H__
+#define __DEBUGGER_CPU_RISCV_CODEPAGES_H__
+
+#include "api_types.h"
+#include "coreservices/ibuslistener.h"
+
+namespace debugger {
+
+class CodePageTableType {
+public:
+    /**
+     * @brief Get code pages table of the harts.
+     * @param[in] name Bus name. Table is created on the first request.
+     *                 Must be called from postinitService() only.
+     */
+    static CodePageTableType *attach(const char *name);
+
+    /** @return false if table is full and the hart isn't notified */
+    bool registerHart(IBusListener *hart);
+
+    /** Hart decodes instructions of the page, called before the fetch */
+    void markCode(uint64_t paddr) {
+        volatile uint8_t *m = &marked_[(paddr >> PAGE_BITS) % PAGE_TOTAL];
+        if (*m == 0) {
+            *m = 1;
+            RISCV_memory_barrier();
+        }
+    }
+
+    /**
+     * @brief Direct write of the hart inside of one page.
+     * @details Called after the write and a memory barrier (reservations
+     *          invalidation), so either the write is seen by the fetch or
+     *          the mark is seen here.
+     */
+    void writeNotify(IBusListener *src, uint64_t paddr, uint32_t size) {
+        if (total_ > 1 && marked_[(paddr >> PAGE_BITS) % PAGE_TOTAL]) {
+            notifyOthers(src, paddr, size);
+        }
+    }
+
+private:
+    explicit CodePageTableType(const char *name);
+
+    void notifyOthers(IBusListener *src, uint64_t paddr, uint32_t size);
+
+    static const int HARTS_MAX = 32;
+    static const int PAGE_BITS = 12;
+    static const int PAGE_TOTAL = 1 << 16;
+
+    char name_[64];
+    CodePageTableType *next_;
+    int total_;
+    IBusListener *harts_[HARTS_MAX];
+    volatile uint8_t marked_[PAGE_TOTAL];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_CODEPAGES_H__
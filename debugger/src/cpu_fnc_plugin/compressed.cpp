@@ -0,0 +1,333 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Compressed instructions (extension C) decoder.
+ */
+
+#include <string.h>
+#include "riscv-isa.h"
+#include "compressed.h"
+
+namespace debugger {
+
+/** @name Major opcodes of the expanded instructions */
+/// @{
+static const uint32_t OPCODE_LOAD = 0x03;
+static const uint32_t OPCODE_LOAD_FP = 0x07;
+static const uint32_t OPCODE_OP_IMM = 0x13;
+static const uint32_t OPCODE_OP_IMM_32 = 0x1b;
+static const uint32_t OPCODE_STORE = 0x23;
+static const uint32_t OPCODE_STORE_FP = 0x27;
+static const uint32_t OPCODE_OP = 0x33;
+static const uint32_t OPCODE_LUI = 0x37;
+static const uint32_t OPCODE_OP_32 = 0x3b;
+static const uint32_t OPCODE_BRANCH = 0x63;
+static const uint32_t OPCODE_JALR = 0x67;
+static const uint32_t OPCODE_JAL = 0x6f;
+/// @}
+
+static const uint32_t INSTR_NOP = 0x00000013;     // addi x0,x0,0
+static const uint32_t INSTR_EBREAK = 0x00100073;
+
+/** Bit field [hi:lo] of the parcel */
+static inline uint32_t fld(uint32_t v, int hi, int lo) {
+    return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+/** Sign extension of the 'width' bits value */
+static inline int32_t sext(uint32_t v, int width) {
+    return static_cast<int32_t>(v << (32 - width)) >> (32 - width);
+}
+
+static uint32_t encR(uint32_t opcode, uint32_t rd, uint32_t funct3,
+                     uint32_t rs1, uint32_t rs2, uint32_t funct7) {
+    return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12)
+         | (rd << 7) | opcode;
+}
+
+static uint32_t encI(uint32_t opcode, uint32_t rd, uint32_t funct3,
+                     uint32_t rs1, int32_t imm) {
+    return (static_cast<uint32_t>(imm & 0xfff) << 20) | (rs1 << 15)
+         | (funct3 << 12) | (rd << 7) | opcode;
+}
+
+static uint32_t encS(uint32_t opcode, uint32_t funct3, uint32_t rs1,
+                     uint32_t rs2, uint32_t imm) {
+    return (fld(imm, 11, 5) << 25) | (rs2 << 20) | (rs1 << 15)
+         | (funct3 << 12) | (fld(imm, 4, 0) << 7) | opcode;
+}
+
+static uint32_t encB(uint32_t funct3, uint32_t rs1, int32_t off) {
+    uint32_t imm = static_cast<uint32_t>(off);
+    return (fld(imm, 12, 12) << 31) | (fld(imm, 10, 5) << 25)
+         | (rs1 << 15) | (funct3 << 12) | (fld(imm, 4, 1) << 8)
+         | (fld(imm, 11, 11) << 7) | OPCODE_BRANCH;
+}
+
+static uint32_t encJ(uint32_t rd, int32_t off) {
+    uint32_t imm = static_cast<uint32_t>(off);
+    return (fld(imm, 20, 20) << 31) | (fld(imm, 10, 1) << 21)
+         | (fld(imm, 11, 11) << 20) | (fld(imm, 19, 12) << 12)
+         | (rd << 7) | OPCODE_JAL;
+}
+
+CompressedTableType::CompressedTableType() {
+    table_ = new CompressedEntryType[TABLE_SIZE];
+    memset(table_, 0, TABLE_SIZE * sizeof(CompressedEntryType));
+}
+
+CompressedTableType::~CompressedTableType() {
+    delete [] table_;
+}
+
+void CompressedTableType::setEntry(uint32_t parcel, uint32_t payload,
+                                   IInstruction *instr) {
+    CompressedEntryType *e = &table_[parcel & 0xffff];
+    e->instr = instr;
+    e->payload = payload;
+    switch (payload & 0x7f) {
+    case OPCODE_BRANCH:
+        e->kind = Compressed_Branch;
+        break;
+    case OPCODE_JAL:
+    case OPCODE_JALR:
+        e->kind = Compressed_Jump;
+        break;
+    default:
+        e->kind = Compressed_Seq;
+    }
+}
+
+/**
+ * Compressed branches compare rs1' with x0 and are evaluated here: the
+ * expanded handler doesn't allow to distinguish taken branch with the
+ * offset 4 from the not taken one.
+ */
+void CompressedTableType::exec(uint32_t *payload, CpuContextType *data) {
+    CompressedEntryType *e = &table_[payload[0] & 0xffff];
+    if (e->kind == Compressed_Branch) {
+        ISA_SB_type u;
+        u.value = e->payload;
+        bool taken = (data->regs[u.bits.rs1] == 0) == (u.bits.funct3 == 0);
+        if (taken) {
+            uint64_t imm = (u.bits.imm12 << 12) | (u.bits.imm11 << 11)
+                    | (u.bits.imm10_5 << 5) | (u.bits.imm4_1 << 1);
+            if (u.bits.imm12) {
+                imm |= EXT_SIGN_12;
+            }
+            data->npc = data->pc + imm;
+        } else {
+            data->npc = data->pc + 2;
+        }
+        return;
+    }
+
+    e->instr->exec(&e->payload, data);
+    if (e->kind == Compressed_Jump) {
+        // Link register points to the instruction following C.JALR
+        uint32_t rd = fld(e->payload, 11, 7);
+        if (rd != 0) {
+            data->regs[rd] = data->pc + 2;
+        }
+    } else {
+        data->npc = data->pc + 2;
+    }
+}
+
+/**
+ * HINT encodings (rd = x0) are expanded into NOP because the integer
+ * instruction handlers don't check destination register x0.
+ */
+bool CompressedTableType::expand(uint32_t c, uint32_t *payload) {
+    uint32_t funct3 = fld(c, 15, 13);
+    uint32_t rd = fld(c, 11, 7);            // rd or rs1
+    uint32_t rs2 = fld(c, 6, 2);
+    uint32_t rdp = fld(c, 4, 2) + 8;        // rd' or rs2'
+    uint32_t rs1p = fld(c, 9, 7) + 8;       // rs1' or rd'
+    int32_t imm6 = sext((fld(c, 12, 12) << 5) | fld(c, 6, 2), 6);
+    uint32_t shamt = (fld(c, 12, 12) << 5) | fld(c, 6, 2);
+    uint32_t uimm;
+    int32_t imm;
+
+    switch (((c & 0x3) << 3) | funct3) {
+    // Quadrant 0
+    case 0x00:      // C.ADDI4SPN
+        uimm = (fld(c, 12, 11) << 4) | (fld(c, 10, 7) << 6)
+             | (fld(c, 6, 6) << 2) | (fld(c, 5, 5) << 3);
+        if (uimm == 0) {
+            return false;
+        }
+        *payload = encI(OPCODE_OP_IMM, rdp, 0, Reg_sp, uimm);
+        break;
+    case 0x01:      // C.FLD
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 5) << 6);
+        *payload = encI(OPCODE_LOAD_FP, rdp, 3, rs1p, uimm);
+        break;
+    case 0x02:      // C.LW
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 6) << 2)
+             | (fld(c, 5, 5) << 6);
+        *payload = encI(OPCODE_LOAD, rdp, 2, rs1p, uimm);
+        break;
+    case 0x03:      // C.LD
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 5) << 6);
+        *payload = encI(OPCODE_LOAD, rdp, 3, rs1p, uimm);
+        break;
+    case 0x05:      // C.FSD
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 5) << 6);
+        *payload = encS(OPCODE_STORE_FP, 3, rs1p, rdp, uimm);
+        break;
+    case 0x06:      // C.SW
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 6) << 2)
+             | (fld(c, 5, 5) << 6);
+        *payload = encS(OPCODE_STORE, 2, rs1p, rdp, uimm);
+        break;
+    case 0x07:      // C.SD
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 6, 5) << 6);
+        *payload = encS(OPCODE_STORE, 3, rs1p, rdp, uimm);
+        break;
+
+    // Quadrant 1
+    case 0x08:      // C.ADDI, C.NOP
+        *payload = rd ? encI(OPCODE_OP_IMM, rd, 0, rd, imm6) : INSTR_NOP;
+        break;
+    case 0x09:      // C.ADDIW
+        if (rd == 0) {
+            return false;
+        }
+        *payload = encI(OPCODE_OP_IMM_32, rd, 0, rd, imm6);
+        break;
+    case 0x0A:      // C.LI
+        *payload = rd ? encI(OPCODE_OP_IMM, rd, 0, 0, imm6) : INSTR_NOP;
+        break;
+    case 0x0B:
+        if (rd == Reg_sp) {
+            // C.ADDI16SP
+            imm = sext((fld(c, 12, 12) << 9) | (fld(c, 6, 6) << 4)
+                     | (fld(c, 5, 5) << 6) | (fld(c, 4, 3) << 7)
+                     | (fld(c, 2, 2) << 5), 10);
+            if (imm == 0) {
+                return false;
+            }
+            *payload = encI(OPCODE_OP_IMM, Reg_sp, 0, Reg_sp, imm);
+        } else {
+            // C.LUI
+            if (imm6 == 0) {
+                return false;
+            }
+            *payload = rd ? ((static_cast<uint32_t>(imm6) << 12)
+                             | (rd << 7) | OPCODE_LUI)
+                          : INSTR_NOP;
+        }
+        break;
+    case 0x0C:
+        switch (fld(c, 11, 10)) {
+        case 0:     // C.SRLI
+            *payload = encI(OPCODE_OP_IMM, rs1p, 5, rs1p, shamt);
+            break;
+        case 1:     // C.SRAI
+            *payload = encI(OPCODE_OP_IMM, rs1p, 5, rs1p, 0x400 | shamt);
+            break;
+        case 2:     // C.ANDI
+            *payload = encI(OPCODE_OP_IMM, rs1p, 7, rs1p, imm6);
+            break;
+        default:
+            if (fld(c, 12, 12) == 0) {
+                // C.SUB, C.XOR, C.OR, C.AND
+                static const uint32_t F3[4] = {0, 4, 6, 7};
+                uint32_t sel = fld(c, 6, 5);
+                *payload = encR(OPCODE_OP, rs1p, F3[sel], rs1p, rdp,
+                                sel == 0 ? 0x20 : 0);
+            } else if (fld(c, 6, 5) == 0) {
+                // C.SUBW
+                *payload = encR(OPCODE_OP_32, rs1p, 0, rs1p, rdp, 0x20);
+            } else if (fld(c, 6, 5) == 1) {
+                // C.ADDW
+                *payload = encR(OPCODE_OP_32, rs1p, 0, rs1p, rdp, 0);
+            } else {
+                return false;
+            }
+        }
+        break;
+    case 0x0D:      // C.J
+        imm = sext((fld(c, 12, 12) << 11) | (fld(c, 11, 11) << 4)
+                 | (fld(c, 10, 9) << 8) | (fld(c, 8, 8) << 10)
+                 | (fld(c, 7, 7) << 6) | (fld(c, 6, 6) << 7)
+                 | (fld(c, 5, 3) << 1) | (fld(c, 2, 2) << 5), 12);
+        *payload = encJ(0, imm);
+        break;
+    case 0x0E:      // C.BEQZ
+    case 0x0F:      // C.BNEZ
+        imm = sext((fld(c, 12, 12) << 8) | (fld(c, 11, 10) << 3)
+                 | (fld(c, 6, 5) << 6) | (fld(c, 4, 3) << 1)
+                 | (fld(c, 2, 2) << 5), 9);
+        *payload = encB(funct3 & 0x1, rs1p, imm);
+        break;
+
+    // Quadrant 2
+    case 0x10:      // C.SLLI
+        *payload = rd ? encI(OPCODE_OP_IMM, rd, 1, rd, shamt) : INSTR_NOP;
+        break;
+    case 0x11:      // C.FLDSP
+        uimm = (fld(c, 12, 12) << 5) | (fld(c, 6, 5) << 3)
+             | (fld(c, 4, 2) << 6);
+        *payload = encI(OPCODE_LOAD_FP, rd, 3, Reg_sp, uimm);
+        break;
+    case 0x12:      // C.LWSP
+        if (rd == 0) {
+            return false;
+        }
+        uimm = (fld(c, 12, 12) << 5) | (fld(c, 6, 4) << 2)
+             | (fld(c, 3, 2) << 6);
+        *payload = encI(OPCODE_LOAD, rd, 2, Reg_sp, uimm);
+        break;
+    case 0x13:      // C.LDSP
+        if (rd == 0) {
+            return false;
+        }
+        uimm = (fld(c, 12, 12) << 5) | (fld(c, 6, 5) << 3)
+             | (fld(c, 4, 2) << 6);
+        *payload = encI(OPCODE_LOAD, rd, 3, Reg_sp, uimm);
+        break;
+    case 0x14:
+        if (fld(c, 12, 12) == 0) {
+            if (rs2 == 0) {
+                // C.JR
+                if (rd == 0) {
+                    return false;
+                }
+                *payload = encI(OPCODE_JALR, 0, 0, rd, 0);
+            } else {
+                // C.MV
+                *payload = rd ? encR(OPCODE_OP, rd, 0, 0, rs2, 0)
+                              : INSTR_NOP;
+            }
+        } else if (rs2 == 0) {
+            // C.EBREAK, C.JALR
+            *payload = rd ? encI(OPCODE_JALR, Reg_ra, 0, rd, 0)
+                          : INSTR_EBREAK;
+        } else {
+            // C.ADD
+            *payload = rd ? encR(OPCODE_OP, rd, 0, rd, rs2, 0) : INSTR_NOP;
+        }
+        break;
+    case 0x15:      // C.FSDSP
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 9, 7) << 6);
+        *payload = encS(OPCODE_STORE_FP, 3, Reg_sp, rs2, uimm);
+        break;
+    case 0x16:      // C.SWSP
+        uimm = (fld(c, 12, 9) << 2) | (fld(c, 8, 7) << 6);
+        *payload = encS(OPCODE_STORE, 2, Reg_sp, rs2, uimm);
+        break;
+    case 0x17:      // C.SDSP
+        uimm = (fld(c, 12, 10) << 3) | (fld(c, 9, 7) << 6);
+        *payload = encS(OPCODE_STORE, 3, Reg_sp, rs2, uimm);
+        break;
+    default:
+        // Reserved quadrant 0 funct3=4 or 32-bits instruction
+        return false;
+    }
+    return true;
+}
+
+}  // namespace debugger
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Compressed instructions (extension C) decoder.
+ *
+ * @details    Each 16-bit parcel is expanded into its 32-bit equivalent
+ *             once on initialization and decoded by the common decoder,
+ *             so the flat table of 64K entries maps any parcel directly to
+ *             the handler of the expanded instruction. The table itself
+ *             is the single handler of all compressed instructions: it
+ *             executes the expanded instruction and corrects the next pc
+ *             and the link register for the 2-bytes instruction length.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_COMPRESSED_H__
+#define __DEBUGGER_CPU_RISCV_COMPRESSED_H__
+
+#include <inttypes.h>
+#include "iinstr.h"
+
+namespace debugger {
+
+enum ECompressedKind {
+    Compressed_Seq,         // next pc is pc + 2
+    Compressed_Jump,        // C.J, C.JR, C.JALR
+    Compressed_Branch       // C.BEQZ, C.BNEZ
+};
+
+struct CompressedEntryType {
+    IInstruction *instr;    // expanded instruction handler, NULL if illegal
+    uint32_t payload;       // expanded instruction
+    uint32_t kind;          // ECompressedKind
+};
+
+class CompressedTableType : public IInstruction {
+public:
+    CompressedTableType();
+    virtual ~CompressedTableType();
+
+    /** IInstruction interface */
+    virtual const char *name() { return "RVC"; }
+    virtual bool parse(uint32_t *payload) {
+        return decode(payload[0]) != 0;
+    }
+    virtual void exec(uint32_t *payload, CpuContextType *data);
+    virtual uint32_t hash() { return 0; }
+
+    /**
+     * @brief Expand RV64C parcel into the equivalent 32-bits instruction.
+     * @return false if the parcel is reserved or illegal.
+     */
+    static bool expand(uint32_t parcel, uint32_t *payload);
+
+    /** Register handler of the expanded instruction */
+    void setEntry(uint32_t parcel, uint32_t payload, IInstruction *instr);
+
+    /** Handler of the compressed instruction or NULL if it's illegal */
+    IInstruction *decode(uint32_t parcel) {
+        if ((parcel & 0x3) == 0x3 || !table_[parcel & 0xffff].instr) {
+            return 0;
+        }
+        return this;
+    }
+
+    /** Expanded equivalent of the compressed instruction */
+    uint32_t expanded(uint32_t parcel) {
+        return table_[parcel & 0xffff].payload;
+    }
+
+    /** Instruction length in bytes */
+    static uint32_t length(uint32_t payload) {
+        return (payload & 0x3) == 0x3 ? 4 : 2;
+    }
+
+private:
+    static const int TABLE_SIZE = 1 << 16;
+
+    CompressedEntryType *table_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_COMPRESSED_H__
@@ -18,6 +18,7 @@ void addIsaUserRV64I(CpuContextType *data, AttributeType *out);
 void addIsaPrivilegedRV64I(CpuContextType *data, AttributeType *out);
 void addIsaExtensionA(CpuContextType *data, AttributeType *out);
 void addIsaExtensionF(CpuContextType *data, AttributeType *out);
+void addIsaExtensionD(CpuContextType *data, AttributeType *out);
 void addIsaExtensionM(CpuContextType *data, AttributeType *out);
 
 void generateException(uint64_t code, CpuContextType *data);
@@ -32,6 +33,11 @@ CpuRiscV_Functional::CpuRiscV_Functional(const char *name)
     registerInterface(static_cast<IThread *>(this));
     registerInterface(static_cast<ICpuRiscV *>(this));
     registerInterface(static_cast<IClock *>(this));
+    registerInterface(static_cast<IBusListener *>(this));
+    registerInterface(static_cast<ISnapshot *>(this));
+    registerInterface(static_cast<IReplayInput *>(this));
+    registerInterface(static_cast<IReplayHart *>(this));
+    registerInterface(static_cast<IProfiler *>(this));
     registerInterface(static_cast<IHap *>(this));
     registerAttribute("Enable", &isEnable_);
     registerAttribute("Bus", &bus_);
@@ -40,6 +46,11 @@ CpuRiscV_Functional::CpuRiscV_Functional(const char *name)
     registerAttribute("GenerateRegTraceFile", &generateRegTraceFile_);
     registerAttribute("GenerateMemTraceFile", &generateMemTraceFile_);
     registerAttribute("ResetVector", &resetVector_);
+    registerAttribute("ExecEngine", &execEngine_);
+    registerAttribute("HartId", &hartId_);
+    registerAttribute("Quantum", &quantum_);
+    registerAttribute("ProfileEnable", &profileEnable_);
+    registerAttribute("ProfilePeriod", &profilePeriod_);
 
     isEnable_.make_boolean(true);
     bus_.make_string("");
@@ -48,11 +59,26 @@ CpuRiscV_Functional::CpuRiscV_Functional(const char *name)
     generateRegTraceFile_.make_boolean(false);
     generateMemTraceFile_.make_boolean(false);
     resetVector_.make_uint64(0x1000);
+    execEngine_.make_string("Interpreter");
+    hartId_.make_uint64(0);
+    quantum_.make_uint64(0);
+    profileEnable_.make_boolean(false);
+    profilePeriod_.make_uint64(10000);
 
     cpu_context_.step_cnt = 0;
     cpu_context_.stack_trace_cnt = 0;
-
-    RISCV_event_create(&config_done_, "config_done");
+    cpu_context_.dmi = 0;
+    cpu_context_.reservations = 0;
+    cpu_context_.wfi = false;
+
+    AttributeType t1;
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&config_done_, t1.to_string());
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&quantumDone_, t1.to_string());
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&profDone_, t1.to_string());
+    RISCV_mutex_init(&mutexProf_);
     RISCV_register_hap(static_cast<IHap *>(this));
     cpu_context_.reset   = true;
     dbg_state_ = STATE_Normal;
@@ -63,6 +89,31 @@ CpuRiscV_Functional::CpuRiscV_Functional(const char *name)
     cpu_context_.reg_trace_file = 0;
     cpu_context_.mem_trace_file = 0;
     dport.valid = 0;
+    dport.wp_address = 0;
+    dport.wp_length = 0;
+    dport.wp_hit_address = 0;
+    dport.wp_hit = false;
+    isrc_ = 0;
+    irecorder_ = 0;
+    lastBlock_ = 0;
+    useBlocks_ = false;
+    useHostCode_ = false;
+    queueNextTime_ = 0;
+    asyncBreak_ = 0;
+    dmiRevoked_ = 0;
+    codePages_ = 0;
+    sync_ = 0;
+    syncSlot_ = 0;
+    syncJoined_ = false;
+    quantumEnd_ = ~0ull;
+    replay_ = false;
+    replayEnd_ = 0;
+    replayHit_ = 0;
+    replayHitValid_ = false;
+    profiling_ = false;
+    profNextSample_ = ~0ull;
+    profRequest_ = ProfRequest_None;
+    profResult_ = 0;
 }
 
 CpuRiscV_Functional::~CpuRiscV_Functional() {
@@ -76,6 +127,9 @@ CpuRiscV_Functional::~CpuRiscV_Functional() {
         delete pContext->mem_trace_file;
     }
     RISCV_event_close(&config_done_);
+    RISCV_event_close(&quantumDone_);
+    RISCV_event_close(&profDone_);
+    RISCV_mutex_destroy(&mutexProf_);
 }
 
 void CpuRiscV_Functional::postinitService() {
@@ -89,6 +143,76 @@ void CpuRiscV_Functional::postinitService() {
                     bus_.to_string());
         return;
     }
+    pContext->ibus->registerBusListener(static_cast<IBusListener *>(this));
+    watchpoints_.init(static_cast<IWatchpointListener *>(this));
+    codePages_ = CodePageTableType::attach(bus_.to_string());
+    if (!codePages_->registerHart(static_cast<IBusListener *>(this))) {
+        RISCV_error("Too many harts on bus '%s', code writes of the "
+                    "other harts aren't seen", bus_.to_string());
+    }
+    dmi_.init(pContext->ibus, static_cast<IBusListener *>(this), codePages_,
+              &watchpoints_, pContext);
+    pContext->dmi = &dmi_;
+    pContext->reservations = ReservationTableType::attach(bus_.to_string());
+    pContext->reserve_slot = pContext->reservations->registerHart();
+    if (pContext->reserve_slot < 0) {
+        RISCV_error("Too many harts on bus '%s', LR/SC aren't shared",
+                    bus_.to_string());
+        pContext->reservations = 0;
+    }
+
+    // Apply configuration attributes (reset vector, hart id)
+    reset();
+
+    if (quantum_.to_uint64()) {
+        sync_ = QuantumSyncType::attach(bus_.to_string());
+        syncSlot_ = sync_->registerHart(&quantumDone_);
+        if (syncSlot_ < 0) {
+            RISCV_error("Too many harts on bus '%s', quantum disabled",
+                        bus_.to_string());
+            sync_ = 0;
+        }
+    }
+
+    if (execEngine_.is_equal("BlockInterpreter")) {
+        useBlocks_ = true;
+    } else if (execEngine_.is_equal("Translator")) {
+        // Memory trace is written by the load handlers
+        DmiLoadPathType load;
+        dmi_.getLoadPath(&load);
+        useBlocks_ = true;
+        useHostCode_ = hostCode_.init(generateMemTraceFile_.to_bool()
+                                      ? NULL : &load);
+        if (!useHostCode_) {
+            RISCV_error("Host code can't be generated, use BlockInterpreter",
+                        NULL);
+        }
+    } else if (!execEngine_.is_equal("Interpreter")) {
+        RISCV_error("Unsupported ExecEngine '%s', use Interpreter",
+                    execEngine_.to_string());
+    }
+
+    // Profiling from the start of simulation (batch runs without console):
+    if (profileEnable_.to_bool()) {
+        profRequest_ = ProfRequest_Start;
+    }
+
+    // Disassembler is optional and used only for the debug messages:
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SOURCE_CODE, &lstServ);
+    if (lstServ.size() != 0) {
+        IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        isrc_ = static_cast<ISourceCode *>(
+                            iserv->getInterface(IFACE_SOURCE_CODE));
+    }
+
+    // Debug port writes are logged for the reverse execution:
+    RISCV_get_services_with_iface(IFACE_INPUT_RECORDER, &lstServ);
+    if (lstServ.size() != 0) {
+        IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        irecorder_ = static_cast<IInputRecorder *>(
+                            iserv->getInterface(IFACE_INPUT_RECORDER));
+    }
 
     // Supported instruction sets:
     for (int i = 0; i < INSTR_HASH_TABLE_SIZE; i++) {
@@ -101,10 +225,18 @@ void CpuRiscV_Functional::postinitService() {
             addIsaExtensionA(pContext, listInstr_);
         } else if (listExtISA_[i].to_string()[0] == 'F') {
             addIsaExtensionF(pContext, listInstr_);
+        } else if (listExtISA_[i].to_string()[0] == 'D') {
+            addIsaExtensionD(pContext, listInstr_);
         } else if (listExtISA_[i].to_string()[0] == 'M') {
             addIsaExtensionM(pContext, listInstr_);
         }
     }
+    // Compressed instructions are expanded into the enabled extensions
+    for (unsigned i = 0; i < listExtISA_.size(); i++) {
+        if (listExtISA_[i].to_string()[0] == 'C') {
+            addIsaExtensionC();
+        }
+    }
 
     // Get global settings:
     const AttributeType *glb = RISCV_get_global_settings();
@@ -114,11 +246,20 @@ void CpuRiscV_Functional::postinitService() {
             return;
         }
 
+        // Binary traces, use 'trace_decoder' to get text files:
         if (generateRegTraceFile_.to_bool()) {
-            pContext->reg_trace_file = new std::ofstream("river_func_regs.log");
+            pContext->reg_trace_file = new BinTraceWriter;
+            if (!pContext->reg_trace_file->open("river_func_regs.bin")) {
+                delete pContext->reg_trace_file;
+                pContext->reg_trace_file = 0;
+            }
         }
         if (generateMemTraceFile_.to_bool()) {
-            pContext->mem_trace_file = new std::ofstream("river_func_mem.log");
+            pContext->mem_trace_file = new BinTraceWriter;
+            if (!pContext->mem_trace_file->open("river_func_mem.bin")) {
+                delete pContext->mem_trace_file;
+                pContext->mem_trace_file = 0;
+            }
         }
     }
 }
@@ -132,12 +273,74 @@ void CpuRiscV_Functional::busyLoop() {
     RISCV_event_wait(&config_done_);
 
     while (isEnabled()) {
-        updatePipeline();
+        // Arrivals after this point will break the next batch
+        RISCV_atomic_xchg64(&asyncBreak_, 0);
+        if (dmiRevoked_ && RISCV_atomic_xchg64(&dmiRevoked_, 0)) {
+            dmi_.flush();
+        }
+        if (profRequest_ != ProfRequest_None) {
+            updateProfiler();
+        }
+        if (sync_) {
+            updateQuantumGroup();
+        }
+        if (isBatchAllowed()) {
+            updateBatch();
+        } else {
+            updatePipeline();
+        }
+    }
+    if (syncJoined_) {
+        sync_->leave(syncSlot_);
+        syncJoined_ = false;
+    }
+}
+
+/**
+ * Only running harts take part in quantum synchronization, so halted or
+ * reset hart doesn't block the others.
+ */
+void CpuRiscV_Functional::updateQuantumGroup() {
+    CpuContextType *pContext = getpContext();
+    bool running = isRunning() && !pContext->reset;
+    if (running == syncJoined_) {
+        return;
     }
+    syncJoined_ = running;
+    if (running) {
+        RISCV_event_clear(&quantumDone_);
+        sync_->join(syncSlot_);
+        quantumEnd_ = pContext->step_cnt + quantum_.to_uint64();
+    } else {
+        sync_->leave(syncSlot_);
+        quantumEnd_ = ~0ull;
+    }
+    queueNextTime_ = 0;     // re-calculate horizon
+}
+
+/**
+ * Wait until all running harts reach the quantum boundary. Step callbacks
+ * (timers and interrupts) are processed only after the synchronization,
+ * so they see all harts at the same step. Memory accesses of the harts
+ * inside of the quantum aren't ordered.
+ */
+void CpuRiscV_Functional::syncQuantum() {
+    uint64_t epoch = sync_->arrive(syncSlot_);
+    while (!sync_->isReleased(epoch) && isEnabled()) {
+        RISCV_event_wait_ms(&quantumDone_, 10);
+    }
+    RISCV_event_clear(&quantumDone_);
+    quantumEnd_ = getpContext()->step_cnt + quantum_.to_uint64();
+}
+
+void CpuRiscV_Functional::stop() {
+    RISCV_event_clear(&loopEnable_);
+    breakBatch();
+    IThread::stop();
 }
 
 void CpuRiscV_Functional::updatePipeline() {
-    IInstruction *instr;
+    IInstruction *instr = NULL;
     CpuContextType *pContext = getpContext();
 
     if (dport.valid) {
@@ -146,29 +349,33 @@ void CpuRiscV_Functional::updatePipeline() {
     }
 
     pContext->pc = pContext->npc;
-    if (isRunning()) {
-        fetchInstruction();
+    if (pContext->wfi && pContext->interrupt_pending) {
+        pContext->wfi = false;
+    }
+    if (isRunning() && !pContext->wfi && !checkBreakpoint(pContext->pc)) {
+        instr = fetchInstruction();
     }
 
     updateState();
     if (pContext->reset) {
         updateQueue();
         reset();
+        if (irecorder_) {
+            irecorder_->resetHistory();
+        }
         return;
     } 
 
-    instr = decodeInstruction(cacheline_);
     if (isRunning()) {
         last_hit_breakpoint_ = ~0;
         if (instr) {
             executeInstruction(instr, cacheline_);
-        } else {
-            pContext->npc += 4;
-            generateException(EXCEPTION_InstrIllegal, pContext);
-
-            RISCV_info("[%" RV_PRI64 "d] pc:%08x: %08x \t illegal instruction",
-                        getStepCounter(),
-                        static_cast<uint32_t>(pContext->pc), cacheline_[0]);
+        } else if (!pContext->exception && !pContext->wfi) {
+            illegalInstruction();
+        }
+        if (profiling_) {
+            profile(pContext->pc, pContext->wfi ? 0 : 1,
+                    pContext->wfi ? 1 : 0);
         }
     }
 
@@ -177,6 +384,274 @@ void CpuRiscV_Functional::updatePipeline() {
     handleTrap();
 }
 
+void CpuRiscV_Functional::illegalInstruction() {
+    CpuContextType *pContext = getpContext();
+    pContext->npc += 4;
+    generateException(EXCEPTION_InstrIllegal, pContext);
+
+    RISCV_info("[%" RV_PRI64 "d] pc:%08x: %08x \t illegal instruction",
+                getStepCounter(),
+                static_cast<uint32_t>(pContext->pc), cacheline_[0]);
+}
+
+/**
+ * Instructions are executed in batches only in the normal running state.
+ * Any other case (debug port request, stepping, reset, injected breakpoint
+ * or trace generation) is handled instruction by instruction.
+ */
+bool CpuRiscV_Functional::isBatchAllowed() {
+    CpuContextType *pContext = getpContext();
+    return dbg_state_ == STATE_Normal
+        && !dport.valid
+        && !pContext->reset
+        && !pContext->br_inject_fetch
+        && !pContext->reg_trace_file
+        && !generateRegTraceFile_.to_bool();
+}
+
+/**
+ * Execute instructions up to the event horizon: the nearest step callback
+ * time, trap or asynchronous request (debug port, signal or new step
+ * callback registration) that sets asyncBreak_ flag. Each instruction
+ * behaves exactly as in updatePipeline(), so step_cnt and the callbacks
+ * order stay the same, only per-instruction checks are omitted.
+ */
+void CpuRiscV_Functional::updateBatch() {
+    CpuContextType *pContext = getpContext();
+    do {
+        uint64_t pc = pContext->npc;
+        uint64_t t0 = pContext->step_cnt;
+        uint64_t t1 = t0;
+        if (pContext->wfi) {
+            pc = pContext->pc;
+            waitInterrupt();
+        } else {
+            if (useBlocks_) {
+                executeBlock();
+            } else {
+                executeStep();
+            }
+            t1 = pContext->step_cnt;
+            if (pContext->npc == pContext->pc) {
+                skipIdleLoop();
+            }
+        }
+        if (profiling_) {
+            // Skipped steps are stalls of the block that entered the wait
+            profile(pc, t1 - t0, pContext->step_cnt - t1);
+        }
+    } while (pContext->step_cnt < queueNextTime_
+        && !asyncBreak_
+        && !queue_.isPreQueued()
+        && !pContext->exception && !pContext->interrupt);
+
+    if (pContext->regs[0] != 0) {
+        RISCV_error("Register x0 was modificated (not equal to zero)", NULL);
+    }
+    if (isRunning()) {
+        last_hit_breakpoint_ = ~0;
+    }
+
+    if (pContext->step_cnt >= queueNextTime_ || queue_.isPreQueued()) {
+        updateQueue();
+    }
+
+    handleTrap();
+}
+
+/**
+ * Profiler state is changed only by the CPU thread between batches, so the
+ * hot path checks a single flag. Without running thread the request is
+ * executed in the caller context.
+ */
+void CpuRiscV_Functional::profileRequest(EProfRequest req,
+                                         AttributeType *res) {
+    RISCV_mutex_lock(&mutexProf_);
+    RISCV_event_clear(&profDone_);
+    profResult_ = res;
+    profRequest_ = req;
+    if (!isEnabled()) {
+        updateProfiler();
+    } else {
+        breakBatch();
+        while (profRequest_ != ProfRequest_None && isEnabled()) {
+            RISCV_event_wait_ms(&profDone_, 10);
+        }
+    }
+    RISCV_mutex_unlock(&mutexProf_);
+}
+
+void CpuRiscV_Functional::updateProfiler() {
+    uint64_t period = profilePeriod_.to_uint64();
+    switch (profRequest_) {
+    case ProfRequest_Start:
+        if (!profiling_) {
+            profNextSample_ = period ? getpContext()->step_cnt + period
+                                     : ~0ull;
+            profiling_ = true;
+        }
+        break;
+    case ProfRequest_Stop:
+        profiling_ = false;
+        break;
+    case ProfRequest_Reset:
+        profile_.clear();
+        break;
+    case ProfRequest_Get:
+        profResult_->make_list(Profile_Total);
+        profile_.getHistogram(&(*profResult_)[Profile_Histogram]);
+        profile_.getStacks(&(*profResult_)[Profile_Stacks]);
+        break;
+    default:;
+    }
+    profRequest_ = ProfRequest_None;
+    RISCV_event_set(&profDone_);
+}
+
+/**
+ * Call stack is taken from the return addresses trace: call sites in the
+ * call order and the next instruction of the current function. Weight is
+ * the number of sample periods passed since the previous sample, so the
+ * skipped idle loops aren't lost.
+ */
+void CpuRiscV_Functional::sampleStack() {
+    CpuContextType *pContext = getpContext();
+    uint64_t frame[STACK_TRACE_BUF_SIZE / 2 + 1];
+    uint64_t period = profilePeriod_.to_uint64();
+    uint64_t weight = (pContext->step_cnt - profNextSample_) / period + 1;
+    profNextSample_ += weight * period;
+
+    int depth = pContext->stack_trace_cnt;
+    if (depth > STACK_TRACE_BUF_SIZE / 2) {
+        depth = STACK_TRACE_BUF_SIZE / 2;
+    } else if (depth < 0) {
+        depth = 0;
+    }
+    for (int i = 0; i < depth; i++) {
+        frame[i] = pContext->stack_trace_buf[2*i];
+    }
+    frame[depth] = pContext->npc;
+    profile_.addStack(frame, depth + 1, weight);
+}
+
+/**
+ * Stalled hart only counts steps, so the counter is moved directly to the
+ * nearest step callback where an interrupt may be raised. Without any
+ * scheduled callback only an asynchronous signal can wake the hart.
+ */
+void CpuRiscV_Functional::waitInterrupt() {
+    CpuContextType *pContext = getpContext();
+    if (pContext->interrupt_pending || pContext->interrupt) {
+        pContext->wfi = false;
+        return;
+    }
+    if (queueNextTime_ != ~0ull) {
+        fastForward();
+    } else {
+        pContext->step_cnt++;
+    }
+}
+
+/**
+ * Branch or jump onto itself doesn't modify registers or memory, so it
+ * repeats with the same result until the nearest step callback. The step
+ * counter and pc are the same as after the executed loop.
+ */
+void CpuRiscV_Functional::skipIdleLoop() {
+    CpuContextType *pContext = getpContext();
+    uint32_t payload = cacheline_[0];
+    if ((payload & 0x3) != 0x3) {
+        payload = compressed_.expanded(payload);
+    }
+    switch (payload & 0x7f) {
+    case 0x63:      // BRANCH, C.BEQZ, C.BNEZ
+    case 0x6f:      // JAL, C.J
+        break;
+    default:
+        return;
+    }
+    if (queueNextTime_ == ~0ull
+        || pContext->exception || pContext->interrupt
+        || queue_.isPreQueued() || asyncBreak_
+        || breakpoints_.isBreakpoint(pContext->pc)) {
+        return;
+    }
+    fastForward();
+}
+
+void CpuRiscV_Functional::fastForward() {
+    CpuContextType *pContext = getpContext();
+    if (pContext->step_cnt < queueNextTime_) {
+        pContext->step_cnt = queueNextTime_;
+    }
+}
+
+void CpuRiscV_Functional::executeStep() {
+    CpuContextType *pContext = getpContext();
+    pContext->pc = pContext->npc;
+    if (checkBreakpoint(pContext->pc)) {
+        return;
+    }
+    IInstruction *instr = fetchDecoded(pContext->pc, cacheline_);
+    pContext->step_cnt++;
+    if (instr) {
+        instr->exec(cacheline_, pContext);
+    } else if (!pContext->exception) {
+        illegalInstruction();
+    }
+}
+
+/**
+ * Execute basic block started from npc. Block execution is interrupted
+ * after the instruction that has raised trap, modified code of the block,
+ * hit data watchpoint, registered new step callback or reached the nearest
+ * callback time. Translated run can't raise trap or modify memory, so the
+ * checks are done after its last instruction. The run is used only when
+ * it ends before the nearest callback time. After a side exit the rest
+ * of the run is executed by handlers.
+ */
+void CpuRiscV_Functional::executeBlock() {
+    CpuContextType *pContext = getpContext();
+    if (checkBreakpoint(pContext->npc)) {
+        pContext->pc = pContext->npc;
+        return;
+    }
+    DecodedBlockType *blk = getBlock(pContext->npc);
+    if (blk == 0) {
+        executeStep();
+        return;
+    }
+
+    int i = 0;
+    int last = blk->size - 1;
+    while (1) {
+        HostCodeFunc host = blk->host[i];
+        int done = 0;
+        if (host && pContext->step_cnt + blk->host_len[i] <= queueNextTime_) {
+            done = host(pContext);
+        }
+        if (done && done == blk->host_len[i]) {
+            i += done - 1;
+        } else {
+            // Side exit: the load of the run is executed by handler
+            i += done;
+            PredecodedInstrType *p = &blk->instr[i];
+            pContext->pc = pContext->npc;
+            pContext->step_cnt++;
+            p->instr->exec(&p->payload, pContext);
+        }
+        if (i == last
+            || pContext->exception || pContext->interrupt
+            || pContext->step_cnt >= queueNextTime_
+            || queue_.isPreQueued() || asyncBreak_
+            || !blocks_.isValid(blk)) {
+            break;
+        }
+        i++;
+    }
+    cacheline_[0] = blk->instr[i].payload;
+}
+
 void CpuRiscV_Functional::updateState() {
     CpuContextType *pContext = getpContext();
     bool upd = true;
@@ -201,20 +676,26 @@ void CpuRiscV_Functional::updateQueue() {
     IFace *cb;
     CpuContextType *pContext = getpContext();
 
-    queue_.initProc();
+    if (pContext->step_cnt >= quantumEnd_) {
+        syncQuantum();
+    }
     queue_.pushPreQueued();
         
     while ((cb = queue_.getNext(pContext->step_cnt)) != 0) {
         static_cast<IClockListener *>(cb)->stepCallback(pContext->step_cnt);
     }
+    queueNextTime_ = queue_.getNextTime();
+    if (quantumEnd_ < queueNextTime_) {
+        queueNextTime_ = quantumEnd_;
+    }
 }
 
 void CpuRiscV_Functional::handleTrap() {
     CpuContextType *pContext = getpContext();
     csr_mstatus_type mstatus;
     csr_mcause_type mcause;
-    mstatus.value = pContext->csr[CSR_mstatus];
-    mcause.value =  pContext->csr[CSR_mcause];
+    mstatus.value = pContext->csr[Csr_mstatus];
+    mcause.value =  pContext->csr[Csr_mcause];
 
     if (pContext->exception == 0 && pContext->interrupt == 0) {
         return;
@@ -227,12 +708,18 @@ void CpuRiscV_Functional::handleTrap() {
         && pContext->br_ctrl.bits.trap_on_break == 0) {
         pContext->exception = 0;
         pContext->npc = pContext->pc;
-        halt("EBREAK Breakpoint");
+        if (!replayHit()) {
+            halt("EBREAK Breakpoint");
+        }
         return;
     }
 
+    // Exception is taken on the instruction, so it could be restarted
+    // (page fault). Interrupt is taken after the instruction.
+    bool is_exception = pContext->exception != 0;
     pContext->interrupt = 0;
     pContext->exception = 0;
+    pContext->wfi = false;
 
     // All traps handle via machine mode while CSR mdelegate
     // doesn't setup other.
@@ -241,18 +728,17 @@ void CpuRiscV_Functional::handleTrap() {
     mstatus.bits.MPIE = (mstatus.value >> pContext->cur_prv_level) & 0x1;
     mstatus.bits.MIE = 0;
     pContext->cur_prv_level = PRV_M;
-    pContext->csr[CSR_mstatus] = mstatus.value;
+    pContext->csr[Csr_mstatus] = mstatus.value;
+    pContext->dmi->updateContext();
 
     uint64_t xepc = (pContext->cur_prv_level << 8) + 0x41;
-    if (pContext->exception) {
-        pContext->csr[xepc]    = pContext->pc;
+    if (is_exception) {
+        writeCSR(static_cast<uint32_t>(xepc), pContext->pc, pContext);
     } else {
         // Software interrupt handled after instruction was executed
-        pContext->csr[xepc]    = pContext->npc;
+        writeCSR(static_cast<uint32_t>(xepc), pContext->npc, pContext);
     }
-    pContext->npc = pContext->csr[CSR_mtvec];
-
-    pContext->exception = 0;
+    pContext->npc = pContext->csr[Csr_mtvec];
 }
 
 bool CpuRiscV_Functional::isRunning() {
@@ -267,50 +753,247 @@ void CpuRiscV_Functional::reset() {
     pContext->exception = 0;
     pContext->interrupt = 0;
     pContext->interrupt_pending = 0;
-    pContext->csr[CSR_mvendorid] = 0x0001;   // UC Berkeley Rocket repo
-    pContext->csr[CSR_mhartid] = 0;
-    pContext->csr[CSR_marchid] = 0;
-    pContext->csr[CSR_mimplementationid] = 0;
-    pContext->csr[CSR_mtvec]   = 0x100;     // Hardwired RO value
-    pContext->csr[CSR_mip] = 0;             // clear pending interrupts
-    pContext->csr[CSR_mie] = 0;             // disabling interrupts
-    pContext->csr[CSR_mepc] = 0;
-    pContext->csr[CSR_mcause] = 0;
-    pContext->csr[CSR_medeleg] = 0;
-    pContext->csr[CSR_mideleg] = 0;
-    pContext->csr[CSR_mtime] = 0;
-    pContext->csr[CSR_mtimecmp] = 0;
-    pContext->csr[CSR_uepc] = 0;
-    pContext->csr[CSR_sepc] = 0;
-    pContext->csr[CSR_hepc] = 0;
+    pContext->reserve_addr = ~0ull;
+    pContext->reserve_value = 0;
+    if (pContext->reservations) {
+        pContext->reservations->cancel(pContext->reserve_slot);
+    }
+    pContext->csr[Csr_mvendorid] = 0x0001;   // UC Berkeley Rocket repo
+    pContext->csr[Csr_mhartid] = hartId_.to_uint64();
+    pContext->csr[Csr_marchid] = 0;
+    pContext->csr[Csr_mimplementationid] = 0;
+    pContext->csr[Csr_mtvec]   = 0x100;     // Hardwired RO value
+    pContext->csr[Csr_mip] = 0;             // clear pending interrupts
+    pContext->csr[Csr_mie] = 0;             // disabling interrupts
+    pContext->csr[Csr_mscratch] = 0;
+    pContext->csr[Csr_mcounteren] = 0;
+    pContext->csr[Csr_stvec] = 0;
+    pContext->csr[Csr_sscratch] = 0;
+    pContext->csr_other_cnt = 0;
+    pContext->csr[Csr_mepc] = 0;
+    pContext->csr[Csr_mcause] = 0;
+    pContext->csr[Csr_mbadaddr] = 0;
+    pContext->csr[Csr_medeleg] = 0;
+    pContext->csr[Csr_mideleg] = 0;
+    pContext->csr[Csr_mtime] = 0;
+    pContext->csr[Csr_mtimecmp] = 0;
+    pContext->csr[Csr_uepc] = 0;
+    pContext->csr[Csr_sepc] = 0;
+    pContext->csr[Csr_hepc] = 0;
+    pContext->csr[Csr_fflags] = 0;
+    pContext->csr[Csr_frm] = 0;
+    pContext->csr[Csr_fcsr] = 0;
+    pContext->csr[Csr_satp] = 0;                // Bare, no translation
     csr_mstatus_type mstat;
     mstat.value = 0;
-    pContext->csr[CSR_mstatus] = mstat.value;
+    pContext->csr[Csr_mstatus] = mstat.value;
     pContext->cur_prv_level = PRV_M;           // Current privilege level
+    if (pContext->dmi) {
+        pContext->dmi->updateContext();
+    }
     pContext->step_cnt = 0;
     pContext->br_ctrl.val = 0;
     pContext->br_inject_fetch = false;
+    pContext->wfi = false;
     pContext->br_status_ena = false;
     pContext->stack_trace_cnt = 0;
 }
 
-void CpuRiscV_Functional::fetchInstruction() {
+IInstruction *CpuRiscV_Functional::fetchInstruction() {
     CpuContextType *pContext = getpContext();
     if (pContext->br_inject_fetch
         && pContext->pc == pContext->br_address_fetch) {
         pContext->br_inject_fetch = false;
         cacheline_[0] = pContext->br_instr_fetch;
-        return;
+        // Injected instruction must not be cached
+        return decodeInstruction(cacheline_);
+    }
+
+    return fetchDecoded(pContext->pc, cacheline_);
+}
+
+/**
+ * Decoded instructions are cached by the physical address, so the
+ * modified code is invalidated independently of the address translation.
+ */
+IInstruction *CpuRiscV_Functional::fetchDecoded(uint64_t pc,
+                                                uint32_t *rpayload) {
+    DmiCacheType *dmi = getpContext()->dmi;
+    uint64_t ppc;
+    uint64_t ppc2;
+    if (!dmi->translate(pc, Access_Fetch, &ppc)) {
+        dmi->pageFault(pc, Access_Fetch);
+        return 0;
+    }
+    PredecodedInstrType *pdec = predecode_.getEntry(ppc);
+    if (pdec->instr) {
+        rpayload[0] = pdec->payload;
+        return pdec->instr;
+    }
+
+    // Only aligned words are fetched. Instruction at the 2-bytes aligned
+    // address may occupy two words located in the different pages, the
+    // next virtual page may be mapped anywhere.
+    codePages_->markCode(ppc);
+    if (!BlockCacheType::isPageCross(pc, 4)) {
+        codePages_->markCode(ppc + 2);
+    } else if (dmi->translate(pc + 2, Access_Fetch, &ppc2)) {
+        codePages_->markCode(ppc2);
     }
     trans_.action = MemAction_Read;
-    trans_.addr = pContext->pc;
+    trans_.addr = pc & ~0x3ull;
     trans_.xsize = 4;
     trans_.wstrb = 0;
-    pContext->ibus->b_transport(&trans_);
-    cacheline_[0] = trans_.rpayload.b32[0];
+    ETransStatus status = dmi->fetch(&trans_);
+    rpayload[0] = trans_.rpayload.b32[0];
+    if (pc & 0x2) {
+        rpayload[0] >>= 16;
+        if ((rpayload[0] & 0x3) == 0x3) {
+            trans_.addr = pc + 2;
+            if (dmi->fetch(&trans_) != TRANS_OK) {
+                status = TRANS_ERROR;
+            }
+            if (getpContext()->exception) {
+                // Page fault on the second half of the instruction
+                return 0;
+            }
+            rpayload[0] |= trans_.rpayload.b32[0] << 16;
+        }
+    } else if ((rpayload[0] & 0x3) != 0x3) {
+        rpayload[0] &= 0xffff;
+    }
+
+    IInstruction *instr = decodeInstruction(rpayload);
+    // Mapping of the next page may change without any write into memory
+    bool remap = ppc != pc && BlockCacheType::isPageCross(pc,
+                            CompressedTableType::length(rpayload[0]));
+    if (status == TRANS_OK && !remap) {
+        pdec->payload = rpayload[0];
+        pdec->instr = instr;
+    }
+    return instr;
+}
+
+/** Control transfer, system and fence instructions end basic block */
+bool CpuRiscV_Functional::isBlockEnd(uint32_t payload) {
+    if ((payload & 0x3) != 0x3) {
+        payload = compressed_.expanded(payload);
+    }
+    switch (payload & 0x7f) {
+    case 0x0f:      // FENCE, FENCE.I
+    case 0x63:      // BRANCH
+    case 0x67:      // JALR
+    case 0x6f:      // JAL
+    case 0x73:      // SYSTEM
+        return true;
+    default:;
+    }
+    return false;
+}
+
+/**
+ * Blocks are tagged by the physical address of the first instruction and
+ * never cross the page boundary, so one translation per block is enough.
+ * Page fault is raised by executeStep() when no block is returned.
+ */
+DecodedBlockType *CpuRiscV_Functional::getBlock(uint64_t pc) {
+    DecodedBlockType *blk;
+    uint64_t ppc;
+    if (!getpContext()->dmi->translate(pc, Access_Fetch, &ppc)) {
+        lastBlock_ = 0;
+        return 0;
+    }
+    if (lastBlock_) {
+        // Chained successors of the previously executed block
+        for (int i = 0; i < 2; i++) {
+            blk = lastBlock_->chain[i];
+            if (blk && blk->pc == ppc && blocks_.isValid(blk)) {
+                lastBlock_ = blk;
+                return blk;
+            }
+        }
+    }
+
+    blk = blocks_.lookup(ppc);
+    if (blk == 0) {
+        if (useHostCode_ && !hostCode_.hasSpace(BLOCK_INSTR_MAX)) {
+            // Blocks may point to the dropped code
+            hostCode_.clear();
+            blocks_.flush();
+            lastBlock_ = 0;
+        }
+        blk = blocks_.allocate(ppc);
+        decodeBlock(blk, pc);
+        if (blk->size == 0) {
+            blk->pc = ~0ull;
+            lastBlock_ = 0;
+            return 0;
+        }
+        if (useHostCode_) {
+            translateBlock(blk);
+        }
+    }
+
+    if (lastBlock_) {
+        lastBlock_->chain[lastBlock_->chain_idx] = blk;
+        lastBlock_->chain_idx ^= 1;
+    }
+    lastBlock_ = blk;
+    return blk;
+}
+
+void CpuRiscV_Functional::decodeBlock(DecodedBlockType *blk, uint64_t pc) {
+    while (blk->size < BLOCK_INSTR_MAX) {
+        if (BlockCacheType::isPageCross(pc, 4)) {
+            // Instruction may continue in the next page: write into that
+            // page wouldn't invalidate the block and the page may be not
+            // mapped. It's executed by the pipeline.
+            break;
+        }
+        PredecodedInstrType *p = &blk->instr[blk->size];
+        p->instr = fetchDecoded(pc, &p->payload);
+        if (p->instr == 0) {
+            // Illegal instruction is handled by the pipeline
+            break;
+        }
+        blk->host[blk->size] = 0;
+        blk->host_len[blk->size] = 0;
+        blk->size++;
+        pc += CompressedTableType::length(p->payload);
+        // Instruction with breakpoint may be only the first in a block
+        if (isBlockEnd(p->payload) || BlockCacheType::isPageStart(pc)
+            || breakpoints_.isBreakpoint(pc)) {
+            break;
+        }
+    }
+}
+
+/**
+ * Runs of the supported instructions are translated into host code, the
+ * compressed instructions are passed in the expanded form.
+ */
+void CpuRiscV_Functional::translateBlock(DecodedBlockType *blk) {
+    uint32_t payload[BLOCK_INSTR_MAX];
+    uint32_t length[BLOCK_INSTR_MAX];
+    for (int i = 0; i < blk->size; i++) {
+        uint32_t t = blk->instr[i].payload;
+        length[i] = CompressedTableType::length(t);
+        payload[i] = length[i] == 4 ? t : compressed_.expanded(t);
+    }
+    int i = 0;
+    while (i < blk->size) {
+        int used;
+        blk->host[i] = hostCode_.translate(&payload[i], &length[i],
+                                           blk->size - i, &used);
+        blk->host_len[i] = used;
+        i += used ? used : 1;
+    }
 }
 
 IInstruction *CpuRiscV_Functional::decodeInstruction(uint32_t *rpayload) {
+    if ((rpayload[0] & 0x3) != 0x3) {
+        return compressed_.decode(rpayload[0]);
+    }
     IInstruction *instr = NULL;
     int hash_idx = hash32(rpayload[0]);
     for (unsigned i = 0; i < listInstr_[hash_idx].size(); i++) {
@@ -325,6 +1008,25 @@ IInstruction *CpuRiscV_Functional::decodeInstruction(uint32_t *rpayload) {
     return instr;
 }
 
+/**
+ * Each 16-bit parcel is expanded and decoded once, so the compressed
+ * instructions use the same handlers as the enabled extensions.
+ */
+void CpuRiscV_Functional::addIsaExtensionC() {
+    uint32_t payload;
+    for (uint32_t parcel = 0; parcel < (1u << 16); parcel++) {
+        if ((parcel & 0x3) == 0x3
+            || !CompressedTableType::expand(parcel, &payload)) {
+            continue;
+        }
+        IInstruction *instr = decodeInstruction(&payload);
+        if (instr) {
+            compressed_.setEntry(parcel, payload, instr);
+        }
+    }
+    getpContext()->csr[Csr_misa] |= (1LL << ('C' - 'A'));
+}
+
 void CpuRiscV_Functional::debugRegOutput(const char *marker,
                                          CpuContextType *pContext) {
         RISCV_debug("%s[%" RV_PRI64 "d] %d %08x: "
@@ -339,7 +1041,7 @@ void CpuRiscV_Functional::debugRegOutput(const char *marker,
             marker,
             getStepCounter(),
             (int)pContext->cur_prv_level,
-            (uint32_t)pContext->csr[CSR_mepc],
+            (uint32_t)pContext->csr[Csr_mepc],
             pContext->regs[1], pContext->regs[2], pContext->regs[3], pContext->regs[4],
             pContext->regs[5], pContext->regs[6], pContext->regs[7], pContext->regs[8],
             pContext->regs[9], pContext->regs[10], pContext->regs[11], pContext->regs[12],
@@ -378,23 +1080,14 @@ void CpuRiscV_Functional::executeInstruction(IInstruction *instr,
     }
 #endif
     if (pContext->reg_trace_file) {
-        int sz;
-        sz = RISCV_sprintf(tstr, sizeof(tstr),"%8I64d [%08x] %08x: ",
-            pContext->step_cnt, static_cast<uint32_t>(pContext->pc), rpayload[0]);
-
-        bool reg_changed = false;
+        uint32_t mask = 0;
         for (int i = 0; i < 32; i++) {
             if (iregs_prev[i] != pContext->regs[i]) {
-                reg_changed = true;
-                sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz,
-                        "%3s <= %016I64x\n", IREGS_NAMES[i], pContext->regs[i]);
+                mask |= 1u << i;
             }
         }
-        if (!reg_changed) {
-            sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz, "%s", "-\n");
-        }
-        (*pContext->reg_trace_file) << tstr;
-        pContext->reg_trace_file->flush();
+        pContext->reg_trace_file->writeRegs(pContext->step_cnt, pContext->pc,
+                                            rpayload[0], mask, pContext->regs);
     }
 
     if (generateRegTraceFile_.to_bool()) {
@@ -438,6 +1131,24 @@ void CpuRiscV_Functional::executeInstruction(IInstruction *instr,
     }
 }
 
+void CpuRiscV_Functional::writeNotify(uint64_t addr, uint32_t size) {
+    predecode_.invalidate(addr, size);
+    blocks_.invalidate(addr, size);
+    if (cpu_context_.reservations) {
+        cpu_context_.reservations->invalidate(addr, size);
+    }
+}
+
+/**
+ * Pointers are revoked by the step callbacks (checkpoints) of this hart
+ * or while the other harts are halted, so the cache is flushed before
+ * the next instruction is executed.
+ */
+void CpuRiscV_Functional::invalidateDmi(uint64_t addr, uint64_t size) {
+    RISCV_atomic_xchg64(&dmiRevoked_, 1);
+    breakBatch();
+}
+
 void CpuRiscV_Functional::registerStepCallback(IClockListener *cb,
                                                uint64_t t) {
     if (!isEnabled()) {
@@ -447,8 +1158,128 @@ void CpuRiscV_Functional::registerStepCallback(IClockListener *cb,
         return;
     }
     queue_.put(t, cb);
+    breakBatch();
+}
+
+
+/**
+ * Snapshot is taken by the step callback, so the context and the queue
+ * are accessed from this hart thread. Pending callbacks are saved with
+ * the listener service names. Services that don't export IClockListener
+ * (snapshot) register their callbacks again after restore.
+ */
+void CpuRiscV_Functional::saveState(AttributeType *state) {
+    CpuContextType *pContext = getpContext();
+    AttributeType items, listeners, queue;
+    queue_.pushPreQueued();
+    queue_.getItems(&items);
+    RISCV_get_services_with_iface(IFACE_CLOCK_LISTENER, &listeners);
+    queue.make_list(0);
+    for (unsigned i = 0; i < items.size(); i++) {
+        IFace *cb = items[i][1].to_iface();
+        for (unsigned n = 0; n < listeners.size(); n++) {
+            IService *iserv = static_cast<IService *>(listeners[n].to_iface());
+            if (iserv->getInterface(IFACE_CLOCK_LISTENER) != cb) {
+                continue;
+            }
+            AttributeType t1;
+            t1.make_list(2);
+            t1[0u] = items[i][0u];
+            t1[1].make_string(iserv->getObjName());
+            queue.add_to_list(&t1);
+            break;
+        }
+    }
+
+    state->make_dict();
+    (*state)["regs"].make_data(sizeof(pContext->regs), pContext->regs);
+    (*state)["fregs"].make_data(sizeof(pContext->fregs), pContext->fregs);
+    (*state)["csr"].make_data(sizeof(pContext->csr), pContext->csr);
+    (*state)["csr_other"].make_data(
+        pContext->csr_other_cnt * sizeof(pContext->csr_other[0]),
+        pContext->csr_other);
+    (*state)["pc"].make_uint64(pContext->pc);
+    (*state)["npc"].make_uint64(pContext->npc);
+    (*state)["step_cnt"].make_uint64(pContext->step_cnt);
+    (*state)["cur_prv_level"].make_uint64(pContext->cur_prv_level);
+    (*state)["exception"].make_uint64(pContext->exception);
+    (*state)["interrupt"].make_uint64(pContext->interrupt);
+    (*state)["interrupt_pending"].make_uint64(pContext->interrupt_pending);
+    (*state)["reserve_addr"].make_uint64(pContext->reserve_addr);
+    (*state)["reserve_value"].make_uint64(pContext->reserve_value);
+    (*state)["wfi"].make_boolean(pContext->wfi);
+    (*state)["queue"] = queue;
 }
 
+/**
+ * Memory was replaced without bus notifications, so all cached host
+ * pointers and decoded instructions are dropped. Debug state (halt,
+ * breakpoints) isn't a part of the snapshot.
+ */
+void CpuRiscV_Functional::restoreState(const AttributeType *state) {
+    CpuContextType *pContext = getpContext();
+    const AttributeType &st = *state;
+    if (!st.is_dict() || !st.has_key("queue")
+        || st["regs"].size() != sizeof(pContext->regs)
+        || st["fregs"].size() != sizeof(pContext->fregs)
+        || st["csr"].size() != sizeof(pContext->csr)) {
+        RISCV_error("Wrong CPU context in snapshot", NULL);
+        return;
+    }
+    memcpy(pContext->regs, st["regs"].data(), sizeof(pContext->regs));
+    memcpy(pContext->fregs, st["fregs"].data(), sizeof(pContext->fregs));
+    memcpy(pContext->csr, st["csr"].data(), sizeof(pContext->csr));
+    pContext->csr_other_cnt = 0;
+    if (st.has_key("csr_other")
+        && st["csr_other"].size() <= sizeof(pContext->csr_other)) {
+        pContext->csr_other_cnt = static_cast<int>(
+            st["csr_other"].size() / sizeof(pContext->csr_other[0]));
+        memcpy(pContext->csr_other, st["csr_other"].data(),
+               st["csr_other"].size());
+    }
+    pContext->pc = st["pc"].to_uint64();
+    pContext->npc = st["npc"].to_uint64();
+    pContext->step_cnt = st["step_cnt"].to_uint64();
+    pContext->cur_prv_level = st["cur_prv_level"].to_uint64();
+    pContext->exception = st["exception"].to_uint64();
+    pContext->interrupt = st["interrupt"].to_uint64();
+    pContext->interrupt_pending = st["interrupt_pending"].to_uint64();
+    pContext->reserve_addr = st["reserve_addr"].to_uint64();
+    pContext->reserve_value = st["reserve_value"].to_uint64();
+    if (pContext->reservations) {
+        // Reservation isn't restored, the next SC fails
+        pContext->reservations->cancel(pContext->reserve_slot);
+    }
+    pContext->wfi = st["wfi"].to_bool();
+    pContext->br_inject_fetch = false;
+    pContext->stack_trace_cnt = 0;
+
+    predecode_.flush();
+    blocks_.flush();
+    dmi_.flush();
+    dmi_.updateContext();
+    lastBlock_ = 0;
+    last_hit_breakpoint_ = ~0;
+
+    const AttributeType &queue = st["queue"];
+    queue_.clear();
+    for (unsigned i = 0; i < queue.size(); i++) {
+        const char *name = queue[i][1].to_string();
+        IClockListener *cb = static_cast<IClockListener *>(
+            RISCV_get_service_iface(name, IFACE_CLOCK_LISTENER));
+        if (!cb) {
+            RISCV_error("Clock listener '%s' not found", name);
+            continue;
+        }
+        queue_.put(queue[i][0u].to_uint64(), cb);
+    }
+    queue_.pushPreQueued();
+    if (syncJoined_) {
+        quantumEnd_ = pContext->step_cnt + quantum_.to_uint64();
+    }
+    queueNextTime_ = 0;     // re-calculate horizon
+    breakBatch();
+}
 
 /** 
  * prv-1.9.1 page 29
@@ -467,7 +1298,7 @@ void CpuRiscV_Functional::registerStepCallback(IClockListener *cb,
 void CpuRiscV_Functional::raiseSignal(int idx) {
     CpuContextType *pContext = getpContext();
     csr_mstatus_type mstatus;
-    mstatus.value = pContext->csr[CSR_mstatus];
+    mstatus.value = pContext->csr[Csr_mstatus];
 
     switch (idx) {
     case CPU_SIGNAL_RESET:
@@ -488,6 +1319,7 @@ void CpuRiscV_Functional::raiseSignal(int idx) {
     default:
         RISCV_error("Unsupported signalRaise(%d)", idx);
     }
+    breakBatch();
 }
 
 void CpuRiscV_Functional::lowerSignal(int idx) {
@@ -502,18 +1334,67 @@ void CpuRiscV_Functional::lowerSignal(int idx) {
     default:
         RISCV_error("Unsupported lowerSignal(%d)", idx);
     }
+    breakBatch();
 }
 
+/**
+ * Writes into the hart state are logged, so they are applied at the same
+ * step when the history is replayed.
+ */
 void CpuRiscV_Functional::updateDebugPort() {
+    DebugPortTransactionType *trans = dport.trans;
+    accessDebugPort(trans);
+    if (irecorder_ && trans->write && isReplayedAccess(trans)) {
+        AttributeType t1;
+        t1.make_list(3);
+        t1[0u].make_uint64(trans->region);
+        t1[1].make_uint64(trans->addr);
+        t1[2].make_uint64(trans->wdata);
+        irecorder_->recordInput(static_cast<IReplayInput *>(this), &t1);
+    }
+    dport.cb->nb_response_debug_port(trans);
+}
+
+/** Registers, CSRs and injected instruction. Debug control isn't logged */
+bool CpuRiscV_Functional::isReplayedAccess(DebugPortTransactionType *trans) {
+    switch (trans->region) {
+    case 0:
+    case 1:
+        return true;
+    case 2:
+        return trans->addr == 4 || trans->addr == 7 || trans->addr == 8;
+    default:;
+    }
+    return false;
+}
+
+void CpuRiscV_Functional::replayInput(const AttributeType *data) {
+    DebugPortTransactionType trans;
+    trans.write = true;
+    trans.region = static_cast<uint8_t>((*data)[0u].to_uint64());
+    trans.addr = static_cast<uint16_t>((*data)[1].to_uint64());
+    trans.wdata = (*data)[2].to_uint64();
+    accessDebugPort(&trans);
+}
+
+void CpuRiscV_Functional::accessDebugPort(DebugPortTransactionType *trans) {
     CpuContextType *pContext = getpContext();
     DsuMapType::udbg_type::debug_region_type::control_reg ctrl;
-    DebugPortTransactionType *trans = dport.trans;
     trans->rdata = 0;
     switch (trans->region) {
     case 0:     // CSR
-        trans->rdata = pContext->csr[trans->addr];
+        if (trans->addr == CSR_dcsr) {
+            // Debug access only: privilege level of the halted hart
+            trans->rdata = pContext->cur_prv_level;
+            if (trans->write) {
+                pContext->cur_prv_level = trans->wdata & 0x3;
+                pContext->dmi->updateContext();
+            }
+            break;
+        }
+        trans->rdata = readCSR(trans->addr, pContext);
         if (trans->write) {
-            pContext->csr[trans->addr] = trans->wdata;
+            writeCSR(trans->addr, trans->wdata, pContext);
         }
         break;
     case 1:     // IRegs
@@ -535,6 +1416,11 @@ void CpuRiscV_Functional::updateDebugPort() {
             if (trans->write) {
                 pContext->stack_trace_cnt = static_cast<int>(trans->wdata);
             }
+        } else if (trans->addr >= 64 && trans->addr < 96) {
+            trans->rdata = pContext->fregs[trans->addr - 64];
+            if (trans->write) {
+                pContext->fregs[trans->addr - 64] = trans->wdata;
+            }
         } else if (trans->addr >= 128 && 
                     trans->addr < (128 + STACK_TRACE_BUF_SIZE)) {
             trans->rdata = pContext->stack_trace_buf[trans->addr - 128];
@@ -558,7 +1444,8 @@ void CpuRiscV_Functional::updateDebugPort() {
                 if (pContext->br_status_ena) {
                     ctrl.bits.breakpoint = 1;
                 }
-                ctrl.bits.core_id = 0;
+                ctrl.bits.watchpoint = dport.wp_hit ? 1: 0;
+                ctrl.bits.core_id = hartId_.to_uint64();
             }
             trans->rdata = ctrl.val;
             break;
@@ -581,6 +1468,7 @@ void CpuRiscV_Functional::updateDebugPort() {
             }
             break;
         case 5:
+            trans->rdata = breakpoints_.getFreeTotal();
             if (trans->write) {
                 addBreakpoint(trans->wdata);
             }
@@ -604,12 +1492,38 @@ void CpuRiscV_Functional::updateDebugPort() {
                 pContext->br_instr_fetch = static_cast<uint32_t>(trans->wdata);
             }
             break;
+        case 9:
+            trans->rdata = dport.wp_address;
+            if (trans->write) {
+                dport.wp_address = trans->wdata;
+            }
+            break;
+        case 10:
+            trans->rdata = dport.wp_length;
+            if (trans->write) {
+                dport.wp_length = trans->wdata;
+            }
+            break;
+        case 11:
+            trans->rdata = watchpoints_.getFreeTotal();
+            if (trans->write) {
+                addWatchpoint(dport.wp_address, dport.wp_length,
+                              static_cast<uint32_t>(trans->wdata));
+            }
+            break;
+        case 12:
+            if (trans->write) {
+                removeWatchpoint(trans->wdata);
+            }
+            break;
+        case 13:
+            trans->rdata = dport.wp_hit_address;
+            break;
         default:;
         }
         break;
     default:;
     }
-    dport.cb->nb_response_debug_port(dport.trans);
 }
 
 void 
@@ -618,6 +1532,7 @@ CpuRiscV_Functional::nb_transport_debug_port(DebugPortTransactionType *trans,
     dport.trans = trans;
     dport.cb = cb;
     dport.valid = true;
+    breakBatch();
 }
 
 void CpuRiscV_Functional::halt(const char *descr) {
@@ -625,23 +1540,37 @@ void CpuRiscV_Functional::halt(const char *descr) {
     dbg_state_ = STATE_Halted;
 
     if (descr == NULL) {
-        RISCV_printf0(
-            "[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: %08x \t CPU halted",
-            getStepCounter(), pContext->pc, cacheline_[0]);
-    } else {
-        RISCV_printf0("[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: %08x \t %s",
-            getStepCounter(), pContext->pc, cacheline_[0], descr);
+        descr = "CPU halted";
     }
+    RISCV_printf0("[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: %08x %s \t %s",
+        getStepCounter(), pContext->pc, cacheline_[0],
+        disasmInstruction(pContext->pc, cacheline_), descr);
+}
+
+/**
+ * Instruction handlers don't produce any text. Disassembly is generated
+ * only on demand from the instruction word.
+ */
+const char *CpuRiscV_Functional::disasmInstruction(uint64_t pc,
+                                                   uint32_t *rpayload) {
+    if (!isrc_) {
+        return "";
+    }
+    isrc_->disasm(pc, reinterpret_cast<uint8_t *>(rpayload), 0,
+                  &mnemonic_, &comment_);
+    return mnemonic_.to_string();
 }
 
 void CpuRiscV_Functional::go() {
     dbg_state_ = STATE_Normal;
+    dport.wp_hit = false;
 }
 
 void CpuRiscV_Functional::step(uint64_t cnt) {
     CpuContextType *pContext = getpContext();
     dbg_step_cnt_ = pContext->step_cnt + cnt;
     dbg_state_ = STATE_Stepping;
+    dport.wp_hit = false;
 }
 
 uint64_t CpuRiscV_Functional::getReg(uint64_t idx) {
@@ -677,27 +1606,147 @@ uint64_t CpuRiscV_Functional::getNPC() {
 void CpuRiscV_Functional::setNPC(uint64_t val) {
     CpuContextType *pContext = getpContext();
     pContext->npc = val;
+    pContext->wfi = false;
 }
 
+/**
+ * Breakpoints don't modify memory, so only decoded blocks of the page
+ * are re-built to stop right before the marked instruction.
+ */
 void CpuRiscV_Functional::addBreakpoint(uint64_t addr) {
-    //CpuContextType *pContext = getpContext();
+    if (!breakpoints_.add(addr)) {
+        RISCV_error("Breakpoints table is full, %08" RV_PRI64 "x ignored",
+                    addr);
+        return;
+    }
+    invalidateBreakpoint(addr);
 }
 
 void CpuRiscV_Functional::removeBreakpoint(uint64_t addr) {
-    //CpuContextType *pContext = getpContext();
+    if (breakpoints_.remove(addr)) {
+        invalidateBreakpoint(addr);
+    }
+}
+
+/**
+ * Blocks are indexed by physical address while breakpoints are set on
+ * virtual. All blocks are flushed when the page isn't mapped now, the
+ * page may be mapped later to the already decoded code.
+ */
+void CpuRiscV_Functional::invalidateBreakpoint(uint64_t addr) {
+    uint64_t paddr;
+    if (dmi_.translate(addr, Access_Fetch, &paddr)) {
+        blocks_.invalidate(paddr, 4);
+    } else {
+        blocks_.flush();
+    }
+    lastBlock_ = 0;
+}
+
+/**
+ * Check breakpoint before instruction fetch. Execution resumed from the
+ * breakpoint address skips it once.
+ */
+bool CpuRiscV_Functional::checkBreakpoint(uint64_t pc) {
+    if (!breakpoints_.isPageMarked(pc)
+        || pc == last_hit_breakpoint_
+        || !breakpoints_.isBreakpoint(pc)) {
+        return false;
+    }
+    if (replayHit()) {
+        return false;
+    }
+    hitBreakpoint(pc);
+    return true;
 }
 
 void CpuRiscV_Functional::hitBreakpoint(uint64_t addr) {
-    CpuContextType *pContext = getpContext();
     if (addr == last_hit_breakpoint_) {
         return;
     }
     dbg_state_ = STATE_Halted;
     last_hit_breakpoint_ = addr;
+    breakBatch();
 
-    RISCV_printf0("[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: %08x \t stop on breakpoint",
-        getStepCounter(), pContext->pc, cacheline_[0]);
+    RISCV_printf0("[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: \t stop on breakpoint",
+        getStepCounter(), addr);
 }
 
-}  // namespace debugger
+/**
+ * Direct memory access to the watched pages is revoked, so the DMI cache
+ * is flushed on each change of the watchpoints table.
+ */
+void CpuRiscV_Functional::addWatchpoint(uint64_t addr, uint64_t length,
+                                        uint32_t flags) {
+    if (!watchpoints_.add(addr, length, flags)) {
+        RISCV_error("Watchpoints table is full, %08" RV_PRI64 "x ignored",
+                    addr);
+        return;
+    }
+    dmi_.flush();
+}
 
+void CpuRiscV_Functional::removeWatchpoint(uint64_t addr) {
+    if (watchpoints_.remove(addr)) {
+        dmi_.flush();
+    }
+}
+
+/**
+ * Called from the load/store instruction before memory access. CPU halts
+ * right after the instruction is completed.
+ */
+void CpuRiscV_Functional::watchpointHit(uint64_t addr, uint32_t flags) {
+    char descr[64];
+    CpuContextType *pContext = getpContext();
+    if (replayHit()) {
+        return;
+    }
+    dbg_state_ = STATE_Halted;
+    dport.wp_hit_address = addr;
+    dport.wp_hit = true;
+    breakBatch();
+
+    RISCV_sprintf(descr, sizeof(descr), "%s %08" RV_PRI64 "x",
+                  (flags & WATCH_WRITE) ? "write" : "read", addr);
+    RISCV_printf0("[%" RV_PRI64 "d] pc:%016" RV_PRI64 "x: \t stop on "
+                  "watchpoint, %s", getStepCounter(), pContext->pc, descr);
+    RISCV_trigger_hap(getInterface(IFACE_SERVICE), HAP_Watchpoint, descr);
+}
+
+/**
+ * Re-executed history doesn't stop on breakpoints. The step of the hart
+ * halted on the latest hit is kept to move back to it.
+ */
+void CpuRiscV_Functional::startReplay(uint64_t end) {
+    replay_ = true;
+    replayEnd_ = end;
+    replayHitValid_ = false;
+    go();
+}
+
+bool CpuRiscV_Functional::stopReplay(uint64_t *hit) {
+    CpuContextType *pContext = getpContext();
+    replay_ = false;
+    dbg_state_ = STATE_Halted;
+    breakBatch();
+    if (breakpoints_.isBreakpoint(pContext->npc)) {
+        // Resumed execution skips breakpoint as after the hit
+        last_hit_breakpoint_ = pContext->npc;
+    }
+    *hit = replayHit_;
+    return replayHitValid_;
+}
+
+bool CpuRiscV_Functional::replayHit() {
+    if (!replay_) {
+        return false;
+    }
+    if (getpContext()->step_cnt < replayEnd_) {
+        replayHit_ = getpContext()->step_cnt;
+        replayHitValid_ = true;
+    }
+    return true;
+}
+
+}  // namespace debugger
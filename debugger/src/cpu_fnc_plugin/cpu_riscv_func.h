@@ -17,7 +17,20 @@
 #include "coreservices/imemop.h"
 #include "coreservices/iclock.h"
 #include "coreservices/iclklistener.h"
+#include "coreservices/ibuslistener.h"
+#include "coreservices/isrccode.h"
+#include "coreservices/isnapshot.h"
+#include "coreservices/ireplay.h"
+#include "coreservices/iprofiler.h"
 #include "instructions.h"
+#include "predecode.h"
+#include "compressed.h"
+#include "blockcache.h"
+#include "breakpoints.h"
+#include "watchpoints.h"
+#include "dmi.h"
+#include "quantum.h"
+#include "profiler.h"
 
 namespace debugger {
 
@@ -25,6 +38,12 @@ class CpuRiscV_Functional : public IService,
                  public IThread,
                  public ICpuRiscV,
                  public IClock,
+                 public IBusListener,
+                 public IWatchpointListener,
+                 public ISnapshot,
+                 public IReplayInput,
+                 public IReplayHart,
+                 public IProfiler,
                  public IHap {
 public:
     CpuRiscV_Functional(const char *name);
@@ -38,11 +57,42 @@ public:
     virtual void lowerSignal(int idx);
     virtual void nb_transport_debug_port(DebugPortTransactionType *trans,
                                          IDbgNbResponse *cb);
+    virtual bool isHalted() { return isHalt(); }
 
     /** IClock */
     virtual uint64_t getStepCounter() { return cpu_context_.step_cnt; }
     virtual void registerStepCallback(IClockListener *cb, uint64_t t);
 
+    /** IBusListener */
+    virtual void writeNotify(uint64_t addr, uint32_t size);
+    virtual void invalidateDmi(uint64_t addr, uint64_t size);
+
+    /** IWatchpointListener */
+    virtual void watchpointHit(uint64_t addr, uint32_t flags);
+
+    /** ISnapshot */
+    virtual void saveState(AttributeType *state);
+    virtual void restoreState(const AttributeType *state);
+
+    /** IReplayInput: logged debug port write */
+    virtual void replayInput(const AttributeType *data);
+
+    /** IReplayHart */
+    virtual void startReplay(uint64_t end);
+    virtual bool stopReplay(uint64_t *hit);
+
+    /** IProfiler */
+    virtual void startProfiling() { profileRequest(ProfRequest_Start, 0); }
+    virtual void stopProfiling() { profileRequest(ProfRequest_Stop, 0); }
+    virtual void resetProfiling() { profileRequest(ProfRequest_Reset, 0); }
+    virtual bool isProfiling() { return profiling_; }
+    virtual void getProfile(AttributeType *res) {
+        profileRequest(ProfRequest_Get, res);
+    }
+
+    /** IThread */
+    virtual void stop();
+
     /** IHap */
     virtual void hapTriggered(IFace *isrc, EHapType type, const char *descr);
 
@@ -63,23 +113,65 @@ private:
     void setNPC(uint64_t val);
     void addBreakpoint(uint64_t addr);
     void removeBreakpoint(uint64_t addr);
+    void invalidateBreakpoint(uint64_t addr);
     void hitBreakpoint(uint64_t addr);
+    bool checkBreakpoint(uint64_t pc);
+    void addWatchpoint(uint64_t addr, uint64_t length, uint32_t flags);
+    void removeWatchpoint(uint64_t addr);
 
     CpuContextType *getpContext() { return &cpu_context_; }
     uint32_t hash32(uint32_t val) { return (val >> 2) & 0x1f; }
 
     void updatePipeline();
+    void updateBatch();
+    void executeStep();
+    void executeBlock();
+    void waitInterrupt();
+    void skipIdleLoop();
+    void fastForward();
+    void breakBatch() { RISCV_atomic_xchg64(&asyncBreak_, 1); }
     void updateState();
     void updateDebugPort();
+    void accessDebugPort(DebugPortTransactionType *trans);
+    bool isReplayedAccess(DebugPortTransactionType *trans);
+    bool replayHit();
     void updateQueue();
+    void updateQuantumGroup();
+    void syncQuantum();
+
+    enum EProfRequest {
+        ProfRequest_None,
+        ProfRequest_Start,
+        ProfRequest_Stop,
+        ProfRequest_Reset,
+        ProfRequest_Get
+    };
+    void profileRequest(EProfRequest req, AttributeType *res);
+    void updateProfiler();
+    void profile(uint64_t pc, uint64_t instr, uint64_t stall) {
+        profile_.add(pc, instr, stall);
+        if (cpu_context_.step_cnt >= profNextSample_) {
+            sampleStack();
+        }
+    }
+    void sampleStack();
 
     bool isRunning();
     void reset();
     void handleTrap();
-    void fetchInstruction();
+    IInstruction *fetchInstruction();
+    IInstruction *fetchDecoded(uint64_t pc, uint32_t *rpayload);
+    bool isBatchAllowed();
+    void illegalInstruction();
+    bool isBlockEnd(uint32_t payload);
+    DecodedBlockType *getBlock(uint64_t pc);
+    void decodeBlock(DecodedBlockType *blk, uint64_t pc);
+    void translateBlock(DecodedBlockType *blk);
     IInstruction *decodeInstruction(uint32_t *rpayload);
+    void addIsaExtensionC();
     void executeInstruction(IInstruction *instr, uint32_t *rpayload);
     void debugRegOutput(const char *marker, CpuContextType *pContext);
+    const char *disasmInstruction(uint64_t pc, uint32_t *rpayload);
 
 private:
     static const int INSTR_HASH_TABLE_SIZE = 1 << 5;
@@ -91,7 +183,16 @@ private:
     AttributeType generateRegTraceFile_;
     AttributeType generateMemTraceFile_;
     AttributeType resetVector_;
+    AttributeType execEngine_;
+    AttributeType hartId_;
+    AttributeType quantum_;
+    AttributeType profileEnable_;
+    AttributeType profilePeriod_;
     event_def config_done_;
+    ISourceCode *isrc_;
+    IInputRecorder *irecorder_;
+    AttributeType mnemonic_;
+    AttributeType comment_;
 
     AsyncTQueueType queue_;
     uint64_t last_hit_breakpoint_;
@@ -101,6 +202,36 @@ private:
 
     // Registers:
     AttributeType listInstr_[INSTR_HASH_TABLE_SIZE];
+    PredecodeCacheType predecode_;
+    CompressedTableType compressed_;
+    BreakpointTableType breakpoints_;
+    WatchpointTableType watchpoints_;
+    BlockCacheType blocks_;
+    HostCodeType hostCode_;
+    DmiCacheType dmi_;
+    CodePageTableType *codePages_;  // shared by the harts of the bus
+    DecodedBlockType *lastBlock_;
+    bool useBlocks_;
+    bool useHostCode_;
+    uint64_t queueNextTime_;    // nearest step callback or quantum end
+    QuantumSyncType *sync_;     // NULL when quantum isn't used
+    int syncSlot_;
+    bool syncJoined_;
+    uint64_t quantumEnd_;
+    event_def quantumDone_;
+    volatile int64_t asyncBreak_;   // asynchronous request breaks batch
+    volatile int64_t dmiRevoked_;   // DMI cache is flushed between batches
+    bool replay_;               // breakpoints don't halt re-executed history
+    uint64_t replayEnd_;
+    uint64_t replayHit_;
+    bool replayHitValid_;
+    ProfileTableType profile_;
+    bool profiling_;
+    uint64_t profNextSample_;   // step of the next call stack sample
+    volatile EProfRequest profRequest_;
+    AttributeType *profResult_;
+    mutex_def mutexProf_;
+    event_def profDone_;
     CpuContextType cpu_context_;
 
     enum EDebugState {
@@ -110,7 +241,6 @@ private:
     } dbg_state_;
     uint64_t dbg_step_cnt_;
 
-    char tstr[1024];
     uint64_t iregs_prev[32]; // to detect changes
     struct DebugPortType {
         bool valid;
@@ -119,6 +249,10 @@ private:
 
         // local registers
         uint64_t stepping_mode_steps;
+        uint64_t wp_address;
+        uint64_t wp_length;
+        uint64_t wp_hit_address;
+        bool wp_hit;
     } dport;
 };
 
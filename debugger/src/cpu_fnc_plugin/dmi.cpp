@@ -0,0 +1,291 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Direct memory interface cache and software TLB of the CPU.
+ */
+
+#include <stddef.h>
+#include "dmi.h"
+#include "iinstr.h"
+
+namespace debugger {
+
+void generateException(uint64_t code, CpuContextType *data);
+
+DmiCacheType::DmiCacheType() {
+    ibus_ = 0;
+    owner_ = 0;
+    code_ = 0;
+    watch_ = 0;
+    memset(util_, 0, sizeof(util_));
+    ctx_ = 0;
+    memset(mode_, 0, sizeof(mode_));
+    flush();
+}
+
+void DmiCacheType::init(IBus *ibus, IBusListener *owner,
+                        CodePageTableType *code, WatchpointTableType *watch,
+                        CpuContextType *ctx) {
+    ibus_ = ibus;
+    owner_ = owner;
+    code_ = code;
+    watch_ = watch;
+    ibus->registerUtilCounters(util_);
+    ctx_ = ctx;
+    memset(mode_, 0, sizeof(mode_));
+    flush();
+}
+
+void DmiCacheType::flush() {
+    for (int i = 0; i < Access_Total; i++) {
+        flushType(static_cast<EAccessType>(i));
+    }
+}
+
+void DmiCacheType::getLoadPath(DmiLoadPathType *path) {
+    path->tlb = reinterpret_cast<const uint8_t *>(tlb_[Access_Load]);
+    path->entry_size = sizeof(PageType);
+    path->entry_total = PAGE_TOTAL;
+    path->tag_off = offsetof(PageType, tag);
+    path->rptr_off = offsetof(PageType, rptr);
+    path->r_cnt = &util_[CFG_NASTI_MASTER_CACHED].r_cnt;
+}
+
+void DmiCacheType::flushType(EAccessType type) {
+    for (int i = 0; i < PAGE_TOTAL; i++) {
+        tlb_[type][i].tag = ~0ull;
+        tlb_[type][i].rptr = 0;
+        tlb_[type][i].wptr = 0;
+        tlb_[type][i].paddr = 0;
+        tlb_[type][i].span = 0;
+    }
+    superpages_[type] = 0;
+}
+
+/**
+ * The 4 KB entry can be only in one slot. Entries of the superpage are
+ * spread over the whole table, so the table is scanned when it holds any.
+ */
+void DmiCacheType::flushPage(uint64_t addr) {
+    uint64_t tag = addr >> PAGE_BITS;
+    for (int i = 0; i < Access_Total; i++) {
+        if (superpages_[i] == 0) {
+            PageType *page = &tlb_[i][slot(addr)];
+            if (page->tag == tag) {
+                page->tag = ~0ull;
+            }
+            continue;
+        }
+        for (int n = 0; n < PAGE_TOTAL; n++) {
+            PageType *page = &tlb_[i][n];
+            if (page->tag == ~0ull) {
+                continue;
+            }
+            if ((page->tag | page->span) == (tag | page->span)) {
+                if (page->span) {
+                    superpages_[i]--;
+                }
+                page->tag = ~0ull;
+                page->span = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Fetch is translated in S and U modes, loads and stores use the
+ * privilege from mstatus.MPP when mstatus.MPRV is set.
+ */
+void DmiCacheType::updateContext() {
+    csr_mstatus_type mstatus;
+    mstatus.value = ctx_->csr[Csr_mstatus];
+    uint64_t satp = ctx_->csr[Csr_satp];
+    if ((satp >> SATP_MODE_SHIFT) != SATP_MODE_SV39) {
+        satp = 0;
+    }
+    uint64_t prv = ctx_->cur_prv_level;
+    setMode(Access_Fetch, prv < PRV_M ? satp : 0, prv, false, false);
+
+    if (mstatus.bits.MPRV) {
+        prv = mstatus.bits.MPP;
+    }
+    bool sum = mstatus.bits.SUM != 0;
+    bool mxr = mstatus.bits.MXR != 0;
+    setMode(Access_Load, prv < PRV_M ? satp : 0, prv, sum, mxr);
+    setMode(Access_Store, prv < PRV_M ? satp : 0, prv, sum, mxr);
+}
+
+void DmiCacheType::setMode(EAccessType type, uint64_t satp, uint64_t prv,
+                           bool sum, bool mxr) {
+    ModeType mode;
+    mode.satp = satp;
+    mode.prv = satp ? prv : 0;
+    mode.sum = satp ? sum : false;
+    mode.mxr = satp ? mxr : false;
+    ModeType &cur = mode_[type];
+    if (cur.satp == mode.satp && cur.prv == mode.prv
+        && cur.sum == mode.sum && cur.mxr == mode.mxr) {
+        return;
+    }
+    cur = mode;
+    flushType(type);
+}
+
+void DmiCacheType::pageFault(uint64_t addr, EAccessType type) {
+    static const uint64_t FAULT_CODE[Access_Total] = {
+        EXCEPTION_InstrPageFault,
+        EXCEPTION_LoadPageFault,
+        EXCEPTION_StorePageFault
+    };
+    ctx_->csr[Csr_mbadaddr] = addr;
+    generateException(FAULT_CODE[type], ctx_);
+}
+
+/**
+ * Accesses are aligned, so only the untranslated accesses may cross the
+ * page boundary.
+ */
+ETransStatus DmiCacheType::slowAccess(Axi4TransactionType *trans,
+                                      PageType *page, EAccessType type) {
+    uint64_t vaddr = trans->addr;
+    trans->addr = page->paddr | (vaddr & PAGE_MASK);
+    if (type != Access_Fetch && watch_->isPageMarked(trans->addr)) {
+        uint32_t flags = trans->action == MemAction_Read ? WATCH_READ
+                                                         : WATCH_WRITE;
+        watch_->check(trans->addr, trans->xsize, flags);
+    }
+    ETransStatus ret = ibus_->b_transport(trans);
+    trans->addr = vaddr;
+    if (trans->action == MemAction_Write && page->rptr && !page->wptr) {
+        // Memory grants the write pointer after the first write (tracking)
+        grantPage(page);
+    }
+    return ret;
+}
+
+bool DmiCacheType::updatePage(PageType *page, uint64_t tag,
+                              EAccessType type) {
+    uint64_t page_addr = tag << PAGE_BITS;
+    uint64_t span = 0;
+    if (page->span) {
+        superpages_[type]--;
+    }
+    page->span = 0;
+    if (mode_[type].satp && !walk(page_addr, type, &page_addr, &span)) {
+        page->tag = ~0ull;
+        return false;
+    }
+    if (span) {
+        superpages_[type]++;
+    }
+    page->tag = tag;
+    page->span = span;
+    page->paddr = page_addr;
+    grantPage(page);
+    return true;
+}
+
+void DmiCacheType::grantPage(PageType *page) {
+    DmiRegionType dmi;
+    uint64_t page_addr = page->paddr;
+    page->rptr = 0;
+    page->wptr = 0;
+    if (watch_->isPageMarked(page_addr)) {
+        return;
+    }
+    if (!ibus_->get_direct_mem_ptr(page_addr, &dmi)) {
+        return;
+    }
+    // Only pages entirely located inside of the region are accessed directly
+    if (page_addr < dmi.addr
+        || (page_addr + PAGE_SIZE) > (dmi.addr + dmi.length)) {
+        return;
+    }
+    uint8_t *ptr = dmi.ptr + (page_addr - dmi.addr);
+    if (dmi.read_allowed) {
+        page->rptr = ptr;
+    }
+    if (dmi.write_allowed) {
+        page->wptr = ptr;
+    }
+}
+
+/**
+ * Sv39 page table walk. Accessed and Dirty bits are updated by the walker,
+ * so the store table is filled with the Dirty bit already set.
+ */
+bool DmiCacheType::walk(uint64_t vaddr, EAccessType type, uint64_t *paddr,
+                        uint64_t *span) {
+    // Bits [63:39] must be equal to bit 38
+    int64_t hi = static_cast<int64_t>(vaddr) >> 38;
+    if (hi != 0 && hi != -1) {
+        return false;
+    }
+    Axi4TransactionType tr;
+    tr.source_idx = CFG_NASTI_MASTER_CACHED;
+    tr.xsize = 8;
+    tr.wstrb = 0xff;
+    uint64_t base = (mode_[type].satp & SATP_PPN_MASK) << PAGE_BITS;
+    for (int level = SV39_LEVELS - 1; level >= 0; level--) {
+        int shift = PAGE_BITS + level * SV39_VPN_BITS;
+        uint64_t vpn = (vaddr >> shift) & ((1ull << SV39_VPN_BITS) - 1);
+        tr.action = MemAction_Read;
+        tr.addr = base + vpn * sizeof(uint64_t);
+        tr.rpayload.b64[0] = 0;
+        if (ibus_->b_transport(&tr) != TRANS_OK) {
+            return false;
+        }
+        uint64_t pte = tr.rpayload.b64[0];
+        if ((pte & PTE_V) == 0 || ((pte & PTE_R) == 0 && (pte & PTE_W))) {
+            return false;
+        }
+        uint64_t ppn = pte >> PTE_PPN_SHIFT;
+        if ((pte & (PTE_R | PTE_X)) == 0) {
+            // Pointer to the next level
+            base = (ppn & SATP_PPN_MASK) << PAGE_BITS;
+            continue;
+        }
+        uint64_t low_mask = (1ull << (level * SV39_VPN_BITS)) - 1;
+        if (!checkLeaf(pte, type) || (ppn & low_mask)) {
+            // No permission or misaligned superpage
+            return false;
+        }
+        uint64_t upd = pte | PTE_A;
+        if (type == Access_Store) {
+            upd |= PTE_D;
+        }
+        if (upd != pte) {
+            tr.action = MemAction_Write;
+            tr.wpayload.b64[0] = upd;
+            ibus_->b_transport(&tr);
+        }
+        ppn = (ppn & SATP_PPN_MASK) | ((vaddr >> PAGE_BITS) & low_mask);
+        *paddr = ppn << PAGE_BITS;
+        *span = low_mask;
+        return true;
+    }
+    return false;
+}
+
+bool DmiCacheType::checkLeaf(uint64_t pte, EAccessType type) {
+    const ModeType &mode = mode_[type];
+    if (pte & PTE_U) {
+        // Supervisor never executes user pages, data access needs SUM
+        if (mode.prv != PRV_U && (type == Access_Fetch || !mode.sum)) {
+            return false;
+        }
+    } else if (mode.prv == PRV_U) {
+        return false;
+    }
+    switch (type) {
+    case Access_Fetch:
+        return (pte & PTE_X) != 0;
+    case Access_Load:
+        return (pte & PTE_R) || (mode.mxr && (pte & PTE_X));
+    default:
+        return (pte & PTE_W) != 0;
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,262 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Direct memory interface cache and software TLB of the CPU.
+ *
+ * @details    Each entry keeps host pointers of one memory page received
+ *             from the slave device via DMI request. Accesses to the pages
+ *             with granted direct access don't use bus transactions. Pages
+ *             of the peripheral devices and pages with the data watchpoints
+ *             are cached with the empty pointers and always use the bus.
+ *
+ *             Entries are tagged by the virtual page number so the cache
+ *             is also the software TLB of the Sv39 translation. There is
+ *             a separate direct-mapped table per access type (fetch, load,
+ *             store): permission and A/D bits are checked on the table
+ *             fill, so a hit costs the same as an untranslated access.
+ *             Tables are flushed when the translation context (satp,
+ *             effective privilege, mstatus.SUM/MXR) changes.
+ *             Memory with the tracked writes grants the write pointer only
+ *             after the first write into the page that goes via the bus.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_DMI_H__
+#define __DEBUGGER_CPU_RISCV_DMI_H__
+
+#include <inttypes.h>
+#include <string.h>
+#include "coreservices/ibus.h"
+#include "coreservices/ibuslistener.h"
+#include "watchpoints.h"
+#include "codepages.h"
+
+namespace debugger {
+
+struct CpuContextType;
+
+/** Direct load path read by the generated host code (hostcode.h) */
+struct DmiLoadPathType {
+    const uint8_t *tlb;     // load entries indexed by the virtual page
+    uint32_t entry_size;
+    uint32_t entry_total;
+    uint32_t tag_off;       // virtual page number of the entry
+    uint32_t rptr_off;      // host pointer, NULL when read isn't direct
+    uint64_t *r_cnt;        // direct reads of the cached master
+};
+
+enum EAccessType {
+    Access_Fetch,
+    Access_Load,
+    Access_Store,       // store and AMO
+    Access_Total
+};
+
+class DmiCacheType {
+public:
+    DmiCacheType();
+
+    /**
+     * @brief Initialize cache.
+     * @param[in] ibus Bus interface to request DMI and to transmit
+     *                 transactions that cannot be handled directly.
+     * @param[in] owner Listener of the own write accesses that aren't
+     *                  visible on bus (decoded instructions cache).
+     * @param[in] code Code pages of the harts on the bus, the other harts
+     *                 are notified about the writes into them.
+     * @param[in] watch Data watchpoints. Direct access isn't granted for
+     *                  the watched pages.
+     * @param[in] ctx CPU context with the translation control registers.
+     *                Page faults are raised in this context.
+     */
+    void init(IBus *ibus, IBusListener *owner, CodePageTableType *code,
+              WatchpointTableType *watch, CpuContextType *ctx);
+
+    /** Data access with the direct memory access fast path */
+    ETransStatus b_transport(Axi4TransactionType *trans) {
+        return access(trans, trans->action == MemAction_Read ? Access_Load
+                                                             : Access_Store);
+    }
+
+    /** Instruction fetch, it isn't checked by data watchpoints */
+    ETransStatus fetch(Axi4TransactionType *trans) {
+        return access(trans, Access_Fetch);
+    }
+
+    /**
+     * @brief Translate virtual address without access.
+     * @return false on page fault, exception isn't raised.
+     */
+    bool translate(uint64_t addr, EAccessType type, uint64_t *paddr) {
+        if (mode_[type].satp == 0) {
+            *paddr = addr;
+            return true;
+        }
+        PageType *page = getPage(addr, type);
+        if (page == 0) {
+            return false;
+        }
+        *paddr = page->paddr | (addr & PAGE_MASK);
+        return true;
+    }
+
+    /** Raise page fault exception of the specified access type */
+    void pageFault(uint64_t addr, EAccessType type);
+
+    /**
+     * @brief Host pointer for the atomic operation.
+     * @param[in] write Read-modify-write access, otherwise read-only (LR).
+     * @return NULL if the data isn't accessible directly (peripheral or
+     *         watched page), use b_transport(), or on page fault that is
+     *         raised in the CPU context.
+     */
+    uint8_t *atomicPtr(uint64_t addr, uint32_t size, bool write) {
+        EAccessType type = write ? Access_Store : Access_Load;
+        PageType *page = getPage(addr, type);
+        if (page == 0) {
+            pageFault(addr, type);
+            return 0;
+        }
+        if (page->rptr == 0 || (write && page->wptr != page->rptr)
+            || (addr & PAGE_MASK) + size > PAGE_SIZE) {
+            return 0;
+        }
+        return &page->rptr[addr & PAGE_MASK];
+    }
+
+    /** Account access made via atomicPtr() */
+    void atomicDone(uint64_t addr, uint32_t size, uint32_t source_idx,
+                    bool write) {
+        util_[source_idx].r_cnt++;
+        if (write) {
+            PageType *page = &tlb_[Access_Store][slot(addr)];
+            util_[source_idx].w_cnt++;
+            owner_->writeNotify(page->paddr | (addr & PAGE_MASK), size);
+            code_->writeNotify(owner_, page->paddr | (addr & PAGE_MASK),
+                               size);
+        }
+    }
+
+    /** Revoke all granted pointers and cached translations */
+    void flush();
+
+    /** Layout of the load entries for the host code */
+    void getLoadPath(DmiLoadPathType *path);
+
+    /**
+     * @brief Remove cached translations of the page (SFENCE.VMA with
+     *        address). Entries filled from a superpage leaf that covers
+     *        the address are removed too.
+     */
+    void flushPage(uint64_t addr);
+
+    /**
+     * @brief Translation control registers or privilege level were
+     *        modified, tables of the changed access types are flushed.
+     */
+    void updateContext();
+
+private:
+    static const int PAGE_BITS = 12;
+    static const uint64_t PAGE_SIZE = 1ull << PAGE_BITS;
+    static const uint64_t PAGE_MASK = PAGE_SIZE - 1;
+    static const int PAGE_TOTAL = 256;
+
+    struct PageType {
+        uint64_t tag;       // virtual page number
+        uint8_t *rptr;      // NULL when direct read isn't allowed
+        uint8_t *wptr;      // NULL when direct write isn't allowed
+        uint64_t paddr;     // physical address of the page
+        uint64_t span;      // mask of the tag bits inside of the leaf page
+    };
+
+    /** Translation context of the access type */
+    struct ModeType {
+        uint64_t satp;      // 0 when translation is disabled
+        uint64_t prv;       // effective privilege level
+        bool sum;           // supervisor access to user pages
+        bool mxr;           // executable pages are readable
+    };
+
+    static uint64_t slot(uint64_t addr) {
+        return (addr >> PAGE_BITS) % PAGE_TOTAL;
+    }
+
+    /** Valid entry of the page or NULL on page fault */
+    PageType *getPage(uint64_t addr, EAccessType type) {
+        uint64_t tag = addr >> PAGE_BITS;
+        PageType *page = &tlb_[type][tag % PAGE_TOTAL];
+        if (page->tag != tag && !updatePage(page, tag, type)) {
+            return 0;
+        }
+        return page;
+    }
+
+    ETransStatus access(Axi4TransactionType *trans, EAccessType type) {
+        uint64_t tag = trans->addr >> PAGE_BITS;
+        PageType *page = &tlb_[type][tag % PAGE_TOTAL];
+        uint64_t off = trans->addr & PAGE_MASK;
+        if (page->tag != tag && !updatePage(page, tag, type)) {
+            pageFault(trans->addr, type);
+            trans->rpayload.b64[0] = 0;
+            trans->response = MemResp_Error;
+            return TRANS_ERROR;
+        }
+        if (off + trans->xsize > PAGE_SIZE) {
+            return slowAccess(trans, page, type);
+        }
+
+        if (trans->action == MemAction_Read) {
+            if (page->rptr == 0) {
+                return slowAccess(trans, page, type);
+            }
+            memcpy(trans->rpayload.b8, &page->rptr[off], trans->xsize);
+            util_[trans->source_idx].r_cnt++;
+        } else {
+            if (page->wptr == 0) {
+                return slowAccess(trans, page, type);
+            }
+            if (trans->wstrb == ((1u << trans->xsize) - 1)) {
+                memcpy(&page->wptr[off], trans->wpayload.b8, trans->xsize);
+            } else {
+                for (uint32_t i = 0; i < trans->xsize; i++) {
+                    if ((trans->wstrb >> i) & 0x1) {
+                        page->wptr[off + i] = trans->wpayload.b8[i];
+                    }
+                }
+            }
+            util_[trans->source_idx].w_cnt++;
+            owner_->writeNotify(page->paddr | off, trans->xsize);
+            code_->writeNotify(owner_, page->paddr | off, trans->xsize);
+        }
+        trans->response = MemResp_Valid;
+        return TRANS_OK;
+    }
+
+    /** Bus transaction, data accesses to the watched pages are checked */
+    ETransStatus slowAccess(Axi4TransactionType *trans, PageType *page,
+                            EAccessType type);
+    bool updatePage(PageType *page, uint64_t tag, EAccessType type);
+    /** Request host pointers of the translated page */
+    void grantPage(PageType *page);
+    bool walk(uint64_t vaddr, EAccessType type, uint64_t *paddr,
+              uint64_t *span);
+    bool checkLeaf(uint64_t pte, EAccessType type);
+    void setMode(EAccessType type, uint64_t satp, uint64_t prv, bool sum,
+                 bool mxr);
+    void flushType(EAccessType type);
+
+    IBus *ibus_;
+    IBusListener *owner_;
+    CodePageTableType *code_;
+    WatchpointTableType *watch_;
+    BusUtilType util_[CFG_NASTI_MASTER_TOTAL];  // DMI accesses of the hart
+    CpuContextType *ctx_;
+    ModeType mode_[Access_Total];
+    int superpages_[Access_Total];  // entries filled from the superpages
+    PageType tlb_[Access_Total][PAGE_TOTAL];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_DMI_H__
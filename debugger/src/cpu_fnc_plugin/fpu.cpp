@@ -0,0 +1,682 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Floating-point operations executed by the host FPU.
+ */
+
+#include <math.h>
+#include "fpu.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FPU_HOST_SSE 1
+#include <emmintrin.h>
+#else
+#include <fenv.h>
+#endif
+
+namespace debugger {
+
+/**
+ * Operands are passed through volatile variables so that the compiler
+ * doesn't move arithmetic out of the region with the modified rounding
+ * control and flags.
+ */
+#ifdef FPU_HOST_SSE
+/** All exceptions are masked, round to nearest, no FTZ/DAZ */
+static const unsigned MXCSR_DEFAULT = 0x1F80;
+/** MXCSR.RC value for each RISC-V rounding mode, RMM is corrected later */
+static const unsigned MXCSR_RC[5] = {0x0000, 0x6000, 0x2000, 0x4000, 0x0000};
+
+/**
+ * MXCSR flags are preloaded with the already accrued flags: reading MXCSR
+ * is several times slower when the operation has to change its flags.
+ */
+static inline void hostBegin(int rm, uint64_t flags) {
+    unsigned t = MXCSR_DEFAULT | MXCSR_RC[rm];
+    if (flags & FFLAGS_NV) {
+        t |= 0x01;
+    }
+    if (flags & FFLAGS_DZ) {
+        t |= 0x04;
+    }
+    if (flags & FFLAGS_OF) {
+        t |= 0x08;
+    }
+    if (flags & FFLAGS_UF) {
+        t |= 0x10;
+    }
+    if (flags & FFLAGS_NX) {
+        t |= 0x20;
+    }
+    _mm_setcsr(t);
+}
+
+static inline uint64_t hostEnd(int rm, uint64_t flags) {
+    unsigned t = _mm_getcsr();
+    if (MXCSR_RC[rm]) {
+        _mm_setcsr(MXCSR_DEFAULT);
+    }
+    uint64_t ret = flags;
+    if (t & 0x01) {
+        ret |= FFLAGS_NV;
+    }
+    if (t & 0x04) {
+        ret |= FFLAGS_DZ;
+    }
+    if (t & 0x08) {
+        ret |= FFLAGS_OF;
+    }
+    if (t & 0x10) {
+        ret |= FFLAGS_UF;
+    }
+    if (t & 0x20) {
+        ret |= FFLAGS_NX;
+    }
+    return ret;
+}
+
+static inline int64_t hostToInt(double x) {
+    volatile double t = x;
+    return _mm_cvtsd_si64(_mm_set_sd(t));
+}
+#else
+static const int FENV_RC[5] = {
+    FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST
+};
+
+static inline void hostBegin(int rm, uint64_t flags) {
+    if (FENV_RC[rm] != FE_TONEAREST) {
+        fesetround(FENV_RC[rm]);
+    }
+    feclearexcept(FE_ALL_EXCEPT);
+}
+
+static inline uint64_t hostEnd(int rm, uint64_t flags) {
+    int t = fetestexcept(FE_ALL_EXCEPT);
+    if (FENV_RC[rm] != FE_TONEAREST) {
+        fesetround(FE_TONEAREST);
+    }
+    uint64_t ret = flags;
+    if (t & FE_INVALID) {
+        ret |= FFLAGS_NV;
+    }
+    if (t & FE_DIVBYZERO) {
+        ret |= FFLAGS_DZ;
+    }
+    if (t & FE_OVERFLOW) {
+        ret |= FFLAGS_OF;
+    }
+    if (t & FE_UNDERFLOW) {
+        ret |= FFLAGS_UF;
+    }
+    if (t & FE_INEXACT) {
+        ret |= FFLAGS_NX;
+    }
+    return ret;
+}
+
+static inline int64_t hostToInt(double x) {
+    volatile double t = x;
+    return llrint(t);
+}
+#endif
+
+static inline float hostSqrt(float x) { return sqrtf(x); }
+static inline double hostSqrt(double x) { return sqrt(x); }
+static inline float hostFma(float a, float b, float c) {
+    return fmaf(a, b, c);
+}
+static inline double hostFma(double a, double b, double c) {
+    return fma(a, b, c);
+}
+static inline float hostNext(float x, float to) { return nextafterf(x, to); }
+static inline double hostNext(double x, double to) {
+    return nextafter(x, to);
+}
+
+template <typename T> struct FpTraits;
+
+template <> struct FpTraits<float> {
+    typedef uint32_t Bits;
+    static const Bits SIGN = 0x80000000u;
+    static const Bits EXP = 0x7f800000u;
+    static const Bits FRAC = 0x007fffffu;
+    static const Bits QUIET = 0x00400000u;
+    static const Bits NAN_VALUE = CANONICAL_NAN32;
+    static const int MANT_BITS = 24;
+    static float value(Bits v) {
+        union { Bits u; float f; } t;
+        t.u = v;
+        return t.f;
+    }
+    static Bits bits(float v) {
+        union { Bits u; float f; } t;
+        t.f = v;
+        return t.u;
+    }
+};
+
+template <> struct FpTraits<double> {
+    typedef uint64_t Bits;
+    static const Bits SIGN = 0x8000000000000000ull;
+    static const Bits EXP = 0x7ff0000000000000ull;
+    static const Bits FRAC = 0x000fffffffffffffull;
+    static const Bits QUIET = 0x0008000000000000ull;
+    static const Bits NAN_VALUE = CANONICAL_NAN64;
+    static const int MANT_BITS = 53;
+    static double value(Bits v) {
+        union { Bits u; double f; } t;
+        t.u = v;
+        return t.f;
+    }
+    static Bits bits(double v) {
+        union { Bits u; double f; } t;
+        t.f = v;
+        return t.u;
+    }
+};
+
+template <typename T>
+static inline bool isNaN(typename FpTraits<T>::Bits v) {
+    return (v & ~FpTraits<T>::SIGN) > FpTraits<T>::EXP;
+}
+
+template <typename T>
+static inline bool isSNaN(typename FpTraits<T>::Bits v) {
+    return isNaN<T>(v) && !(v & FpTraits<T>::QUIET);
+}
+
+template <typename T>
+static inline bool isInf(typename FpTraits<T>::Bits v) {
+    return (v & ~FpTraits<T>::SIGN) == FpTraits<T>::EXP;
+}
+
+/**
+ * @brief Round to nearest with ties to max magnitude.
+ * @details Host rounds ties to even, so the result is moved one ulp
+ *          away from zero when the exact value was exactly in the middle.
+ * @param[in] r Result rounded to nearest even.
+ * @param[in] err Exact rounding error (exact value minus 'r').
+ */
+template <typename T>
+static T tieAway(T r, double err) {
+    if (err == 0 || isInf<T>(FpTraits<T>::bits(r))) {
+        return r;
+    }
+    T n = hostNext(r, err > 0 ? static_cast<T>(HUGE_VAL)
+                              : static_cast<T>(-HUGE_VAL));
+    double gap = fabs(static_cast<double>(n) - static_cast<double>(r));
+    if (fabs(n) > fabs(r) && 2.0 * fabs(err) == gap) {
+        return n;
+    }
+    return r;
+}
+
+/** Exact error of the rounded single precision product */
+static inline double mulError(float a, float b, float r) {
+    return static_cast<double>(a) * static_cast<double>(b)
+         - static_cast<double>(r);
+}
+
+/** Exact error of the rounded double precision product */
+static inline double mulError(double a, double b, double r) {
+    return fma(a, b, -r);
+}
+
+/**
+ * @brief Exact zero test of a sum of doubles.
+ * @details Terms are accumulated into a non-overlapping expansion with the
+ *          error-free summation (Shewchuk's Grow-Expansion), such sum is
+ *          zero only when all of its components are zero. Requires round
+ *          to nearest and no overflow.
+ */
+static bool isZeroSum(const double *term, int total) {
+    double e[8];
+    int sz = 0;
+    for (int i = 0; i < total; i++) {
+        volatile double q = term[i];
+        for (int n = 0; n < sz; n++) {
+            volatile double sum = q + e[n];
+            volatile double bv = sum - q;
+            volatile double av = sum - bv;
+            e[n] = (q - av) + (e[n] - bv);
+            q = sum;
+        }
+        e[sz++] = q;
+    }
+    for (int i = 0; i < sz; i++) {
+        if (e[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Single precision product is exact in double precision, so the fused
+ * result is exactly the sum of the product and the addend.
+ */
+static bool isFmaMidpoint(float a, float b, float c, float r, float n) {
+    double t[4];
+    t[0] = static_cast<double>(a) * static_cast<double>(b);
+    t[1] = static_cast<double>(c);
+    t[2] = -static_cast<double>(r);
+    t[3] = -0.5 * (static_cast<double>(n) - static_cast<double>(r));
+    return isZeroSum(t, 4);
+}
+
+/**
+ * Operands are scaled to the product exponent near zero, so the product
+ * error and the half of ulp are exact. Addend that is far below or above
+ * the product can't make an exact midpoint.
+ */
+static bool isFmaMidpoint(double a, double b, double c, double r, double n) {
+    if (a == 0 || b == 0) {
+        return false;
+    }
+    int ka = -ilogb(a);
+    int kb = -ilogb(b);
+    int k = ka + kb;
+    if (c != 0) {
+        int ec = ilogb(c);
+        // Product is below 1/8 of the addend ulp or above its bits
+        if (ec - 57 > -k || ec + k < -900) {
+            return false;
+        }
+    }
+    double x = ldexp(a, ka);
+    double y = ldexp(b, kb);
+    double rs = ldexp(r, k);
+    double t[5];
+    t[0] = x * y;
+    t[1] = fma(x, y, -t[0]);
+    t[2] = ldexp(c, k);
+    t[3] = -rs;
+    t[4] = -0.5 * (ldexp(n, k) - rs);
+    return isZeroSum(t, 5);
+}
+
+template <typename T>
+static typename FpTraits<T>::Bits arith(EFpuOp op, int rm,
+                                        typename FpTraits<T>::Bits a,
+                                        typename FpTraits<T>::Bits b,
+                                        uint64_t *flags) {
+    volatile T x = FpTraits<T>::value(a);
+    volatile T y = FpTraits<T>::value(b);
+    volatile T r;
+    hostBegin(rm, *flags);
+    switch (op) {
+    case Fpu_Add:
+        r = x + y;
+        break;
+    case Fpu_Sub:
+        r = x - y;
+        break;
+    case Fpu_Mul:
+        r = x * y;
+        break;
+    case Fpu_Div:
+        r = x / y;
+        break;
+    default:
+        r = hostSqrt(x);
+    }
+    *flags = hostEnd(rm, *flags);
+
+    typename FpTraits<T>::Bits ret = FpTraits<T>::bits(r);
+    if (isNaN<T>(ret)) {
+        return FpTraits<T>::NAN_VALUE;
+    }
+    if (rm == FRM_RMM && (*flags & FFLAGS_NX)) {
+        // Quotient and square root are never exactly in the middle
+        T s = r;
+        T u = x;
+        T v = op == Fpu_Sub ? -y : y;
+        if (op == Fpu_Add || op == Fpu_Sub) {
+            T bb = s - u;
+            ret = FpTraits<T>::bits(tieAway(s, (u - (s - bb)) + (v - bb)));
+        } else if (op == Fpu_Mul) {
+            ret = FpTraits<T>::bits(tieAway(s, mulError(u, v, s)));
+        }
+    }
+    return ret;
+}
+
+template <typename T>
+static typename FpTraits<T>::Bits fusedMulAdd(EFpuFma op, int rm,
+                                              typename FpTraits<T>::Bits a,
+                                              typename FpTraits<T>::Bits b,
+                                              typename FpTraits<T>::Bits c,
+                                              uint64_t *flags) {
+    if (op == Fpu_NMSub || op == Fpu_NMAdd) {
+        a ^= FpTraits<T>::SIGN;
+    }
+    if (op == Fpu_MSub || op == Fpu_NMAdd) {
+        c ^= FpTraits<T>::SIGN;
+    }
+    volatile T x = FpTraits<T>::value(a);
+    volatile T y = FpTraits<T>::value(b);
+    volatile T z = FpTraits<T>::value(c);
+    volatile T r;
+    hostBegin(rm, *flags);
+    r = hostFma(x, y, z);
+    *flags = hostEnd(rm, *flags);
+
+    // Invalid even if the addend is a quiet NaN
+    if ((isInf<T>(a) && (b & ~FpTraits<T>::SIGN) == 0)
+        || (isInf<T>(b) && (a & ~FpTraits<T>::SIGN) == 0)) {
+        *flags |= FFLAGS_NV;
+    }
+    typename FpTraits<T>::Bits ret = FpTraits<T>::bits(r);
+    if (isNaN<T>(ret)) {
+        return FpTraits<T>::NAN_VALUE;
+    }
+    if (rm == FRM_RMM && (*flags & FFLAGS_NX) && !isInf<T>(ret)) {
+        // Host result is the even neighbour, check the one away from zero
+        T s = r;
+        T n = hostNext(s, (ret & FpTraits<T>::SIGN)
+                          ? static_cast<T>(-HUGE_VAL)
+                          : static_cast<T>(HUGE_VAL));
+        if (!isInf<T>(FpTraits<T>::bits(n)) && isFmaMidpoint(x, y, z, s, n)) {
+            ret = FpTraits<T>::bits(n);
+        }
+    }
+    return ret;
+}
+
+template <typename T>
+static typename FpTraits<T>::Bits minMax(bool max,
+                                         typename FpTraits<T>::Bits a,
+                                         typename FpTraits<T>::Bits b,
+                                         uint64_t *flags) {
+    if (isSNaN<T>(a) || isSNaN<T>(b)) {
+        *flags |= FFLAGS_NV;
+    }
+    if (isNaN<T>(a)) {
+        return isNaN<T>(b) ? FpTraits<T>::NAN_VALUE : b;
+    } else if (isNaN<T>(b)) {
+        return a;
+    }
+    T x = FpTraits<T>::value(a);
+    T y = FpTraits<T>::value(b);
+    if (x == y) {
+        // -0.0 is less than +0.0
+        return max ? (a & b) : (a | b);
+    }
+    return ((x < y) != max) ? a : b;
+}
+
+template <typename T>
+static uint64_t compare(bool lt, bool eq, typename FpTraits<T>::Bits a,
+                        typename FpTraits<T>::Bits b, uint64_t *flags) {
+    if (isNaN<T>(a) || isNaN<T>(b)) {
+        // FEQ is quiet comparision, FLT and FLE are signaling
+        if (lt || isSNaN<T>(a) || isSNaN<T>(b)) {
+            *flags |= FFLAGS_NV;
+        }
+        return 0;
+    }
+    T x = FpTraits<T>::value(a);
+    T y = FpTraits<T>::value(b);
+    return ((lt && x < y) || (eq && x == y)) ? 1 : 0;
+}
+
+template <typename T>
+static uint64_t classify(typename FpTraits<T>::Bits a) {
+    bool sign = (a & FpTraits<T>::SIGN) != 0;
+    typename FpTraits<T>::Bits exp = a & FpTraits<T>::EXP;
+    typename FpTraits<T>::Bits frac = a & FpTraits<T>::FRAC;
+    if (exp == FpTraits<T>::EXP) {
+        if (frac == 0) {
+            return sign ? (1 << 0) : (1 << 7);
+        }
+        return (frac & FpTraits<T>::QUIET) ? (1 << 9) : (1 << 8);
+    }
+    if (exp == 0) {
+        if (frac == 0) {
+            return sign ? (1 << 3) : (1 << 4);
+        }
+        return sign ? (1 << 2) : (1 << 5);
+    }
+    return sign ? (1 << 1) : (1 << 6);
+}
+
+/**
+ * Both single and double precision values are converted from the double
+ * value, single to double conversion is exact.
+ */
+static uint64_t toInt(int rm, double x, bool nan, bool is32, bool isUnsigned,
+                      uint64_t *flags) {
+    static const double TWO63 = 9223372036854775808.0;
+    uint64_t imax, imin;
+    if (is32) {
+        imax = isUnsigned ? ~0ull : 0x7fffffffull;
+        imin = isUnsigned ? 0 : 0xffffffff80000000ull;
+    } else {
+        imax = isUnsigned ? ~0ull : 0x7fffffffffffffffull;
+        imin = isUnsigned ? 0 : 0x8000000000000000ull;
+    }
+    // Invalid conversion raises only NV
+    uint64_t accrued = *flags;
+    *flags = accrued | FFLAGS_NV;
+    if (nan) {
+        return imax;
+    }
+
+    uint64_t inexact = 0;
+    if (rm == FRM_RMM) {
+        // round() rounds half-way cases away from zero
+        double t = round(x);
+        if (t != x) {
+            inexact = FFLAGS_NX;
+        }
+        x = t;
+        rm = FRM_RNE;
+    }
+
+    if (isUnsigned && !is32 && x >= TWO63) {
+        if (x >= 2.0 * TWO63) {
+            return imax;
+        }
+        // All values of this range are integers, conversion is exact
+        *flags = accrued | inexact;
+        return static_cast<uint64_t>(hostToInt(x - TWO63)) ^ (1ull << 63);
+    }
+    if (x >= TWO63) {
+        return imax;
+    } else if (x < -TWO63) {
+        return imin;
+    }
+
+    hostBegin(rm, accrued);
+    int64_t r = hostToInt(x);
+    uint64_t res_flags = hostEnd(rm, accrued) | inexact;
+
+    if (isUnsigned && r < 0) {
+        return 0;
+    }
+    if (is32) {
+        if (isUnsigned && r > 0xffffffffll) {
+            return imax;
+        } else if (!isUnsigned && r > 0x7fffffffll) {
+            return imax;
+        } else if (!isUnsigned && r < -0x80000000ll) {
+            return imin;
+        }
+        // Sign extension of 32-bits result even for unsigned conversion
+        *flags = res_flags;
+        return static_cast<uint64_t>(static_cast<int64_t>(
+                    static_cast<int32_t>(r)));
+    }
+    *flags = res_flags;
+    return static_cast<uint64_t>(r);
+}
+
+/** Integer conversion with ties to max magnitude rounded in software */
+template <typename T>
+static typename FpTraits<T>::Bits fromIntAway(uint64_t v, bool isUnsigned,
+                                              uint64_t *flags) {
+    bool neg = !isUnsigned && static_cast<int64_t>(v) < 0;
+    uint64_t m = neg ? 0 - v : v;
+    int shift = -FpTraits<T>::MANT_BITS;
+    for (uint64_t t = m; t; t >>= 1) {
+        shift++;
+    }
+    if (shift > 0) {
+        uint64_t rest = m & ((1ull << shift) - 1);
+        m >>= shift;
+        if (rest >= (1ull << (shift - 1))) {
+            m++;
+        }
+        if (rest) {
+            *flags |= FFLAGS_NX;
+        }
+    } else {
+        shift = 0;
+    }
+    // Mantissa fits into the type, so both conversions are exact
+    T r = static_cast<T>(ldexp(static_cast<double>(m), shift));
+    return FpTraits<T>::bits(neg ? -r : r);
+}
+
+template <typename T>
+static typename FpTraits<T>::Bits fromInt(int rm, uint64_t v,
+                                          bool isUnsigned, uint64_t *flags) {
+    volatile T r;
+    if (rm == FRM_RMM) {
+        return fromIntAway<T>(v, isUnsigned, flags);
+    }
+    hostBegin(rm, *flags);
+    if (!isUnsigned || !(v >> 63)) {
+        volatile int64_t t = static_cast<int64_t>(v);
+        r = static_cast<T>(t);
+    } else {
+        // Halve with the sticky bit to keep the rounding correct
+        volatile int64_t t = static_cast<int64_t>((v >> 1) | (v & 1));
+        r = static_cast<T>(t);
+        r = r + r;
+    }
+    *flags = hostEnd(rm, *flags);
+    return FpTraits<T>::bits(r);
+}
+
+int fpuRoundingMode(uint32_t rm, CpuContextType *data) {
+    if (rm == FRM_DYN) {
+        rm = static_cast<uint32_t>(data->csr[Csr_frm]);
+    }
+    return rm <= FRM_RMM ? static_cast<int>(rm) : -1;
+}
+
+void fpuUpdateStatus(uint64_t flags, CpuContextType *data) {
+    if (flags) {
+        data->csr[Csr_fflags] |= flags;
+        data->csr[Csr_fcsr] |= flags;
+    }
+    csr_mstatus_type mstatus;
+    mstatus.value = data->csr[Csr_mstatus];
+    if (mstatus.bits.FS != 3) {
+        mstatus.bits.FS = 3;
+        mstatus.bits.SD = 1;
+        data->csr[Csr_mstatus] = mstatus.value;
+    }
+}
+
+uint32_t fpuArith32(EFpuOp op, int rm, uint32_t a, uint32_t b,
+                    uint64_t *flags) {
+    return arith<float>(op, rm, a, b, flags);
+}
+
+uint64_t fpuArith64(EFpuOp op, int rm, uint64_t a, uint64_t b,
+                    uint64_t *flags) {
+    return arith<double>(op, rm, a, b, flags);
+}
+
+uint32_t fpuFma32(EFpuFma op, int rm, uint32_t a, uint32_t b, uint32_t c,
+                  uint64_t *flags) {
+    return fusedMulAdd<float>(op, rm, a, b, c, flags);
+}
+
+uint64_t fpuFma64(EFpuFma op, int rm, uint64_t a, uint64_t b, uint64_t c,
+                  uint64_t *flags) {
+    return fusedMulAdd<double>(op, rm, a, b, c, flags);
+}
+
+uint32_t fpuMinMax32(bool max, uint32_t a, uint32_t b, uint64_t *flags) {
+    return minMax<float>(max, a, b, flags);
+}
+
+uint64_t fpuMinMax64(bool max, uint64_t a, uint64_t b, uint64_t *flags) {
+    return minMax<double>(max, a, b, flags);
+}
+
+uint64_t fpuCompare32(bool lt, bool eq, uint32_t a, uint32_t b,
+                      uint64_t *flags) {
+    return compare<float>(lt, eq, a, b, flags);
+}
+
+uint64_t fpuCompare64(bool lt, bool eq, uint64_t a, uint64_t b,
+                      uint64_t *flags) {
+    return compare<double>(lt, eq, a, b, flags);
+}
+
+uint64_t fpuClass32(uint32_t a) {
+    return classify<float>(a);
+}
+
+uint64_t fpuClass64(uint64_t a) {
+    return classify<double>(a);
+}
+
+uint32_t fpuCvtSD(int rm, uint64_t a, uint64_t *flags) {
+    if (isNaN<double>(a)) {
+        if (isSNaN<double>(a)) {
+            *flags |= FFLAGS_NV;
+        }
+        return CANONICAL_NAN32;
+    }
+    volatile double x = FpTraits<double>::value(a);
+    volatile float r;
+    hostBegin(rm, *flags);
+    r = static_cast<float>(x);
+    *flags = hostEnd(rm, *flags);
+    if (rm == FRM_RMM && (*flags & FFLAGS_NX)) {
+        float s = r;
+        return FpTraits<float>::bits(tieAway(s, x - static_cast<double>(s)));
+    }
+    return FpTraits<float>::bits(r);
+}
+
+uint64_t fpuCvtDS(uint32_t a, uint64_t *flags) {
+    if (isNaN<float>(a)) {
+        if (isSNaN<float>(a)) {
+            *flags |= FFLAGS_NV;
+        }
+        return CANONICAL_NAN64;
+    }
+    return FpTraits<double>::bits(FpTraits<float>::value(a));
+}
+
+uint64_t fpuToInt32(int rm, uint32_t a, bool is32, bool isUnsigned,
+                    uint64_t *flags) {
+    double x = isNaN<float>(a) ? 0 : FpTraits<float>::value(a);
+    return toInt(rm, x, isNaN<float>(a), is32, isUnsigned, flags);
+}
+
+uint64_t fpuToInt64(int rm, uint64_t a, bool is32, bool isUnsigned,
+                    uint64_t *flags) {
+    double x = isNaN<double>(a) ? 0 : FpTraits<double>::value(a);
+    return toInt(rm, x, isNaN<double>(a), is32, isUnsigned, flags);
+}
+
+uint32_t fpuFromInt32(int rm, uint64_t v, bool isUnsigned,
+                      uint64_t *flags) {
+    return fromInt<float>(rm, v, isUnsigned, flags);
+}
+
+uint64_t fpuFromInt64(int rm, uint64_t v, bool isUnsigned,
+                      uint64_t *flags) {
+    return fromInt<double>(rm, v, isUnsigned, flags);
+}
+
+}  // namespace debugger
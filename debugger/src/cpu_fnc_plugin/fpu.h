@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Floating-point operations executed by the host FPU.
+ *
+ * @details    Arithmetic is done by the host scalar SSE instructions with
+ *             the MXCSR rounding control switched to the RISC-V rounding
+ *             mode, accrued exceptions are read back from MXCSR and
+ *             converted into the fflags format. Cases where x86 behaves
+ *             differently from RISC-V (NaN propagation, min/max, integer
+ *             conversion overflow, unsigned conversion, RMM rounding) are
+ *             corrected in software. Hosts without SSE use <fenv.h>.
+ *
+ *             Operands and results are raw IEEE-754 bits. Single precision
+ *             values are stored in 64-bits registers NaN-boxed.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_FPU_H__
+#define __DEBUGGER_CPU_RISCV_FPU_H__
+
+#include <inttypes.h>
+#include "iinstr.h"
+
+namespace debugger {
+
+/** @name fflags bits */
+/// @{
+static const uint64_t FFLAGS_NX = 0x01;     // Inexact
+static const uint64_t FFLAGS_UF = 0x02;     // Underflow
+static const uint64_t FFLAGS_OF = 0x04;     // Overflow
+static const uint64_t FFLAGS_DZ = 0x08;     // Divide by zero
+static const uint64_t FFLAGS_NV = 0x10;     // Invalid operation
+/// @}
+
+/** @name Rounding modes (instruction 'rm' field and frm register) */
+/// @{
+static const int FRM_RNE = 0;   // Round to nearest, ties to even
+static const int FRM_RTZ = 1;   // Round towards zero
+static const int FRM_RDN = 2;   // Round down
+static const int FRM_RUP = 3;   // Round up
+static const int FRM_RMM = 4;   // Round to nearest, ties to max magnitude
+static const int FRM_DYN = 7;   // Use frm register
+/// @}
+
+static const uint32_t CANONICAL_NAN32 = 0x7fc00000;
+static const uint64_t CANONICAL_NAN64 = 0x7ff8000000000000ull;
+static const uint64_t NAN_BOX32 = 0xffffffff00000000ull;
+
+enum EFpuOp {
+    Fpu_Add,
+    Fpu_Sub,
+    Fpu_Mul,
+    Fpu_Div,
+    Fpu_Sqrt
+};
+
+enum EFpuFma {
+    Fpu_MAdd,       // rs1 * rs2 + rs3
+    Fpu_MSub,       // rs1 * rs2 - rs3
+    Fpu_NMSub,      // -(rs1 * rs2) + rs3
+    Fpu_NMAdd       // -(rs1 * rs2) - rs3
+};
+
+/**
+ * @brief Resolve instruction rounding mode.
+ * @return Static rounding mode or -1 if it is reserved.
+ */
+int fpuRoundingMode(uint32_t rm, CpuContextType *data);
+
+/** Update fflags and mark FPU state (mstatus.FS) as Dirty. */
+void fpuUpdateStatus(uint64_t flags, CpuContextType *data);
+
+/** Single precision operand from NaN-boxed register value. */
+static inline uint32_t fpuUnbox32(uint64_t v) {
+    return (v & NAN_BOX32) == NAN_BOX32 ? static_cast<uint32_t>(v)
+                                        : CANONICAL_NAN32;
+}
+
+/**
+ * @name Operations.
+ * @param[in] rm Static rounding mode.
+ * @param[in,out] flags Accrued exceptions in fflags format, raised by
+ *                      the operation flags are added.
+ */
+/// @{
+uint32_t fpuArith32(EFpuOp op, int rm, uint32_t a, uint32_t b,
+                    uint64_t *flags);
+uint64_t fpuArith64(EFpuOp op, int rm, uint64_t a, uint64_t b,
+                    uint64_t *flags);
+uint32_t fpuFma32(EFpuFma op, int rm, uint32_t a, uint32_t b, uint32_t c,
+                  uint64_t *flags);
+uint64_t fpuFma64(EFpuFma op, int rm, uint64_t a, uint64_t b, uint64_t c,
+                  uint64_t *flags);
+uint32_t fpuMinMax32(bool max, uint32_t a, uint32_t b, uint64_t *flags);
+uint64_t fpuMinMax64(bool max, uint64_t a, uint64_t b, uint64_t *flags);
+
+/** @return 1 when relation is true; 'le' without 'lt' means equal. */
+uint64_t fpuCompare32(bool lt, bool eq, uint32_t a, uint32_t b,
+                      uint64_t *flags);
+uint64_t fpuCompare64(bool lt, bool eq, uint64_t a, uint64_t b,
+                      uint64_t *flags);
+uint64_t fpuClass32(uint32_t a);
+uint64_t fpuClass64(uint64_t a);
+
+uint32_t fpuCvtSD(int rm, uint64_t a, uint64_t *flags);
+uint64_t fpuCvtDS(uint32_t a, uint64_t *flags);
+
+/**
+ * @brief Conversion into integer with saturation.
+ * @param[in] is32 Result is 32-bits value sign extended to 64 bits.
+ * @param[in] isUnsigned Unsigned integer conversion.
+ */
+uint64_t fpuToInt32(int rm, uint32_t a, bool is32, bool isUnsigned,
+                    uint64_t *flags);
+uint64_t fpuToInt64(int rm, uint64_t a, bool is32, bool isUnsigned,
+                    uint64_t *flags);
+
+/** @param[in] v Integer already sign or zero extended to 64 bits. */
+uint32_t fpuFromInt32(int rm, uint64_t v, bool isUnsigned,
+                      uint64_t *flags);
+uint64_t fpuFromInt64(int rm, uint64_t v, bool isUnsigned,
+                      uint64_t *flags);
+/// @}
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_FPU_H__
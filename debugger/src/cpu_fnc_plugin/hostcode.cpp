@@ -0,0 +1,493 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      x86-64 code generator of the decoded basic blocks.
+ *
+ * @details    Generated function keeps context pointer in rbx and virtual
+ *             pc of the run start in r8. Registers are loaded into rax
+ *             and rcx for each instruction, the result is stored back.
+ *             Loads use rdx and r9 too. Side exits are placed after the
+ *             run epilogue.
+ */
+
+#include <stddef.h>
+#include "hostcode.h"
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace debugger {
+
+enum EHostReg {
+    Host_rax = 0,
+    Host_rcx = 1,
+    Host_rdx = 2
+};
+
+/** Condition codes of the x86 jcc/setcc/cmovcc instructions */
+enum EHostCond {
+    Cond_B = 0x2,
+    Cond_AE = 0x3,
+    Cond_E = 0x4,
+    Cond_NE = 0x5,
+    Cond_L = 0xC,
+    Cond_GE = 0xD
+};
+
+static const int32_t OFF_REGS = offsetof(CpuContextType, regs);
+static const int32_t OFF_PC = offsetof(CpuContextType, pc);
+static const int32_t OFF_NPC = offsetof(CpuContextType, npc);
+static const int32_t OFF_STEP = offsetof(CpuContextType, step_cnt);
+
+static uint32_t fld(uint32_t v, int hi, int lo) {
+    return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+HostCodeType::HostCodeType() {
+    buf_ = 0;
+    size_ = 0;
+    used_ = 0;
+    load_.tlb = 0;
+}
+
+HostCodeType::~HostCodeType() {
+    if (!buf_) {
+        return;
+    }
+#if defined(_WIN32) || defined(__CYGWIN__)
+    VirtualFree(buf_, 0, MEM_RELEASE);
+#else
+    munmap(buf_, size_);
+#endif
+}
+
+bool HostCodeType::init(const DmiLoadPathType *load) {
+#if defined(_M_X64) || defined(__x86_64__)
+    load_.tlb = 0;
+    // Table slot is selected by mask
+    if (load && (load->entry_total & (load->entry_total - 1)) == 0) {
+        load_ = *load;
+    }
+#if defined(_WIN32) || defined(__CYGWIN__)
+    void *p = VirtualAlloc(NULL, static_cast<SIZE_T>(BUFFER_SIZE),
+                           MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+    if (p == NULL) {
+        return false;
+    }
+#else
+    void *p = mmap(NULL, BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+#endif
+    buf_ = static_cast<uint8_t *>(p);
+    size_ = BUFFER_SIZE;
+    used_ = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Handlers write x0 as any other register, translated code drops such
+ * results, x0 is always zero for the compiler generated code.
+ */
+bool HostCodeType::isSupported(uint32_t payload) {
+    uint32_t funct3 = fld(payload, 14, 12);
+    uint32_t funct7 = fld(payload, 31, 25);
+    switch (payload & 0x7f) {
+    case 0x37:      // LUI
+    case 0x17:      // AUIPC
+        return true;
+    case 0x13:      // OP-IMM
+        if (funct3 == 1) {
+            return fld(payload, 31, 26) == 0;
+        }
+        if (funct3 == 5) {
+            return fld(payload, 31, 26) == 0 || fld(payload, 31, 26) == 0x10;
+        }
+        return true;
+    case 0x1B:      // OP-IMM-32
+        if (funct3 == 0) {
+            return true;
+        }
+        if (funct3 == 1) {
+            return funct7 == 0;
+        }
+        return funct3 == 5 && (funct7 == 0 || funct7 == 0x20);
+    case 0x33:      // OP
+        if (funct7 == 0) {
+            return true;
+        }
+        if (funct7 == 0x20) {
+            return funct3 == 0 || funct3 == 5;
+        }
+        return funct7 == 1 && funct3 == 0;
+    case 0x3B:      // OP-32, SLLW and SRLW handlers don't mask shift amount
+        if (funct7 == 0) {
+            return funct3 == 0;
+        }
+        if (funct7 == 0x20) {
+            return funct3 == 0 || funct3 == 5;
+        }
+        return funct7 == 1 && funct3 == 0;
+    case 0x63:      // BRANCH
+        return funct3 != 2 && funct3 != 3;
+    case 0x03:      // LOAD, x0 destination is left to the handler
+        return load_.tlb && funct3 != 7 && fld(payload, 11, 7) != 0;
+    default:;
+    }
+    return false;
+}
+
+HostCodeFunc HostCodeType::translate(const uint32_t *payload,
+                                     const uint32_t *length,
+                                     int total, int *used) {
+    *used = 0;
+    if (total > RUN_INSTR_MAX) {
+        total = RUN_INSTR_MAX;
+    }
+    if (!buf_ || total == 0 || !isSupported(payload[0])
+        || !hasSpace(total)) {
+        return 0;
+    }
+    uint8_t *start = &buf_[used_];
+    emit8(0x53);                        // push rbx
+#if defined(_WIN32) || defined(__CYGWIN__)
+    emit8(0x48); emit8(0x89); emit8(0xCB);  // mov rbx, rcx
+#else
+    emit8(0x48); emit8(0x89); emit8(0xFB);  // mov rbx, rdi
+#endif
+    emit8(0x4C); emit8(0x8B); emit8(0x83);  // mov r8, [rbx + npc]
+    emit32(OFF_NPC);
+
+    uint32_t off = 0;
+    uint32_t last = 0;
+    bool branch = false;
+    int n = 0;
+    int exit_total = 0;
+    while (n < total && isSupported(payload[n])) {
+        if (isBranch(payload[n])) {
+            last = off;
+            emitBranch(payload[n], off, length[n]);
+            branch = true;
+            n++;
+            break;
+        }
+        if (isLoad(payload[n])) {
+            SideExitType *exit = &exits_[exit_total++];
+            exit->jump_total = 0;
+            exit->executed = n;
+            exit->prev_off = last;
+            exit->off = off;
+            emitLoad(payload[n], exit);
+        } else {
+            emitInstr(payload[n], off);
+        }
+        last = off;
+        off += length[n];
+        n++;
+    }
+
+    emitLeaPc(Host_rax, last);
+    emitStoreCtx(OFF_PC);
+    if (!branch) {
+        emitLeaPc(Host_rax, off);
+        emitStoreCtx(OFF_NPC);
+    }
+    emit8(0x48); emit8(0x81); emit8(0x83);  // add qword [rbx + step], n
+    emit32(OFF_STEP);
+    emit32(n);
+    emit8(0xB8);                        // mov eax, n
+    emit32(n);
+    emit8(0x5B);                        // pop rbx
+    emit8(0xC3);                        // ret
+
+    for (int i = 0; i < exit_total; i++) {
+        emitExit(&exits_[i]);
+    }
+
+    *used = n;
+    return reinterpret_cast<HostCodeFunc>(start);
+}
+
+void HostCodeType::emitInstr(uint32_t payload, uint32_t off) {
+    uint32_t rd = fld(payload, 11, 7);
+    uint32_t funct3 = fld(payload, 14, 12);
+    uint32_t rs1 = fld(payload, 19, 15);
+    uint32_t rs2 = fld(payload, 24, 20);
+    uint32_t funct7 = fld(payload, 31, 25);
+    int32_t imm = static_cast<int32_t>(payload) >> 20;
+    int32_t uimm = static_cast<int32_t>(payload & 0xfffff000);
+    if (rd == 0) {
+        return;
+    }
+
+    switch (payload & 0x7f) {
+    case 0x37:      // LUI
+        emit8(0x48); emit8(0xC7); emit8(0xC0);  // mov rax, simm32
+        emit32(uimm);
+        break;
+    case 0x17:      // AUIPC
+        emitLeaPc(Host_rax, off);
+        emitAluImm(0, uimm, true);
+        break;
+    case 0x13:      // OP-IMM
+        emitLoadReg(Host_rax, rs1);
+        switch (funct3) {
+        case 0: emitAluImm(0, imm, true); break;                // ADDI
+        case 1: emitShiftImm(4, imm & 0x3f, true); break;       // SLLI
+        case 2: emitAluImm(7, imm, true); emitSetcc(Cond_L); break;
+        case 3: emitAluImm(7, imm, true); emitSetcc(Cond_B); break;
+        case 4: emitAluImm(6, imm, true); break;                // XORI
+        case 5:                                                 // SRLI/SRAI
+            emitShiftImm(funct7 & 0x20 ? 7 : 5, imm & 0x3f, true);
+            break;
+        case 6: emitAluImm(1, imm, true); break;                // ORI
+        default: emitAluImm(4, imm, true);                      // ANDI
+        }
+        break;
+    case 0x1B:      // OP-IMM-32
+        emitLoadReg(Host_rax, rs1);
+        switch (funct3) {
+        case 0: emitAluImm(0, imm, false); break;               // ADDIW
+        case 1: emitShiftImm(4, imm & 0x1f, false); break;      // SLLIW
+        default:                                                // SRLIW/SRAIW
+            emitShiftImm(funct7 & 0x20 ? 7 : 5, imm & 0x1f, false);
+        }
+        emitSignExt32();
+        break;
+    case 0x33:      // OP
+        emitLoadReg(Host_rax, rs1);
+        emitLoadReg(Host_rcx, rs2);
+        if (funct7 == 1) {                                      // MUL
+            emit8(0x48); emit8(0x0F); emit8(0xAF); emit8(0xC1);
+            break;
+        }
+        switch (funct3) {
+        case 0: emitAluReg(funct7 ? 0x29 : 0x01, true); break;  // SUB/ADD
+        case 1: emitShiftCl(4, true); break;                    // SLL
+        case 2: emitAluReg(0x39, true); emitSetcc(Cond_L); break;
+        case 3: emitAluReg(0x39, true); emitSetcc(Cond_B); break;
+        case 4: emitAluReg(0x31, true); break;                  // XOR
+        case 5: emitShiftCl(funct7 ? 7 : 5, true); break;       // SRA/SRL
+        case 6: emitAluReg(0x09, true); break;                  // OR
+        default: emitAluReg(0x21, true);                        // AND
+        }
+        break;
+    default:        // OP-32
+        emitLoadReg(Host_rax, rs1);
+        emitLoadReg(Host_rcx, rs2);
+        if (funct7 == 1) {                                      // MULW
+            emit8(0x0F); emit8(0xAF); emit8(0xC1);
+        } else if (funct3 == 0) {                               // SUBW/ADDW
+            emitAluReg(funct7 ? 0x29 : 0x01, false);
+        } else {                                                // SRAW
+            emitShiftCl(7, false);
+        }
+        emitSignExt32();
+    }
+    emitStoreReg(rd);
+}
+
+/** npc is selected by cmov, so the code has no host branches */
+void HostCodeType::emitBranch(uint32_t payload, uint32_t off, uint32_t len) {
+    static const uint8_t COND[8] = {
+        Cond_E, Cond_NE, 0, 0, Cond_L, Cond_GE, Cond_B, Cond_AE
+    };
+    int32_t imm = (fld(payload, 31, 31) << 12) | (fld(payload, 7, 7) << 11)
+                | (fld(payload, 30, 25) << 5) | (fld(payload, 11, 8) << 1);
+    if (imm & (1 << 12)) {
+        imm -= 1 << 13;
+    }
+    emitLoadReg(Host_rax, fld(payload, 19, 15));
+    emitLoadReg(Host_rcx, fld(payload, 24, 20));
+    emitAluReg(0x39, true);                     // cmp rax, rcx
+    emitLeaPc(Host_rax, off + len);
+    emitLeaPc(Host_rcx, static_cast<int32_t>(off) + imm);
+    emit8(0x48); emit8(0x0F);                   // cmovcc rax, rcx
+    emit8(0x40 | COND[fld(payload, 14, 12)]); emit8(0xC1);
+    emitStoreCtx(OFF_NPC);
+}
+
+/**
+ * Fast path of LoadAccess: aligned address of the page cached in the
+ * load table with the direct read pointer.
+ */
+void HostCodeType::emitLoad(uint32_t payload, SideExitType *exit) {
+    uint32_t funct3 = fld(payload, 14, 12);
+    uint32_t size_mask = (1u << (funct3 & 0x3)) - 1;
+    emitLoadReg(Host_rax, fld(payload, 19, 15));
+    emitAluImm(0, static_cast<int32_t>(payload) >> 20, true);
+    if (size_mask) {
+        emit8(0xA8); emit8(static_cast<uint8_t>(size_mask)); // test al, mask
+        emitJcc(Cond_NE, exit);
+    }
+    emit8(0x48); emit8(0x89); emit8(0xC2);  // mov rdx, rax
+    emit8(0x48); emit8(0xC1); emit8(0xEA);  // shr rdx, 12
+    emit8(12);
+    emit8(0x89); emit8(0xD1);               // mov ecx, edx
+    emit8(0x81); emit8(0xE1);               // and ecx, total - 1
+    emit32(load_.entry_total - 1);
+    emit8(0x69); emit8(0xC9);               // imul ecx, ecx, entry_size
+    emit32(load_.entry_size);
+    emit8(0x49); emit8(0xB9);               // mov r9, tlb
+    emit64(reinterpret_cast<uint64_t>(load_.tlb));
+    emit8(0x49); emit8(0x01); emit8(0xC9);  // add r9, rcx
+    emit8(0x49); emit8(0x39); emit8(0x91);  // cmp [r9 + tag], rdx
+    emit32(load_.tag_off);
+    emitJcc(Cond_NE, exit);
+    emit8(0x4D); emit8(0x8B); emit8(0x89);  // mov r9, [r9 + rptr]
+    emit32(load_.rptr_off);
+    emit8(0x4D); emit8(0x85); emit8(0xC9);  // test r9, r9
+    emitJcc(Cond_E, exit);
+    emit8(0x25);                            // and eax, page offset mask
+    emit32(0xfff);
+    switch (funct3) {
+    case 0:     // LB: movsx rax, byte [r9 + rax]
+        emit8(0x49); emit8(0x0F); emit8(0xBE);
+        break;
+    case 1:     // LH: movsx rax, word [r9 + rax]
+        emit8(0x49); emit8(0x0F); emit8(0xBF);
+        break;
+    case 2:     // LW: movsxd rax, dword [r9 + rax]
+        emit8(0x49); emit8(0x63);
+        break;
+    case 3:     // LD: mov rax, [r9 + rax]
+        emit8(0x49); emit8(0x8B);
+        break;
+    case 4:     // LBU: movzx eax, byte [r9 + rax]
+        emit8(0x41); emit8(0x0F); emit8(0xB6);
+        break;
+    case 5:     // LHU: movzx eax, word [r9 + rax]
+        emit8(0x41); emit8(0x0F); emit8(0xB7);
+        break;
+    default:    // LWU: mov eax, [r9 + rax]
+        emit8(0x41); emit8(0x8B);
+    }
+    emit8(0x04); emit8(0x01);
+    emit8(0x49); emit8(0xB9);               // mov r9, r_cnt
+    emit64(reinterpret_cast<uint64_t>(load_.r_cnt));
+    emit8(0x49); emit8(0xFF); emit8(0x01);  // inc qword [r9]
+    emitStoreReg(fld(payload, 11, 7));
+}
+
+/** Jump to the side exit, rel32 is patched by emitExit() */
+void HostCodeType::emitJcc(uint8_t cc, SideExitType *exit) {
+    emit8(0x0F); emit8(0x80 | cc);
+    exit->jump[exit->jump_total++] = used_;
+    emit32(0);
+}
+
+/** Same context update as the run epilogue for the executed part */
+void HostCodeType::emitExit(const SideExitType *exit) {
+    for (int i = 0; i < exit->jump_total; i++) {
+        uint64_t pos = exit->jump[i];
+        uint32_t rel = static_cast<uint32_t>(used_ - (pos + 4));
+        for (int n = 0; n < 4; n++) {
+            buf_[pos + n] = static_cast<uint8_t>(rel >> (8 * n));
+        }
+    }
+    if (exit->executed) {
+        emitLeaPc(Host_rax, exit->prev_off);
+        emitStoreCtx(OFF_PC);
+        emitLeaPc(Host_rax, exit->off);
+        emitStoreCtx(OFF_NPC);
+        emit8(0x48); emit8(0x81); emit8(0x83);  // add qword [rbx + step]
+        emit32(OFF_STEP);
+        emit32(exit->executed);
+    }
+    emit8(0xB8);                        // mov eax, executed
+    emit32(exit->executed);
+    emit8(0x5B);                        // pop rbx
+    emit8(0xC3);                        // ret
+}
+
+void HostCodeType::emit32(uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        emit8(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void HostCodeType::emit64(uint64_t v) {
+    emit32(static_cast<uint32_t>(v));
+    emit32(static_cast<uint32_t>(v >> 32));
+}
+
+/** mov host, [rbx + regs + 8*r] or xor host, host for x0 */
+void HostCodeType::emitLoadReg(int host, uint32_t r) {
+    if (r == 0) {
+        emit8(0x31); emit8(0xC0 | (host << 3) | host);
+        return;
+    }
+    emit8(0x48); emit8(0x8B); emit8(0x83 | (host << 3));
+    emit32(OFF_REGS + 8 * r);
+}
+
+/** mov [rbx + regs + 8*r], rax */
+void HostCodeType::emitStoreReg(uint32_t r) {
+    emitStoreCtx(OFF_REGS + 8 * r);
+}
+
+/** mov [rbx + off], rax */
+void HostCodeType::emitStoreCtx(int32_t off) {
+    emit8(0x48); emit8(0x89); emit8(0x83);
+    emit32(off);
+}
+
+/** lea host, [r8 + off] */
+void HostCodeType::emitLeaPc(int host, int32_t off) {
+    emit8(0x49); emit8(0x8D); emit8(0x80 | (host << 3));
+    emit32(off);
+}
+
+/** op rax, rcx (eax, ecx when !w64) */
+void HostCodeType::emitAluReg(uint8_t opcode, bool w64) {
+    if (w64) {
+        emit8(0x48);
+    }
+    emit8(opcode); emit8(0xC8);
+}
+
+/** op rax, simm32 (eax, imm32 when !w64) */
+void HostCodeType::emitAluImm(int digit, int32_t imm, bool w64) {
+    if (w64) {
+        emit8(0x48);
+    }
+    emit8(0x81); emit8(0xC0 | (digit << 3));
+    emit32(imm);
+}
+
+/** shl/shr/sar rax, cl, the count is masked by host as by the handlers */
+void HostCodeType::emitShiftCl(int digit, bool w64) {
+    if (w64) {
+        emit8(0x48);
+    }
+    emit8(0xD3); emit8(0xC0 | (digit << 3));
+}
+
+void HostCodeType::emitShiftImm(int digit, uint32_t shamt, bool w64) {
+    if (w64) {
+        emit8(0x48);
+    }
+    emit8(0xC1); emit8(0xC0 | (digit << 3));
+    emit8(static_cast<uint8_t>(shamt));
+}
+
+/** setcc al; movzx eax, al */
+void HostCodeType::emitSetcc(uint8_t cc) {
+    emit8(0x0F); emit8(0x90 | cc); emit8(0xC0);
+    emit8(0x0F); emit8(0xB6); emit8(0xC0);
+}
+
+/** movsxd rax, eax */
+void HostCodeType::emitSignExt32() {
+    emit8(0x48); emit8(0x63); emit8(0xC0);
+}
+
+}  // namespace debugger
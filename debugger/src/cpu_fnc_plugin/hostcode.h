@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      x86-64 code generator of the decoded basic blocks.
+ *
+ * @details    Runs of the integer computational instructions and loads
+ *             (RV64I/M without stores, jumps, system, division and upper
+ *             multiplication) are translated into the host code. A run
+ *             may end with a conditional branch. Translated run updates
+ *             registers, pc, npc and step_cnt exactly as the same
+ *             instructions executed by their handlers, other instructions
+ *             are executed by the handlers.
+ *             Loads read memory via the direct pointers of the DMI load
+ *             table. A load that isn't aligned or misses the table leaves
+ *             the run before the instruction (side exit), so the handler
+ *             executes it with the page walk or bus transaction.
+ *             Code is written into one executable buffer. When the buffer
+ *             is full it's cleared together with all decoded blocks.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_HOSTCODE_H__
+#define __DEBUGGER_CPU_RISCV_HOSTCODE_H__
+
+#include <inttypes.h>
+#include "iinstr.h"
+#include "dmi.h"
+
+namespace debugger {
+
+/**
+ * Translated run of instructions, pc and npc are virtual addresses.
+ * Returns the number of executed instructions, less than the run length
+ * on side exit.
+ */
+typedef int (*HostCodeFunc)(CpuContextType *ctx);
+
+class HostCodeType {
+public:
+    HostCodeType();
+    ~HostCodeType();
+
+    /**
+     * @brief Allocate executable buffer.
+     * @param[in] load DMI load table, NULL if loads aren't translated
+     * @return false when host isn't x86-64
+     */
+    bool init(const DmiLoadPathType *load);
+
+    /** Free space for the specified number of instructions */
+    bool hasSpace(int instr_total) {
+        // Each instruction may be a separate run in the worst case
+        return used_ + static_cast<uint64_t>(instr_total)
+                * (INSTR_CODE_MAX + RUN_CODE_MAX) <= size_;
+    }
+
+    /** All translated code is dropped, blocks must be flushed too */
+    void clear() { used_ = 0; }
+
+    /**
+     * @brief Translate run of instructions started from npc.
+     * @param[in] payload 32-bits instructions, compressed are expanded
+     * @param[in] length  Original instructions length in bytes
+     * @param[in] total   Number of instructions
+     * @param[out] used   Number of the translated instructions
+     * @return Host code or NULL if the first instruction isn't supported
+     */
+    HostCodeFunc translate(const uint32_t *payload, const uint32_t *length,
+                           int total, int *used);
+
+private:
+    static const uint64_t BUFFER_SIZE = 8ull << 20;
+    static const int INSTR_CODE_MAX = 192;  // including side exit
+    static const int RUN_CODE_MAX = 64;
+    static const int RUN_INSTR_MAX = 64;
+    static const int EXIT_JUMP_MAX = 3;
+
+    /** Side exit of the load, the load isn't executed */
+    struct SideExitType {
+        uint64_t jump[EXIT_JUMP_MAX];   // rel32 fields of the jcc
+        int jump_total;
+        int executed;                   // instructions before the load
+        uint32_t prev_off;              // pc of the previous instruction
+        uint32_t off;                   // npc, pc of the load
+    };
+
+    bool isSupported(uint32_t payload);
+    bool isBranch(uint32_t payload) { return (payload & 0x7f) == 0x63; }
+    bool isLoad(uint32_t payload) { return (payload & 0x7f) == 0x03; }
+    void emitInstr(uint32_t payload, uint32_t off);
+    void emitBranch(uint32_t payload, uint32_t off, uint32_t len);
+    void emitLoad(uint32_t payload, SideExitType *exit);
+    void emitExit(const SideExitType *exit);
+    void emitJcc(uint8_t cc, SideExitType *exit);
+
+    void emit8(uint8_t v) { buf_[used_++] = v; }
+    void emit32(uint32_t v);
+    void emit64(uint64_t v);
+    void emitLoadReg(int host, uint32_t r);
+    void emitStoreReg(uint32_t r);
+    void emitStoreCtx(int32_t off);
+    void emitLeaPc(int host, int32_t off);
+    void emitAluReg(uint8_t opcode, bool w64);
+    void emitAluImm(int digit, int32_t imm, bool w64);
+    void emitShiftCl(int digit, bool w64);
+    void emitShiftImm(int digit, uint32_t shamt, bool w64);
+    void emitSetcc(uint8_t cc);
+    void emitSignExt32();
+
+private:
+    uint8_t *buf_;
+    uint64_t size_;
+    uint64_t used_;
+    DmiLoadPathType load_;      // tlb is NULL if loads aren't translated
+    SideExitType exits_[RUN_INSTR_MAX];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_HOSTCODE_H__
@@ -9,37 +9,96 @@
 #define __DEBUGGER_IINSTRUCTION_H__
 
 #include <inttypes.h>
-#include <fstream>
 #include "riscv-isa.h"
 #include "coreservices/ibus.h"
 #include "coreservices/isocinfo.h"
+#include "dmi.h"
+#include "reservation.h"
+#include "bintrace.h"
 
 namespace debugger {
 
 static const int STACK_TRACE_BUF_SIZE = 256;
+static const int CSR_OTHER_TOTAL = 32;
 
+/**
+ * @brief Slots of the implemented CSRs in the context.
+ *
+ * CSR addresses are translated into these indexes by readCSR()/writeCSR(),
+ * the frequently accessed registers may be used directly.
+ */
+enum ECsrIndex {
+    Csr_fflags,
+    Csr_frm,
+    Csr_fcsr,
+    Csr_mstatus,
+    Csr_medeleg,
+    Csr_mideleg,
+    Csr_mie,
+    Csr_mtvec,
+    Csr_mcounteren,
+    Csr_mtimecmp,
+    Csr_mscratch,
+    Csr_stvec,
+    Csr_sscratch,
+    Csr_uepc,
+    Csr_sepc,
+    Csr_hepc,
+    Csr_mepc,
+    Csr_mcause,
+    Csr_mbadaddr,
+    Csr_mip,
+    Csr_satp,
+    Csr_mtime,
+    Csr_misa,
+    Csr_mvendorid,
+    Csr_marchid,
+    Csr_mimplementationid,
+    Csr_mhartid,
+    Csr_Total
+};
+
+/**
+ * @brief Architectural state of the hart.
+ *
+ * Fields accessed on every instruction or memory access go first so they
+ * occupy the six consecutive cache lines (384 bytes up to ibus), debug
+ * and trace state goes to the end.
+ */
 struct CpuContextType {
+    // Hot: register file and state of the instruction in progress
     uint64_t regs[Reg_Total];
-    uint64_t csr[1<<12];
     uint64_t pc;
     uint64_t npc;
+    uint64_t step_cnt;
+    uint64_t cur_prv_level;
     uint64_t exception;
     uint64_t interrupt;
     uint64_t interrupt_pending;
-    uint64_t step_cnt;
-    uint64_t cur_prv_level;
+    DmiCacheType *dmi;      // bus access with the direct memory fast path
+    // Checked on each step or memory access
+    bool reset;
+    bool br_inject_fetch;
+    bool wfi;               // hart is stalled by WFI until interrupt
+    BinTraceWriter *reg_trace_file;
+    BinTraceWriter *mem_trace_file;
+    uint64_t reserve_addr;  // LR/SC reservation address, ~0 when empty
+    uint64_t reserve_value; // value loaded by LR
+    ReservationTableType *reservations; // LR/SC of the harts on the bus
+    int reserve_slot;
+    IBus *ibus;
+    uint64_t fregs[32];     // single precision values are NaN-boxed
+    uint64_t csr[Csr_Total];// indexed by ECsrIndex
+    // Cold: debug support
     DsuMapType::udbg_type::debug_region_type::breakpoint_control_reg br_ctrl;
     bool br_status_ena;     // show breakpoint bit in common status register
-    bool br_inject_fetch;
     uint64_t br_address_fetch;
     uint32_t br_instr_fetch;
-    bool reset;
-    IBus *ibus;
-    char disasm[256];
-    std::ofstream *reg_trace_file;
-    std::ofstream *mem_trace_file;
     uint64_t stack_trace_buf[STACK_TRACE_BUF_SIZE]; // [[from,to],*]
     int stack_trace_cnt;
+    // Cold: written CSRs without a slot, kept as plain storage
+    uint64_t csr_other[CSR_OTHER_TOTAL][2];         // [[address,value],*]
+    int csr_other_cnt;
 };
 
 
@@ -0,0 +1,73 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Cache of the already decoded instructions.
+ */
+
+#include <string.h>
+#include "predecode.h"
+
+namespace debugger {
+
+PredecodeCacheType::PredecodeCacheType() {
+    memset(slots_, 0, sizeof(slots_));
+    lastPage_ = 0;
+    lastTag_ = ~0ull;
+}
+
+PredecodeCacheType::~PredecodeCacheType() {
+    for (int i = 0; i < PAGE_SLOTS; i++) {
+        if (slots_[i]) {
+            delete slots_[i];
+        }
+    }
+}
+
+PredecodeCacheType::PageType *PredecodeCacheType::getPage(uint64_t tag) {
+    PageType *page = slots_[tag % PAGE_SLOTS];
+    if (page == 0) {
+        page = new PageType;
+        slots_[tag % PAGE_SLOTS] = page;
+        clearPage(page, tag);
+    } else if (page->tag != tag) {
+        clearPage(page, tag);
+    }
+    return page;
+}
+
+void PredecodeCacheType::clearPage(PageType *page, uint64_t tag) {
+    memset(page->entry, 0, sizeof(page->entry));
+    page->tag = tag;
+}
+
+void PredecodeCacheType::invalidate(uint64_t addr, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+    // 4-bytes instruction started 2 bytes before the range overlaps it
+    uint64_t half = addr >> 1;
+    uint64_t half_end = (addr + size - 1) >> 1;
+    if (half) {
+        half--;
+    }
+    for (; half <= half_end; half++) {
+        uint64_t tag = half >> (PAGE_BITS - 1);
+        PageType *page = slots_[tag % PAGE_SLOTS];
+        if (page == 0 || page->tag != tag) {
+            continue;
+        }
+        page->entry[half & (PAGE_ENTRIES - 1)].instr = 0;
+    }
+}
+
+void PredecodeCacheType::flush() {
+    for (int i = 0; i < PAGE_SLOTS; i++) {
+        if (slots_[i]) {
+            clearPage(slots_[i], ~0ull);
+        }
+    }
+    lastTag_ = ~0ull;
+}
+
+}  // namespace debugger
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Cache of the already decoded instructions.
+ *
+ * @details    Each entry stores the fetched instruction word together with
+ *             the resolved instruction handler so that the steady-state
+ *             simulation loop doesn't access the bus and doesn't walk
+ *             through the list of the supported instructions.
+ *             Entries are grouped into pages and invalidated on any write
+ *             into the cached page. Entries have 2-bytes granularity to
+ *             support compressed instructions.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_PREDECODE_H__
+#define __DEBUGGER_CPU_RISCV_PREDECODE_H__
+
+#include <inttypes.h>
+#include "iinstr.h"
+
+namespace debugger {
+
+struct PredecodedInstrType {
+    IInstruction *instr;    // NULL when entry isn't valid
+    uint32_t payload;
+};
+
+class PredecodeCacheType {
+public:
+    PredecodeCacheType();
+    ~PredecodeCacheType();
+
+    /**
+     * @brief Get cache entry of the specified instruction pointer.
+     * @details Entry is allocated when not found. Page that occupied the
+     *          same slot before will be evicted.
+     */
+    PredecodedInstrType *getEntry(uint64_t pc) {
+        uint64_t tag = pc >> PAGE_BITS;
+        if (tag != lastTag_) {
+            lastPage_ = getPage(tag);
+            lastTag_ = tag;
+        }
+        return &lastPage_->entry[(pc & PAGE_MASK) >> 1];
+    }
+
+    /** Invalidate entries overlapped with the modified memory range. */
+    void invalidate(uint64_t addr, uint32_t size);
+
+    /** Invalidate all entries. */
+    void flush();
+
+private:
+    static const int PAGE_BITS = 12;
+    static const uint64_t PAGE_MASK = (1ull << PAGE_BITS) - 1;
+    static const int PAGE_ENTRIES = (1 << PAGE_BITS) / 2;
+    static const int PAGE_SLOTS = 256;
+
+    struct PageType {
+        uint64_t tag;
+        PredecodedInstrType entry[PAGE_ENTRIES];
+    };
+
+    PageType *getPage(uint64_t tag);
+    void clearPage(PageType *page, uint64_t tag);
+
+    PageType *slots_[PAGE_SLOTS];
+    PageType *lastPage_;
+    uint64_t lastTag_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_PREDECODE_H__
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Execution profile of the functional CPU model.
+ */
+
+#include <string.h>
+#include "profiler.h"
+
+namespace debugger {
+
+ProfileTableType::ProfileTableType() {
+    entry_ = new EntryType[ENTRY_TOTAL];
+    stack_ = new StackType[STACK_TOTAL];
+    clear();
+}
+
+ProfileTableType::~ProfileTableType() {
+    delete [] entry_;
+    delete [] stack_;
+}
+
+void ProfileTableType::clear() {
+    for (unsigned i = 0; i < ENTRY_TOTAL; i++) {
+        entry_[i].pc = ~0ull;
+        entry_[i].instr = 0;
+        entry_[i].stall = 0;
+    }
+    other_.pc = ~0ull;
+    other_.instr = 0;
+    other_.stall = 0;
+    entryCnt_ = 0;
+    for (unsigned i = 0; i < STACK_TOTAL; i++) {
+        stack_[i].hash = 0;
+        stack_[i].weight = 0;
+        stack_[i].frames.make_nil();
+    }
+    stackCnt_ = 0;
+    stackLost_ = 0;
+}
+
+/** Linear probing, new entry is added on the first empty slot */
+ProfileTableType::EntryType *ProfileTableType::find(uint64_t pc) {
+    unsigned idx = static_cast<unsigned>(pc >> 1) & (ENTRY_TOTAL - 1);
+    for (unsigned i = 0; i < ENTRY_TOTAL; i++) {
+        EntryType *e = &entry_[(idx + i) & (ENTRY_TOTAL - 1)];
+        if (e->pc == pc) {
+            return e;
+        }
+        if (e->pc == ~0ull) {
+            if (entryCnt_ >= ENTRY_TOTAL / 2) {
+                break;
+            }
+            entryCnt_++;
+            e->pc = pc;
+            return e;
+        }
+    }
+    return &other_;
+}
+
+void ProfileTableType::addStack(const uint64_t *frame, int depth,
+                                uint64_t weight) {
+    unsigned sz = static_cast<unsigned>(depth) * sizeof(uint64_t);
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < depth; i++) {
+        hash = (hash ^ frame[i]) * 1099511628211ull;
+    }
+
+    unsigned idx = static_cast<unsigned>(hash) & (STACK_TOTAL - 1);
+    for (unsigned i = 0; i < STACK_TOTAL; i++) {
+        StackType *s = &stack_[(idx + i) & (STACK_TOTAL - 1)];
+        if (s->weight == 0) {
+            if (stackCnt_ >= STACK_TOTAL / 2) {
+                break;
+            }
+            stackCnt_++;
+            s->hash = hash;
+            s->weight = weight;
+            s->frames.make_data(sz, frame);
+            return;
+        }
+        if (s->hash == hash && s->frames.size() == sz
+            && memcmp(s->frames.data(), frame, sz) == 0) {
+            s->weight += weight;
+            return;
+        }
+    }
+    stackLost_ += weight;
+}
+
+void ProfileTableType::getHistogram(AttributeType *list) {
+    list->make_list(0);
+    for (unsigned i = 0; i < ENTRY_TOTAL; i++) {
+        EntryType *e = &entry_[i];
+        if (e->pc == ~0ull) {
+            continue;
+        }
+        AttributeType item;
+        item.make_list(3);
+        item[0u].make_uint64(e->pc);
+        item[1].make_uint64(e->instr);
+        item[2].make_uint64(e->stall);
+        list->add_to_list(&item);
+    }
+    if (other_.instr || other_.stall) {
+        AttributeType item;
+        item.make_list(3);
+        item[0u].make_uint64(other_.pc);
+        item[1].make_uint64(other_.instr);
+        item[2].make_uint64(other_.stall);
+        list->add_to_list(&item);
+    }
+}
+
+void ProfileTableType::getStacks(AttributeType *list) {
+    list->make_list(0);
+    for (unsigned i = 0; i < STACK_TOTAL; i++) {
+        StackType *s = &stack_[i];
+        if (s->weight == 0) {
+            continue;
+        }
+        const uint64_t *frame =
+            reinterpret_cast<const uint64_t *>(s->frames.data());
+        unsigned depth = s->frames.size() / sizeof(uint64_t);
+        AttributeType item;
+        item.make_list(2);
+        item[0u].make_uint64(s->weight);
+        item[1].make_list(depth);
+        for (unsigned n = 0; n < depth; n++) {
+            item[1][n].make_uint64(frame[n]);
+        }
+        list->add_to_list(&item);
+    }
+    if (stackLost_) {
+        AttributeType item;
+        item.make_list(2);
+        item[0u].make_uint64(stackLost_);
+        item[1].make_list(0);
+        list->add_to_list(&item);
+    }
+}
+
+}  // namespace debugger
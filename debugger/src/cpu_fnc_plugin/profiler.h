@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Execution profile of the functional CPU model.
+ *
+ * @details    Instructions and stall steps (WFI and skipped idle loops) are
+ *             counted per entry address of the executed basic block or
+ *             instruction. Hash table has fixed size, so the entries aren't
+ *             moved and the counting costs one lookup per block. Call stacks
+ *             are sampled with the fixed step period.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_PROFILER_H__
+#define __DEBUGGER_CPU_RISCV_PROFILER_H__
+
+#include <inttypes.h>
+#include "attribute.h"
+
+namespace debugger {
+
+class ProfileTableType {
+public:
+    ProfileTableType();
+    ~ProfileTableType();
+
+    void add(uint64_t pc, uint64_t instr, uint64_t stall) {
+        EntryType *e = &entry_[(pc >> 1) & (ENTRY_TOTAL - 1)];
+        if (e->pc != pc) {
+            e = find(pc);
+        }
+        e->instr += instr;
+        e->stall += stall;
+    }
+
+    /** Call stack from the outer function to the current pc */
+    void addStack(const uint64_t *frame, int depth, uint64_t weight);
+
+    void clear();
+
+    /** List of [pc, instructions, stalls] */
+    void getHistogram(AttributeType *list);
+
+    /** List of [weight, [frame0, frame1, ...]] */
+    void getStacks(AttributeType *list);
+
+private:
+    static const unsigned ENTRY_TOTAL = 1 << 15;
+    static const unsigned STACK_TOTAL = 1 << 12;
+
+    struct EntryType {
+        uint64_t pc;                // ~0 when empty
+        uint64_t instr;
+        uint64_t stall;
+    };
+
+    struct StackType {
+        uint64_t hash;
+        uint64_t weight;            // 0 when empty
+        AttributeType frames;       // uint64_t array
+    };
+
+    EntryType *find(uint64_t pc);
+
+    EntryType *entry_;
+    EntryType other_;               // table is full
+    unsigned entryCnt_;
+    StackType *stack_;
+    unsigned stackCnt_;
+    uint64_t stackLost_;            // weight of the stacks that don't fit
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_PROFILER_H__
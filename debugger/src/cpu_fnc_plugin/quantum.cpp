@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Quantum synchronization of the functional harts.
+ */
+
+#include <string.h>
+#include "api_core.h"
+#include "quantum.h"
+
+namespace debugger {
+
+static QuantumSyncType *groups_ = 0;
+
+QuantumSyncType *QuantumSyncType::attach(const char *name) {
+    QuantumSyncType *p = groups_;
+    while (p) {
+        if (strcmp(p->name_, name) == 0) {
+            return p;
+        }
+        p = p->next_;
+    }
+    p = new QuantumSyncType(name);
+    p->next_ = groups_;
+    groups_ = p;
+    return p;
+}
+
+QuantumSyncType::QuantumSyncType(const char *name) {
+    RISCV_sprintf(name_, sizeof(name_), "%s", name);
+    next_ = 0;
+    RISCV_mutex_init(&mutex_);
+    total_ = 0;
+    activeCnt_ = 0;
+    arrivedCnt_ = 0;
+    epoch_ = 0;
+}
+
+int QuantumSyncType::registerHart(event_def *ev) {
+    if (total_ == HARTS_MAX) {
+        return -1;
+    }
+    events_[total_] = ev;
+    active_[total_] = false;
+    arrived_[total_] = false;
+    return total_++;
+}
+
+void QuantumSyncType::join(int slot) {
+    RISCV_mutex_lock(&mutex_);
+    if (!active_[slot]) {
+        active_[slot] = true;
+        activeCnt_++;
+    }
+    RISCV_mutex_unlock(&mutex_);
+}
+
+void QuantumSyncType::leave(int slot) {
+    RISCV_mutex_lock(&mutex_);
+    if (active_[slot]) {
+        active_[slot] = false;
+        activeCnt_--;
+        if (arrived_[slot]) {
+            arrived_[slot] = false;
+            arrivedCnt_--;
+        }
+        if (arrivedCnt_ != 0 && arrivedCnt_ == activeCnt_) {
+            release();
+        }
+    }
+    RISCV_mutex_unlock(&mutex_);
+}
+
+uint64_t QuantumSyncType::arrive(int slot) {
+    RISCV_mutex_lock(&mutex_);
+    uint64_t ret = epoch_;
+    if (active_[slot] && !arrived_[slot]) {
+        arrived_[slot] = true;
+        arrivedCnt_++;
+        if (arrivedCnt_ == activeCnt_) {
+            release();
+        }
+    }
+    RISCV_mutex_unlock(&mutex_);
+    return ret;
+}
+
+/** Called under lock when the last running hart has arrived */
+void QuantumSyncType::release() {
+    epoch_ = epoch_ + 1;
+    arrivedCnt_ = 0;
+    for (int i = 0; i < total_; i++) {
+        if (arrived_[i]) {
+            arrived_[i] = false;
+            RISCV_event_set(events_[i]);
+        }
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Quantum synchronization of the functional harts.
+ *
+ * @details    Harts connected to the same bus run in parallel on their own
+ *             threads. Each hart executes fixed number of instructions
+ *             (quantum) and waits until all other running harts reach the
+ *             same boundary. Halted harts leave the group and don't block
+ *             others.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_QUANTUM_H__
+#define __DEBUGGER_CPU_RISCV_QUANTUM_H__
+
+#include "api_types.h"
+
+namespace debugger {
+
+class QuantumSyncType {
+public:
+    /**
+     * @brief Get synchronization group of the harts.
+     * @param[in] name Group name (bus name). Group is created on the first
+     *                 request. Must be called from postinitService() only.
+     */
+    static QuantumSyncType *attach(const char *name);
+
+    /** @return Hart slot in the group or -1 if group is full */
+    int registerHart(event_def *ev);
+
+    /** Hart starts (or stops) to take part in synchronization */
+    void join(int slot);
+    void leave(int slot);
+
+    /**
+     * @brief Hart reached quantum boundary.
+     * @return Epoch number that will be released when all harts arrive.
+     */
+    uint64_t arrive(int slot);
+
+    bool isReleased(uint64_t epoch) { return epoch_ != epoch; }
+
+private:
+    QuantumSyncType(const char *name);
+
+    void release();
+
+    static const int HARTS_MAX = 32;
+
+    char name_[64];
+    QuantumSyncType *next_;
+    mutex_def mutex_;
+    event_def *events_[HARTS_MAX];
+    bool active_[HARTS_MAX];
+    bool arrived_[HARTS_MAX];
+    int total_;
+    int activeCnt_;
+    int arrivedCnt_;
+    volatile uint64_t epoch_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_QUANTUM_H__
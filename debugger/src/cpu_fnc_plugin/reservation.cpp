@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      LR/SC reservations of the harts sharing memory.
+ */
+
+#include <string.h>
+#include "api_core.h"
+#include "reservation.h"
+
+namespace debugger {
+
+static ReservationTableType *tables_ = 0;
+
+ReservationTableType *ReservationTableType::attach(const char *name) {
+    ReservationTableType *p = tables_;
+    while (p) {
+        if (strcmp(p->name_, name) == 0) {
+            return p;
+        }
+        p = p->next_;
+    }
+    p = new ReservationTableType(name);
+    p->next_ = tables_;
+    tables_ = p;
+    return p;
+}
+
+ReservationTableType::ReservationTableType(const char *name) {
+    RISCV_sprintf(name_, sizeof(name_), "%s", name);
+    next_ = 0;
+    total_ = 0;
+    for (int i = 0; i < HARTS_MAX; i++) {
+        entry_[i] = EMPTY;
+    }
+}
+
+int ReservationTableType::registerHart() {
+    if (total_ == HARTS_MAX) {
+        return -1;
+    }
+    return total_++;
+}
+
+/**
+ * Entry is cancelled only if it still holds the same granule, a new LR of
+ * the hart isn't lost. Busy entry belongs to SC that is writing memory, the
+ * store is ordered after it.
+ */
+void ReservationTableType::invalidateEntry(int slot, uint64_t paddr,
+                                           uint32_t size) {
+    int64_t e = entry_[slot];
+    while (e != EMPTY) {
+        uint64_t g = static_cast<uint64_t>(e) & ~GRANULE_MASK;
+        if (paddr + size <= g || paddr > g + GRANULE_MASK) {
+            return;
+        }
+        if (e & BUSY) {
+            while (entry_[slot] == e) {}
+            return;
+        }
+        int64_t prev = RISCV_atomic_cmpxchg64(&entry_[slot], e, EMPTY);
+        if (prev == e) {
+            return;
+        }
+        e = prev;
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,100 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      LR/SC reservations of the harts sharing memory.
+ *
+ * @details    Reservation set is the naturally aligned 8-bytes granule of
+ *             the physical address loaded by LR. Any write to the granule
+ *             (store, AMO or SC of any hart, write of other bus master)
+ *             cancels the reservations, so SC fails after an intervening
+ *             store even if the old value was written back.
+ *
+ *             Table is lock-free. LR publishes the reservation with a full
+ *             barrier before loading the value, the writer checks the table
+ *             after its store and a barrier, so either LR sees the store or
+ *             the store sees the reservation. SC marks its entry busy while
+ *             it writes memory and writers wait for the mark to clear.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_RESERVATION_H__
+#define __DEBUGGER_CPU_RISCV_RESERVATION_H__
+
+#include "api_types.h"
+
+namespace debugger {
+
+class ReservationTableType {
+public:
+    /**
+     * @brief Get reservation table of the harts.
+     * @param[in] name Bus name. Table is created on the first request.
+     *                 Must be called from postinitService() only.
+     */
+    static ReservationTableType *attach(const char *name);
+
+    /** @return Hart slot in the table or -1 if table is full */
+    int registerHart();
+
+    /** LR: reserve the granule, called before the value is loaded */
+    void reserve(int slot, uint64_t paddr) {
+        RISCV_atomic_xchg64(&entry_[slot],
+                            static_cast<int64_t>(paddr & ~GRANULE_MASK));
+    }
+
+    /** Drop reservation of the hart (reset, state restore) */
+    void cancel(int slot) {
+        RISCV_atomic_xchg64(&entry_[slot], EMPTY);
+    }
+
+    /**
+     * @brief SC: hart still holds reservation of the address.
+     * @return true if the entry is marked busy and SC may write memory,
+     *         then release() must be called.
+     */
+    bool acquire(int slot, uint64_t paddr) {
+        int64_t g = static_cast<int64_t>(paddr & ~GRANULE_MASK);
+        return RISCV_atomic_cmpxchg64(&entry_[slot], g, g | BUSY) == g;
+    }
+
+    /** SC has written memory, reservation is released */
+    void release(int slot) {
+        RISCV_atomic_xchg64(&entry_[slot], EMPTY);
+    }
+
+    /**
+     * @brief Memory was written, overlapping reservations are cancelled.
+     * @details Called after the write. Bus transactions are already
+     *          ordered by the atomic utilization counters, direct stores
+     *          need the barrier only when other harts may reserve.
+     */
+    void invalidate(uint64_t paddr, uint32_t size) {
+        if (total_ > 1) {
+            RISCV_memory_barrier();
+        }
+        for (int i = 0; i < total_; i++) {
+            if (entry_[i] != EMPTY) {
+                invalidateEntry(i, paddr, size);
+            }
+        }
+    }
+
+private:
+    explicit ReservationTableType(const char *name);
+
+    void invalidateEntry(int slot, uint64_t paddr, uint32_t size);
+
+    static const int HARTS_MAX = 32;
+    static const uint64_t GRANULE_MASK = 0x7;
+    static const int64_t EMPTY = -1;
+    static const int64_t BUSY = 0x1;
+
+    char name_[64];
+    ReservationTableType *next_;
+    int total_;
+    volatile int64_t entry_[HARTS_MAX];     // granule address or EMPTY
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_RESERVATION_H__
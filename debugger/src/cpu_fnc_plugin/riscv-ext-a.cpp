@@ -3,6 +3,16 @@
  * @copyright  Copyright 2016 GNSS Sensor Ltd. All right reserved.
  * @author     Sergey Khabarov - sergeykhbr@gmail.com
  * @brief      RISC-V extension-A (Atomic Instructions).
+ *
+ * @details    Memory reached through the direct memory pointer is modified
+ *             by the host compare-and-swap, so the operations stay atomic
+ *             when harts run on different host threads. Other memory
+ *             (peripheries, watched pages) is accessed by two bus
+ *             transactions. Reservations are kept in the table shared by
+ *             the harts of the bus, any write to the reserved granule
+ *             cancels them. SC also compares the word with the value
+ *             loaded by LR, so a store that raced with SC and changed the
+ *             word is detected too.
  */
 
 #include "api_utils.h"
@@ -11,34 +21,463 @@
 
 namespace debugger {
 
+void generateException(uint64_t code, CpuContextType *data);
+
+/**
+ * @brief Read-modify-write (AMO) instruction of 32 or 64 bits.
+ */
+class AmoProcessor : public IsaProcessor {
+public:
+    AmoProcessor(const char *name, const char *bits, uint32_t size)
+        : IsaProcessor(name, bits), size_(size) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t addr = data->regs[u.bits.rs1];
+        uint64_t val = data->regs[u.bits.rs2];
+        uint64_t old;
+        if (addr & (size_ - 1)) {
+            generateException(EXCEPTION_StoreMisalign, data);
+            return;
+        }
+
+        uint8_t *p = data->dmi->atomicPtr(addr, size_, true);
+        if (data->exception) {
+            return;     // page fault
+        }
+        if (p && size_ == 4) {
+            volatile int32_t *p32 = reinterpret_cast<volatile int32_t *>(p);
+            int32_t prev = *p32;
+            int32_t cur;
+            do {
+                cur = prev;
+                prev = RISCV_atomic_cmpxchg32(p32, cur,
+                        static_cast<int32_t>(op(cur, val)));
+            } while (prev != cur);
+            old = static_cast<int64_t>(prev);
+            data->dmi->atomicDone(addr, size_, CFG_NASTI_MASTER_CACHED, true);
+        } else if (p) {
+            volatile int64_t *p64 = reinterpret_cast<volatile int64_t *>(p);
+            int64_t prev = *p64;
+            int64_t cur;
+            do {
+                cur = prev;
+                prev = RISCV_atomic_cmpxchg64(p64, cur,
+                        static_cast<int64_t>(op(cur, val)));
+            } while (prev != cur);
+            old = static_cast<uint64_t>(prev);
+            data->dmi->atomicDone(addr, size_, CFG_NASTI_MASTER_CACHED, true);
+        } else {
+            Axi4TransactionType trans;
+            trans.source_idx = CFG_NASTI_MASTER_CACHED;
+            trans.action = MemAction_Read;
+            trans.addr = addr;
+            trans.xsize = size_;
+            trans.rpayload.b64[0] = 0;
+            data->dmi->b_transport(&trans);
+            old = trans.rpayload.b64[0];
+            if (size_ == 4) {
+                old = static_cast<int64_t>(static_cast<int32_t>(old));
+            }
+            trans.action = MemAction_Write;
+            trans.wstrb = (1 << size_) - 1;
+            trans.wpayload.b64[0] = op(old, val);
+            data->dmi->b_transport(&trans);
+        }
+        if (data->mem_trace_file) {
+            data->mem_trace_file->writeMem(data->pc, addr, false, old);
+            data->mem_trace_file->writeMem(data->pc, addr, true,
+                                           op(old, val));
+        }
+        if (u.bits.rd != 0) {
+            data->regs[u.bits.rd] = old;
+        }
+        data->npc = data->pc + 4;
+    }
+
+protected:
+    /**
+     * @param[in] mem Memory value, sign extended for the 32-bits operation.
+     * @param[in] rs2 Register value.
+     */
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) =0;
+
+    uint32_t size_;
+};
+
+class AMOADD_W : public AmoProcessor {
+public:
+    AMOADD_W() : AmoProcessor("AMOADD_W",
+                        "00000????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem + rs2; }
+};
+
+class AMOXOR_W : public AmoProcessor {
+public:
+    AMOXOR_W() : AmoProcessor("AMOXOR_W",
+                        "00100????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem ^ rs2; }
+};
+
+class AMOOR_W : public AmoProcessor {
+public:
+    AMOOR_W() : AmoProcessor("AMOOR_W",
+                        "01000????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem | rs2; }
+};
+
+class AMOAND_W : public AmoProcessor {
+public:
+    AMOAND_W() : AmoProcessor("AMOAND_W",
+                        "01100????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem & rs2; }
+};
+
+class AMOMIN_W : public AmoProcessor {
+public:
+    AMOMIN_W() : AmoProcessor("AMOMIN_W",
+                        "10000????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<int32_t>(mem) < static_cast<int32_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOMAX_W : public AmoProcessor {
+public:
+    AMOMAX_W() : AmoProcessor("AMOMAX_W",
+                        "10100????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<int32_t>(mem) > static_cast<int32_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOMINU_W : public AmoProcessor {
+public:
+    AMOMINU_W() : AmoProcessor("AMOMINU_W",
+                        "11000????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<uint32_t>(mem) < static_cast<uint32_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOMAXU_W : public AmoProcessor {
+public:
+    AMOMAXU_W() : AmoProcessor("AMOMAXU_W",
+                        "11100????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<uint32_t>(mem) > static_cast<uint32_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOSWAP_W : public AmoProcessor {
+public:
+    AMOSWAP_W() : AmoProcessor("AMOSWAP_W",
+                        "00001????????????010?????0101111", 4) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return rs2; }
+};
+
+class AMOADD_D : public AmoProcessor {
+public:
+    AMOADD_D() : AmoProcessor("AMOADD_D",
+                        "00000????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem + rs2; }
+};
+
+class AMOXOR_D : public AmoProcessor {
+public:
+    AMOXOR_D() : AmoProcessor("AMOXOR_D",
+                        "00100????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem ^ rs2; }
+};
+
+class AMOOR_D : public AmoProcessor {
+public:
+    AMOOR_D() : AmoProcessor("AMOOR_D",
+                        "01000????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem | rs2; }
+};
+
+class AMOAND_D : public AmoProcessor {
+public:
+    AMOAND_D() : AmoProcessor("AMOAND_D",
+                        "01100????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return mem & rs2; }
+};
+
+class AMOMIN_D : public AmoProcessor {
+public:
+    AMOMIN_D() : AmoProcessor("AMOMIN_D",
+                        "10000????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<int64_t>(mem) < static_cast<int64_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOMAX_D : public AmoProcessor {
+public:
+    AMOMAX_D() : AmoProcessor("AMOMAX_D",
+                        "10100????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return static_cast<int64_t>(mem) > static_cast<int64_t>(rs2)
+                ? mem : rs2;
+    }
+};
+
+class AMOMINU_D : public AmoProcessor {
+public:
+    AMOMINU_D() : AmoProcessor("AMOMINU_D",
+                        "11000????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return mem < rs2 ? mem : rs2;
+    }
+};
+
+class AMOMAXU_D : public AmoProcessor {
+public:
+    AMOMAXU_D() : AmoProcessor("AMOMAXU_D",
+                        "11100????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) {
+        return mem > rs2 ? mem : rs2;
+    }
+};
+
+class AMOSWAP_D : public AmoProcessor {
+public:
+    AMOSWAP_D() : AmoProcessor("AMOSWAP_D",
+                        "00001????????????011?????0101111", 8) {}
+protected:
+    virtual uint64_t op(uint64_t mem, uint64_t rs2) { return rs2; }
+};
+
+/**
+ * @brief Load-reserved. Reservation set is the 8-bytes granule.
+ */
+class LoadReserved : public IsaProcessor {
+public:
+    LoadReserved(const char *name, const char *bits, uint32_t size)
+        : IsaProcessor(name, bits), size_(size) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t addr = data->regs[u.bits.rs1];
+        uint64_t val;
+        if (addr & (size_ - 1)) {
+            generateException(EXCEPTION_LoadMisalign, data);
+            return;
+        }
+        uint8_t *p = data->dmi->atomicPtr(addr, size_, false);
+        if (data->exception) {
+            return;     // page fault
+        }
+        if (data->reservations) {
+            uint64_t paddr;
+            data->dmi->translate(addr, Access_Load, &paddr);
+            data->reservations->reserve(data->reserve_slot, paddr);
+        }
+        if (p && size_ == 4) {
+            val = static_cast<int64_t>(
+                    *reinterpret_cast<volatile int32_t *>(p));
+            data->dmi->atomicDone(addr, size_, CFG_NASTI_MASTER_CACHED, false);
+        } else if (p) {
+            val = *reinterpret_cast<volatile uint64_t *>(p);
+            data->dmi->atomicDone(addr, size_, CFG_NASTI_MASTER_CACHED, false);
+        } else {
+            Axi4TransactionType trans;
+            trans.source_idx = CFG_NASTI_MASTER_CACHED;
+            trans.action = MemAction_Read;
+            trans.addr = addr;
+            trans.xsize = size_;
+            trans.rpayload.b64[0] = 0;
+            data->dmi->b_transport(&trans);
+            val = trans.rpayload.b64[0];
+            if (size_ == 4) {
+                val = static_cast<int64_t>(static_cast<int32_t>(val));
+            }
+        }
+        if (data->mem_trace_file) {
+            data->mem_trace_file->writeMem(data->pc, addr, false, val);
+        }
+        data->reserve_addr = addr;
+        data->reserve_value = val;
+        if (u.bits.rd != 0) {
+            data->regs[u.bits.rd] = val;
+        }
+        data->npc = data->pc + 4;
+    }
+
+protected:
+    uint32_t size_;
+};
+
+/**
+ * @brief Store-conditional. Writes zero into rd on success.
+ */
+class StoreConditional : public IsaProcessor {
+public:
+    StoreConditional(const char *name, const char *bits, uint32_t size)
+        : IsaProcessor(name, bits), size_(size) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t addr = data->regs[u.bits.rs1];
+        uint64_t val = data->regs[u.bits.rs2];
+        bool ok = false;
+        if (addr & (size_ - 1)) {
+            generateException(EXCEPTION_StoreMisalign, data);
+            return;
+        }
+        if (addr == data->reserve_addr) {
+            ok = store(addr, val, data);
+            if (data->exception) {
+                return;     // page fault, reservation is kept
+            }
+        } else if (data->reservations) {
+            data->reservations->cancel(data->reserve_slot);
+        }
+        data->reserve_addr = ~0ull;
+        if (ok && data->mem_trace_file) {
+            data->mem_trace_file->writeMem(data->pc, addr, true, val);
+        }
+        if (u.bits.rd != 0) {
+            data->regs[u.bits.rd] = ok ? 0 : 1;
+        }
+        data->npc = data->pc + 4;
+    }
+
+protected:
+    /**
+     * Reservation entry stays busy while the word is written, so the other
+     * writers of the granule wait and are ordered after SC. Bus write isn't
+     * atomic with the check, as the bus AMO.
+     */
+    bool store(uint64_t addr, uint64_t val, CpuContextType *data) {
+        uint64_t expected = data->reserve_value;
+        ReservationTableType *rsv = data->reservations;
+        uint8_t *p = data->dmi->atomicPtr(addr, size_, true);
+        if (data->exception) {
+            return false;   // page fault
+        }
+        if (rsv) {
+            uint64_t paddr;
+            data->dmi->translate(addr, Access_Store, &paddr);
+            if (!rsv->acquire(data->reserve_slot, paddr)) {
+                return false;   // cancelled by a write
+            }
+            if (!p) {
+                rsv->release(data->reserve_slot);
+            }
+        }
+        bool ok = true;
+        if (p && size_ == 4) {
+            int32_t cmp = static_cast<int32_t>(expected);
+            ok = RISCV_atomic_cmpxchg32(reinterpret_cast<volatile int32_t *>(p),
+                        cmp, static_cast<int32_t>(val)) == cmp;
+        } else if (p) {
+            int64_t cmp = static_cast<int64_t>(expected);
+            ok = RISCV_atomic_cmpxchg64(reinterpret_cast<volatile int64_t *>(p),
+                        cmp, static_cast<int64_t>(val)) == cmp;
+        } else {
+            Axi4TransactionType trans;
+            trans.source_idx = CFG_NASTI_MASTER_CACHED;
+            trans.action = MemAction_Read;
+            trans.addr = addr;
+            trans.xsize = size_;
+            trans.rpayload.b64[0] = 0;
+            data->dmi->b_transport(&trans);
+            uint64_t cur = trans.rpayload.b64[0];
+            if (size_ == 4) {
+                cur = static_cast<int64_t>(static_cast<int32_t>(cur));
+            }
+            if (cur != expected) {
+                return false;
+            }
+            trans.action = MemAction_Write;
+            trans.wstrb = (1 << size_) - 1;
+            trans.wpayload.b64[0] = val;
+            data->dmi->b_transport(&trans);
+            return true;
+        }
+        if (rsv) {
+            rsv->release(data->reserve_slot);
+        }
+        data->dmi->atomicDone(addr, size_, CFG_NASTI_MASTER_CACHED, ok);
+        return ok;
+    }
+
+    uint32_t size_;
+};
+
+class LR_W : public LoadReserved {
+public:
+    LR_W() : LoadReserved("LR_W", "00010??00000?????010?????0101111", 4) {}
+};
+
+class LR_D : public LoadReserved {
+public:
+    LR_D() : LoadReserved("LR_D", "00010??00000?????011?????0101111", 8) {}
+};
+
+class SC_W : public StoreConditional {
+public:
+    SC_W() : StoreConditional("SC_W",
+                        "00011????????????010?????0101111", 4) {}
+};
+
+class SC_D : public StoreConditional {
+public:
+    SC_D() : StoreConditional("SC_D",
+                        "00011????????????011?????0101111", 8) {}
+};
 
 void addIsaExtensionA(CpuContextType *data, AttributeType *out) {
-    // TODO
-    /*
-    addInstr("AMOADD_W",           "00000????????????010?????0101111", NULL, out);
-    addInstr("AMOXOR_W",           "00100????????????010?????0101111", NULL, out);
-    addInstr("AMOOR_W",            "01000????????????010?????0101111", NULL, out);
-    addInstr("AMOAND_W",           "01100????????????010?????0101111", NULL, out);
-    addInstr("AMOMIN_W",           "10000????????????010?????0101111", NULL, out);
-    addInstr("AMOMAX_W",           "10100????????????010?????0101111", NULL, out);
-    addInstr("AMOMINU_W",          "11000????????????010?????0101111", NULL, out);
-    addInstr("AMOMAXU_W",          "11100????????????010?????0101111", NULL, out);
-    addInstr("AMOSWAP_W",          "00001????????????010?????0101111", NULL, out);
-    addInstr("LR_W",               "00010??00000?????010?????0101111", NULL, out);
-    addInstr("SC_W",               "00011????????????010?????0101111", NULL, out);
-    addInstr("AMOADD_D",           "00000????????????011?????0101111", NULL, out);
-    addInstr("AMOXOR_D",           "00100????????????011?????0101111", NULL, out);
-    addInstr("AMOOR_D",            "01000????????????011?????0101111", NULL, out);
-    addInstr("AMOAND_D",           "01100????????????011?????0101111", NULL, out);
-    addInstr("AMOMIN_D",           "10000????????????011?????0101111", NULL, out);
-    addInstr("AMOMAX_D",           "10100????????????011?????0101111", NULL, out);
-    addInstr("AMOMINU_D",          "11000????????????011?????0101111", NULL, out);
-    addInstr("AMOMAXU_D",          "11100????????????011?????0101111", NULL, out);
-    addInstr("AMOSWAP_D",          "00001????????????011?????0101111", NULL, out);
-    addInstr("LR_D",               "00010??00000?????011?????0101111", NULL, out);
-    addInstr("SC_D",               "00011????????????011?????0101111", NULL, out);
-    */
-    data->csr[CSR_misa] |= (1LL << ('A' - 'A'));
+    addSupportedInstruction(new AMOADD_W, out);
+    addSupportedInstruction(new AMOXOR_W, out);
+    addSupportedInstruction(new AMOOR_W, out);
+    addSupportedInstruction(new AMOAND_W, out);
+    addSupportedInstruction(new AMOMIN_W, out);
+    addSupportedInstruction(new AMOMAX_W, out);
+    addSupportedInstruction(new AMOMINU_W, out);
+    addSupportedInstruction(new AMOMAXU_W, out);
+    addSupportedInstruction(new AMOSWAP_W, out);
+    addSupportedInstruction(new LR_W, out);
+    addSupportedInstruction(new SC_W, out);
+    addSupportedInstruction(new AMOADD_D, out);
+    addSupportedInstruction(new AMOXOR_D, out);
+    addSupportedInstruction(new AMOOR_D, out);
+    addSupportedInstruction(new AMOAND_D, out);
+    addSupportedInstruction(new AMOMIN_D, out);
+    addSupportedInstruction(new AMOMAX_D, out);
+    addSupportedInstruction(new AMOMINU_D, out);
+    addSupportedInstruction(new AMOMAXU_D, out);
+    addSupportedInstruction(new AMOSWAP_D, out);
+    addSupportedInstruction(new LR_D, out);
+    addSupportedInstruction(new SC_D, out);
+    data->csr[Csr_misa] |= (1LL << ('A' - 'A'));
 }
 
 }  // namespace debugger
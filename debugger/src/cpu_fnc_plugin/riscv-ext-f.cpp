@@ -2,90 +2,585 @@
  * @file
  * @copyright  Copyright 2016 GNSS Sensor Ltd. All right reserved.
  * @author     Sergey Khabarov - sergeykhbr@gmail.com
- * @brief      RISC-V extension-F (Floating-point Instructions).
+ * @brief      RISC-V extension-F and extension-D (Floating-point
+ *             Instructions).
+ *
+ * @details    Each instruction class handles both single and double
+ *             precision formats, computations are done by the host FPU
+ *             (see fpu.h). Single precision values are NaN-boxed in the
+ *             64-bits registers, not properly boxed operands are treated
+ *             as the canonical NaN.
  */
 
 #include "api_utils.h"
 #include "riscv-isa.h"
 #include "instructions.h"
+#include "fpu.h"
 
 namespace debugger {
 
+void generateException(uint64_t code, CpuContextType *data);
+
+/**
+ * @brief Base class of the floating-point instructions.
+ */
+class FpuProcessor : public IsaProcessor {
+public:
+    FpuProcessor(const char *name, const char *bits, bool dbl)
+        : IsaProcessor(name, bits), dbl_(dbl) {}
+
+protected:
+    /** @return -1 and raise Illegal instruction on reserved rounding mode */
+    int roundingMode(uint32_t rm, CpuContextType *data) {
+        int ret = fpuRoundingMode(rm, data);
+        if (ret < 0) {
+            generateException(EXCEPTION_InstrIllegal, data);
+        }
+        return ret;
+    }
+
+    /** Finalize instruction with the floating-point register result */
+    void writeFreg(uint32_t rd, uint64_t v, uint64_t flags,
+                   CpuContextType *data) {
+        data->fregs[rd] = dbl_ ? v : (NAN_BOX32 | v);
+        fpuUpdateStatus(flags, data);
+        data->npc = data->pc + 4;
+    }
+
+    /** Finalize instruction with the integer register result */
+    void writeIreg(uint32_t rd, uint64_t v, uint64_t flags,
+                   CpuContextType *data) {
+        if (rd != 0) {
+            data->regs[rd] = v;
+        }
+        if (flags != data->csr[Csr_fflags]) {
+            fpuUpdateStatus(flags, data);
+        }
+        data->npc = data->pc + 4;
+    }
+
+    uint64_t freg(uint32_t idx, CpuContextType *data) {
+        return dbl_ ? data->fregs[idx] : fpuUnbox32(data->fregs[idx]);
+    }
+
+    bool dbl_;
+};
+
+/**
+ * @brief Add, subtract, multiply, divide and square root.
+ */
+class FpuArith : public FpuProcessor {
+public:
+    FpuArith(const char *name, const char *bits, bool dbl, EFpuOp op)
+        : FpuProcessor(name, bits, dbl), op_(op) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        int rm = roundingMode(u.bits.funct3, data);
+        if (rm < 0) {
+            return;
+        }
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t b = freg(u.bits.rs2, data);
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuArith64(op_, rm, a, b, &flags);
+        } else {
+            res = fpuArith32(op_, rm, static_cast<uint32_t>(a),
+                             static_cast<uint32_t>(b), &flags);
+        }
+        writeFreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    EFpuOp op_;
+};
+
+/**
+ * @brief Fused multiply-add instructions (R4-type).
+ */
+class FpuFma : public FpuProcessor {
+public:
+    FpuFma(const char *name, const char *bits, bool dbl, EFpuFma op)
+        : FpuProcessor(name, bits, dbl), op_(op) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        int rm = roundingMode(u.bits.funct3, data);
+        if (rm < 0) {
+            return;
+        }
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t b = freg(u.bits.rs2, data);
+        uint64_t c = freg(u.bits.funct7 >> 2, data);    // rs3
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuFma64(op_, rm, a, b, c, &flags);
+        } else {
+            res = fpuFma32(op_, rm, static_cast<uint32_t>(a),
+                           static_cast<uint32_t>(b),
+                           static_cast<uint32_t>(c), &flags);
+        }
+        writeFreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    EFpuFma op_;
+};
+
+/**
+ * @brief Sign injection: FSGNJ (mode 0), FSGNJN (1), FSGNJX (2).
+ */
+class FpuSignInject : public FpuProcessor {
+public:
+    FpuSignInject(const char *name, const char *bits, bool dbl, int mode)
+        : FpuProcessor(name, bits, dbl), mode_(mode) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t sign = dbl_ ? (1ull << 63) : (1ull << 31);
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t b = freg(u.bits.rs2, data);
+        switch (mode_) {
+        case 0:
+            b &= sign;
+            break;
+        case 1:
+            b = ~b & sign;
+            break;
+        default:
+            b = (a ^ b) & sign;
+        }
+        writeFreg(u.bits.rd, (a & ~sign) | b, 0, data);
+    }
+
+private:
+    int mode_;
+};
+
+class FpuMinMax : public FpuProcessor {
+public:
+    FpuMinMax(const char *name, const char *bits, bool dbl, bool max)
+        : FpuProcessor(name, bits, dbl), max_(max) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t b = freg(u.bits.rs2, data);
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuMinMax64(max_, a, b, &flags);
+        } else {
+            res = fpuMinMax32(max_, static_cast<uint32_t>(a),
+                              static_cast<uint32_t>(b), &flags);
+        }
+        writeFreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    bool max_;
+};
+
+/**
+ * @brief FEQ, FLT and FLE write 1 into integer register if true.
+ */
+class FpuCompare : public FpuProcessor {
+public:
+    FpuCompare(const char *name, const char *bits, bool dbl,
+               bool lt, bool eq)
+        : FpuProcessor(name, bits, dbl), lt_(lt), eq_(eq) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t b = freg(u.bits.rs2, data);
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuCompare64(lt_, eq_, a, b, &flags);
+        } else {
+            res = fpuCompare32(lt_, eq_, static_cast<uint32_t>(a),
+                               static_cast<uint32_t>(b), &flags);
+        }
+        writeIreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    bool lt_;
+    bool eq_;
+};
+
+class FpuClass : public FpuProcessor {
+public:
+    FpuClass(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t res = dbl_ ? fpuClass64(a)
+                            : fpuClass32(static_cast<uint32_t>(a));
+        writeIreg(u.bits.rd, res, 0, data);
+    }
+};
+
+/**
+ * @brief Conversion into signed or unsigned integer (W or L).
+ */
+class FpuToInt : public FpuProcessor {
+public:
+    FpuToInt(const char *name, const char *bits, bool dbl,
+             bool is32, bool isUnsigned)
+        : FpuProcessor(name, bits, dbl), is32_(is32),
+        isUnsigned_(isUnsigned) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        int rm = roundingMode(u.bits.funct3, data);
+        if (rm < 0) {
+            return;
+        }
+        uint64_t a = freg(u.bits.rs1, data);
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuToInt64(rm, a, is32_, isUnsigned_, &flags);
+        } else {
+            res = fpuToInt32(rm, static_cast<uint32_t>(a), is32_,
+                             isUnsigned_, &flags);
+        }
+        writeIreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    bool is32_;
+    bool isUnsigned_;
+};
+
+/**
+ * @brief Conversion from signed or unsigned integer (W or L).
+ */
+class FpuFromInt : public FpuProcessor {
+public:
+    FpuFromInt(const char *name, const char *bits, bool dbl,
+               bool is32, bool isUnsigned)
+        : FpuProcessor(name, bits, dbl), is32_(is32),
+        isUnsigned_(isUnsigned) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        int rm = roundingMode(u.bits.funct3, data);
+        if (rm < 0) {
+            return;
+        }
+        uint64_t v = data->regs[u.bits.rs1];
+        if (is32_ && isUnsigned_) {
+            v &= 0xffffffffull;
+        } else if (is32_) {
+            v = static_cast<int64_t>(static_cast<int32_t>(v));
+        }
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuFromInt64(rm, v, isUnsigned_, &flags);
+        } else {
+            res = fpuFromInt32(rm, v, isUnsigned_, &flags);
+        }
+        writeFreg(u.bits.rd, res, flags, data);
+    }
+
+private:
+    bool is32_;
+    bool isUnsigned_;
+};
+
+/**
+ * @brief FCVT.S.D (dbl = false) and FCVT.D.S (dbl = true).
+ */
+class FpuConvert : public FpuProcessor {
+public:
+    FpuConvert(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        int rm = roundingMode(u.bits.funct3, data);
+        if (rm < 0) {
+            return;
+        }
+        uint64_t flags = data->csr[Csr_fflags];
+        uint64_t res;
+        if (dbl_) {
+            res = fpuCvtDS(fpuUnbox32(data->fregs[u.bits.rs1]), &flags);
+        } else {
+            res = fpuCvtSD(rm, data->fregs[u.bits.rs1], &flags);
+        }
+        writeFreg(u.bits.rd, res, flags, data);
+    }
+};
+
+/**
+ * @brief Move bits from floating-point register into integer register.
+ *
+ * Single precision value is sign extended, NaN-boxing isn't checked.
+ */
+class FpuMoveToInt : public FpuProcessor {
+public:
+    FpuMoveToInt(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t v = data->fregs[u.bits.rs1];
+        if (!dbl_) {
+            v = static_cast<int64_t>(static_cast<int32_t>(v));
+        }
+        writeIreg(u.bits.rd, v, 0, data);
+    }
+};
+
+class FpuMoveFromInt : public FpuProcessor {
+public:
+    FpuMoveFromInt(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        uint64_t v = data->regs[u.bits.rs1];
+        if (!dbl_) {
+            v &= 0xffffffffull;
+        }
+        writeFreg(u.bits.rd, v, 0, data);
+    }
+};
+
+/**
+ * @brief FLW and FLD.
+ */
+class FpuLoad : public FpuProcessor {
+public:
+    FpuLoad(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        Axi4TransactionType trans;
+        ISA_I_type u;
+        u.value = payload[0];
+        uint64_t off = u.bits.imm;
+        if (off & 0x800) {
+            off |= EXT_SIGN_12;
+        }
+        trans.source_idx = CFG_NASTI_MASTER_CACHED;
+        trans.action = MemAction_Read;
+        trans.addr = data->regs[u.bits.rs1] + off;
+        trans.xsize = dbl_ ? 8 : 4;
+        trans.rpayload.b64[0] = 0;
+        if (trans.addr & (trans.xsize - 1)) {
+            generateException(EXCEPTION_LoadMisalign, data);
+            return;
+        }
+        data->dmi->b_transport(&trans);
+        if (data->exception) {
+            return;     // page fault, rd isn't modified
+        }
+        if (dbl_) {
+            writeFreg(u.bits.rd, trans.rpayload.b64[0], 0, data);
+        } else {
+            writeFreg(u.bits.rd, trans.rpayload.b32[0], 0, data);
+        }
+        if (data->mem_trace_file) {
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
+        }
+    }
+};
+
+/**
+ * @brief FSW and FSD.
+ */
+class FpuStore : public FpuProcessor {
+public:
+    FpuStore(const char *name, const char *bits, bool dbl)
+        : FpuProcessor(name, bits, dbl) {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        Axi4TransactionType trans;
+        ISA_S_type u;
+        u.value = payload[0];
+        uint64_t off = (u.bits.imm11_5 << 5) | u.bits.imm4_0;
+        if (off & 0x800) {
+            off |= EXT_SIGN_12;
+        }
+        trans.source_idx = CFG_NASTI_MASTER_CACHED;
+        trans.action = MemAction_Write;
+        trans.xsize = dbl_ ? 8 : 4;
+        trans.wstrb = (1 << trans.xsize) - 1;
+        trans.addr = data->regs[u.bits.rs1] + off;
+        trans.wpayload.b64[0] = data->fregs[u.bits.rs2];
+        if (!dbl_) {
+            trans.wpayload.b64[0] &= 0xffffffffull;
+        }
+        if (trans.addr & (trans.xsize - 1)) {
+            generateException(EXCEPTION_StoreMisalign, data);
+            return;
+        }
+        data->dmi->b_transport(&trans);
+        data->npc = data->pc + 4;
+        if (data->mem_trace_file) {
+            data->mem_trace_file->writeMem(data->pc, trans.addr, true,
+                                           trans.wpayload.b64[0]);
+        }
+    }
+};
+
 void addIsaExtensionF(CpuContextType *data, AttributeType *out) {
-    // TODO
-    /*
-    addInstr("FADD_S",             "0000000??????????????????1010011", NULL, out);
-    addInstr("FSUB_S",             "0000100??????????????????1010011", NULL, out);
-    addInstr("FMUL_S",             "0001000??????????????????1010011", NULL, out);
-    addInstr("FDIV_S",             "0001100??????????????????1010011", NULL, out);
-    addInstr("FSGNJ_S",            "0010000??????????000?????1010011", NULL, out);
-    addInstr("FSGNJN_S",           "0010000??????????001?????1010011", NULL, out);
-    addInstr("FSGNJX_S",           "0010000??????????010?????1010011", NULL, out);
-    addInstr("FMIN_S",             "0010100??????????000?????1010011", NULL, out);
-    addInstr("FMAX_S",             "0010100??????????001?????1010011", NULL, out);
-    addInstr("FSQRT_S",            "010110000000?????????????1010011", NULL, out);
-    addInstr("FADD_D",             "0000001??????????????????1010011", NULL, out);
-    addInstr("FSUB_D",             "0000101??????????????????1010011", NULL, out);
-    addInstr("FMUL_D",             "0001001??????????????????1010011", NULL, out);
-    addInstr("FDIV_D",             "0001101??????????????????1010011", NULL, out);
-    addInstr("FSGNJ_D",            "0010001??????????000?????1010011", NULL, out);
-    addInstr("FSGNJN_D",           "0010001??????????001?????1010011", NULL, out);
-    addInstr("FSGNJX_D",           "0010001??????????010?????1010011", NULL, out);
-    addInstr("FMIN_D",             "0010101??????????000?????1010011", NULL, out);
-    addInstr("FMAX_D",             "0010101??????????001?????1010011", NULL, out);
-    addInstr("FCVT_S_D",           "010000000001?????????????1010011", NULL, out);
-    addInstr("FCVT_D_S",           "010000100000?????????????1010011", NULL, out);
-    addInstr("FSQRT_D",            "010110100000?????????????1010011", NULL, out);
-    addInstr("FLE_S",              "1010000??????????000?????1010011", NULL, out);
-    addInstr("FLT_S",              "1010000??????????001?????1010011", NULL, out);
-    addInstr("FEQ_S",              "1010000??????????010?????1010011", NULL, out);
-    addInstr("FLE_D",              "1010001??????????000?????1010011", NULL, out);
-    addInstr("FLT_D",              "1010001??????????001?????1010011", NULL, out);
-    addInstr("FEQ_D",              "1010001??????????010?????1010011", NULL, out);
-    addInstr("FCVT_W_S",           "110000000000?????????????1010011", NULL, out);
-    addInstr("FCVT_WU_S",          "110000000001?????????????1010011", NULL, out);
-    addInstr("FCVT_L_S",           "110000000010?????????????1010011", NULL, out);
-    addInstr("FCVT_LU_S",          "110000000011?????????????1010011", NULL, out);
-    addInstr("FMV_X_S",            "111000000000?????000?????1010011", NULL, out);
-    addInstr("FCLASS_S",           "111000000000?????001?????1010011", NULL, out);
-    addInstr("FCVT_W_D",           "110000100000?????????????1010011", NULL, out);
-    addInstr("FCVT_WU_D",          "110000100001?????????????1010011", NULL, out);
-    addInstr("FCVT_L_D",           "110000100010?????????????1010011", NULL, out);
-    addInstr("FCVT_LU_D",          "110000100011?????????????1010011", NULL, out);
-    addInstr("FMV_X_D",            "111000100000?????000?????1010011", NULL, out);
-    addInstr("FCLASS_D",           "111000100000?????001?????1010011", NULL, out);
-    addInstr("FCVT_S_W",           "110100000000?????????????1010011", NULL, out);
-    addInstr("FCVT_S_WU",          "110100000001?????????????1010011", NULL, out);
-    addInstr("FCVT_S_L",           "110100000010?????????????1010011", NULL, out);
-    addInstr("FCVT_S_LU",          "110100000011?????????????1010011", NULL, out);
-    addInstr("FMV_S_X",            "111100000000?????000?????1010011", NULL, out);
-    addInstr("FCVT_D_W",           "110100100000?????????????1010011", NULL, out);
-    addInstr("FCVT_D_WU",          "110100100001?????????????1010011", NULL, out);
-    addInstr("FCVT_D_L",           "110100100010?????????????1010011", NULL, out);
-    addInstr("FCVT_D_LU",          "110100100011?????????????1010011", NULL, out);
-    addInstr("FMV_D_X",            "111100100000?????000?????1010011", NULL, out);
-    addInstr("FLW",                "?????????????????010?????0000111", NULL, out);
-    addInstr("FLD",                "?????????????????011?????0000111", NULL, out);
-    addInstr("FSW",                "?????????????????010?????0100111", NULL, out);
-    addInstr("FSD",                "?????????????????011?????0100111", NULL, out);
-    addInstr("FMADD_S",            "?????00??????????????????1000011", NULL, out);
-    addInstr("FMSUB_S",            "?????00??????????????????1000111", NULL, out);
-    addInstr("FNMSUB_S",           "?????00??????????????????1001011", NULL, out);
-    addInstr("FNMADD_S",           "?????00??????????????????1001111", NULL, out);
-    addInstr("FMADD_D",            "?????01??????????????????1000011", NULL, out);
-    addInstr("FMSUB_D",            "?????01??????????????????1000111", NULL, out);
-    addInstr("FNMSUB_D",           "?????01??????????????????1001011", NULL, out);
-    addInstr("FNMADD_D",           "?????01??????????????????1001111", NULL, out);
-    def FRFLAGS            = BitPat("b00000000000100000010?????1110011")
-    def FSFLAGS            = BitPat("b000000000001?????001?????1110011")
-    def FSFLAGSI           = BitPat("b000000000001?????101?????1110011")
-    def FRRM               = BitPat("b00000000001000000010?????1110011")
-    def FSRM               = BitPat("b000000000010?????001?????1110011")
-    def FSRMI              = BitPat("b000000000010?????101?????1110011")
-    def FSCSR              = BitPat("b000000000011?????001?????1110011")
-    def FRCSR              = BitPat("b00000000001100000010?????1110011")
-    */
-    data->csr[CSR_misa] |= (1LL << ('F' - 'A'));
+    addSupportedInstruction(new FpuArith("FADD_S",
+        "0000000??????????????????1010011", false, Fpu_Add), out);
+    addSupportedInstruction(new FpuArith("FSUB_S",
+        "0000100??????????????????1010011", false, Fpu_Sub), out);
+    addSupportedInstruction(new FpuArith("FMUL_S",
+        "0001000??????????????????1010011", false, Fpu_Mul), out);
+    addSupportedInstruction(new FpuArith("FDIV_S",
+        "0001100??????????????????1010011", false, Fpu_Div), out);
+    addSupportedInstruction(new FpuArith("FSQRT_S",
+        "010110000000?????????????1010011", false, Fpu_Sqrt), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJ_S",
+        "0010000??????????000?????1010011", false, 0), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJN_S",
+        "0010000??????????001?????1010011", false, 1), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJX_S",
+        "0010000??????????010?????1010011", false, 2), out);
+    addSupportedInstruction(new FpuMinMax("FMIN_S",
+        "0010100??????????000?????1010011", false, false), out);
+    addSupportedInstruction(new FpuMinMax("FMAX_S",
+        "0010100??????????001?????1010011", false, true), out);
+    addSupportedInstruction(new FpuCompare("FLE_S",
+        "1010000??????????000?????1010011", false, true, true), out);
+    addSupportedInstruction(new FpuCompare("FLT_S",
+        "1010000??????????001?????1010011", false, true, false), out);
+    addSupportedInstruction(new FpuCompare("FEQ_S",
+        "1010000??????????010?????1010011", false, false, true), out);
+    addSupportedInstruction(new FpuToInt("FCVT_W_S",
+        "110000000000?????????????1010011", false, true, false), out);
+    addSupportedInstruction(new FpuToInt("FCVT_WU_S",
+        "110000000001?????????????1010011", false, true, true), out);
+    addSupportedInstruction(new FpuToInt("FCVT_L_S",
+        "110000000010?????????????1010011", false, false, false), out);
+    addSupportedInstruction(new FpuToInt("FCVT_LU_S",
+        "110000000011?????????????1010011", false, false, true), out);
+    addSupportedInstruction(new FpuMoveToInt("FMV_X_S",
+        "111000000000?????000?????1010011", false), out);
+    addSupportedInstruction(new FpuClass("FCLASS_S",
+        "111000000000?????001?????1010011", false), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_S_W",
+        "110100000000?????????????1010011", false, true, false), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_S_WU",
+        "110100000001?????????????1010011", false, true, true), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_S_L",
+        "110100000010?????????????1010011", false, false, false), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_S_LU",
+        "110100000011?????????????1010011", false, false, true), out);
+    addSupportedInstruction(new FpuMoveFromInt("FMV_S_X",
+        "111100000000?????000?????1010011", false), out);
+    addSupportedInstruction(new FpuLoad("FLW",
+        "?????????????????010?????0000111", false), out);
+    addSupportedInstruction(new FpuStore("FSW",
+        "?????????????????010?????0100111", false), out);
+    addSupportedInstruction(new FpuFma("FMADD_S",
+        "?????00??????????????????1000011", false, Fpu_MAdd), out);
+    addSupportedInstruction(new FpuFma("FMSUB_S",
+        "?????00??????????????????1000111", false, Fpu_MSub), out);
+    addSupportedInstruction(new FpuFma("FNMSUB_S",
+        "?????00??????????????????1001011", false, Fpu_NMSub), out);
+    addSupportedInstruction(new FpuFma("FNMADD_S",
+        "?????00??????????????????1001111", false, Fpu_NMAdd), out);
+    // FRFLAGS, FSFLAGS, FRRM, FSRM, FRCSR, FSCSR are aliases of the CSR
+    // instructions with the fflags, frm and fcsr registers.
+
+    data->csr[Csr_misa] |= (1LL << ('F' - 'A'));
+}
+
+void addIsaExtensionD(CpuContextType *data, AttributeType *out) {
+    addSupportedInstruction(new FpuArith("FADD_D",
+        "0000001??????????????????1010011", true, Fpu_Add), out);
+    addSupportedInstruction(new FpuArith("FSUB_D",
+        "0000101??????????????????1010011", true, Fpu_Sub), out);
+    addSupportedInstruction(new FpuArith("FMUL_D",
+        "0001001??????????????????1010011", true, Fpu_Mul), out);
+    addSupportedInstruction(new FpuArith("FDIV_D",
+        "0001101??????????????????1010011", true, Fpu_Div), out);
+    addSupportedInstruction(new FpuArith("FSQRT_D",
+        "010110100000?????????????1010011", true, Fpu_Sqrt), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJ_D",
+        "0010001??????????000?????1010011", true, 0), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJN_D",
+        "0010001??????????001?????1010011", true, 1), out);
+    addSupportedInstruction(new FpuSignInject("FSGNJX_D",
+        "0010001??????????010?????1010011", true, 2), out);
+    addSupportedInstruction(new FpuMinMax("FMIN_D",
+        "0010101??????????000?????1010011", true, false), out);
+    addSupportedInstruction(new FpuMinMax("FMAX_D",
+        "0010101??????????001?????1010011", true, true), out);
+    addSupportedInstruction(new FpuConvert("FCVT_S_D",
+        "010000000001?????????????1010011", false), out);
+    addSupportedInstruction(new FpuConvert("FCVT_D_S",
+        "010000100000?????????????1010011", true), out);
+    addSupportedInstruction(new FpuCompare("FLE_D",
+        "1010001??????????000?????1010011", true, true, true), out);
+    addSupportedInstruction(new FpuCompare("FLT_D",
+        "1010001??????????001?????1010011", true, true, false), out);
+    addSupportedInstruction(new FpuCompare("FEQ_D",
+        "1010001??????????010?????1010011", true, false, true), out);
+    addSupportedInstruction(new FpuToInt("FCVT_W_D",
+        "110000100000?????????????1010011", true, true, false), out);
+    addSupportedInstruction(new FpuToInt("FCVT_WU_D",
+        "110000100001?????????????1010011", true, true, true), out);
+    addSupportedInstruction(new FpuToInt("FCVT_L_D",
+        "110000100010?????????????1010011", true, false, false), out);
+    addSupportedInstruction(new FpuToInt("FCVT_LU_D",
+        "110000100011?????????????1010011", true, false, true), out);
+    addSupportedInstruction(new FpuMoveToInt("FMV_X_D",
+        "111000100000?????000?????1010011", true), out);
+    addSupportedInstruction(new FpuClass("FCLASS_D",
+        "111000100000?????001?????1010011", true), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_D_W",
+        "110100100000?????????????1010011", true, true, false), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_D_WU",
+        "110100100001?????????????1010011", true, true, true), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_D_L",
+        "110100100010?????????????1010011", true, false, false), out);
+    addSupportedInstruction(new FpuFromInt("FCVT_D_LU",
+        "110100100011?????????????1010011", true, false, true), out);
+    addSupportedInstruction(new FpuMoveFromInt("FMV_D_X",
+        "111100100000?????000?????1010011", true), out);
+    addSupportedInstruction(new FpuLoad("FLD",
+        "?????????????????011?????0000111", true), out);
+    addSupportedInstruction(new FpuStore("FSD",
+        "?????????????????011?????0100111", true), out);
+    addSupportedInstruction(new FpuFma("FMADD_D",
+        "?????01??????????????????1000011", true, Fpu_MAdd), out);
+    addSupportedInstruction(new FpuFma("FMSUB_D",
+        "?????01??????????????????1000111", true, Fpu_MSub), out);
+    addSupportedInstruction(new FpuFma("FNMSUB_D",
+        "?????01??????????????????1001011", true, Fpu_NMSub), out);
+    addSupportedInstruction(new FpuFma("FNMADD_D",
+        "?????01??????????????????1001111", true, Fpu_NMAdd), out);
+
+    data->csr[Csr_misa] |= (1LL << ('D' - 'A'));
 }
 
 }  // namespace debugger
@@ -14,30 +14,131 @@ namespace debugger {
 void generateException(uint64_t code, CpuContextType *data);
 void generateInterrupt(uint64_t code, CpuContextType *data);
 
-uint64_t readCSR(uint32_t idx, CpuContextType *data) {
-    uint64_t ret = data->csr[idx];
+/**
+ * @brief Slot of the CSR in the context table.
+ * @return -1 if the register isn't implemented.
+ */
+int csrIndex(uint32_t idx) {
     switch (idx) {
-    case CSR_mtime:
-        ret = data->step_cnt;
-        break;
+    case CSR_fflags:            return Csr_fflags;
+    case CSR_frm:               return Csr_frm;
+    case CSR_fcsr:              return Csr_fcsr;
+    case CSR_mstatus:           return Csr_mstatus;
+    case CSR_medeleg:           return Csr_medeleg;
+    case CSR_mideleg:           return Csr_mideleg;
+    case CSR_mie:               return Csr_mie;
+    case CSR_mtvec:             return Csr_mtvec;
+    case CSR_mcounteren:        return Csr_mcounteren;
+    case CSR_mtimecmp:          return Csr_mtimecmp;
+    case CSR_mscratch:          return Csr_mscratch;
+    case CSR_stvec:             return Csr_stvec;
+    case CSR_sscratch:          return Csr_sscratch;
+    case CSR_uepc:              return Csr_uepc;
+    case CSR_sepc:              return Csr_sepc;
+    case CSR_hepc:              return Csr_hepc;
+    case CSR_mepc:              return Csr_mepc;
+    case CSR_mcause:            return Csr_mcause;
+    case CSR_mbadaddr:          return Csr_mbadaddr;
+    case CSR_mip:               return Csr_mip;
+    case CSR_satp:              return Csr_satp;
+    case CSR_mtime:             return Csr_mtime;
+    case CSR_misa:              return Csr_misa;
+    case CSR_mvendorid:         return Csr_mvendorid;
+    case CSR_marchid:           return Csr_marchid;
+    case CSR_mimplementationid: return Csr_mimplementationid;
+    case CSR_mhartid:           return Csr_mhartid;
     default:;
     }
-    return ret;
+    return -1;
+}
+
+/**
+ * @brief Storage of the CSR without a slot.
+ * @details Such registers aren't used by the model, but software still
+ *          reads back the written value. Returns 0 when the table is full.
+ */
+static uint64_t *otherCSR(uint32_t idx, bool add, CpuContextType *data) {
+    for (int i = 0; i < data->csr_other_cnt; i++) {
+        if (data->csr_other[i][0] == idx) {
+            return &data->csr_other[i][1];
+        }
+    }
+    if (!add || data->csr_other_cnt >= CSR_OTHER_TOTAL) {
+        return 0;
+    }
+    uint64_t *item = data->csr_other[data->csr_other_cnt++];
+    item[0] = idx;
+    item[1] = 0;
+    return &item[1];
+}
+
+uint64_t readCSR(uint32_t idx, CpuContextType *data) {
+    int slot = csrIndex(idx);
+    uint64_t *pother;
+    switch (slot) {
+    case -1:
+        // Never written registers are read as zero
+        pother = otherCSR(idx, false, data);
+        return pother ? *pother : 0;
+    case Csr_mtime:
+        return data->step_cnt;
+    default:;
+    }
+    return data->csr[slot];
 }
 
 void writeCSR(uint32_t idx, uint64_t val, CpuContextType *data) {
-    switch (idx) {
+    int slot = csrIndex(idx);
+    uint64_t *pother;
+    switch (slot) {
+    case -1:
+        pother = otherCSR(idx, true, data);
+        if (pother) {
+            *pother = val;
+        } else {
+            RISCV_printf(NULL, LOG_ERROR,
+                         "CSR %03x write ignored, table is full", idx);
+        }
+        break;
     // Read-Only registers
-    case CSR_misa:
-    case CSR_mvendorid:
-    case CSR_marchid:
-    case CSR_mimplementationid:
-    case CSR_mhartid:
+    case Csr_misa:
+    case Csr_mvendorid:
+    case Csr_marchid:
+    case Csr_mimplementationid:
+    case Csr_mhartid:
+        break;
+    case Csr_mtime:
         break;
-    case CSR_mtime:
+    // Floating-point flags and rounding mode are views of fcsr
+    case Csr_fflags:
+        data->csr[Csr_fcsr] = (data->csr[Csr_fcsr] & ~0x1full) | (val & 0x1f);
+        data->csr[Csr_fflags] = val & 0x1f;
+        break;
+    case Csr_frm:
+        data->csr[Csr_fcsr] = (data->csr[Csr_fcsr] & 0x1f) | ((val & 0x7) << 5);
+        data->csr[Csr_frm] = val & 0x7;
+        break;
+    case Csr_fcsr:
+        data->csr[Csr_fcsr] = val & 0xff;
+        data->csr[Csr_fflags] = val & 0x1f;
+        data->csr[Csr_frm] = (val >> 5) & 0x7;
+        break;
+    // Address translation context
+    case Csr_mstatus:
+        data->csr[slot] = val;
+        data->dmi->updateContext();
+        break;
+    case Csr_satp:
+        // Unsupported mode (WARL) ignores the entire write
+        if ((val >> SATP_MODE_SHIFT) != SATP_MODE_BARE
+            && (val >> SATP_MODE_SHIFT) != SATP_MODE_SV39) {
+            break;
+        }
+        data->csr[slot] = val;
+        data->dmi->updateContext();
         break;
     default:
-        data->csr[idx] = val;
+        data->csr[slot] = val;
     }
 }
 
@@ -343,6 +444,53 @@ public:
     }
 };
 
+/**
+ * @brief SFENCE.VMA (supervisor memory-management fence)
+ *
+ * Orders the page table updates with the following implicit references.
+ * Cached translations of the page rs1 or of all pages (rs1 = x0) are
+ * removed, address space identifier in rs2 isn't used.
+ */
+class SFENCE_VMA : public IsaProcessor {
+public:
+    SFENCE_VMA() : IsaProcessor("SFENCE_VMA",
+                                "0001001??????????000000001110011") {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        ISA_R_type u;
+        u.value = payload[0];
+        if (data->cur_prv_level == PRV_U) {
+            generateException(EXCEPTION_InstrIllegal, data);
+            return;
+        }
+        if (u.bits.rs1 == 0) {
+            data->dmi->flush();
+        } else {
+            data->dmi->flushPage(data->regs[u.bits.rs1]);
+        }
+        data->npc = data->pc + 4;
+    }
+};
+
+/**
+ * @brief WFI (wait for interrupt)
+ *
+ * Hart is stalled until any interrupt becomes pending and then continues
+ * from the next instruction, or traps if the interrupt is enabled. Stalled
+ * cycles are skipped by the CPU loop up to the nearest scheduled event.
+ */
+class WFI : public IsaProcessor {
+public:
+    WFI() : IsaProcessor("WFI", "00010000010100000000000001110011") {}
+
+    virtual void exec(uint32_t *payload, CpuContextType *data) {
+        data->npc = data->pc + 4;
+        if (data->interrupt_pending == 0) {
+            data->wfi = true;
+        }
+    }
+};
+
 /**
  * @brief EBREAK (breakpoint instruction)
  *
@@ -400,13 +548,13 @@ void addIsaPrivilegedRV64I(CpuContextType *data, AttributeType *out) {
     addSupportedInstruction(new MRET, out);
     addSupportedInstruction(new FENCE, out);
     addSupportedInstruction(new FENCE_I, out);
+    addSupportedInstruction(new SFENCE_VMA, out);
+    addSupportedInstruction(new WFI, out);
     addSupportedInstruction(new ECALL, out);
     addSupportedInstruction(new EBREAK, out);
     // TODO:
     /*
   def DRET               = BitPat("b01111011001000000000000001110011")
-  def SFENCE_VM          = BitPat("b000100000100?????000000001110011")
-  def WFI                = BitPat("b00010000010100000000000001110011")  // wait for interrupt
 
     def RDCYCLE            = BitPat("b11000000000000000010?????1110011")
     def RDTIME             = BitPat("b11000000000100000010?????1110011")
@@ -422,9 +570,9 @@ void addIsaPrivilegedRV64I(CpuContextType *data, AttributeType *out) {
      * The 'U', 'S', and 'H' bits will be set if there is support for 
      * user, supervisor, and hypervisor privilege modes respectively.
      */
-    data->csr[CSR_misa] |= (1LL << ('U' - 'A'));
-    data->csr[CSR_misa] |= (1LL << ('S' - 'A'));
-    data->csr[CSR_misa] |= (1LL << ('H' - 'A'));
+    data->csr[Csr_misa] |= (1LL << ('U' - 'A'));
+    data->csr[Csr_misa] |= (1LL << ('S' - 'A'));
+    data->csr[Csr_misa] |= (1LL << ('H' - 'A'));
 }
 
 }  // namespace debugger
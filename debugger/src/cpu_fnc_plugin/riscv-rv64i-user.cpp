@@ -51,16 +51,6 @@ public:
         }
         data->regs[u.bits.rd] = data->regs[u.bits.rs1] + imm;
         data->npc = data->pc + 4;
-
-        if (u.bits.rs1 == 0) {
-            RISCV_sprintf(data->disasm, sizeof(data->disasm), 
-                "li %s,%d", IREGS_NAMES[u.bits.rd], static_cast<uint32_t>(imm));
-        } else {
-            RISCV_sprintf(data->disasm, sizeof(data->disasm), 
-                "addi %s,%s,%d", IREGS_NAMES[u.bits.rd], 
-                                 IREGS_NAMES[u.bits.rs1], 
-                                 static_cast<uint32_t>(imm));
-        }
     }
 };
 
@@ -91,12 +81,6 @@ public:
             data->regs[u.bits.rd] |= EXT_SIGN_32;
         }
         data->npc = data->pc + 4;
-
-        if (u.bits.imm == 0) {
-            //RISCV_sprintf(data->disasm, sizeof(data->disasm), "sext.w %s,%d",);
-        } else {
-            //RISCV_sprintf(data->disasm, sizeof(data->disasm), "addiw %s,%s,%d",);
-        }
     }
 };
 
@@ -454,18 +438,16 @@ public:
             trans.rpayload.b64[0] = 0;
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
+            if (data->exception) {
+                return;     // page fault, rd isn't modified
+            }
             data->npc = data->pc + 4;
         }
         data->regs[u.bits.rd] = trans.rpayload.b64[0];
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -494,7 +476,10 @@ public:
             trans.rpayload.b64[0] = 0;
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
+            if (data->exception) {
+                return;     // page fault, rd isn't modified
+            }
             data->npc = data->pc + 4;
         }
         data->regs[u.bits.rd] = trans.rpayload.b64[0];
@@ -502,13 +487,8 @@ public:
             data->regs[u.bits.rd] |= EXT_SIGN_32;
         }
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                    "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                    static_cast<int>(data->pc),
-                    static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -537,18 +517,16 @@ public:
             trans.rpayload.b64[0] = 0;
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
+            if (data->exception) {
+                return;     // page fault, rd isn't modified
+            }
             data->npc = data->pc + 4;
         }
         data->regs[u.bits.rd] = trans.rpayload.b64[0];
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                    "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                    static_cast<int>(data->pc),
-                    static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -577,7 +555,10 @@ public:
             trans.rpayload.b64[0] = 0;
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
+            if (data->exception) {
+                return;     // page fault, rd isn't modified
+            }
             data->npc = data->pc + 4;
         }
         data->regs[u.bits.rd] = trans.rpayload.b16[0];
@@ -585,13 +566,8 @@ public:
             data->regs[u.bits.rd] |= EXT_SIGN_16;
         }
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -620,18 +596,16 @@ public:
             trans.rpayload.b64[0] = 0;
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
+            if (data->exception) {
+                return;     // page fault, rd isn't modified
+            }
             data->npc = data->pc + 4;
         }
         data->regs[u.bits.rd] = trans.rpayload.b16[0];
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -656,20 +630,18 @@ public:
         trans.action = MemAction_Read;
         trans.addr = data->regs[u.bits.rs1] + off;
         trans.xsize = 1;
-        data->ibus->b_transport(&trans);
+        data->dmi->b_transport(&trans);
+        if (data->exception) {
+            return;     // page fault, rd isn't modified
+        }
         data->regs[u.bits.rd] = trans.rpayload.b8[0];
         if (data->regs[u.bits.rd] & (1LL << 7)) {
             data->regs[u.bits.rd] |= EXT_SIGN_8;
         }
         data->npc = data->pc + 4;
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -694,17 +666,15 @@ public:
         trans.action = MemAction_Read;
         trans.addr = data->regs[u.bits.rs1] + off;
         trans.xsize = 1;
-        data->ibus->b_transport(&trans);
+        data->dmi->b_transport(&trans);
+        if (data->exception) {
+            return;     // page fault, rd isn't modified
+        }
         data->regs[u.bits.rd] = trans.rpayload.b8[0];
         data->npc = data->pc + 4;
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                    "%08x: [%08x] => %016" RV_PRI64 "x\n",
-                    static_cast<int>(data->pc),
-                    static_cast<int>(trans.addr), trans.rpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, false,
+                                           trans.rpayload.b64[0]);
         }
     }
 };
@@ -1126,17 +1096,12 @@ public:
         if (trans.addr & 0x7) {
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
             data->npc = data->pc + 4;
         }
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] <= %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr), trans.wpayload.b64[0]);
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, true,
+                                           trans.wpayload.b64[0]);
         }
     }
 };
@@ -1166,18 +1131,12 @@ public:
         if (trans.addr & 0x3) {
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
             data->npc = data->pc + 4;
         }
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] <= %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr),
-                        static_cast<uint64_t>(trans.wpayload.b32[0]));
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, true,
+                                           trans.wpayload.b32[0]);
         }
     }
 };
@@ -1207,18 +1166,12 @@ public:
         if (trans.addr & 0x1) {
             generateException(EXCEPTION_LoadMisalign, data);
         } else {
-            data->ibus->b_transport(&trans);
+            data->dmi->b_transport(&trans);
             data->npc = data->pc + 4;
         }
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] <= %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr),
-                        static_cast<uint64_t>(trans.wpayload.b16[0]));
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, true,
+                                           trans.wpayload.b16[0]);
         }
     }
 };
@@ -1245,17 +1198,11 @@ public:
         trans.wstrb = (1 << trans.xsize) - 1;
         trans.addr = data->regs[u.bits.rs1] + off;
         trans.wpayload.b64[0] = data->regs[u.bits.rs2] & 0xFF;
-        data->ibus->b_transport(&trans);
+        data->dmi->b_transport(&trans);
         data->npc = data->pc + 4;
         if (data->mem_trace_file) {
-            char tstr[512];
-            RISCV_sprintf(tstr, sizeof(tstr), 
-                        "%08x: [%08x] <= %016" RV_PRI64 "x\n",
-                        static_cast<int>(data->pc),
-                        static_cast<int>(trans.addr),
-                        static_cast<uint64_t>(trans.wpayload.b8[0]));
-            (*data->mem_trace_file) << tstr;
-            data->mem_trace_file->flush();
+            data->mem_trace_file->writeMem(data->pc, trans.addr, true,
+                                           trans.wpayload.b8[0]);
         }
     }
 };
@@ -1395,8 +1342,8 @@ void addIsaUserRV64I(CpuContextType *data, AttributeType *out) {
      *      2 = 64
      *      3 = 128
      */
-    data->csr[CSR_misa] = 0x8000000000000000LL;
-    data->csr[CSR_misa] |= (1LL << ('I' - 'A'));
+    data->csr[Csr_misa] = 0x8000000000000000LL;
+    data->csr[Csr_misa] |= (1LL << ('I' - 'A'));
 }
 
 /**
@@ -1421,7 +1368,7 @@ void generateException(uint64_t code, CpuContextType *data) {
     cause.value     = 0;
     cause.bits.irq  = 0;
     cause.bits.code = code;
-    data->csr[CSR_mcause] = cause.value;
+    data->csr[Csr_mcause] = cause.value;
     data->exception |= 1LL << code;
 }
 
@@ -1430,7 +1377,7 @@ void generateInterrupt(uint64_t code, CpuContextType *data) {
     cause.value     = 0;
     cause.bits.irq  = 1;
     cause.bits.code = code;
-    data->csr[CSR_mcause] = cause.value;
+    data->csr[Csr_mcause] = cause.value;
     data->interrupt = 1;
 }
 
@@ -0,0 +1,73 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Data watchpoints table of the functional CPU model.
+ */
+
+#include <string.h>
+#include "watchpoints.h"
+
+namespace debugger {
+
+WatchpointTableType::WatchpointTableType() {
+    listener_ = 0;
+    total_ = 0;
+    memset(bitmap_, 0, sizeof(bitmap_));
+}
+
+bool WatchpointTableType::add(uint64_t addr, uint64_t length,
+                              uint32_t flags) {
+    if (total_ == WATCHPOINTS_MAX || length == 0) {
+        return false;
+    }
+    wp_[total_].addr = addr;
+    wp_[total_].length = length;
+    wp_[total_].flags = flags;
+    total_++;
+    updateBitmap();
+    return true;
+}
+
+bool WatchpointTableType::remove(uint64_t addr) {
+    for (int i = 0; i < total_; i++) {
+        if (wp_[i].addr == addr) {
+            wp_[i] = wp_[--total_];
+            updateBitmap();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WatchpointTableType::check(uint64_t addr, uint32_t size,
+                                uint32_t flags) {
+    for (int i = 0; i < total_; i++) {
+        WatchpointType &wp = wp_[i];
+        if ((wp.flags & flags) == 0) {
+            continue;
+        }
+        if (addr < wp.addr + wp.length && wp.addr < addr + size) {
+            listener_->watchpointHit(addr, flags);
+            return;
+        }
+    }
+}
+
+void WatchpointTableType::updateBitmap() {
+    memset(bitmap_, 0, sizeof(bitmap_));
+    for (int i = 0; i < total_; i++) {
+        uint64_t page = wp_[i].addr >> PAGE_BITS;
+        uint64_t last = (wp_[i].addr + wp_[i].length - 1) >> PAGE_BITS;
+        if (last - page >= PAGE_HASH_TOTAL) {
+            memset(bitmap_, 0xff, sizeof(bitmap_));
+            return;
+        }
+        for (; page <= last; page++) {
+            uint32_t idx = static_cast<uint32_t>(page) & (PAGE_HASH_TOTAL - 1);
+            bitmap_[idx >> 5] |= 1u << (idx & 0x1f);
+        }
+    }
+}
+
+}  // namespace debugger
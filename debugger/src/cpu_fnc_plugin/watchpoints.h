@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Data watchpoints table of the functional CPU model.
+ *
+ * @details    Each memory page has a bit in the bitmap that is set if any
+ *             watched range overlaps the page. Direct memory access isn't
+ *             granted for such pages, so only accesses to the marked pages
+ *             are checked against the list of ranges.
+ */
+
+#ifndef __DEBUGGER_CPU_RISCV_WATCHPOINTS_H__
+#define __DEBUGGER_CPU_RISCV_WATCHPOINTS_H__
+
+#include <inttypes.h>
+#include "iface.h"
+
+namespace debugger {
+
+static const uint32_t WATCH_READ = 0x1;
+static const uint32_t WATCH_WRITE = 0x2;
+
+static const char *const IFACE_WATCHPOINT_LISTENER = "IWatchpointListener";
+
+class IWatchpointListener : public IFace {
+public:
+    IWatchpointListener() : IFace(IFACE_WATCHPOINT_LISTENER) {}
+
+    /**
+     * @brief Data access to the watched range.
+     * @param[in] addr Access address.
+     * @param[in] flags WATCH_READ or WATCH_WRITE.
+     */
+    virtual void watchpointHit(uint64_t addr, uint32_t flags) =0;
+};
+
+class WatchpointTableType {
+public:
+    WatchpointTableType();
+
+    void init(IWatchpointListener *listener) { listener_ = listener; }
+
+    /** @return false if the table is full */
+    bool add(uint64_t addr, uint64_t length, uint32_t flags);
+
+    /** @return false if watchpoint with such start address wasn't found */
+    bool remove(uint64_t addr);
+
+    int getFreeTotal() { return WATCHPOINTS_MAX - total_; }
+
+    /** Page of the specified address possibly contains watched data */
+    bool isPageMarked(uint64_t addr) {
+        uint32_t idx = pageIndex(addr);
+        return ((bitmap_[idx >> 5] >> (idx & 0x1f)) & 0x1) != 0;
+    }
+
+    /** Check access to the marked page and notify listener on hit */
+    void check(uint64_t addr, uint32_t size, uint32_t flags);
+
+private:
+    static const int PAGE_BITS = 12;
+    static const uint32_t PAGE_HASH_TOTAL = 1 << 16;
+    static const int WATCHPOINTS_MAX = 16;
+
+    struct WatchpointType {
+        uint64_t addr;
+        uint64_t length;
+        uint32_t flags;
+    };
+
+    static uint32_t pageIndex(uint64_t addr) {
+        return static_cast<uint32_t>(addr >> PAGE_BITS) & (PAGE_HASH_TOTAL - 1);
+    }
+    void updateBitmap();
+
+    IWatchpointListener *listener_;
+    uint32_t bitmap_[PAGE_HASH_TOTAL / 32];
+    WatchpointType wp_[WATCHPOINTS_MAX];
+    int total_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CPU_RISCV_WATCHPOINTS_H__
@@ -7,9 +7,21 @@
 
 #include "api_core.h"
 #include "cpu_riscv_rtl.h"
+#include "coreservices/ielfreader.h"
 
 namespace debugger {
 
+/**
+ * CSRs copied in both directions. Privilege level is transferred via
+ * debug-only dcsr.
+ */
+static const uint16_t TRANSFER_CSR[] = {
+    CSR_mstatus, CSR_mtvec, CSR_mscratch, CSR_mepc, CSR_mcause,
+    CSR_mbadaddr, CSR_mie, CSR_dcsr
+};
+static const unsigned TRANSFER_CSR_TOTAL =
+    sizeof(TRANSFER_CSR) / sizeof(TRANSFER_CSR[0]);
+
 CpuRiscV_RTL::CpuRiscV_RTL(const char *name)  
     : IService(name), IHap(HAP_ConfigDone) {
     registerInterface(static_cast<IThread *>(this));
@@ -20,13 +32,43 @@ CpuRiscV_RTL::CpuRiscV_RTL(const char *name)
     registerAttribute("InVcdFile", &InVcdFile_);
     registerAttribute("OutVcdFile", &OutVcdFile_);
     registerAttribute("GenerateRef", &GenerateRef_);
+    registerAttribute("FastForwardCpu", &ffCpu_);
+    registerAttribute("FastForwardSteps", &ffSteps_);
+    registerAttribute("FastForwardBreak", &ffBreak_);
+    registerAttribute("SamplePeriod", &samplePeriod_);
+    registerAttribute("SampleWarmup", &sampleWarmup_);
+    registerAttribute("SampleLength", &sampleLength_);
+    registerAttribute("Samples", &samples_);
 
     bus_.make_string("");
     freqHz_.make_uint64(1);
     InVcdFile_.make_string("");
     OutVcdFile_.make_string("");
     GenerateRef_.make_boolean(false);
+    ffCpu_.make_string("");
+    ffSteps_.make_uint64(0);
+    ffBreak_.make_string("");
+    samplePeriod_.make_uint64(0);
+    sampleWarmup_.make_uint64(0);
+    sampleLength_.make_uint64(0);
+    samples_.make_list(0);
+    ifunc_ = 0;
+    ifclk_ = 0;
+    phase_ = Phase_Rtl;
+    ffOffset_ = 0;
+    rtlOffset_ = 0;
+    armed_ = ~0ull;
+    breakSet_ = false;
+    breakAddr_ = 0;
+    dportDone_ = false;
+    ffDone_ = false;
+    dsuTrans_ = 0;
+    dsuCb_ = 0;
     RISCV_event_create(&config_done_, "config_done");
+    RISCV_event_create(&wake_, "ffwd_wake");
+    RISCV_event_create(&dportEvent_, "ffwd_dport");
+    RISCV_mutex_init(&mutexClock_);
+    RISCV_mutex_init(&mutexDsu_);
     RISCV_register_hap(static_cast<IHap *>(this));
 
     createSystemC();
@@ -35,6 +77,10 @@ CpuRiscV_RTL::CpuRiscV_RTL(const char *name)
 CpuRiscV_RTL::~CpuRiscV_RTL() {
     deleteSystemC();
     RISCV_event_close(&config_done_);
+    RISCV_event_close(&wake_);
+    RISCV_event_close(&dportEvent_);
+    RISCV_mutex_destroy(&mutexClock_);
+    RISCV_mutex_destroy(&mutexDsu_);
 }
 
 void CpuRiscV_RTL::postinitService() {
@@ -47,6 +93,21 @@ void CpuRiscV_RTL::postinitService() {
         return;
     }
 
+    if (ffCpu_.size()) {
+        ifunc_ = static_cast<ICpuRiscV *>(
+            RISCV_get_service_iface(ffCpu_.to_string(), IFACE_CPU_RISCV));
+        ifclk_ = static_cast<IClock *>(
+            RISCV_get_service_iface(ffCpu_.to_string(), IFACE_CLOCK));
+        if (!ifunc_ || !ifclk_) {
+            RISCV_error("Fast-forward CPU '%s' not found",
+                        ffCpu_.to_string());
+            ifunc_ = 0;
+        } else {
+            phase_ = Phase_Functional;
+            wrapper_->setBypass(static_cast<ICpuRiscV *>(this));
+        }
+    }
+
     if (InVcdFile_.size()) {
         i_vcd_ = sc_create_vcd_trace_file(InVcdFile_.to_string());
         i_vcd_->set_time_unit(1, SC_PS);
@@ -134,15 +195,22 @@ void CpuRiscV_RTL::hapTriggered(IFace *isrc, EHapType type,
     RISCV_event_set(&config_done_);
 }
 
+/** Fast-forward loop runs SystemC by slices and checks the thread state */
 void CpuRiscV_RTL::stop() {
-    sc_stop();
+    if (!isFastForward()) {
+        sc_stop();
+    }
     IThread::stop();
 }
 
 void CpuRiscV_RTL::busyLoop() {
     RISCV_event_wait(&config_done_);
 
-    sc_start();
+    if (isFastForward()) {
+        runFastForward();
+    } else {
+        sc_start();
+    }
 
     if (i_vcd_) {
         sc_close_vcd_trace_file(i_vcd_);
@@ -152,5 +220,423 @@ void CpuRiscV_RTL::busyLoop() {
     }
 }
 
-}  // namespace debugger
+uint64_t CpuRiscV_RTL::getStepCounter() {
+    if (phase_ != Phase_Rtl) {
+        return ifclk_->getStepCounter() + ffOffset_;
+    }
+    return wb_time.read() + 2 + rtlOffset_;
+}
+
+/**
+ * While the functional model is active callbacks are kept in the own queue
+ * and only the nearest one is registered in the functional model.
+ * Wrapper calls callback immediately when the RTL core is in reset, so
+ * it's done without lock.
+ */
+void CpuRiscV_RTL::registerStepCallback(IClockListener *cb, uint64_t t) {
+    if (!isFastForward()) {
+        wrapper_->registerStepCallback(cb, t);
+        return;
+    }
+    bool immediate = false;
+    RISCV_mutex_lock(&mutexClock_);
+    if (phase_ == Phase_Rtl) {
+        if (wrapper_->w_nrst) {
+            wrapper_->registerStepCallback(cb, toLocal(t, rtlOffset_));
+        } else {
+            immediate = true;
+        }
+    } else {
+        queue_.put(t, cb);
+        if (phase_ == Phase_Functional && t < armed_) {
+            armed_ = t;
+            ifclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                         toLocal(t, ffOffset_));
+        }
+    }
+    RISCV_mutex_unlock(&mutexClock_);
+    if (immediate) {
+        wrapper_->registerStepCallback(cb, toLocal(t, rtlOffset_));
+    }
+}
+
+void CpuRiscV_RTL::stepCallback(uint64_t t) {
+    IFace *cb;
+    if (phase_ != Phase_Functional) {
+        return;
+    }
+    uint64_t now = t + ffOffset_;
+    queue_.pushPreQueued();
+    while ((cb = queue_.getNext(now)) != 0) {
+        static_cast<IClockListener *>(cb)->stepCallback(now);
+    }
+
+    RISCV_mutex_lock(&mutexClock_);
+    queue_.pushPreQueued();
+    armed_ = queue_.getNextTime();
+    if (armed_ != ~0ull) {
+        ifclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                     toLocal(armed_, ffOffset_));
+    }
+    RISCV_mutex_unlock(&mutexClock_);
+}
+
+void CpuRiscV_RTL::raiseSignal(int idx) {
+    ifunc_->raiseSignal(idx);
+}
+
+void CpuRiscV_RTL::lowerSignal(int idx) {
+    ifunc_->lowerSignal(idx);
+}
+
+/**
+ * DSU requests are executed by the fast-forward loop, so they don't
+ * interleave with the state transfer.
+ */
+void CpuRiscV_RTL::nb_transport_debug_port(DebugPortTransactionType *trans,
+                                           IDbgNbResponse *cb) {
+    RISCV_mutex_lock(&mutexDsu_);
+    if (ffDone_) {
+        RISCV_mutex_unlock(&mutexDsu_);
+        wrapper_->dportRequest(trans, cb);
+        return;
+    }
+    dsuTrans_ = trans;
+    dsuCb_ = cb;
+    RISCV_mutex_unlock(&mutexDsu_);
+    RISCV_event_set(&wake_);
+}
+
+void CpuRiscV_RTL::nb_response_debug_port(DebugPortTransactionType *trans) {
+    dportDone_ = true;
+    RISCV_event_set(&dportEvent_);
+}
+
+/**
+ * Without FastForwardSteps and FastForwardBreak the switch happens when
+ * the functional model is halted from debugger and RTL core stays halted.
+ */
+void CpuRiscV_RTL::runFastForward() {
+    bool use_break = ffBreak_.is_integer() || ffBreak_.size() != 0;
+    uint64_t target = ~0ull;
+    if (ffSteps_.to_uint64()) {
+        target = ffSteps_.to_uint64();
+    }
+    bool halted = target == ~0ull && !use_break;
+    bool sampling = samplePeriod_.to_uint64() && sampleLength_.to_uint64();
+
+    while (runFunctional(target, use_break)) {
+        if (!switchToRtl(halted)) {
+            // Retried on the next sample or halt from debugger
+            use_break = false;
+            if (sampling && !halted) {
+                target = ifclk_->getStepCounter() + samplePeriod_.to_uint64();
+            } else {
+                target = ~0ull;
+                halted = true;
+            }
+            continue;
+        }
+        if (!sampling || halted) {
+            break;
+        }
+        if (!measureSample()) {
+            return;
+        }
+        switchToFunctional();
+        target = ifclk_->getStepCounter() + samplePeriod_.to_uint64();
+        use_break = false;
+    }
+
+    finishFastForward();
+    while (isEnabled()) {
+        sc_start(wrapper_->o_clk.period() * POLL_CLOCKS);
+    }
+}
+
+/** Functional model is halted on the instruction count 'target' */
+bool CpuRiscV_RTL::runFunctional(uint64_t target, bool use_break) {
+    uint64_t step = dport(false, false, 2, 3, 0);
+    if (target == ~0ull) {
+        dport(false, true, 2, 0, 0);
+    } else if (target > step) {
+        dport(false, true, 2, 1, target - step);
+        dport(false, true, 2, 0, 0x2);      // stepping
+    } else {
+        dport(false, true, 2, 0, 0x1);
+    }
+
+    while (isEnabled()) {
+        RISCV_event_wait_ms(&wake_, POLL_MS);
+        RISCV_event_clear(&wake_);
+        serveDsu();
+        if (use_break && !breakSet_ && resolveBreak(&breakAddr_)) {
+            dport(false, true, 2, 5, breakAddr_);
+            breakSet_ = true;
+        }
+        if ((dport(false, false, 2, 0, 0) & 0x1) == 0) {
+            continue;
+        }
+        step = dport(false, false, 2, 3, 0);
+        uint64_t npc = dport(false, false, 1, Reg_Total + 1, 0);
+        bool bp = breakSet_ && npc == breakAddr_;
+        if (step >= target || bp || (target == ~0ull && !use_break)) {
+            if (breakSet_) {
+                dport(false, true, 2, 6, breakAddr_);
+                breakSet_ = false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/** RTL core is running until 'executed' instructions */
+bool CpuRiscV_RTL::runRtl(uint64_t executed) {
+    while (isEnabled()) {
+        sc_start(wrapper_->o_clk.period() * POLL_CLOCKS);
+        serveDsu();
+        if (dport(true, false, 2, 3, 0) >= executed) {
+            return true;
+        }
+    }
+    return false;
+}
 
+/** Caches and branch predictor are warmed up before the measurement */
+bool CpuRiscV_RTL::measureSample() {
+    uint64_t instr0 = dport(true, false, 2, 3, 0);
+    if (!runRtl(instr0 + sampleWarmup_.to_uint64())) {
+        return false;
+    }
+    instr0 = dport(true, false, 2, 3, 0);
+    uint64_t clk0 = dport(true, false, 2, 2, 0);
+    if (!runRtl(instr0 + sampleLength_.to_uint64())) {
+        return false;
+    }
+    uint64_t instr = dport(true, false, 2, 3, 0) - instr0;
+    uint64_t clk = dport(true, false, 2, 2, 0) - clk0;
+
+    AttributeType item;
+    item.make_list(3);
+    item[0u].make_uint64(getStepCounter());
+    item[1].make_uint64(instr);
+    item[2].make_uint64(clk);
+    samples_.add_to_list(&item);
+
+    uint64_t instr_total = 0;
+    uint64_t clk_total = 0;
+    for (unsigned i = 0; i < samples_.size(); i++) {
+        instr_total += samples_[i][1].to_uint64();
+        clk_total += samples_[i][2].to_uint64();
+    }
+    RISCV_info("Sample %d: CPI %.3f, average CPI %.3f",
+               samples_.size(),
+               static_cast<double>(clk) / static_cast<double>(instr),
+               static_cast<double>(clk_total)
+                    / static_cast<double>(instr_total));
+    return true;
+}
+
+/**
+ * Reset flushes RTL pipeline and caches. Halt is requested right after the
+ * reset and the registers are overwritten, so the reset code started in
+ * these few clocks doesn't affect the transferred state.
+ */
+bool CpuRiscV_RTL::switchToRtl(bool halted) {
+    AttributeType state;
+    phase_ = Phase_Switch;
+    // Round trip via debug port after the phase change, so callback of
+    // the functional model isn't executed anymore
+    readState(false, &state);
+    if (!isTransferable(&state)) {
+        phase_ = Phase_Functional;
+        return false;
+    }
+
+    wrapper_->w_nrst = 0;
+    sc_start(wrapper_->o_clk.period() * RESET_CLOCKS);
+    wrapper_->w_nrst = 1;
+    sc_start(wrapper_->o_clk.period() * 3);
+    dport(true, true, 2, 0, 0x1);
+    writeState(true, &state);
+
+    AttributeType list;
+    RISCV_mutex_lock(&mutexClock_);
+    uint64_t now = ifclk_->getStepCounter() + ffOffset_;
+    rtlOffset_ = toLocal(now, wb_time.read() + 2);
+    queue_.pushPreQueued();
+    queue_.getItems(&list);
+    queue_.clear();
+    armed_ = ~0ull;
+    phase_ = Phase_Rtl;
+    RISCV_mutex_unlock(&mutexClock_);
+
+    for (unsigned i = 0; i < list.size(); i++) {
+        wrapper_->registerStepCallback(
+            static_cast<IClockListener *>(list[i][1].to_iface()),
+            toLocal(list[i][0u].to_uint64(), rtlOffset_));
+    }
+    RISCV_info("Switched to RTL at step %" RV_PRI64 "d, npc %08" RV_PRI64 "x",
+               now, state[1].to_uint64());
+
+    if (!halted) {
+        dport(true, true, 2, 0, 0);
+    }
+    return true;
+}
+
+/**
+ * RTL core implements neither supervisor mode nor virtual memory, such
+ * state of the functional model can't be transferred.
+ */
+bool CpuRiscV_RTL::isTransferable(const AttributeType *state) {
+    uint64_t npc = (*state)[1].to_uint64();
+    uint64_t prv = dport(false, false, 0, CSR_dcsr, 0) & 0x3;
+    if (prv == PRV_S) {
+        RISCV_error("Can't switch to RTL at %08" RV_PRI64 "x: "
+                    "supervisor mode isn't supported", npc);
+        return false;
+    }
+    uint64_t satp = dport(false, false, 0, CSR_satp, 0);
+    if ((satp >> SATP_MODE_SHIFT) != SATP_MODE_BARE) {
+        RISCV_error("Can't switch to RTL at %08" RV_PRI64 "x: "
+                    "address translation isn't supported", npc);
+        return false;
+    }
+    return true;
+}
+
+void CpuRiscV_RTL::switchToFunctional() {
+    AttributeType state;
+    AttributeType list;
+    dport(true, true, 2, 0, 0x1);
+    readState(true, &state);
+    writeState(false, &state);
+
+    RISCV_mutex_lock(&mutexClock_);
+    wrapper_->takeStepQueue(&list);
+    uint64_t now = wb_time.read() + 2 + rtlOffset_;
+    ffOffset_ = toLocal(now, ifclk_->getStepCounter());
+    for (unsigned i = 0; i < list.size(); i++) {
+        queue_.put(list[i][0u].to_uint64() + rtlOffset_,
+                   list[i][1].to_iface());
+    }
+    phase_ = Phase_Functional;
+    queue_.pushPreQueued();
+    armed_ = queue_.getNextTime();
+    if (armed_ != ~0ull) {
+        ifclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                     toLocal(armed_, ffOffset_));
+    }
+    RISCV_mutex_unlock(&mutexClock_);
+}
+
+/** DSU requests are passed to the RTL core directly */
+void CpuRiscV_RTL::finishFastForward() {
+    RISCV_mutex_lock(&mutexDsu_);
+    ffDone_ = true;
+    RISCV_mutex_unlock(&mutexDsu_);
+    serveDsu();
+}
+
+/** Symbol is resolved when ELF-file is loaded */
+bool CpuRiscV_RTL::resolveBreak(uint64_t *addr) {
+    if (ffBreak_.is_integer()) {
+        *addr = ffBreak_.to_uint64();
+        return true;
+    }
+    AttributeType lstServ;
+    AttributeType symbols;
+    RISCV_get_services_with_iface(IFACE_ELFREADER, &lstServ);
+    for (unsigned i = 0; i < lstServ.size(); i++) {
+        IService *iserv = static_cast<IService *>(lstServ[i].to_iface());
+        IElfReader *elf = static_cast<IElfReader *>(
+                            iserv->getInterface(IFACE_ELFREADER));
+        elf->getSymbols(&symbols);
+        for (unsigned n = 0; n < symbols.size(); n++) {
+            AttributeType &item = symbols[n];
+            if (item[Symbol_Name].is_equal(ffBreak_.to_string())) {
+                *addr = item[Symbol_Addr].to_uint64();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void CpuRiscV_RTL::serveDsu() {
+    RISCV_mutex_lock(&mutexDsu_);
+    DebugPortTransactionType *trans = dsuTrans_;
+    IDbgNbResponse *cb = dsuCb_;
+    dsuTrans_ = 0;
+    RISCV_mutex_unlock(&mutexDsu_);
+    if (!trans) {
+        return;
+    }
+    transport(phase_ == Phase_Rtl, trans);
+    cb->nb_response_debug_port(trans);
+}
+
+/** Integer registers, npc and CSRs as [regs, npc, csrs] list */
+void CpuRiscV_RTL::readState(bool rtl, AttributeType *state) {
+    state->make_list(3);
+    AttributeType &regs = (*state)[0u];
+    AttributeType &csrs = (*state)[2];
+    regs.make_list(Reg_Total);
+    for (unsigned i = 0; i < Reg_Total; i++) {
+        regs[i].make_uint64(dport(rtl, false, 1, i, 0));
+    }
+    (*state)[1].make_uint64(dport(rtl, false, 1, Reg_Total + 1, 0));
+    csrs.make_list(TRANSFER_CSR_TOTAL);
+    for (unsigned i = 0; i < TRANSFER_CSR_TOTAL; i++) {
+        csrs[i].make_uint64(dport(rtl, false, 0, TRANSFER_CSR[i], 0));
+    }
+}
+
+void CpuRiscV_RTL::writeState(bool rtl, AttributeType *state) {
+    AttributeType &regs = (*state)[0u];
+    AttributeType &csrs = (*state)[2];
+    for (unsigned i = 1; i < Reg_Total; i++) {
+        dport(rtl, true, 1, i, regs[i].to_uint64());
+    }
+    for (unsigned i = 0; i < TRANSFER_CSR_TOTAL; i++) {
+        dport(rtl, true, 0, TRANSFER_CSR[i], csrs[i].to_uint64());
+    }
+    dport(rtl, true, 1, Reg_Total + 1, (*state)[1].to_uint64());
+}
+
+uint64_t CpuRiscV_RTL::dport(bool rtl, bool write, uint8_t region,
+                             uint16_t addr, uint64_t wdata) {
+    DebugPortTransactionType trans;
+    trans.write = write;
+    trans.region = region;
+    trans.addr = addr;
+    trans.wdata = wdata;
+    trans.rdata = 0;
+    transport(rtl, &trans);
+    return trans.rdata;
+}
+
+/**
+ * Request to the RTL core is processed by the SystemC kernel running on
+ * this thread, the functional model responds from its own thread.
+ */
+void CpuRiscV_RTL::transport(bool rtl, DebugPortTransactionType *trans) {
+    dportDone_ = false;
+    RISCV_event_clear(&dportEvent_);
+    if (rtl) {
+        wrapper_->dportRequest(trans, static_cast<IDbgNbResponse *>(this));
+        while (!dportDone_ && isEnabled()) {
+            sc_start(wrapper_->o_clk.period());
+        }
+    } else {
+        ifunc_->nb_transport_debug_port(trans,
+                                        static_cast<IDbgNbResponse *>(this));
+        while (!dportDone_ && isEnabled()) {
+            RISCV_event_wait_ms(&dportEvent_, POLL_MS);
+        }
+    }
+}
+
+}  // namespace debugger
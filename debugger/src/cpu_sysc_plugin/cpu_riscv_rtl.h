@@ -10,8 +10,25 @@
  *             InVcdFile   - Stimulus VCD file
  *             OutVcdFile  - Reference VCD file with any number of signals
  *
+ *             FastForwardCpu   - Functional model executing the code before
+ *                                the switch to RTL core
+ *             FastForwardSteps - Switch at the instruction count
+ *             FastForwardBreak - Switch at address or symbol name
+ *             SamplePeriod     - Instructions executed by functional model
+ *                                between samples, 0 = single switch
+ *             SampleWarmup     - RTL instructions before the measurement
+ *             SampleLength     - Measured RTL instructions
+ *
  * @note       When GenerateRef is true Core uses step counter instead 
  *             of clock counter to generate callbacks.
+ *
+ * @note       With FastForwardCpu the functional model shares the bus and
+ *             memory. Integer registers, npc, machine CSRs and privilege
+ *             level (debug-only dcsr) are transferred into the reset and
+ *             halted RTL core. Switch is refused in supervisor mode or with
+ *             enabled address translation. IClock of this core proxies
+ *             the clock of the active model and step counter continues
+ *             across the switches.
  */
 
 #ifndef __DEBUGGER_CPU_RISCV_RTL_H__
@@ -26,6 +43,7 @@
 #include "coreservices/imemop.h"
 #include "coreservices/ibus.h"
 #include "coreservices/iclock.h"
+#include "coreservices/iclklistener.h"
 #include "rtl_wrapper.h"
 #include "riverlib/river_top.h"
 #include <systemc.h>
@@ -35,6 +53,9 @@ namespace debugger {
 class CpuRiscV_RTL : public IService, 
                  public IThread,
                  public IClock,
+                 public IClockListener,
+                 public ICpuRiscV,
+                 public IDbgNbResponse,
                  public IHap {
 public:
     CpuRiscV_RTL(const char *name);
@@ -44,13 +65,20 @@ public:
     virtual void postinitService();
 
     /** IClock */
-    virtual uint64_t getStepCounter() {
-        return wb_time.read() + 2;
-    }
+    virtual uint64_t getStepCounter();
+    virtual void registerStepCallback(IClockListener *cb, uint64_t t);
 
-    virtual void registerStepCallback(IClockListener *cb, uint64_t t) {
-        wrapper_->registerStepCallback(cb, t);
-    }
+    /** IClockListener: step callbacks of the functional model */
+    virtual void stepCallback(uint64_t t);
+
+    /** ICpuRiscV: wrapper bypass while fast-forwarding */
+    virtual void raiseSignal(int idx);
+    virtual void lowerSignal(int idx);
+    virtual void nb_transport_debug_port(DebugPortTransactionType *trans,
+                                         IDbgNbResponse *cb);
+
+    /** IDbgNbResponse */
+    virtual void nb_response_debug_port(DebugPortTransactionType *trans);
 
     /** IHap */
     virtual void hapTriggered(IFace *isrc, EHapType type, const char *descr);
@@ -62,18 +90,74 @@ protected:
     virtual void busyLoop();
 
 private:
+    static const unsigned POLL_MS = 10;
+    static const unsigned POLL_CLOCKS = 10000;
+    static const unsigned RESET_CLOCKS = 8;
+
+    enum EPhase {
+        Phase_Rtl,
+        Phase_Functional,
+        Phase_Switch
+    };
+
     void createSystemC();
     void deleteSystemC();
 
+    bool isFastForward() { return ifunc_ != 0; }
+    void runFastForward();
+    bool runFunctional(uint64_t target, bool use_break);
+    bool runRtl(uint64_t executed);
+    bool measureSample();
+    bool switchToRtl(bool halted);
+    bool isTransferable(const AttributeType *state);
+    void switchToFunctional();
+    void finishFastForward();
+    bool resolveBreak(uint64_t *addr);
+    void serveDsu();
+    void readState(bool rtl, AttributeType *state);
+    void writeState(bool rtl, AttributeType *state);
+    uint64_t dport(bool rtl, bool write, uint8_t region, uint16_t addr,
+                   uint64_t wdata);
+    void transport(bool rtl, DebugPortTransactionType *trans);
+    uint64_t toLocal(uint64_t t, uint64_t offset) {
+        return t > offset ? t - offset : 0;
+    }
+
 private:
     AttributeType bus_;
     AttributeType freqHz_;
     AttributeType InVcdFile_;
     AttributeType OutVcdFile_;
     AttributeType GenerateRef_;
+    AttributeType ffCpu_;
+    AttributeType ffSteps_;
+    AttributeType ffBreak_;
+    AttributeType samplePeriod_;
+    AttributeType sampleWarmup_;
+    AttributeType sampleLength_;
+    AttributeType samples_;         // [step, instructions, clocks] list
     event_def config_done_;
     IBus *ibus_;
 
+    ICpuRiscV *ifunc_;
+    IClock *ifclk_;
+    volatile EPhase phase_;
+    uint64_t ffOffset_;             // step counter minus functional time
+    uint64_t rtlOffset_;            // step counter minus RTL time
+    AsyncTQueueType queue_;         // step callbacks while not in RTL
+    uint64_t armed_;                // nearest functional step callback
+    mutex_def mutexClock_;
+    bool breakSet_;
+    uint64_t breakAddr_;
+
+    event_def wake_;
+    event_def dportEvent_;
+    volatile bool dportDone_;
+    mutex_def mutexDsu_;
+    bool ffDone_;                   // DSU requests go to the wrapper
+    DebugPortTransactionType *dsuTrans_;
+    IDbgNbResponse *dsuCb_;
+
     sc_signal<bool> w_clk;
     sc_signal<bool> w_nrst;
     // Timer:
@@ -35,6 +35,7 @@ CsrRegs::CsrRegs(sc_module_name name_) : sc_module(name_) {
     sensitive << r.mpie;
     sensitive << r.mpp;
     sensitive << r.mepc;
+    sensitive << r.mie_bits;
     sensitive << r.trap_irq;
     sensitive << r.trap_code;
 
@@ -119,6 +120,10 @@ void CsrRegs::procedure_RegAccess(uint64_t iaddr, bool iwena,
     case CSR_mideleg:// - Machine itnerrupt delegation
         break;
     case CSR_mie:// - Machine interrupt enable bit
+        (*ordata) = ir.mie_bits;
+        if (iwena) {
+            ov->mie_bits = iwdata;
+        }
         break;
     case CSR_mtvec:
         (*ordata) = ir.mtvec;
@@ -144,9 +149,16 @@ void CsrRegs::procedure_RegAccess(uint64_t iaddr, bool iwena,
         (*ordata) = 0;
         (*ordata)[63] = ir.trap_irq;
         (*ordata)(3, 0) = ir.trap_code;
+        if (iwena) {
+            ov->trap_irq = iwdata[63];
+            ov->trap_code = iwdata(3, 0);
+        }
         break;
     case CSR_mbadaddr:// - Machine bad address
         (*ordata) = ir.mbadaddr;
+        if (iwena) {
+            ov->mbadaddr = iwdata(BUS_ADDR_WIDTH - 1, 0);
+        }
         break;
     case CSR_mip:// - Machine interrupt pending
         break;
@@ -171,6 +183,14 @@ void CsrRegs::comb() {
     procedure_RegAccess(i_dport_addr.read(), w_dport_wena,
                         i_dport_wdata.read(), r, &v, &wb_dport_rdata);
 
+    // Privilege level is accessible only via debug port
+    if (i_dport_addr.read() == CSR_dcsr) {
+        wb_dport_rdata(1, 0) = r.mode;
+        if (w_dport_wena) {
+            v.mode = i_dport_wdata.read()(1, 0);
+        }
+    }
+
 
     if (i_addr.read() == CSR_mepc && i_xret.read()) {
         // Switch to previous mode
@@ -214,6 +234,7 @@ void CsrRegs::comb() {
         v.mpie = 0;
         v.mpp = 0;
         v.mepc = 0;
+        v.mie_bits = 0;
         v.trap_code = 0;
         v.trap_irq = 0;
     }
@@ -57,6 +57,7 @@ private:
         sc_signal<bool> mpie;                   // Previous MIE value
         sc_signal<sc_uint<2>> mpp;              // Previous mode
         sc_signal<sc_uint<RISCV_ARCH>> mepc;
+        sc_signal<sc_uint<RISCV_ARCH>> mie_bits;    // mie CSR, doesn't mask irq
 
         sc_signal<bool> trap_irq;
         sc_signal<sc_uint<4>> trap_code;
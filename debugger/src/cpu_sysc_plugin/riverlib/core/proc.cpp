@@ -309,8 +309,16 @@ void Processor::comb() {
 void Processor::generateRef(bool v) {
     generate_ref_ = v;
     if (generate_ref_) {
-        reg_dbg = new ofstream("river_sysc_regs.log");
-        mem_dbg = new ofstream("river_sysc_mem.log");
+        reg_dbg = new BinTraceWriter;
+        if (!reg_dbg->open("river_sysc_regs.bin")) {
+            delete reg_dbg;
+            reg_dbg = 0;
+        }
+        mem_dbg = new BinTraceWriter;
+        if (!mem_dbg->open("river_sysc_mem.bin")) {
+            delete mem_dbg;
+            mem_dbg = 0;
+        }
         mem_dbg_write_flag = false;
     }
 }
@@ -319,43 +327,31 @@ void Processor::negedge_dbg_print() {
     if (!generate_ref_) {
         return;
     }
-    int sz;
-    if (w.m.valid.read()) {
+    if (reg_dbg && w.m.valid.read()) {
         uint64_t line_cnt = dbg.executed_cnt.read() + 1;
-        sz = RISCV_sprintf(tstr, sizeof(tstr), "%8" RV_PRI64 "d [%08x] %08x: ",
-            line_cnt,
-            w.m.pc.read().to_int(),
-            w.m.instr.read().to_int());
-        uint64_t prev_val = iregs0->r.mem[w.w.waddr.read().to_int()].to_int64();
+        uint64_t regs[32];
+        uint32_t mask = 0;
+        int waddr = w.w.waddr.read().to_int();
+        uint64_t prev_val = iregs0->r.mem[waddr].to_int64();
         uint64_t cur_val = w.w.wdata.read().to_int64();
-        if (w.w.waddr.read() == 0 || prev_val == cur_val) {
-            // not writing
-            sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz, "%s", "-\n");
-        } else {
-            sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz, 
-                   "%3s <= %016" RV_PRI64 "x\n", 
-                   IREGS_NAMES[w.w.waddr.read().to_int()], cur_val);
+        if (waddr != 0 && prev_val != cur_val) {
+            mask = 1u << waddr;
+            regs[waddr] = cur_val;
         }
-
-        (*reg_dbg) << tstr;
-        reg_dbg->flush();
+        reg_dbg->writeRegs(line_cnt, w.m.pc.read().to_uint(),
+                           w.m.instr.read().to_uint(), mask, regs);
     }
     // Memory access debug:
-    if (i_resp_data_valid.read()) {
-        sz = RISCV_sprintf(tstr, sizeof(tstr), "%08x: [%08x] ",
-                        w.m.pc.read().to_uint(),
-                        i_resp_data_addr.read().to_uint());
+    if (mem_dbg && i_resp_data_valid.read()) {
+        uint64_t val;
         if (mem_dbg_write_flag) {
-            sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz, 
-                "<= %016" RV_PRI64 "x\n", 
-                dbg_mem_write_value & dbg_mem_value_mask);
+            val = dbg_mem_write_value & dbg_mem_value_mask;
         } else {
-            sz += RISCV_sprintf(&tstr[sz], sizeof(tstr) - sz, 
-                "=> %016" RV_PRI64 "x\n", 
-                i_resp_data_data.read().to_uint64() & dbg_mem_value_mask);
+            val = i_resp_data_data.read().to_uint64() & dbg_mem_value_mask;
         }
-        (*mem_dbg) << tstr;
-        mem_dbg->flush();
+        mem_dbg->writeMem(w.m.pc.read().to_uint(),
+                          i_resp_data_addr.read().to_uint(),
+                          mem_dbg_write_flag, val);
     }
     if (w.e.memop_store.read() || w.e.memop_load.read()) {
         mem_dbg_write_flag = w.e.memop_store;
@@ -19,7 +19,7 @@
 #include "csr.h"
 #include "br_predic.h"
 #include "dbg_port.h"
-#include <fstream>
+#include "bintrace.h"
 
 
 namespace debugger {
@@ -208,9 +208,8 @@ private:
     /** Used only for reference trace generation to compare with
         functional model */
     bool generate_ref_;
-    char tstr[1024];
-    ofstream *reg_dbg;
-    ofstream *mem_dbg;
+    BinTraceWriter *reg_dbg;
+    BinTraceWriter *mem_dbg;
     bool mem_dbg_write_flag;
     uint64_t dbg_mem_value_mask;
     uint64_t dbg_mem_write_value;
@@ -19,6 +19,7 @@ namespace debugger {
 RtlWrapper::RtlWrapper(IFace *parent, sc_module_name name) : sc_module(name),
     o_clk("clk", 10, SC_NS) {
     iparent_ = parent;
+    bypass_ = 0;
     generate_ref_ = false;
     clockCycles_ = 1000000; // 1 MHz when default resolution = 1 ps
 
@@ -99,7 +100,6 @@ void RtlWrapper::clk_negedge_proc() {
     /** Simulation events queue */
     IFace *cb;
 
-    step_queue_.initProc();
     step_queue_.pushPreQueued();
     uint64_t step_cnt = i_time.read();
     while ((cb = step_queue_.getNext(step_cnt)) != 0) {
@@ -237,6 +237,12 @@ void RtlWrapper::registerStepCallback(IClockListener *cb, uint64_t t) {
     }
 }
 
+void RtlWrapper::takeStepQueue(AttributeType *list) {
+    step_queue_.pushPreQueued();
+    step_queue_.getItems(list);
+    step_queue_.clear();
+}
+
 void RtlWrapper::raiseSignal(int idx) {
     switch (idx) {
     case CPU_SIGNAL_RESET:
@@ -247,6 +253,9 @@ void RtlWrapper::raiseSignal(int idx) {
         break;
     default:;
     }
+    if (bypass_) {
+        bypass_->raiseSignal(idx);
+    }
 }
 
 void RtlWrapper::lowerSignal(int idx) {
@@ -259,10 +268,22 @@ void RtlWrapper::lowerSignal(int idx) {
         break;
     default:;
     }
+    if (bypass_) {
+        bypass_->lowerSignal(idx);
+    }
 }
 
 void RtlWrapper::nb_transport_debug_port(DebugPortTransactionType *trans,
                                          IDbgNbResponse *cb) {
+    if (bypass_) {
+        bypass_->nb_transport_debug_port(trans, cb);
+        return;
+    }
+    dportRequest(trans, cb);
+}
+
+void RtlWrapper::dportRequest(DebugPortTransactionType *trans,
+                              IDbgNbResponse *cb) {
     dport_.trans = trans;
     dport_.cb = cb;
     dport_.trans_idx_up++;
@@ -75,6 +75,15 @@ public:
     void generateRef(bool v) { generate_ref_ = v; }
     void generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd);
     void setBus(IBus *v) { ibus_ = v; }
+    /** Signals and debug port requests are passed to 'v' while it's set */
+    void setBypass(ICpuRiscV *v) { bypass_ = v; }
+    /** Debug port request to the RTL core ignoring the bypass */
+    void dportRequest(DebugPortTransactionType *trans, IDbgNbResponse *cb);
+    /**
+     * Pending step callbacks as [time, IFace] list, the queue is cleared.
+     * Must be called while SystemC kernel isn't running.
+     */
+    void takeStepQueue(AttributeType *list);
     /** Default time resolution 1 picosecond. */
     void setClockHz(double hz);
    
@@ -93,6 +102,7 @@ private:
 private:
     IBus *ibus_;
     IFace *iparent_;    // pointer on parent module object (used for logging)
+    ICpuRiscV *bypass_;
     int clockCycles_;   // default in [ps]
     AsyncTQueueType step_queue_;
     uint64_t step_cnt_z;
@@ -365,8 +365,6 @@ void DbgMainWindow::slotPostInit(AttributeType *cfg) {
 
         ebreak_->setBrAddressFetch(
             reinterpret_cast<uint64_t>(&dsu->udbg.v.br_address_fetch));
-        ebreak_->setHwRemoveBreakpoint(
-            reinterpret_cast<uint64_t>(&dsu->udbg.v.remove_breakpoint));
     }
 }
 
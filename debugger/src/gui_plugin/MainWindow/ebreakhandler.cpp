@@ -17,7 +17,6 @@ EBreakHandler::EBreakHandler(IGui *gui) {
     readBr_.make_string("br");
     readNpc_.make_string("reg npc");
     dsu_sw_br_ = ~0;
-    dsu_hw_br_ = ~0;
 }
 
 EBreakHandler::~EBreakHandler() {
@@ -41,7 +40,7 @@ void EBreakHandler::handleResponse(AttributeType *req,
     }
     uint64_t br_addr = resp->to_uint64();
     uint32_t br_instr = 0;
-    bool br_hw;
+    bool br_hw = false;
     for (unsigned i = 0; i < brList_.size(); i++) {
         const AttributeType &br = brList_[i];
         if (br_addr == br[BrkList_address].to_uint64()) {
@@ -50,18 +49,13 @@ void EBreakHandler::handleResponse(AttributeType *req,
             break;
         }
     }
-    if (br_instr == 0) {
+    // Hardware breakpoint is skipped by CPU itself on resume
+    if (br_instr == 0 || br_hw) {
         return;
     }
-    if (br_hw) {
-        RISCV_sprintf(tstr, sizeof(tstr),
-                "write 0x%08" RV_PRI64 "x 8 0x%" RV_PRI64 "x",
-                dsu_hw_br_, br_addr);
-    } else {
-        RISCV_sprintf(tstr, sizeof(tstr),
-                "write 0x%08" RV_PRI64 "x 16 [0x%" RV_PRI64 "x,0x%x]",
-                dsu_sw_br_, br_addr, br_instr);
-    }
+    RISCV_sprintf(tstr, sizeof(tstr),
+            "write 0x%08" RV_PRI64 "x 16 [0x%" RV_PRI64 "x,0x%x]",
+            dsu_sw_br_, br_addr, br_instr);
     memWrite.make_string(tstr);
     igui_->registerCommand(NULL, &memWrite, true);
 }
@@ -20,7 +20,6 @@ public:
     ~EBreakHandler();
 
     void setBrAddressFetch(uint64_t addr) { dsu_sw_br_ = addr; }
-    void setHwRemoveBreakpoint(uint64_t addr) { dsu_hw_br_ = addr; }
 
     /** IGuiCmdHandler */
     virtual void handleResponse(AttributeType *req, AttributeType *resp);
@@ -34,7 +33,6 @@ private:
     AttributeType brList_;
     IGui *igui_;
     uint64_t dsu_sw_br_;
-    uint64_t dsu_hw_br_;
 }; 
 
 }  // namespace debugger
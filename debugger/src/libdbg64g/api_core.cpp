@@ -236,8 +236,8 @@ extern "C" void RISCV_get_services_with_iface(const char *iname,
     for (unsigned i = 0; i < listClasses_.size(); i++) {
         icls = static_cast<IClass *>(listClasses_[i].to_iface());
         tlist = icls->getInstanceList();
-        if (tlist->size()) {
-            iserv = static_cast<IService *>((*tlist)[0u].to_iface());
+        for (unsigned n = 0; n < tlist->size(); n++) {
+            iserv = static_cast<IService *>((*tlist)[n].to_iface());
             iface = iserv->getInterface(iname);
             if (iface) {
                 AttributeType t1(iserv);
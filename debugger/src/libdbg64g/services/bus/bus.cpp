@@ -8,6 +8,7 @@
 #include "api_core.h"
 #include "bus.h"
 #include "coreservices/icpuriscv.h"
+#include "coreservices/ibuslistener.h"
 
 namespace debugger {
 
@@ -20,15 +21,27 @@ Bus::Bus(const char *name)
     registerAttribute("MapList", &listMap_);
 
     listMap_.make_list(0);
-    imap_.make_list(0);
-    RISCV_mutex_init(&mutexBAccess_);
-    RISCV_mutex_init(&mutexNBAccess_);
+    listeners_.make_list(0);
+    slavesTotal_ = 0;
+    memset(root_, 0, sizeof(root_));
+    memset(leaf_, 0, sizeof(leaf_));
+    iclk0_ = 0;
     memset(info_, 0, sizeof(info_));
+    utilExtTotal_ = 0;
+    for (int i = 0; i < SLAVES_MAX; i++) {
+        RISCV_mutex_init(&mutexSlave_[i]);
+    }
 }
 
 Bus::~Bus() {
-    RISCV_mutex_destroy(&mutexBAccess_);
-    RISCV_mutex_destroy(&mutexNBAccess_);
+    for (uint32_t i = 0; i < ROOT_TOTAL; i++) {
+        if (leaf_[i]) {
+            delete [] leaf_[i];
+        }
+    }
+    for (int i = 0; i < SLAVES_MAX; i++) {
+        RISCV_mutex_destroy(&mutexSlave_[i]);
+    }
 }
 
 void Bus::postinitService() {
@@ -53,28 +66,135 @@ void Bus::postinitService() {
 }
 
 void Bus::map(IMemoryOperation *imemop) {
-    AttributeType t1(imemop);
-    imap_.add_to_list(&t1);
+    uint64_t base = imemop->getBaseAddress();
+    uint64_t end = base + imemop->getLength();
+    if (imemop->getLength() == 0) {
+        return;
+    }
+    if (slavesTotal_ == SLAVES_MAX) {
+        RISCV_error("Too many slave devices", NULL);
+        return;
+    }
+    int pos = 0;
+    for (int i = 0; i < slavesTotal_; i++) {
+        if (base < slaves_[i].end && slaves_[i].base < end) {
+            RISCV_error("Slave [%08" RV_PRI64 "x..%08" RV_PRI64 "x] "
+                        "overlaps [%08" RV_PRI64 "x..%08" RV_PRI64 "x]",
+                        base, end - 1, slaves_[i].base, slaves_[i].end - 1);
+            return;
+        }
+        if (slaves_[i].base < base) {
+            pos = i + 1;
+        }
+    }
+    for (int i = slavesTotal_; i > pos; i--) {
+        slaves_[i] = slaves_[i - 1];
+    }
+    slaves_[pos].base = base;
+    slaves_[pos].end = end;
+    slaves_[pos].imem = imemop;
+    slaves_[pos].hits = 0;
+    slaves_[pos].mutex = &mutexSlave_[slavesTotal_];
+    slavesTotal_++;
+    buildDecoder();
 }
 
-ETransStatus Bus::b_transport(Axi4TransactionType *trans) {
-    IMemoryOperation *imem;
-    bool unmapped = true;
-    ETransStatus ret = TRANS_OK;
+int Bus::search(uint64_t addr) {
+    for (int i = 0; i < slavesTotal_; i++) {
+        if (addr < slaves_[i].base) {
+            break;
+        }
+        if (addr < slaves_[i].end) {
+            return i;
+        }
+    }
+    return -1;
+}
 
-    RISCV_mutex_lock(&mutexBAccess_);
+void Bus::setPage(uint64_t page, uint8_t v) {
+    uint32_t r = static_cast<uint32_t>(page >> (L2_BITS - PAGE_BITS));
+    uint8_t *leaf = leaf_[r];
+    if (leaf == NULL) {
+        leaf = new uint8_t[L2_MASK + 1];
+        memset(leaf, root_[r], L2_MASK + 1);
+        leaf_[r] = leaf;
+    }
+    uint8_t &e = leaf[page & L2_MASK];
+    e = e == 0 ? v : DECODE_SPLIT;
+}
 
-    for (unsigned i = 0; i < imap_.size(); i++) {
-        imem = static_cast<IMemoryOperation *>(imap_[i].to_iface());
-        if (imem->getBaseAddress() <= trans->addr
-            && trans->addr < (imem->getBaseAddress() + imem->getLength())) {
+/**
+ * Slave index is shifted by the order insertion, so the whole table is
+ * rebuilt. Whole 1 MB covered by one device doesn't need the leaf table,
+ * partially covered page is marked to be resolved by search().
+ */
+void Bus::buildDecoder() {
+    const uint64_t LIMIT = 1ull << 32;
+    const uint64_t PAGE = 1ull << PAGE_BITS;
+    const uint64_t L2_PAGES = L2_MASK + 1;
+    for (uint32_t i = 0; i < ROOT_TOTAL; i++) {
+        if (leaf_[i]) {
+            delete [] leaf_[i];
+            leaf_[i] = NULL;
+        }
+    }
+    memset(root_, 0, sizeof(root_));
 
-            imem->b_transport(trans);
-            unmapped = false;
-            break;
-            /// @todo Check memory overlapping
+    for (int i = 0; i < slavesTotal_; i++) {
+        uint64_t base = slaves_[i].base;
+        uint64_t end = slaves_[i].end < LIMIT ? slaves_[i].end : LIMIT;
+        uint8_t idx = static_cast<uint8_t>(i + 1);
+        uint64_t p = base >> PAGE_BITS;
+        while (base < end && p < ((end + PAGE - 1) >> PAGE_BITS)) {
+            uint32_t r = static_cast<uint32_t>(p >> (L2_BITS - PAGE_BITS));
+            if ((p & L2_MASK) == 0 && (p << PAGE_BITS) >= base
+                && ((p + L2_PAGES) << PAGE_BITS) <= end
+                && leaf_[r] == NULL && root_[r] == 0) {
+                root_[r] = idx;
+                p += L2_PAGES;
+                continue;
+            }
+            bool full = (p << PAGE_BITS) >= base
+                     && ((p + 1) << PAGE_BITS) <= end;
+            setPage(p, full ? idx : DECODE_SPLIT);
+            p++;
         }
     }
+}
+
+void Bus::registerBusListener(IFace *listener) {
+    AttributeType t1(listener);
+    listeners_.add_to_list(&t1);
+}
+
+void Bus::registerUtilCounters(BusUtilType *cnt) {
+    if (utilExtTotal_ == UTIL_EXT_MAX) {
+        RISCV_error("Too many utilization counters", NULL);
+        return;
+    }
+    utilExt_[utilExtTotal_++] = cnt;
+}
+
+void Bus::writeNotify(uint64_t addr, uint32_t size) {
+    IBusListener *ilstn;
+    for (unsigned i = 0; i < listeners_.size(); i++) {
+        ilstn = static_cast<IBusListener *>(listeners_[i].to_iface());
+        ilstn->writeNotify(addr, size);
+    }
+}
+
+ETransStatus Bus::b_transport(Axi4TransactionType *trans) {
+    bool unmapped = true;
+    ETransStatus ret = TRANS_OK;
+
+    int idx = decode(trans->addr);
+    if (idx >= 0) {
+        RISCV_atomic_add64(&slaves_[idx].hits, 1);
+        RISCV_mutex_lock(slaves_[idx].mutex);
+        slaves_[idx].imem->b_transport(trans);
+        RISCV_mutex_unlock(slaves_[idx].mutex);
+        unmapped = false;
+    }
 
     if (unmapped) {
         RISCV_error("[%" RV_PRI64 "d] Read from unmapped address "
@@ -87,33 +207,22 @@ ETransStatus Bus::b_transport(Axi4TransactionType *trans) {
             trans->rpayload.b32[1], trans->rpayload.b32[0]);
     }
 
-    // Update Bus utilization counters:
-    if (trans->action == MemAction_Read) {
-        info_[trans->source_idx].r_cnt++;
-    } else if (trans->action == MemAction_Write) {
-        info_[trans->source_idx].w_cnt++;
-    }
-    RISCV_mutex_unlock(&mutexBAccess_);
+    updateUtil(trans->action, trans->source_idx, trans->addr, trans->xsize, 1);
     return ret;
 }
 
 ETransStatus Bus::nb_transport(Axi4TransactionType *trans,
                                IAxi4NbResponse *cb) {
-    IMemoryOperation *imem;
     bool unmapped = true;
     ETransStatus ret = TRANS_OK;
 
-    RISCV_mutex_lock(&mutexNBAccess_);
-
-    for (unsigned i = 0; i < imap_.size(); i++) {
-        imem = static_cast<IMemoryOperation *>(imap_[i].to_iface());
-        if (imem->getBaseAddress() <= trans->addr
-            && trans->addr < (imem->getBaseAddress() + imem->getLength())) {
-
-            imem->nb_transport(trans, cb);
-            unmapped = false;
-            break;
-        }
+    int idx = decode(trans->addr);
+    if (idx >= 0) {
+        RISCV_atomic_add64(&slaves_[idx].hits, 1);
+        RISCV_mutex_lock(slaves_[idx].mutex);
+        slaves_[idx].imem->nb_transport(trans, cb);
+        RISCV_mutex_unlock(slaves_[idx].mutex);
+        unmapped = false;
     }
 
     if (unmapped) {
@@ -128,18 +237,143 @@ ETransStatus Bus::nb_transport(Axi4TransactionType *trans,
                     trans->addr);
     }
 
-    // Update Bus utilization counters:
-    if (trans->action == MemAction_Read) {
-        info_[trans->source_idx].r_cnt++;
-    } else if (trans->action == MemAction_Write) {
-        info_[trans->source_idx].w_cnt++;
+    updateUtil(trans->action, trans->source_idx, trans->addr, trans->xsize, 1);
+    return ret;
+}
+
+/**
+ * Part of the burst handled by one slave or the unmapped gap before the
+ * next slave.
+ */
+uint32_t Bus::burstPart(uint64_t addr, uint32_t len, int idx) {
+    uint64_t end = addr + len;
+    if (idx >= 0) {
+        if (slaves_[idx].end < end) {
+            end = slaves_[idx].end;
+        }
+        return static_cast<uint32_t>(end - addr);
+    }
+    for (int i = 0; i < slavesTotal_; i++) {
+        if (slaves_[i].base > addr) {
+            if (slaves_[i].base < end) {
+                end = slaves_[i].base;
+            }
+            break;
+        }
+    }
+    return static_cast<uint32_t>(end - addr);
+}
+
+/**
+ * Burst crossing slave boundary is split, each slave gets its part.
+ * Response is the error if any part has failed.
+ */
+ETransStatus Bus::b_transport_burst(Axi4BurstTransactionType *trans) {
+    ETransStatus ret = TRANS_OK;
+    Axi4BurstTransactionType part = *trans;
+    uint32_t off = 0;
+    trans->response = MemResp_Valid;
+    while (off < trans->len) {
+        part.addr = trans->addr + off;
+        part.payload = &trans->payload[off];
+        int idx = decode(part.addr);
+        part.len = burstPart(part.addr, trans->len - off, idx);
+        if (idx >= 0) {
+            RISCV_atomic_add64(&slaves_[idx].hits, 1);
+            RISCV_mutex_lock(slaves_[idx].mutex);
+            slaves_[idx].imem->b_transport_burst(&part);
+            RISCV_mutex_unlock(slaves_[idx].mutex);
+            if (part.response == MemResp_Error) {
+                trans->response = MemResp_Error;
+            }
+        } else {
+            RISCV_error("[%" RV_PRI64 "d] Burst to unmapped address "
+                        "%08" RV_PRI64 "x", iclk0_->getStepCounter(),
+                        part.addr);
+            if (trans->action == MemAction_Read) {
+                memset(part.payload, 0xFF, part.len);
+            }
+            trans->response = MemResp_Error;
+            ret = TRANS_ERROR;
+        }
+        off += part.len;
+    }
+    updateUtil(trans->action, trans->source_idx, trans->addr, trans->len,
+               trans->len / trans->xsize);
+    return ret;
+}
+
+ETransStatus Bus::nb_transport_burst(Axi4BurstTransactionType *trans,
+                                     IAxi4NbResponse *cb) {
+    int idx = decode(trans->addr);
+    if (idx < 0 || burstPart(trans->addr, trans->len, idx) != trans->len) {
+        // Parts of the several slaves and gaps are accessed one by one
+        ETransStatus ret = b_transport_burst(trans);
+        cb->nb_response_burst(trans);
+        return ret;
+    }
+    // Initiator may reuse transaction as soon as the response is received
+    EAxi4Action action = trans->action;
+    int source_idx = trans->source_idx;
+    uint64_t addr = trans->addr;
+    uint32_t len = trans->len;
+    int64_t beats = trans->len / trans->xsize;
+    RISCV_atomic_add64(&slaves_[idx].hits, 1);
+    RISCV_mutex_lock(slaves_[idx].mutex);
+    slaves_[idx].imem->nb_transport_burst(trans, cb);
+    RISCV_mutex_unlock(slaves_[idx].mutex);
+    updateUtil(action, source_idx, addr, len, beats);
+    return TRANS_OK;
+}
+
+bool Bus::get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi) {
+    bool ret = false;
+
+    int idx = decode(addr);
+    if (idx >= 0) {
+        ret = slaves_[idx].imem->get_direct_mem_ptr(addr, dmi);
     }
-    RISCV_mutex_unlock(&mutexNBAccess_);
     return ret;
 }
 
-BusUtilType *Bus::bus_utilization() {
-    return info_;
+void Bus::invalidate_direct_mem_ptr(uint64_t addr, uint64_t size) {
+    IBusListener *ilstn;
+    for (unsigned i = 0; i < listeners_.size(); i++) {
+        ilstn = static_cast<IBusListener *>(listeners_[i].to_iface());
+        ilstn->invalidateDmi(addr, size);
+    }
+}
+
+void Bus::updateUtil(EAxi4Action action, int source_idx, uint64_t addr,
+                     uint32_t len, int64_t beats) {
+    if (action == MemAction_Read) {
+        RISCV_atomic_add64(&info_[source_idx].r_cnt, beats);
+    } else if (action == MemAction_Write) {
+        RISCV_atomic_add64(&info_[source_idx].w_cnt, beats);
+        writeNotify(addr, len);
+    }
+}
+
+void Bus::bus_utilization(BusUtilType *util) {
+    for (int i = 0; i < CFG_NASTI_MASTER_TOTAL; i++) {
+        util[i].w_cnt = static_cast<uint64_t>(info_[i].w_cnt);
+        util[i].r_cnt = static_cast<uint64_t>(info_[i].r_cnt);
+        for (int n = 0; n < utilExtTotal_; n++) {
+            util[i].w_cnt += utilExt_[n][i].w_cnt;
+            util[i].r_cnt += utilExt_[n][i].r_cnt;
+        }
+    }
+}
+
+void Bus::slave_hits(AttributeType *list) {
+    list->make_list(slavesTotal_);
+    for (int i = 0; i < slavesTotal_; i++) {
+        AttributeType &item = (*list)[i];
+        item.make_list(3);
+        item[0u].make_uint64(slaves_[i].base);
+        item[1].make_uint64(slaves_[i].end - slaves_[i].base);
+        item[2].make_uint64(static_cast<uint64_t>(slaves_[i].hits));
+    }
 }
 
 }  // namespace debugger
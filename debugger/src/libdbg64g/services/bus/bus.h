@@ -3,6 +3,16 @@
  * @copyright  Copyright 2016 GNSS Sensor Ltd. All right reserved.
  * @author     Sergey Khabarov - sergeykhbr@gmail.com
  * @brief      System Bus class declaration (AMBA or whatever).
+ *
+ * @details    Slave device is selected via two-levels page table built
+ *             when the device is mapped. Page shared by several devices
+ *             or address above 4 GB falls back to the search in the sorted
+ *             list of slaves.
+ *             Map and listeners are changed only before the simulation
+ *             starts, so there is no global bus lock: counters are updated
+ *             atomically and each slave device has its own lock, so
+ *             masters accessing different devices don't wait each other.
+ *             Memory accessed via DMI pointers doesn't use the bus at all.
  */
 
 #ifndef __DEBUGGER_BUS_H__
@@ -27,21 +37,81 @@ public:
 
     /** IBus interface */
     virtual void map(IMemoryOperation *imemop);
+    virtual void registerBusListener(IFace *listener);
+    virtual void registerUtilCounters(BusUtilType *cnt);
     virtual ETransStatus b_transport(Axi4TransactionType *trans);
     virtual ETransStatus nb_transport(Axi4TransactionType *trans,
                                       IAxi4NbResponse *cb);
-    virtual BusUtilType *bus_utilization();
+    virtual ETransStatus b_transport_burst(Axi4BurstTransactionType *trans);
+    virtual ETransStatus nb_transport_burst(Axi4BurstTransactionType *trans,
+                                            IAxi4NbResponse *cb);
+    virtual bool get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi);
+    virtual void invalidate_direct_mem_ptr(uint64_t addr, uint64_t size);
+    virtual void bus_utilization(BusUtilType *util);
+    virtual void slave_hits(AttributeType *list);
 
 private:
+    void writeNotify(uint64_t addr, uint32_t size);
+    void updateUtil(EAxi4Action action, int source_idx, uint64_t addr,
+                    uint32_t len, int64_t beats);
+    /** Bytes of the burst part starting at addr, idx is decode(addr) */
+    uint32_t burstPart(uint64_t addr, uint32_t len, int idx);
+
+    /** Index of the slave device mapped on address or -1 */
+    int decode(uint64_t addr) {
+        if ((addr >> 32) == 0) {
+            uint32_t r = static_cast<uint32_t>(addr >> L2_BITS);
+            uint8_t *leaf = leaf_[r];
+            uint8_t e = leaf ? leaf[(addr >> PAGE_BITS) & L2_MASK] : root_[r];
+            if (e != DECODE_SPLIT) {
+                return static_cast<int>(e) - 1;
+            }
+        }
+        return search(addr);
+    }
+    int search(uint64_t addr);
+    void buildDecoder();
+    void setPage(uint64_t page, uint8_t v);
+
+private:
+    static const int PAGE_BITS = 12;
+    static const int L2_BITS = 20;          // 1 MB per root entry
+    static const uint32_t L2_MASK = (1u << (L2_BITS - PAGE_BITS)) - 1;
+    static const uint32_t ROOT_TOTAL = 1u << (32 - L2_BITS);
+    static const int SLAVES_MAX = 128;
+    static const uint8_t DECODE_SPLIT = 0xFF;
+    static const int UTIL_EXT_MAX = 64;
+    static const int CACHE_LINE = 64;
+
+    struct SlaveMapType {
+        uint64_t base;
+        uint64_t end;                       // last address + 1
+        IMemoryOperation *imem;
+        volatile int64_t hits;
+        mutex_def *mutex;                   // entry is moved on insertion
+    };
+
+    /** Masters don't share cache line with the counters of other master */
+    struct BusUtilCntType {
+        volatile int64_t w_cnt;
+        volatile int64_t r_cnt;
+        uint8_t rsrv[CACHE_LINE - 2 * sizeof(int64_t)];
+    };
+
     AttributeType listMap_;
-    AttributeType imap_;
+    SlaveMapType slaves_[SLAVES_MAX];       // sorted by base address
+    int slavesTotal_;
+    mutex_def mutexSlave_[SLAVES_MAX];      // device model isn't reentrant
+    uint8_t root_[ROOT_TOTAL];              // slave index + 1, 0 unmapped
+    uint8_t *leaf_[ROOT_TOTAL];             // per page entries
+    AttributeType listeners_;
     // Clock interface is used just to tag debug output with some step value,
     // in a case of several clocks the first found will be used.
     IClock *iclk0_;
-    mutex_def mutexBAccess_;
-    mutex_def mutexNBAccess_;
 
-    BusUtilType info_[CFG_NASTI_MASTER_TOTAL];
+    BusUtilCntType info_[CFG_NASTI_MASTER_TOTAL];
+    BusUtilType *utilExt_[UTIL_EXT_MAX];
+    int utilExtTotal_;
 };
 
 DECLARE_CLASS(Bus)
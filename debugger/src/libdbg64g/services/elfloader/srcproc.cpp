@@ -15,9 +15,12 @@ namespace debugger {
 REGISTER_CLASS(SourceService)
 
 const char *const *RN = IREGS_NAMES;
+const char *const *FN = FREGS_NAME;
 
 int opcode_0x00(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
+int opcode_0x01(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x03(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x04(IElfReader *ielf, uint64_t pc, uint32_t code,
@@ -28,12 +31,20 @@ int opcode_0x06(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x08(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
+int opcode_0x09(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment);
+int opcode_0x0B(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x0C(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x0D(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x0E(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
+int opcode_0x10(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment);
+int opcode_0x14(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x18(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x19(IElfReader *ielf, uint64_t pc, uint32_t code,
@@ -42,20 +53,30 @@ int opcode_0x1B(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
 int opcode_0x1C(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment);
+int opcode_rvc(IElfReader *ielf, uint64_t pc, uint32_t code,
+               AttributeType *mnemonic, AttributeType *comment);
 
 
 SourceService::SourceService(const char *name) : IService(name) {
     registerInterface(static_cast<ISourceCode *>(this));
     memset(tblOpcode1_, 0, sizeof(tblOpcode1_));
     tblOpcode1_[0x00] = &opcode_0x00;
+    tblOpcode1_[0x01] = &opcode_0x01;
     tblOpcode1_[0x03] = &opcode_0x03;
     tblOpcode1_[0x04] = &opcode_0x04;
     tblOpcode1_[0x05] = &opcode_0x05;
     tblOpcode1_[0x06] = &opcode_0x06;
     tblOpcode1_[0x08] = &opcode_0x08;
+    tblOpcode1_[0x09] = &opcode_0x09;
+    tblOpcode1_[0x0B] = &opcode_0x0B;
     tblOpcode1_[0x0C] = &opcode_0x0C;
     tblOpcode1_[0x0D] = &opcode_0x0D;
     tblOpcode1_[0x0E] = &opcode_0x0E;
+    tblOpcode1_[0x10] = &opcode_0x10;
+    tblOpcode1_[0x11] = &opcode_0x10;
+    tblOpcode1_[0x12] = &opcode_0x10;
+    tblOpcode1_[0x13] = &opcode_0x10;
+    tblOpcode1_[0x14] = &opcode_0x14;
     tblOpcode1_[0x18] = &opcode_0x18;
     tblOpcode1_[0x19] = &opcode_0x19;
     tblOpcode1_[0x1B] = &opcode_0x1B;
@@ -128,9 +149,9 @@ int SourceService::disasm(uint64_t pc,
                        AttributeType *mnemonic,
                        AttributeType *comment) {
     if ((data[offset] & 0x3) != 0x3) {
-        mnemonic->make_string("err");
-        comment->make_string("");
-        return 4;
+        uint32_t parcel = *reinterpret_cast<uint16_t*>(&data[offset]);
+        return opcode_rvc(ielf_, pc + static_cast<uint64_t>(offset),
+                          parcel, mnemonic, comment);
     }
     uint32_t val = *reinterpret_cast<uint32_t*>(&data[offset]);
     uint32_t opcode1 = (val >> 2) & 0x1f;
@@ -175,7 +196,14 @@ void SourceService::disasm(uint64_t pc,
     int codesz;
 
     while (static_cast<unsigned>(off) < idata->size()) {
-        val = *reinterpret_cast<uint32_t*>(&data[off]);
+        if (idata->size() - static_cast<unsigned>(off) >= 4) {
+            val = *reinterpret_cast<uint32_t*>(&data[off]);
+        } else {
+            val = *reinterpret_cast<uint16_t*>(&data[off]);
+        }
+        if ((val & 0x3) != 0x3) {
+            val &= 0xffff;      // compressed instruction
+        }
         opcode1 = (val >> 2) & 0x1f;
 
         if (ielf_) {
@@ -190,24 +218,7 @@ void SourceService::disasm(uint64_t pc,
         asm_item[ASM_code].make_uint64(val);
         asm_item[ASM_breakpoint].make_boolean(false);
         asm_item[ASM_label].make_string("");
-        if ((val & 0x3) != 0x3) {
-            asm_item[ASM_mnemonic].make_string("err");
-            asm_item[ASM_comment].make_string("");
-            asm_item[ASM_codesize].make_uint64(4);
-            asmlist->add_to_list(&asm_item);
-            off += 4;
-            continue;
-        }
-        if (!tblOpcode1_[opcode1]) {
-            asm_item[ASM_mnemonic].make_string("unimpl");
-            asm_item[ASM_comment].make_string("");
-            asm_item[ASM_codesize].make_uint64(4);
-            asmlist->add_to_list(&asm_item);
-            off += 4;
-            continue;
-        }
-
-        if (val == 0x00100073) {
+        if (val == 0x00100073 || val == 0x9002) {   // EBREAK, C.EBREAK
             asm_item[ASM_breakpoint].make_boolean(true);
             for (unsigned i = 0; i < brList_.size(); i++) {
                 const AttributeType &br = brList_[i];
@@ -220,11 +231,26 @@ void SourceService::disasm(uint64_t pc,
             }
             
         }
-        codesz = tblOpcode1_[opcode1](ielf_,
-                                      pc + off,
-                                      val,
-                                      &asm_item[ASM_mnemonic],
-                                      &asm_item[ASM_comment]);
+        if ((val & 0x3) != 0x3) {
+            codesz = opcode_rvc(ielf_,
+                                pc + off,
+                                val,
+                                &asm_item[ASM_mnemonic],
+                                &asm_item[ASM_comment]);
+        } else if (!tblOpcode1_[opcode1]) {
+            asm_item[ASM_mnemonic].make_string("unimpl");
+            asm_item[ASM_comment].make_string("");
+            asm_item[ASM_codesize].make_uint64(4);
+            asmlist->add_to_list(&asm_item);
+            off += 4;
+            continue;
+        } else {
+            codesz = tblOpcode1_[opcode1](ielf_,
+                                          pc + off,
+                                          val,
+                                          &asm_item[ASM_mnemonic],
+                                          &asm_item[ASM_comment]);
+        }
         asm_item[ASM_codesize].make_uint64(codesz);
         asmlist->add_to_list(&asm_item);
         off += codesz;
@@ -276,6 +302,32 @@ int opcode_0x00(IElfReader *ielf, uint64_t pc, uint32_t code,
     return 4;
 }
 
+/** FLW, FLD */
+int opcode_0x01(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment) {
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    ISA_I_type i;
+    int32_t imm;
+
+    i.value = code;
+    imm = static_cast<int32_t>(code) >> 20;
+    switch (i.bits.funct3) {
+    case 2:
+        RISCV_sprintf(tstr, sizeof(tstr), "flw     %s,%d(%s)",
+            FN[i.bits.rd], imm, RN[i.bits.rs1]);
+        break;
+    case 3:
+        RISCV_sprintf(tstr, sizeof(tstr), "fld     %s,%d(%s)",
+            FN[i.bits.rd], imm, RN[i.bits.rs1]);
+        break;
+    default:;
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 4;
+}
+
 int opcode_0x03(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment) {
     char tstr[128] = "unimpl";
@@ -448,6 +500,63 @@ int opcode_0x08(IElfReader *ielf, uint64_t pc, uint32_t code,
 }
 
 
+/** FSW, FSD */
+int opcode_0x09(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment) {
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    ISA_S_type s;
+    int32_t imm;
+
+    s.value = code;
+    imm = (static_cast<int32_t>(code) >> 25) << 5;
+    imm |= s.bits.imm4_0;
+    switch (s.bits.funct3) {
+    case 2:
+        RISCV_sprintf(tstr, sizeof(tstr), "fsw     %s,%d(%s)",
+            FN[s.bits.rs2], imm, RN[s.bits.rs1]);
+        break;
+    case 3:
+        RISCV_sprintf(tstr, sizeof(tstr), "fsd     %s,%d(%s)",
+            FN[s.bits.rs2], imm, RN[s.bits.rs1]);
+        break;
+    default:;
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 4;
+}
+
+int opcode_0x0B(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment) {
+    static const char *AMO_NAMES[32] = {
+        "amoadd", "amoswap", "lr", "sc", "amoxor", 0, 0, 0,
+        "amoor", 0, 0, 0, "amoand", 0, 0, 0,
+        "amomin", 0, 0, 0, "amomax", 0, 0, 0,
+        "amominu", 0, 0, 0, "amomaxu", 0, 0, 0
+    };
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    char name[16];
+    ISA_R_type r;
+    r.value = code;
+    const char *op = AMO_NAMES[r.bits.funct7 >> 2];
+    if (op && (r.bits.funct3 == 2 || r.bits.funct3 == 3)) {
+        RISCV_sprintf(name, sizeof(name), "%s.%c", op,
+                      r.bits.funct3 == 2 ? 'w' : 'd');
+        if ((r.bits.funct7 >> 2) == 0x2) {
+            RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,(%s)",
+                name, RN[r.bits.rd], RN[r.bits.rs1]);
+        } else {
+            RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,%s,(%s)",
+                name, RN[r.bits.rd], RN[r.bits.rs2], RN[r.bits.rs1]);
+        }
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 4;
+}
+
 int opcode_0x0C(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment) {
     char tstr[128] = "unimpl";
@@ -599,6 +708,124 @@ int opcode_0x0E(IElfReader *ielf, uint64_t pc, uint32_t code,
     return 4;
 }
 
+/** FMADD, FMSUB, FNMSUB, FNMADD (opcodes 0x10..0x13) */
+int opcode_0x10(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment) {
+    static const char *FMA_NAMES[4] = {"fmadd", "fmsub", "fnmsub", "fnmadd"};
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    char name[16];
+    ISA_R_type r;
+    r.value = code;
+    uint32_t fmt = r.bits.funct7 & 0x3;
+    if (fmt < 2) {
+        RISCV_sprintf(name, sizeof(name), "%s.%c",
+            FMA_NAMES[(code >> 2) & 0x3], fmt ? 'd' : 's');
+        RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,%s,%s,%s", name,
+            FN[r.bits.rd], FN[r.bits.rs1], FN[r.bits.rs2],
+            FN[r.bits.funct7 >> 2]);
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 4;
+}
+
+/** Floating-point computational instructions */
+int opcode_0x14(IElfReader *ielf, uint64_t pc, uint32_t code,
+                AttributeType *mnemonic, AttributeType *comment) {
+    static const char *ARITH_NAMES[4] = {"fadd", "fsub", "fmul", "fdiv"};
+    static const char *SGNJ_NAMES[3] = {"fsgnj", "fsgnjn", "fsgnjx"};
+    static const char *CMP_NAMES[3] = {"fle", "flt", "feq"};
+    static const char *INT_NAMES[4] = {"w", "wu", "l", "lu"};
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    char name[16] = "";
+    ISA_R_type r;
+    r.value = code;
+    char fmt = (r.bits.funct7 & 0x1) ? 'd' : 's';
+    const char *rd = FN[r.bits.rd];
+    const char *rs1 = FN[r.bits.rs1];
+    const char *rs2 = FN[r.bits.rs2];
+
+    switch ((r.bits.funct7 & 0x2) ? ~0u : (r.bits.funct7 >> 2)) {
+    case 0x00:
+    case 0x01:
+    case 0x02:
+    case 0x03:
+        RISCV_sprintf(name, sizeof(name), "%s.%c",
+            ARITH_NAMES[r.bits.funct7 >> 2], fmt);
+        break;
+    case 0x04:
+        if (r.bits.funct3 < 3) {
+            RISCV_sprintf(name, sizeof(name), "%s.%c",
+                SGNJ_NAMES[r.bits.funct3], fmt);
+        }
+        break;
+    case 0x05:
+        if (r.bits.funct3 < 2) {
+            RISCV_sprintf(name, sizeof(name), "%s.%c",
+                r.bits.funct3 ? "fmax" : "fmin", fmt);
+        }
+        break;
+    case 0x08:
+        RISCV_sprintf(name, sizeof(name), "fcvt.%c.%c",
+            fmt, fmt == 'd' ? 's' : 'd');
+        rs2 = 0;
+        break;
+    case 0x0B:
+        RISCV_sprintf(name, sizeof(name), "fsqrt.%c", fmt);
+        rs2 = 0;
+        break;
+    case 0x14:
+        if (r.bits.funct3 < 3) {
+            RISCV_sprintf(name, sizeof(name), "%s.%c",
+                CMP_NAMES[r.bits.funct3], fmt);
+            rd = RN[r.bits.rd];
+        }
+        break;
+    case 0x18:
+        if (r.bits.rs2 < 4) {
+            RISCV_sprintf(name, sizeof(name), "fcvt.%s.%c",
+                INT_NAMES[r.bits.rs2], fmt);
+            rd = RN[r.bits.rd];
+            rs2 = 0;
+        }
+        break;
+    case 0x1A:
+        if (r.bits.rs2 < 4) {
+            RISCV_sprintf(name, sizeof(name), "fcvt.%c.%s",
+                fmt, INT_NAMES[r.bits.rs2]);
+            rs1 = RN[r.bits.rs1];
+            rs2 = 0;
+        }
+        break;
+    case 0x1C:
+        if (r.bits.funct3 == 0) {
+            RISCV_sprintf(name, sizeof(name), "fmv.x.%c", fmt);
+        } else if (r.bits.funct3 == 1) {
+            RISCV_sprintf(name, sizeof(name), "fclass.%c", fmt);
+        }
+        rd = RN[r.bits.rd];
+        rs2 = 0;
+        break;
+    case 0x1E:
+        RISCV_sprintf(name, sizeof(name), "fmv.%c.x", fmt);
+        rs1 = RN[r.bits.rs1];
+        rs2 = 0;
+        break;
+    default:;
+    }
+    if (name[0] && rs2) {
+        RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,%s,%s",
+            name, rd, rs1, rs2);
+    } else if (name[0]) {
+        RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,%s", name, rd, rs1);
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 4;
+}
+
 int opcode_0x18(IElfReader *ielf, uint64_t pc, uint32_t code,
                 AttributeType *mnemonic, AttributeType *comment) {
     char tstr[128] = "unimpl";
@@ -782,6 +1009,11 @@ int opcode_0x1C(IElfReader *ielf, uint64_t pc, uint32_t code,
             RISCV_sprintf(tstr, sizeof(tstr), "%s", "hret");
         } else if (code == 0x30200073) {
             RISCV_sprintf(tstr, sizeof(tstr), "%s", "mret");
+        } else if (code == 0x10500073) {
+            RISCV_sprintf(tstr, sizeof(tstr), "%s", "wfi");
+        } else if ((code >> 25) == 0x09 && i.bits.rd == 0) {
+            RISCV_sprintf(tstr, sizeof(tstr), "sfence.vma %s,%s",
+                RN[i.bits.rs1], RN[(code >> 20) & 0x1f]);
         }
         break;
     case 1:
@@ -851,4 +1083,213 @@ int opcode_0x1C(IElfReader *ielf, uint64_t pc, uint32_t code,
     return 4;
 }
 
+static inline uint32_t cfield(uint32_t v, int hi, int lo) {
+    return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+static inline int32_t csext(uint32_t v, int width) {
+    return static_cast<int32_t>(v << (32 - width)) >> (32 - width);
+}
+
+/** Compressed instructions (extension C), RV64 encoding */
+int opcode_rvc(IElfReader *ielf, uint64_t pc, uint32_t code,
+               AttributeType *mnemonic, AttributeType *comment) {
+    char tstr[128] = "unimpl";
+    char tcomm[128] = "";
+    uint32_t rd = cfield(code, 11, 7);
+    uint32_t rs2 = cfield(code, 6, 2);
+    uint32_t rdp = cfield(code, 4, 2) + 8;
+    uint32_t rs1p = cfield(code, 9, 7) + 8;
+    int32_t imm6 = csext((cfield(code, 12, 12) << 5) | cfield(code, 6, 2), 6);
+    uint32_t shamt = (cfield(code, 12, 12) << 5) | cfield(code, 6, 2);
+    uint32_t uimm_w = (cfield(code, 12, 10) << 3) | (cfield(code, 6, 6) << 2)
+                    | (cfield(code, 5, 5) << 6);
+    uint32_t uimm_d = (cfield(code, 12, 10) << 3) | (cfield(code, 6, 5) << 6);
+    uint64_t target = 0;
+    bool branch = false;
+    int32_t imm;
+
+    switch (((code & 0x3) << 3) | cfield(code, 15, 13)) {
+    case 0x00:
+        imm = (cfield(code, 12, 11) << 4) | (cfield(code, 10, 7) << 6)
+            | (cfield(code, 6, 6) << 2) | (cfield(code, 5, 5) << 3);
+        if (imm) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.addi4spn %s,sp,%d",
+                RN[rdp], imm);
+        }
+        break;
+    case 0x01:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.fld   %s,%d(%s)",
+            FN[rdp], uimm_d, RN[rs1p]);
+        break;
+    case 0x02:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.lw    %s,%d(%s)",
+            RN[rdp], uimm_w, RN[rs1p]);
+        break;
+    case 0x03:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.ld    %s,%d(%s)",
+            RN[rdp], uimm_d, RN[rs1p]);
+        break;
+    case 0x05:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.fsd   %s,%d(%s)",
+            FN[rdp], uimm_d, RN[rs1p]);
+        break;
+    case 0x06:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.sw    %s,%d(%s)",
+            RN[rdp], uimm_w, RN[rs1p]);
+        break;
+    case 0x07:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.sd    %s,%d(%s)",
+            RN[rdp], uimm_d, RN[rs1p]);
+        break;
+    case 0x08:
+        if (rd == 0) {
+            RISCV_sprintf(tstr, sizeof(tstr), "%s", "c.nop");
+        } else {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.addi  %s,%d",
+                RN[rd], imm6);
+        }
+        break;
+    case 0x09:
+        if (rd) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.addiw %s,%d",
+                RN[rd], imm6);
+        }
+        break;
+    case 0x0A:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.li    %s,%d", RN[rd], imm6);
+        break;
+    case 0x0B:
+        if (rd == Reg_sp) {
+            imm = csext((cfield(code, 12, 12) << 9)
+                      | (cfield(code, 6, 6) << 4) | (cfield(code, 5, 5) << 6)
+                      | (cfield(code, 4, 3) << 7)
+                      | (cfield(code, 2, 2) << 5), 10);
+            if (imm) {
+                RISCV_sprintf(tstr, sizeof(tstr), "c.addi16sp sp,%d", imm);
+            }
+        } else if (imm6) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.lui   %s,0x%x",
+                RN[rd], static_cast<uint32_t>(imm6) & 0xfffff);
+        }
+        break;
+    case 0x0C:
+        switch (cfield(code, 11, 10)) {
+        case 0:
+            RISCV_sprintf(tstr, sizeof(tstr), "c.srli  %s,%d",
+                RN[rs1p], shamt);
+            break;
+        case 1:
+            RISCV_sprintf(tstr, sizeof(tstr), "c.srai  %s,%d",
+                RN[rs1p], shamt);
+            break;
+        case 2:
+            RISCV_sprintf(tstr, sizeof(tstr), "c.andi  %s,%d",
+                RN[rs1p], imm6);
+            break;
+        default:
+            if (cfield(code, 12, 12) == 0 || cfield(code, 6, 6) == 0) {
+                static const char *ALU_NAMES[2][4] = {
+                    {"c.sub", "c.xor", "c.or", "c.and"},
+                    {"c.subw", "c.addw", "", ""}
+                };
+                RISCV_sprintf(tstr, sizeof(tstr), "%-7s %s,%s",
+                    ALU_NAMES[cfield(code, 12, 12)][cfield(code, 6, 5)],
+                    RN[rs1p], RN[rdp]);
+            }
+        }
+        break;
+    case 0x0D:
+        imm = csext((cfield(code, 12, 12) << 11) | (cfield(code, 11, 11) << 4)
+                  | (cfield(code, 10, 9) << 8) | (cfield(code, 8, 8) << 10)
+                  | (cfield(code, 7, 7) << 6) | (cfield(code, 6, 6) << 7)
+                  | (cfield(code, 5, 3) << 1) | (cfield(code, 2, 2) << 5), 12);
+        target = pc + static_cast<int64_t>(imm);
+        branch = true;
+        RISCV_sprintf(tstr, sizeof(tstr), "c.j     %08" RV_PRI64 "x", target);
+        break;
+    case 0x0E:
+    case 0x0F:
+        imm = csext((cfield(code, 12, 12) << 8) | (cfield(code, 11, 10) << 3)
+                  | (cfield(code, 6, 5) << 6) | (cfield(code, 4, 3) << 1)
+                  | (cfield(code, 2, 2) << 5), 9);
+        target = pc + static_cast<int64_t>(imm);
+        branch = true;
+        RISCV_sprintf(tstr, sizeof(tstr), "%s  %s,%08" RV_PRI64 "x",
+            cfield(code, 13, 13) ? "c.bnez" : "c.beqz", RN[rs1p], target);
+        break;
+    case 0x10:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.slli  %s,%d", RN[rd], shamt);
+        break;
+    case 0x11:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.fldsp %s,%d(sp)", FN[rd],
+            (cfield(code, 12, 12) << 5) | (cfield(code, 6, 5) << 3)
+            | (cfield(code, 4, 2) << 6));
+        break;
+    case 0x12:
+        if (rd) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.lwsp  %s,%d(sp)", RN[rd],
+                (cfield(code, 12, 12) << 5) | (cfield(code, 6, 4) << 2)
+                | (cfield(code, 3, 2) << 6));
+        }
+        break;
+    case 0x13:
+        if (rd) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.ldsp  %s,%d(sp)", RN[rd],
+                (cfield(code, 12, 12) << 5) | (cfield(code, 6, 5) << 3)
+                | (cfield(code, 4, 2) << 6));
+        }
+        break;
+    case 0x14:
+        if (cfield(code, 12, 12) == 0) {
+            if (rs2 == 0 && rd == Reg_ra) {
+                RISCV_sprintf(tstr, sizeof(tstr), "%s", "c.ret");
+            } else if (rs2 == 0 && rd) {
+                RISCV_sprintf(tstr, sizeof(tstr), "c.jr    %s", RN[rd]);
+            } else if (rs2) {
+                RISCV_sprintf(tstr, sizeof(tstr), "c.mv    %s,%s",
+                    RN[rd], RN[rs2]);
+            }
+        } else if (rs2 == 0 && rd == 0) {
+            RISCV_sprintf(tstr, sizeof(tstr), "%s", "c.ebreak");
+        } else if (rs2 == 0) {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.jalr  %s", RN[rd]);
+        } else {
+            RISCV_sprintf(tstr, sizeof(tstr), "c.add   %s,%s",
+                RN[rd], RN[rs2]);
+        }
+        break;
+    case 0x15:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.fsdsp %s,%d(sp)", FN[rs2],
+            (cfield(code, 12, 10) << 3) | (cfield(code, 9, 7) << 6));
+        break;
+    case 0x16:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.swsp  %s,%d(sp)", RN[rs2],
+            (cfield(code, 12, 9) << 2) | (cfield(code, 8, 7) << 6));
+        break;
+    case 0x17:
+        RISCV_sprintf(tstr, sizeof(tstr), "c.sdsp  %s,%d(sp)", RN[rs2],
+            (cfield(code, 12, 10) << 3) | (cfield(code, 9, 7) << 6));
+        break;
+    default:;
+    }
+
+    if (branch && ielf) {
+        AttributeType info;
+        ielf->addressToSymbol(target, &info);
+        if (info[0u].size()) {
+            if (info[1].to_uint32() == 0) {
+                RISCV_sprintf(tcomm, sizeof(tcomm), "%s",
+                        info[0u].to_string());
+            } else {
+                RISCV_sprintf(tcomm, sizeof(tcomm), "%s+%xh",
+                        info[0u].to_string(), info[1].to_uint32());
+            }
+        }
+    }
+    mnemonic->make_string(tstr);
+    comment->make_string(tcomm);
+    return 2;
+}
+
 }  // namespace debugger
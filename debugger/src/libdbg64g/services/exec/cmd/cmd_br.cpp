@@ -28,6 +28,9 @@ CmdBr::CmdBr(ITap *tap, ISocInfo *info)
         "    br add <addr>\n"
         "    br rm <addr>\n"
         "    br add <addr> hw\n"
+        "    'hw' breakpoint is checked by CPU on instruction fetch without\n"
+        "    memory modification. EBREAK is used instead if CPU doesn't\n"
+        "    support it or has no free hardware breakpoints.\n"
         "Example:\n"
         "    br add 0x10000000\n"
         "    br add 0x00020040 hw\n"
@@ -69,19 +72,50 @@ void CmdBr::exec(AttributeType *args, AttributeType *res) {
     }
 
     Reg64Type instr;
+    Reg64Type t1;
     uint64_t addr = (*args)[2].to_uint64();
-    tap_->read(addr, 4, instr.buf);
-    isrc_->registerBreakpoint(addr, instr.buf32[0], flags);
-
-    instr.buf32[0] = 0x00100073;   // EBREAK instruction
+    DsuMapType *dsu = info_->getpDsu();
 
     if ((*args)[1].is_equal("add")) {
-        tap_->write(addr, 4, instr.buf);
+        if (flags & BreakFlag_HW) {
+            tap_->read(reinterpret_cast<uint64_t>(
+                        &dsu->udbg.v.add_breakpoint), 8, t1.buf);
+            if (t1.val == 0) {
+                flags &= ~BreakFlag_HW;
+            }
+        }
+        tap_->read(addr, 4, instr.buf);
+        if ((instr.buf32[0] & 0x3) != 0x3) {
+            instr.buf32[0] &= 0xffff;
+        }
+        isrc_->registerBreakpoint(addr, instr.buf32[0], flags);
+        if (flags & BreakFlag_HW) {
+            // CPU checks address on fetch, memory stays untouched
+            t1.val = addr;
+            tap_->write(reinterpret_cast<uint64_t>(
+                        &dsu->udbg.v.add_breakpoint), 8, t1.buf);
+        } else if ((instr.buf32[0] & 0x3) != 0x3) {
+            // Compressed instruction is replaced by the 2-bytes C.EBREAK
+            instr.buf32[0] = 0x9002;
+            tap_->write(addr, 2, instr.buf);
+        } else {
+            instr.buf32[0] = 0x00100073;   // EBREAK instruction
+            tap_->write(addr, 4, instr.buf);
+        }
         return;
     } 
     
     if ((*args)[1].is_equal("rm")) {
-        if (!isrc_->unregisterBreakpoint(addr, instr.buf32, &flags)) {
+        if (isrc_->unregisterBreakpoint(addr, instr.buf32, &flags)) {
+            return;
+        }
+        if (flags & BreakFlag_HW) {
+            t1.val = addr;
+            tap_->write(reinterpret_cast<uint64_t>(
+                        &dsu->udbg.v.remove_breakpoint), 8, t1.buf);
+        } else if ((instr.buf32[0] & 0x3) != 0x3) {
+            tap_->write(addr, 2, instr.buf);
+        } else {
             tap_->write(addr, 4, instr.buf);
         }
     }
@@ -0,0 +1,260 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Execution profile command.
+ */
+
+#include "iservice.h"
+#include "cmd_prof.h"
+#include <stdio.h>
+
+namespace debugger {
+
+CmdProf::CmdProf(ITap *tap, ISocInfo *info) 
+    : ICommand ("prof", tap, info) {
+
+    briefDescr_.make_string("Profile execution of the functional model");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Count executed instructions and stall steps (WFI and skipped\n"
+        "    idle loops) per function and sample call stacks each\n"
+        "    'ProfilePeriod' steps. Functions are taken from the symbols\n"
+        "    of the loaded elf-file, otherwise address is shown.\n"
+        "    Folded stacks file is the input of the flame graph tools.\n"
+        "Output format:\n"
+        "    flat:      [[s,i,i,d],*]\n"
+        "         s - Function name.\n"
+        "         i - Executed instructions.\n"
+        "         i - Stall steps.\n"
+        "         d - Percent of all steps.\n"
+        "    callgraph: [[s,s,i],*]\n"
+        "         s - Caller name.\n"
+        "         s - Callee name.\n"
+        "         i - Number of the stack samples with this call.\n"
+        "Usage:\n"
+        "    prof start|stop|reset\n"
+        "    prof flat <N=20>\n"
+        "    prof callgraph <N=20>\n"
+        "    prof folded <filename>\n"
+        "Example:\n"
+        "    prof start\n"
+        "    prof\n"
+        "    prof callgraph 50\n"
+        "    prof folded app.folded\n");
+    elf_ = 0;
+}
+
+bool CmdProf::isValid(AttributeType *args) {
+    if (!(*args)[0u].is_equal("prof")) {
+        return CMD_INVALID;
+    }
+    if (args->size() == 1) {
+        return CMD_VALID;
+    }
+    AttributeType &sub = (*args)[1];
+    if (args->size() == 2
+        && (sub.is_equal("start") || sub.is_equal("stop")
+            || sub.is_equal("reset") || sub.is_equal("flat")
+            || sub.is_equal("callgraph"))) {
+        return CMD_VALID;
+    }
+    if (args->size() == 3
+        && ((sub.is_equal("flat") || sub.is_equal("callgraph"))
+            && (*args)[2].is_integer())) {
+        return CMD_VALID;
+    }
+    if (args->size() == 3 && sub.is_equal("folded")
+        && (*args)[2].is_string()) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+void CmdProf::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_PROFILER, &lstServ);
+    if (lstServ.size() == 0) {
+        generateError(res, "Profiler isn't supported");
+        return;
+    }
+    IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+    IProfiler *iprof = static_cast<IProfiler *>(
+                        iserv->getInterface(IFACE_PROFILER));
+
+    const char *sub = "flat";
+    unsigned total = 20;
+    if (args->size() > 1) {
+        sub = (*args)[1].to_string();
+    }
+    if (args->size() == 3 && (*args)[2].is_integer()) {
+        total = static_cast<unsigned>((*args)[2].to_uint64());
+    }
+
+    if (strcmp(sub, "start") == 0) {
+        iprof->startProfiling();
+        return;
+    } else if (strcmp(sub, "stop") == 0) {
+        iprof->stopProfiling();
+        return;
+    } else if (strcmp(sub, "reset") == 0) {
+        iprof->resetProfiling();
+        return;
+    }
+
+    // Symbols are optional, elf-file could be loaded after the start:
+    elf_ = 0;
+    RISCV_get_services_with_iface(IFACE_ELFREADER, &lstServ);
+    if (lstServ.size() != 0) {
+        iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        elf_ = static_cast<IElfReader *>(
+                        iserv->getInterface(IFACE_ELFREADER));
+    }
+
+    AttributeType prof;
+    iprof->getProfile(&prof);
+    if (strcmp(sub, "flat") == 0) {
+        getFlat(&prof[Profile_Histogram], total, res);
+    } else if (strcmp(sub, "callgraph") == 0) {
+        getCallGraph(&prof[Profile_Stacks], total, res);
+    } else if (!writeFolded(&prof[Profile_Stacks], (*args)[2].to_string())) {
+        char tst[256];
+        RISCV_sprintf(tst, sizeof(tst), "Can't open '%s' file",
+                      (*args)[2].to_string());
+        generateError(res, tst);
+    }
+}
+
+void CmdProf::symbolName(uint64_t addr, AttributeType *name) {
+    if (elf_) {
+        AttributeType info;
+        elf_->addressToSymbol(addr, &info);
+        if (info[0u].size()) {
+            *name = info[0u];
+            return;
+        }
+    }
+    char tstr[32];
+    RISCV_sprintf(tstr, sizeof(tstr), "0x%08" RV_PRI64 "x", addr);
+    name->make_string(tstr);
+}
+
+/**
+ * Entries are merged by symbol name, the histogram is kept in the table
+ * order that is almost sorted by address and isn't suitable for quicksort.
+ */
+void CmdProf::getFlat(AttributeType *hist, unsigned total,
+                      AttributeType *res) {
+    AttributeType dict, name;
+    uint64_t steps = 0;
+    dict.make_dict();
+    for (unsigned i = 0; i < hist->size(); i++) {
+        AttributeType &e = (*hist)[i];
+        uint64_t instr = e[1].to_uint64();
+        uint64_t stall = e[2].to_uint64();
+        steps += instr + stall;
+        if (e[0u].to_uint64() == ~0ull) {
+            name.make_string("[other]");
+        } else {
+            symbolName(e[0u].to_uint64(), &name);
+        }
+        AttributeType &item = dict[name.to_string()];
+        if (item.is_nil()) {
+            item.make_list(4);
+            item[0u] = name;
+            item[1].make_uint64(0);
+            item[2].make_uint64(0);
+            item[3].make_uint64(0);         // sort key
+        }
+        item[1].make_uint64(item[1].to_uint64() + instr);
+        item[2].make_uint64(item[2].to_uint64() + stall);
+        item[3].make_uint64(item[3].to_uint64() + instr + stall);
+    }
+
+    AttributeType func;
+    func.make_list(0);
+    for (unsigned i = 0; i < dict.size(); i++) {
+        func.add_to_list(dict.dict_value(i));
+    }
+    func.sort(3);
+    res->make_list(0);
+    for (unsigned i = func.size(); i > 0 && res->size() < total; i--) {
+        AttributeType &item = func[i - 1];
+        double pct = 0;
+        if (steps) {
+            pct = 100.0 * static_cast<double>(item[3].to_uint64())
+                / static_cast<double>(steps);
+        }
+        item[3].make_floating(pct);
+        res->add_to_list(&item);
+    }
+}
+
+/** Each pair of the adjacent frames in a sample is a caller-callee arc */
+void CmdProf::getCallGraph(AttributeType *stacks, unsigned total,
+                           AttributeType *res) {
+    AttributeType arcs, caller, callee;
+    char key[512];
+    arcs.make_dict();
+    for (unsigned i = 0; i < stacks->size(); i++) {
+        AttributeType &s = (*stacks)[i];
+        uint64_t weight = s[0u].to_uint64();
+        AttributeType &frames = s[1];
+        for (unsigned n = 1; n < frames.size(); n++) {
+            symbolName(frames[n - 1].to_uint64(), &caller);
+            symbolName(frames[n].to_uint64(), &callee);
+            RISCV_sprintf(key, sizeof(key), "%s;%s",
+                          caller.to_string(), callee.to_string());
+            AttributeType &arc = arcs[key];
+            if (arc.is_nil()) {
+                arc.make_list(3);
+                arc[0u] = caller;
+                arc[1] = callee;
+                arc[2].make_uint64(0);
+            }
+            arc[2].make_uint64(arc[2].to_uint64() + weight);
+        }
+    }
+
+    AttributeType list;
+    list.make_list(0);
+    for (unsigned i = 0; i < arcs.size(); i++) {
+        list.add_to_list(arcs.dict_value(i));
+    }
+    list.sort(2);
+    res->make_list(0);
+    for (unsigned i = list.size(); i > 0 && res->size() < total; i--) {
+        res->add_to_list(&list[i - 1]);
+    }
+}
+
+/** Line per stack: 'outer;...;inner weight' */
+bool CmdProf::writeFolded(AttributeType *stacks, const char *filename) {
+    FILE *fd = fopen(filename, "w");
+    if (fd == NULL) {
+        return false;
+    }
+    AttributeType name;
+    for (unsigned i = 0; i < stacks->size(); i++) {
+        AttributeType &s = (*stacks)[i];
+        AttributeType &frames = s[1];
+        if (frames.size() == 0) {
+            fprintf(fd, "[lost]");
+        }
+        for (unsigned n = 0; n < frames.size(); n++) {
+            symbolName(frames[n].to_uint64(), &name);
+            fprintf(fd, "%s%s", n ? ";" : "", name.to_string());
+        }
+        fprintf(fd, " %" RV_PRI64 "d\n", s[0u].to_uint64());
+    }
+    fclose(fd);
+    return true;
+}
+
+}  // namespace debugger
@@ -0,0 +1,41 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Execution profile command.
+ */
+
+#ifndef __DEBUGGER_CMD_PROF_H__
+#define __DEBUGGER_CMD_PROF_H__
+
+#include "api_core.h"
+#include "coreservices/itap.h"
+#include "coreservices/isocinfo.h"
+#include "coreservices/icommand.h"
+#include "coreservices/iprofiler.h"
+#include "coreservices/ielfreader.h"
+
+namespace debugger {
+
+class CmdProf : public ICommand  {
+public:
+    explicit CmdProf(ITap *tap, ISocInfo *info);
+
+    /** ICommand */
+    virtual bool isValid(AttributeType *args);
+    virtual void exec(AttributeType *args, AttributeType *res);
+
+private:
+    void symbolName(uint64_t addr, AttributeType *name);
+    void getFlat(AttributeType *hist, unsigned total, AttributeType *res);
+    void getCallGraph(AttributeType *stacks, unsigned total,
+                      AttributeType *res);
+    bool writeFolded(AttributeType *stacks, const char *filename);
+
+private:
+    IElfReader *elf_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CMD_PROF_H__
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Reverse continue command.
+ */
+
+#include "iservice.h"
+#include "cmd_rcont.h"
+#include "coreservices/ireplay.h"
+
+namespace debugger {
+
+CmdRcont::CmdRcont(ITap *tap, ISocInfo *info) 
+    : ICommand ("rcont", tap, info) {
+
+    briefDescr_.make_string("Move execution back to the previous breakpoint");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Move execution back to the latest breakpoint or watchpoint\n"
+        "    hit before the current step. Without hits hart stops at the\n"
+        "    oldest checkpoint. Requires 'CheckpointInterval' of the\n"
+        "    snapshot service.\n"
+        "Usage:\n"
+        "    rcont\n"
+        "Example:\n"
+        "    br add 0x10000100\n"
+        "    rcont\n");
+}
+
+bool CmdRcont::isValid(AttributeType *args) {
+    if ((*args)[0u].is_equal("rcont") && args->size() == 1) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+void CmdRcont::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_REVERSE_CONTROL, &lstServ);
+    if (lstServ.size() == 0) {
+        generateError(res, "Reverse execution isn't supported");
+        return;
+    }
+
+    IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+    IReverseControl *irev = static_cast<IReverseControl *>(
+                        iserv->getInterface(IFACE_REVERSE_CONTROL));
+    if (!irev->reverseContinue()) {
+        generateError(res, "Can't reverse execution");
+    }
+}
+
+}  // namespace debugger
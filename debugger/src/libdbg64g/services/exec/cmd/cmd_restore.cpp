@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Snapshot restore command.
+ */
+
+#include "iservice.h"
+#include "cmd_restore.h"
+#include "coreservices/isnapshot.h"
+
+namespace debugger {
+
+CmdRestore::CmdRestore(ITap *tap, ISocInfo *info) 
+    : ICommand ("restore", tap, info) {
+
+    briefDescr_.make_string("Restore simulated platform state from file");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Restore CPU context, writable memory and devices state saved\n"
+        "    by the 'save' command. Platform configuration must be the\n"
+        "    same. Debug state (halt, breakpoints) isn't changed.\n"
+        "Usage:\n"
+        "    restore filename\n"
+        "Example:\n"
+        "    restore /home/riscv/boot.snap\n");
+}
+
+bool CmdRestore::isValid(AttributeType *args) {
+    if ((*args)[0u].is_equal("restore") && args->size() == 2) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+void CmdRestore::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SNAPSHOT_CONTROL, &lstServ);
+    if (lstServ.size() == 0) {
+        generateError(res, "Snapshot service not found");
+        return;
+    }
+
+    IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+    ISnapshotControl *isnap = static_cast<ISnapshotControl *>(
+                        iserv->getInterface(IFACE_SNAPSHOT_CONTROL));
+    if (!isnap->restore((*args)[1].to_string(), true)) {
+        generateError(res, "Can't restore snapshot");
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Reverse step command.
+ */
+
+#include "iservice.h"
+#include "cmd_rstep.h"
+#include "coreservices/ireplay.h"
+
+namespace debugger {
+
+CmdRstep::CmdRstep(ITap *tap, ISocInfo *info) 
+    : ICommand ("rstep", tap, info) {
+
+    briefDescr_.make_string("Move execution back on the number of steps");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Restore the nearest checkpoint and re-execute instructions up\n"
+        "    to the specified number of steps before the current one. Hart\n"
+        "    is halted. Requires 'CheckpointInterval' of the snapshot\n"
+        "    service.\n"
+        "Usage:\n"
+        "    rstep <N=1>\n"
+        "Example:\n"
+        "    rstep\n"
+        "    rstep 1000\n");
+}
+
+bool CmdRstep::isValid(AttributeType *args) {
+    if ((*args)[0u].is_equal("rstep")
+        && (args->size() == 1
+            || (args->size() == 2 && (*args)[1].is_integer()))) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+void CmdRstep::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_REVERSE_CONTROL, &lstServ);
+    if (lstServ.size() == 0) {
+        generateError(res, "Reverse execution isn't supported");
+        return;
+    }
+
+    IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+    IReverseControl *irev = static_cast<IReverseControl *>(
+                        iserv->getInterface(IFACE_REVERSE_CONTROL));
+    uint64_t steps = 1;
+    if (args->size() == 2) {
+        steps = (*args)[1].to_uint64();
+    }
+    if (!irev->reverseStep(steps)) {
+        generateError(res, "Can't reverse execution");
+    }
+}
+
+}  // namespace debugger
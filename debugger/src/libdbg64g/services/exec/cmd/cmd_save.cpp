@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Snapshot save command.
+ */
+
+#include "iservice.h"
+#include "cmd_save.h"
+#include "coreservices/isnapshot.h"
+
+namespace debugger {
+
+CmdSave::CmdSave(ITap *tap, ISocInfo *info) 
+    : ICommand ("save", tap, info) {
+
+    briefDescr_.make_string("Save simulated platform state into file");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Save CPU context, writable memory and devices state of the\n"
+        "    simulated platform. When the file was saved or restored last\n"
+        "    only the memory pages modified since then are written.\n"
+        "Usage:\n"
+        "    save filename\n"
+        "Example:\n"
+        "    save /home/riscv/boot.snap\n");
+}
+
+bool CmdSave::isValid(AttributeType *args) {
+    if ((*args)[0u].is_equal("save") && args->size() == 2) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+void CmdSave::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SNAPSHOT_CONTROL, &lstServ);
+    if (lstServ.size() == 0) {
+        generateError(res, "Snapshot service not found");
+        return;
+    }
+
+    IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+    ISnapshotControl *isnap = static_cast<ISnapshotControl *>(
+                        iserv->getInterface(IFACE_SNAPSHOT_CONTROL));
+    if (!isnap->save((*args)[1].to_string(), true)) {
+        generateError(res, "Can't save snapshot");
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Add or remove data watchpoint.
+ */
+
+#include "cmd_wp.h"
+
+namespace debugger {
+
+CmdWp::CmdWp(ITap *tap, ISocInfo *info) 
+    : ICommand ("wp", tap, info) {
+
+    briefDescr_.make_string("Add or remove data watchpoint.");
+    detailedDescr_.make_string(
+        "Description:\n"
+        "    Get watchpoints list or add/remove watchpoint on the data\n"
+        "    address range. CPU halts after the load/store instruction\n"
+        "    that has accessed watched data.\n"
+        "Response:\n"
+        "    List of lists [[iis]*] if watchpoint list was requested, where:\n"
+        "        i    - uint64_t start address\n"
+        "        i    - uint64_t length in bytes\n"
+        "        s    - access type: 'r', 'w' or 'rw'\n"
+        "    Nil in a case of add/rm watchpoint\n"
+        "Usage:\n"
+        "    wp\n"
+        "    wp add <addr> <length> [r|w|rw]\n"
+        "    wp rm <addr>\n"
+        "    Write access is watched if type isn't specified. Error is\n"
+        "    returned if CPU doesn't support watchpoints or has no free.\n"
+        "Example:\n"
+        "    wp add 0x10007ff0 8\n"
+        "    wp add 0x10001000 0x100 rw\n"
+        "    wp rm 0x10007ff0\n");
+
+    wpList_.make_list(0);
+}
+
+bool CmdWp::isValid(AttributeType *args) {
+    if (!(*args)[0u].is_equal(cmdName_.to_string())) {
+        return CMD_INVALID;
+    }
+    if (args->size() == 1) {
+        return CMD_VALID;
+    }
+    if (args->size() == 3 && (*args)[1].is_equal("rm")) {
+        return CMD_VALID;
+    }
+    if ((args->size() == 4 || args->size() == 5)
+        && (*args)[1].is_equal("add")) {
+        return CMD_VALID;
+    }
+    return CMD_INVALID;
+}
+
+uint64_t CmdWp::toFlags(AttributeType *args) {
+    if (args->size() < 5) {
+        return 0x2;
+    }
+    AttributeType &type = (*args)[4];
+    if (type.is_equal("r")) {
+        return 0x1;
+    } else if (type.is_equal("w")) {
+        return 0x2;
+    } else if (type.is_equal("rw")) {
+        return 0x3;
+    }
+    return 0;
+}
+
+void CmdWp::exec(AttributeType *args, AttributeType *res) {
+    res->make_nil();
+    if (!isValid(args)) {
+        generateError(res, "Wrong argument list");
+        return;
+    }
+    if (args->size() == 1) {
+        *res = wpList_;
+        return;
+    }
+
+    Reg64Type t1;
+    uint64_t addr = (*args)[2].to_uint64();
+    DsuMapType *dsu = info_->getpDsu();
+
+    if ((*args)[1].is_equal("add")) {
+        uint64_t flags = toFlags(args);
+        if (flags == 0) {
+            generateError(res, "Wrong access type");
+            return;
+        }
+        t1.val = 0;
+        tap_->read(reinterpret_cast<uint64_t>(
+                    &dsu->udbg.v.add_watchpoint), 8, t1.buf);
+        if (t1.val == 0) {
+            generateError(res, "No free watchpoints or not supported");
+            return;
+        }
+        t1.val = addr;
+        tap_->write(reinterpret_cast<uint64_t>(
+                    &dsu->udbg.v.wp_address), 8, t1.buf);
+        t1.val = (*args)[3].to_uint64();
+        tap_->write(reinterpret_cast<uint64_t>(
+                    &dsu->udbg.v.wp_length), 8, t1.buf);
+        t1.val = flags;
+        tap_->write(reinterpret_cast<uint64_t>(
+                    &dsu->udbg.v.add_watchpoint), 8, t1.buf);
+
+        AttributeType item;
+        item.make_list(3);
+        item[0u].make_uint64(addr);
+        item[1].make_uint64((*args)[3].to_uint64());
+        item[2].make_string(flags == 0x1 ? "r" : flags == 0x2 ? "w" : "rw");
+        wpList_.add_to_list(&item);
+        return;
+    }
+
+    for (unsigned i = 0; i < wpList_.size(); i++) {
+        if (wpList_[i][0u].to_uint64() == addr) {
+            wpList_.remove_from_list(i);
+            break;
+        }
+    }
+    t1.val = addr;
+    tap_->write(reinterpret_cast<uint64_t>(
+                &dsu->udbg.v.remove_watchpoint), 8, t1.buf);
+}
+
+}  // namespace debugger
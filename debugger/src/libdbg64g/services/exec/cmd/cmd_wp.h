@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Add or remove data watchpoint.
+ */
+
+#ifndef __DEBUGGER_CMD_WP_H__
+#define __DEBUGGER_CMD_WP_H__
+
+#include "api_core.h"
+#include "coreservices/icommand.h"
+
+namespace debugger {
+
+class CmdWp : public ICommand  {
+public:
+    explicit CmdWp(ITap *tap, ISocInfo *info);
+
+    /** ICommand */
+    virtual bool isValid(AttributeType *args);
+    virtual void exec(AttributeType *args, AttributeType *res);
+
+private:
+    uint64_t toFlags(AttributeType *args);
+
+private:
+    AttributeType wpList_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_CMD_WP_H__
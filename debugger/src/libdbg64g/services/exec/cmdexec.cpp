@@ -23,10 +23,16 @@
 #include "cmd/cmd_cpi.h"
 #include "cmd/cmd_status.h"
 #include "cmd/cmd_reset.h"
+#include "cmd/cmd_restore.h"
+#include "cmd/cmd_save.h"
+#include "cmd/cmd_rstep.h"
+#include "cmd/cmd_rcont.h"
+#include "cmd/cmd_prof.h"
 #include "cmd/cmd_disas.h"
 #include "cmd/cmd_busutil.h"
 #include "cmd/cmd_symb.h"
 #include "cmd/cmd_stack.h"
+#include "cmd/cmd_wp.h"
 
 namespace debugger {
 
@@ -78,14 +84,20 @@ void CmdExecutor::postinitService() {
     registerCommand(new CmdLoadElf(itap_, info_));
     registerCommand(new CmdLog(itap_, info_));
     registerCommand(new CmdMemDump(itap_, info_));
+    registerCommand(new CmdProf(itap_, info_));
+    registerCommand(new CmdRcont(itap_, info_));
     registerCommand(new CmdRead(itap_, info_));
     registerCommand(new CmdRun(itap_, info_));
+    registerCommand(new CmdSave(itap_, info_));
     registerCommand(new CmdReg(itap_, info_));
     registerCommand(new CmdRegs(itap_, info_));
     registerCommand(new CmdReset(itap_, info_));
+    registerCommand(new CmdRestore(itap_, info_));
+    registerCommand(new CmdRstep(itap_, info_));
     registerCommand(new CmdStack(itap_, info_));
     registerCommand(new CmdStatus(itap_, info_));
     registerCommand(new CmdSymb(itap_, info_));
+    registerCommand(new CmdWp(itap_, info_));
     registerCommand(new CmdWrite(itap_, info_));
 }
 
@@ -7,8 +7,21 @@
 
 #include "api_core.h"
 #include "memsim.h"
+#include "../elfloader/elf_types.h"
 #include <iostream>
 #include <string.h>
+#if defined(_M_X64) || defined(__x86_64__)
+#define MEMSIM_HEX_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
 
 namespace debugger {
 
@@ -17,22 +30,30 @@ REGISTER_CLASS(MemorySim)
 
 MemorySim::MemorySim(const char *name)  : IService(name) {
     registerInterface(static_cast<IMemoryOperation *>(this));
+    registerInterface(static_cast<IMemoryTracker *>(this));
     registerAttribute("InitFile", &initFile_);
     registerAttribute("ReadOnly", &readOnly_);
     registerAttribute("BaseAddress", &baseAddress_);
     registerAttribute("Length", &length_);
+    registerAttribute("MappedFile", &mappedFile_);
+    registerAttribute("HugePages", &hugePages_);
 
     initFile_.make_string("");
     readOnly_.make_boolean(false);
     baseAddress_.make_uint64(0);
     length_.make_uint64(0);
+    mappedFile_.make_string("");
+    hugePages_.make_boolean(false);
     mem_ = NULL;
+    memSize_ = 0;
+    tracker_ = NULL;
+    dirty_ = NULL;
+    pageTotal_ = 0;
 }
 
 MemorySim::~MemorySim() {
-    if (mem_) {
-        delete mem_;
-    }
+    freeMemory();
+    delete [] dirty_;
 }
 
 void MemorySim::postinitService() {
@@ -42,7 +63,17 @@ void MemorySim::postinitService() {
         return;
     }
 
-    mem_ = new uint8_t[static_cast<unsigned>(length_.to_uint64())];
+    mem_ = allocMemory(length_.to_uint64());
+    if (mem_ == NULL) {
+        RISCV_error("Can't allocate %" RV_PRI64 "d bytes",
+                    length_.to_uint64());
+        return;
+    }
+
+    if (mappedFile_.size() != 0 && !mapImage(mappedFile_.to_string())) {
+        RISCV_error("Can't map '%s' file", mappedFile_.to_string());
+    }
+
     if (initFile_.size() == 0) {
         return;
     }
@@ -56,8 +87,10 @@ void MemorySim::postinitService() {
         filename = spath + std::string(initFile_.to_string());
     }
 
-    FILE *fp = fopen(initFile_.to_string(), "r");
-    if (fp == NULL) {
+    uint64_t t_start = RISCV_get_time_ms();
+    uint64_t fsz;
+    uint8_t *fbuf = openImage(filename.c_str(), &fsz);
+    if (fbuf == NULL) {
         for (uint64_t i = 0; i < length_.to_uint64()/4; i++) {
             // NOP isntruction
             reinterpret_cast<uint32_t *>(mem_)[i] = 0x00000013;  // intialize by NOPs
@@ -66,50 +99,40 @@ void MemorySim::postinitService() {
         return;
     }
 
-    bool bhalf = false;
-    int rd_symb;
-    uint8_t symb;
-    int linecnt = 0;
-    int symbinline = SYMB_IN_LINE - 1;
-    while (!feof(fp)) {
-        rd_symb = fgetc(fp);
-        if (!chishex(rd_symb))
-            continue;
-
-        if (!bhalf) {
-            bhalf = true;
-            symb = chtohex(rd_symb) << 4;
-            continue;
-        } 
-
-        bhalf = false;
-        symb |= chtohex(rd_symb) & 0xf;
-
-        if ((SYMB_IN_LINE * linecnt + symbinline) >= 
-                    static_cast<int>(length_.to_uint64())) {
-            RISCV_error("HEX file tries to write out "
-                        "of allocated array\n", NULL);
-            break;
-        } 
-
-        mem_[SYMB_IN_LINE * linecnt + symbinline] = symb;
-        if (--symbinline < 0) {
-            linecnt++;
-            symbinline = SYMB_IN_LINE - 1;
-        }
+    uint64_t loaded;
+    const char *fmt;
+    size_t namelen = filename.size();
+    if (fsz >= sizeof(ElfHeaderType) && fbuf[0] == MAGIC_BYTES[0]
+        && fbuf[1] == MAGIC_BYTES[1] && fbuf[2] == MAGIC_BYTES[2]
+        && fbuf[3] == MAGIC_BYTES[3]) {
+        fmt = "ELF";
+        loaded = loadElf(fbuf, fsz);
+    } else if (namelen > 4
+        && strcmp(&filename.c_str()[namelen - 4], ".hex") == 0) {
+        fmt = "HEX";
+        loaded = loadHex(fbuf, fsz);
+    } else {
+        fmt = "RAW";
+        loaded = loadRaw(fbuf, fsz);
     }
-    fclose(fp);
+    closeImage(fbuf, fsz);
+    RISCV_info("%s image '%s': %" RV_PRI64 "d B loaded in %" RV_PRI64 "d ms",
+               fmt, initFile_.to_string(), loaded,
+               RISCV_get_time_ms() - t_start);
 }
 
 void MemorySim::b_transport(Axi4TransactionType *trans) {
-    uint64_t mask = (length_.to_uint64() - 1);
-    uint64_t off = (trans->addr - getBaseAddress()) & mask;
+    uint64_t off = trans->addr - getBaseAddress();
     trans->response = MemResp_Valid;
-    if (trans->action == MemAction_Write) {
+    if (mem_ == NULL || off + trans->xsize > length_.to_uint64()) {
+        RISCV_error("Access out of range [%08" RV_PRI64 "x]", trans->addr);
+        trans->response = MemResp_Error;
+    } else if (trans->action == MemAction_Write) {
         if (readOnly_.to_bool()) {
             RISCV_error("Write to READ ONLY memory", NULL);
             trans->response = MemResp_Error;
         } else {
+            trackWrite(off, trans->xsize);
             for (uint64_t i = 0; i < trans->xsize; i++) {
                 if (((trans->wstrb >> i) & 0x1) == 0) {
                     continue;
@@ -129,6 +152,353 @@ void MemorySim::b_transport(Axi4TransactionType *trans) {
         pdata[trans->action][1], pdata[trans->action][0]);
 }
 
+void MemorySim::b_transport_burst(Axi4BurstTransactionType *trans) {
+    uint64_t off = trans->addr - getBaseAddress();
+    trans->response = MemResp_Valid;
+    if (mem_ == NULL || off + trans->len > length_.to_uint64()) {
+        RISCV_error("Burst out of range [%08" RV_PRI64 "x]", trans->addr);
+        trans->response = MemResp_Error;
+    } else if (trans->action == MemAction_Write) {
+        if (readOnly_.to_bool()) {
+            RISCV_error("Write to READ ONLY memory", NULL);
+            trans->response = MemResp_Error;
+        } else {
+            trackWrite(off, trans->len);
+            memcpy(&mem_[off], trans->payload, trans->len);
+        }
+    } else {
+        memcpy(trans->payload, &mem_[off], trans->len);
+    }
+    RISCV_debug("[%08" RV_PRI64 "x] burst %s %d B",
+        trans->addr, trans->action == MemAction_Write ? "<=" : "=>",
+        trans->len);
+}
+
+bool MemorySim::get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi) {
+    if (mem_ == NULL) {
+        return false;
+    }
+    dmi->ptr = mem_;
+    dmi->addr = getBaseAddress();
+    dmi->length = getLength();
+    dmi->read_allowed = true;
+    dmi->write_allowed = !readOnly_.to_bool();
+    uint64_t off = addr - getBaseAddress();
+    if (tracker_ == NULL || !dmi->write_allowed || off >= getLength()) {
+        return true;
+    }
+    // Clean page is readable only, dirty one is granted for write alone
+    uint64_t page = off / TRACK_PAGE_BYTES;
+    if (!dirty_[page]) {
+        dmi->write_allowed = false;
+        return true;
+    }
+    off = page * TRACK_PAGE_BYTES;
+    dmi->ptr = &mem_[off];
+    dmi->addr = getBaseAddress() + off;
+    dmi->length = getLength() - off;
+    if (dmi->length > TRACK_PAGE_BYTES) {
+        dmi->length = TRACK_PAGE_BYTES;
+    }
+    return true;
+}
+
+bool MemorySim::getMemory(DmiRegionType *dmi) {
+    if (mem_ == NULL || readOnly_.to_bool()) {
+        return false;
+    }
+    dmi->ptr = mem_;
+    dmi->addr = getBaseAddress();
+    dmi->length = getLength();
+    dmi->read_allowed = true;
+    dmi->write_allowed = true;
+    return true;
+}
+
+void MemorySim::setTrackListener(IMemoryTrackListener *listener) {
+    if (dirty_ == NULL) {
+        pageTotal_ = (getLength() + TRACK_PAGE_BYTES - 1) / TRACK_PAGE_BYTES;
+        dirty_ = new uint8_t[static_cast<size_t>(pageTotal_)];
+        memset(dirty_, 1, static_cast<size_t>(pageTotal_));
+    }
+    tracker_ = listener;
+}
+
+void MemorySim::clearDirty() {
+    if (dirty_) {
+        memset(dirty_, 0, static_cast<size_t>(pageTotal_));
+    }
+}
+
+/**
+ * Writes go via the bus which serializes accesses to this device, so the
+ * listener is called once per page and before the page is modified.
+ */
+void MemorySim::trackWrite(uint64_t off, uint64_t len) {
+    if (tracker_ == NULL || len == 0) {
+        return;
+    }
+    uint64_t last = (off + len - 1) / TRACK_PAGE_BYTES;
+    for (uint64_t page = off / TRACK_PAGE_BYTES; page <= last; page++) {
+        if (!dirty_[page]) {
+            tracker_->pageWrite(static_cast<IMemoryTracker *>(this),
+                                page * TRACK_PAGE_BYTES);
+            dirty_[page] = 1;
+        }
+    }
+}
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+uint8_t *MemorySim::allocMemory(uint64_t size) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    uint64_t page = si.dwPageSize;
+    memSize_ = (size + page - 1) & ~(page - 1);
+    // Committed pages get physical storage on the first touch only
+    void *p = VirtualAlloc(NULL, static_cast<SIZE_T>(memSize_),
+                           MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    return static_cast<uint8_t *>(p);
+}
+
+void MemorySim::freeMemory() {
+    if (mem_) {
+        VirtualFree(mem_, 0, MEM_RELEASE);
+        mem_ = NULL;
+    }
+}
+
+bool MemorySim::mapImage(const char *filename) {
+    // No copy-on-write view inside the reserved array, so read it instead
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    size_t sz = fread(mem_, 1, static_cast<size_t>(length_.to_uint64()), fp);
+    fclose(fp);
+    RISCV_info("Loaded %d bytes from '%s'", static_cast<int>(sz), filename);
+    return true;
+}
+
+uint8_t *MemorySim::openImage(const char *filename, uint64_t *size) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = static_cast<uint64_t>(ftell(fp));
+    rewind(fp);
+    uint8_t *buf = new uint8_t[static_cast<size_t>(*size) + 1];
+    *size = fread(buf, 1, static_cast<size_t>(*size), fp);
+    fclose(fp);
+    return buf;
+}
+
+void MemorySim::closeImage(uint8_t *buf, uint64_t size) {
+    delete [] buf;
+}
+#else
+uint8_t *MemorySim::allocMemory(uint64_t size) {
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    if (hugePages_.to_bool()) {
+        page = 2ull << 20;      // THP covers only whole 2 MB pages
+    }
+    memSize_ = (size + page - 1) & ~(page - 1);
+    void *p = mmap(NULL, memSize_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        memSize_ = 0;
+        return NULL;
+    }
+#if defined(MADV_HUGEPAGE)
+    if (hugePages_.to_bool() && madvise(p, memSize_, MADV_HUGEPAGE) != 0) {
+        RISCV_info("Transparent huge pages aren't available", NULL);
+    }
+#endif
+    return static_cast<uint8_t *>(p);
+}
+
+void MemorySim::freeMemory() {
+    if (mem_) {
+        munmap(mem_, memSize_);
+        mem_ = NULL;
+        memSize_ = 0;
+    }
+}
+
+bool MemorySim::mapImage(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    uint64_t sz = static_cast<uint64_t>(st.st_size);
+    if (sz > length_.to_uint64()) {
+        RISCV_error("File '%s' is larger than memory, truncated", filename);
+        sz = length_.to_uint64();
+    }
+    if (sz == 0) {
+        close(fd);
+        return true;
+    }
+    // Replace the head of anonymous array by the private file view. Pages
+    // are read on demand and the tail of the last page is zero-filled.
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t maplen = (sz + page - 1) & ~(page - 1);
+    void *p = mmap(mem_, maplen, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    RISCV_info("Mapped %" RV_PRI64 "d bytes from '%s'", sz, filename);
+    return true;
+}
+
+uint8_t *MemorySim::openImage(const char *filename, uint64_t *size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0) {
+        *size = static_cast<uint64_t>(st.st_size);
+        // Zero length mapping isn't allowed, empty file still gets a page
+        p = mmap(NULL, *size ? *size : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(p, *size ? *size : 1, MADV_SEQUENTIAL);
+    return static_cast<uint8_t *>(p);
+}
+
+void MemorySim::closeImage(uint8_t *buf, uint64_t size) {
+    munmap(buf, size ? size : 1);
+}
+#endif
+
+/**
+ * ROM hex array is the stream of hex digits where each group of
+ * 2*SYMB_IN_LINE digits is one 64-bits word written MSB first. Groups
+ * that entirely lie in the buffer are decoded with SSE2, the rest digit by
+ * digit skipping line separators.
+ */
+uint64_t MemorySim::loadHex(const uint8_t *buf, uint64_t sz) {
+    uint64_t length = length_.to_uint64();
+    uint64_t off = 0;          // byte offset of the current group
+    int symbinline = SYMB_IN_LINE - 1;
+    bool bhalf = false;
+    uint8_t symb = 0;
+    uint64_t i = 0;
+    while (i < sz) {
+#ifdef MEMSIM_HEX_SSE
+        if (!bhalf && symbinline == SYMB_IN_LINE - 1 && i + 16 <= sz
+            && off + SYMB_IN_LINE <= length) {
+            __m128i v = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(&buf[i]));
+            __m128i lc = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i dig = _mm_and_si128(
+                        _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                        _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), v));
+            __m128i alpha = _mm_and_si128(
+                        _mm_cmpgt_epi8(lc, _mm_set1_epi8('a' - 1)),
+                        _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lc));
+            if (_mm_movemask_epi8(_mm_or_si128(dig, alpha)) == 0xFFFF) {
+                // '0'..'9' -> 0..9, 'a'/'A'..'f'/'F' -> 1..6 + 9
+                __m128i nib = _mm_add_epi8(
+                        _mm_and_si128(v, _mm_set1_epi8(0x0F)),
+                        _mm_and_si128(alpha, _mm_set1_epi8(9)));
+                // Even digit is the high nibble of byte
+                __m128i hi = _mm_slli_epi16(
+                        _mm_and_si128(nib, _mm_set1_epi16(0x00FF)), 4);
+                __m128i lo = _mm_srli_epi16(nib, 8);
+                __m128i b = _mm_packus_epi16(_mm_or_si128(hi, lo), hi);
+                uint8_t t[16];
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(t), b);
+                for (int n = 0; n < SYMB_IN_LINE; n++) {
+                    mem_[off + n] = t[SYMB_IN_LINE - 1 - n];
+                }
+                off += SYMB_IN_LINE;
+                i += 16;
+                continue;
+            }
+        }
+#endif
+        int rd_symb = buf[i++];
+        if (!chishex(rd_symb)) {
+            continue;
+        }
+        if (!bhalf) {
+            bhalf = true;
+            symb = chtohex(rd_symb) << 4;
+            continue;
+        }
+        bhalf = false;
+        symb |= chtohex(rd_symb) & 0xf;
+
+        if (off + symbinline >= length) {
+            RISCV_error("HEX file tries to write out "
+                        "of allocated array\n", NULL);
+            break;
+        }
+        mem_[off + symbinline] = symb;
+        if (--symbinline < 0) {
+            off += SYMB_IN_LINE;
+            symbinline = SYMB_IN_LINE - 1;
+        }
+    }
+    return off + (SYMB_IN_LINE - 1 - symbinline);
+}
+
+uint64_t MemorySim::loadRaw(const uint8_t *buf, uint64_t sz) {
+    if (sz > length_.to_uint64()) {
+        RISCV_error("Raw image is larger than memory, truncated", NULL);
+        sz = length_.to_uint64();
+    }
+    memcpy(mem_, buf, static_cast<size_t>(sz));
+    return sz;
+}
+
+/**
+ * Loadable sections are placed relative to the entry point as elf2raw64
+ * does, so the same image may be preloaded into ROM and RAM regions.
+ */
+uint64_t MemorySim::loadElf(const uint8_t *buf, uint64_t sz) {
+    const ElfHeaderType *h = reinterpret_cast<const ElfHeaderType *>(buf);
+    uint64_t total = 0;
+    if (h->e_shoff == 0 || h->e_shoff
+        + h->e_shnum * sizeof(SectionHeaderType) > sz) {
+        RISCV_error("Wrong ELF section table", NULL);
+        return 0;
+    }
+    const SectionHeaderType *sh_tbl =
+        reinterpret_cast<const SectionHeaderType *>(&buf[h->e_shoff]);
+    for (int i = 0; i < h->e_shnum; i++) {
+        const SectionHeaderType *sh = &sh_tbl[i];
+        if (sh->sh_type != SHT_PROGBITS || (sh->sh_flags & SHF_ALLOC) == 0
+            || sh->sh_size == 0) {
+            continue;
+        }
+        uint64_t off = sh->sh_addr - h->e_entry;
+        if (sh->sh_addr < h->e_entry || off + sh->sh_size > length_.to_uint64()
+            || sh->sh_offset + sh->sh_size > sz) {
+            RISCV_error("ELF section [%08" RV_PRI64 "x] is out of memory",
+                        sh->sh_addr);
+            continue;
+        }
+        memcpy(&mem_[off], &buf[sh->sh_offset],
+               static_cast<size_t>(sh->sh_size));
+        total += sh->sh_size;
+    }
+    return total;
+}
+
 bool MemorySim::chishex(int s) {
     bool ret = false;
     if (s >= '0' && s <= '9') {
@@ -3,6 +3,14 @@
  * @copyright  Copyright 2016 GNSS Sensor Ltd. All right reserved.
  * @author     Sergey Khabarov - sergeykhbr@gmail.com
  * @brief      ROM functional model declaration.
+ *
+ * @details    Memory array is reserved in the host address space and host
+ *             pages are committed on the first access, so only the touched
+ *             part of a large DDR region is allocated. Optional raw image
+ *             file is mapped copy-on-write at the beginning of the region.
+ *             When the writes are tracked, the DMI write pointer is granted
+ *             only for the dirty page, so the first write into the clean
+ *             page goes via the bus and is reported to the listener.
  */
 
 #ifndef __DEBUGGER_SOCSIM_PLUGIN_ROM_H__
@@ -11,11 +19,13 @@
 #include "iclass.h"
 #include "iservice.h"
 #include "coreservices/imemop.h"
+#include "coreservices/imemtracker.h"
 
 namespace debugger {
 
 class MemorySim : public IService, 
-                  public IMemoryOperation {
+                  public IMemoryOperation,
+                  public IMemoryTracker {
 public:
     MemorySim(const char *name);
     ~MemorySim();
@@ -25,6 +35,8 @@ public:
 
     /** IMemoryOperation */
     virtual void b_transport(Axi4TransactionType *trans);
+    virtual void b_transport_burst(Axi4BurstTransactionType *trans);
+    virtual bool get_direct_mem_ptr(uint64_t addr, DmiRegionType *dmi);
     
     virtual uint64_t getBaseAddress() {
         return baseAddress_.to_uint64();
@@ -33,17 +45,44 @@ public:
         return length_.to_uint64();
     }
 
+    /** IMemoryTracker */
+    virtual bool getMemory(DmiRegionType *dmi);
+    virtual void setTrackListener(IMemoryTrackListener *listener);
+    virtual void clearDirty();
+
 private:
     static const int SYMB_IN_LINE = 16/2;
     bool chishex(int s);
+    /** Report the first write into the clean pages of the range */
+    void trackWrite(uint64_t off, uint64_t len);
     uint8_t chtohex(int s);
 
+    /** Reserve zero-filled array with the lazy pages commit */
+    uint8_t *allocMemory(uint64_t size);
+    void freeMemory();
+    /** Map raw image at the beginning of the array, writes aren't saved */
+    bool mapImage(const char *filename);
+
+    /** Read-only view of the whole InitFile */
+    uint8_t *openImage(const char *filename, uint64_t *size);
+    void closeImage(uint8_t *buf, uint64_t size);
+    /** Image loaders return number of written bytes */
+    uint64_t loadHex(const uint8_t *buf, uint64_t sz);
+    uint64_t loadRaw(const uint8_t *buf, uint64_t sz);
+    uint64_t loadElf(const uint8_t *buf, uint64_t sz);
+
 private:
     AttributeType initFile_;
     AttributeType readOnly_;
     AttributeType baseAddress_;
     AttributeType length_;
+    AttributeType mappedFile_;
+    AttributeType hugePages_;
     uint8_t *mem_;
+    uint64_t memSize_;          // reserved size aligned to the host page
+    IMemoryTrackListener *tracker_;
+    uint8_t *dirty_;            // per tracked page flags
+    uint64_t pageTotal_;
 };
 
 DECLARE_CLASS(MemorySim)
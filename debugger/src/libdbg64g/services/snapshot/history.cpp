@@ -0,0 +1,269 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      In-memory checkpoints and log of the external inputs.
+ */
+
+#include "history.h"
+#include <string.h>
+
+namespace debugger {
+
+static uint64_t attrBytes(const AttributeType *a) {
+    uint64_t ret = sizeof(AttributeType);
+    if (a->is_data() || a->is_string()) {
+        ret += a->size();
+    } else if (a->is_list()) {
+        for (unsigned i = 0; i < a->size(); i++) {
+            ret += attrBytes(&(*a)[i]);
+        }
+    } else if (a->is_dict()) {
+        for (unsigned i = 0; i < a->size(); i++) {
+            ret += attrBytes(a->dict_key(i)) + attrBytes(a->dict_value(i));
+        }
+    }
+    return ret;
+}
+
+ReplayHistoryType::ReplayHistoryType() {
+    regionTotal_ = 0;
+    oldest_ = 0;
+    newest_ = 0;
+    pending_ = 0;
+    pendingBytes_ = 0;
+    inputs_ = 0;
+    inputsTail_ = 0;
+    replay_ = 0;
+    inputSeq_ = 0;
+    bytes_ = 0;
+    budget_ = 0;
+}
+
+ReplayHistoryType::~ReplayHistoryType() {
+    clear();
+}
+
+void ReplayHistoryType::clear() {
+    while (newest_) {
+        CheckpointType *cp = newest_;
+        newest_ = cp->older;
+        freePages(&cp->undo);
+        delete cp;
+    }
+    oldest_ = 0;
+    freePages(&pending_);
+    pendingBytes_ = 0;
+    replay_ = inputs_;
+    truncateInputs();
+    for (unsigned i = 0; i < regionTotal_; i++) {
+        delete [] regions_[i].saved;
+    }
+    regionTotal_ = 0;
+    bytes_ = 0;
+}
+
+CheckpointType *ReplayHistoryType::find(uint64_t t) {
+    CheckpointType *cp = newest_;
+    while (cp && cp->step > t) {
+        cp = cp->older;
+    }
+    return cp;
+}
+
+void ReplayHistoryType::captureRegions(const DmiRegionType *region,
+                                       unsigned total) {
+    for (unsigned i = 0; i < total && i < HISTORY_REGION_MAX; i++) {
+        RegionType &r = regions_[i];
+        uint64_t pages = (region[i].length + HISTORY_PAGE_BYTES - 1)
+                       / HISTORY_PAGE_BYTES;
+        r.ptr = region[i].ptr;
+        r.length = region[i].length;
+        r.saved = new uint8_t[static_cast<size_t>(pages)];
+        memset(r.saved, 0, static_cast<size_t>(pages));
+        bytes_ += pages;
+        regionTotal_++;
+    }
+}
+
+void ReplayHistoryType::addCheckpoint(uint64_t t,
+                                      const DmiRegionType *region,
+                                      unsigned total,
+                                      const AttributeType *state) {
+    CheckpointType *cp = new CheckpointType;
+    cp->older = newest_;
+    cp->newer = 0;
+    cp->step = t;
+    cp->input_seq = replay_ ? replay_->seq : inputSeq_;
+    cp->state = *state;
+    cp->undo = pending_;
+    cp->bytes = sizeof(CheckpointType) + attrBytes(state) + pendingBytes_;
+    pending_ = 0;
+    bytes_ -= pendingBytes_;
+    pendingBytes_ = 0;
+
+    if (newest_ == 0) {
+        captureRegions(region, total);
+        oldest_ = cp;
+    } else {
+        newest_->newer = cp;
+    }
+    newest_ = cp;
+    clearMarks();
+    bytes_ += cp->bytes;
+    trim();
+}
+
+/** Previous content is saved only once per checkpoint interval */
+void ReplayHistoryType::pageWrite(unsigned r, uint64_t off) {
+    if (newest_ == 0 || r >= regionTotal_) {
+        return;
+    }
+    uint8_t &saved = regions_[r].saved[off / HISTORY_PAGE_BYTES];
+    if (saved) {
+        return;
+    }
+    saved = 1;
+    UndoPageType *page = new UndoPageType;
+    page->region = r;
+    page->off = off;
+    memcpy(page->data, &regions_[r].ptr[off], pageSize(r, off));
+    page->next = pending_;
+    pending_ = page;
+    pendingBytes_ += sizeof(UndoPageType);
+    bytes_ += sizeof(UndoPageType);
+    trim();
+}
+
+void ReplayHistoryType::rollback(CheckpointType *cp) {
+    // Memory of the newest checkpoint
+    restorePages(pending_);
+    freePages(&pending_);
+    bytes_ -= pendingBytes_;
+    pendingBytes_ = 0;
+
+    while (newest_ != cp) {
+        CheckpointType *t = newest_;
+        restorePages(t->undo);
+        newest_ = t->older;
+        newest_->newer = 0;
+        bytes_ -= t->bytes;
+        freePages(&t->undo);
+        delete t;
+    }
+    clearMarks();
+
+    replay_ = inputs_;
+    while (replay_ && replay_->seq < cp->input_seq) {
+        replay_ = replay_->next;
+    }
+}
+
+void ReplayHistoryType::addInput(uint64_t t, IReplayInput *dst,
+                                 const AttributeType *data) {
+    if (newest_ == 0) {
+        // Nothing to replay from
+        return;
+    }
+    truncateInputs();
+
+    InputEntryType *e = new InputEntryType;
+    e->next = 0;
+    e->step = t;
+    e->seq = inputSeq_++;
+    e->dst = dst;
+    e->data = *data;
+    e->bytes = sizeof(InputEntryType) + attrBytes(data);
+    if (inputsTail_) {
+        inputsTail_->next = e;
+    } else {
+        inputs_ = e;
+    }
+    inputsTail_ = e;
+    bytes_ += e->bytes;
+    trim();
+}
+
+/** Remove inputs starting from the replay position */
+void ReplayHistoryType::truncateInputs() {
+    if (replay_ == 0) {
+        return;
+    }
+    InputEntryType *last = 0;
+    if (replay_ != inputs_) {
+        last = inputs_;
+        while (last->next != replay_) {
+            last = last->next;
+        }
+        last->next = 0;
+    } else {
+        inputs_ = 0;
+    }
+    inputsTail_ = last;
+    while (replay_) {
+        InputEntryType *e = replay_;
+        replay_ = e->next;
+        bytes_ -= e->bytes;
+        delete e;
+    }
+}
+
+void ReplayHistoryType::restorePages(UndoPageType *list) {
+    for (UndoPageType *p = list; p; p = p->next) {
+        memcpy(&regions_[p->region].ptr[p->off], p->data,
+               pageSize(p->region, p->off));
+    }
+}
+
+void ReplayHistoryType::freePages(UndoPageType **list) {
+    while (*list) {
+        UndoPageType *p = *list;
+        *list = p->next;
+        delete p;
+    }
+}
+
+void ReplayHistoryType::clearMarks() {
+    for (unsigned i = 0; i < regionTotal_; i++) {
+        uint64_t pages = (regions_[i].length + HISTORY_PAGE_BYTES - 1)
+                       / HISTORY_PAGE_BYTES;
+        memset(regions_[i].saved, 0, static_cast<size_t>(pages));
+    }
+}
+
+/**
+ * Undo pages of the next checkpoint restore the oldest one only, so they
+ * are removed too.
+ */
+void ReplayHistoryType::removeOldest() {
+    CheckpointType *cp = oldest_;
+    CheckpointType *next = cp->newer;
+    while (inputs_ && inputs_->seq < next->input_seq) {
+        InputEntryType *e = inputs_;
+        inputs_ = e->next;
+        bytes_ -= e->bytes;
+        delete e;
+    }
+    if (inputs_ == 0) {
+        inputsTail_ = 0;
+    }
+
+    uint64_t undo_bytes = 0;
+    for (UndoPageType *p = next->undo; p; p = p->next) {
+        undo_bytes += sizeof(UndoPageType);
+    }
+    freePages(&next->undo);
+    next->bytes -= undo_bytes;
+    next->older = 0;
+    oldest_ = next;
+    bytes_ -= cp->bytes + undo_bytes;
+    delete cp;
+}
+
+void ReplayHistoryType::trim() {
+    while (bytes_ > budget_ && oldest_ != newest_) {
+        removeOldest();
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      In-memory checkpoints and log of the external inputs.
+ *
+ * @details    Memory reports the first write into each page after the
+ *             checkpoint, so the previous content of the page is saved
+ *             before it is modified. These undo pages are attached to the
+ *             next checkpoint, so older checkpoint is restored by rolling
+ *             the pages back checkpoint by checkpoint. The oldest
+ *             checkpoint and inputs logged before the next one are dropped
+ *             when the history (states, pages, inputs and page flags)
+ *             exceeds the budget.
+ */
+
+#ifndef __DEBUGGER_SNAPSHOT_HISTORY_H__
+#define __DEBUGGER_SNAPSHOT_HISTORY_H__
+
+#include "attribute.h"
+#include "coreservices/imemtracker.h"
+#include "coreservices/ireplay.h"
+
+namespace debugger {
+
+static const unsigned HISTORY_PAGE_BYTES = TRACK_PAGE_BYTES;
+static const unsigned HISTORY_REGION_MAX = 64;
+
+struct UndoPageType {
+    UndoPageType *next;
+    unsigned region;
+    uint64_t off;
+    uint8_t data[HISTORY_PAGE_BYTES];
+};
+
+struct CheckpointType {
+    CheckpointType *older;
+    CheckpointType *newer;
+    uint64_t step;
+    uint64_t input_seq;         // first input applied after the checkpoint
+    AttributeType state;        // models state
+    UndoPageType *undo;         // pages of the previous checkpoint
+    uint64_t bytes;
+};
+
+struct InputEntryType {
+    InputEntryType *next;
+    uint64_t step;
+    uint64_t seq;
+    IReplayInput *dst;
+    AttributeType data;
+    uint64_t bytes;
+};
+
+class ReplayHistoryType {
+ public:
+    ReplayHistoryType();
+    ~ReplayHistoryType();
+
+    void setBudget(uint64_t bytes) { budget_ = bytes; }
+    bool isEmpty() { return newest_ == 0; }
+    CheckpointType *oldest() { return oldest_; }
+    CheckpointType *newest() { return newest_; }
+
+    /** Latest checkpoint taken at step 't' or before it */
+    CheckpointType *find(uint64_t t);
+
+    /** Remove checkpoints, inputs and the saved pages */
+    void clear();
+
+    /**
+     * Memory regions are captured by the first checkpoint. Pages written
+     * since the previous checkpoint are attached to the new one, the
+     * caller starts the next tracking interval.
+     */
+    void addCheckpoint(uint64_t t, const DmiRegionType *region,
+                       unsigned total, const AttributeType *state);
+
+    /** The first write into the page since the latest checkpoint */
+    void pageWrite(unsigned r, uint64_t off);
+
+    /**
+     * Memory is restored to the checkpoint content, newer checkpoints are
+     * removed and inputs logged after it are queued to replay. The caller
+     * starts the next tracking interval.
+     */
+    void rollback(CheckpointType *cp);
+
+    /** Inputs that weren't replayed yet are removed as the new one differs */
+    void addInput(uint64_t t, IReplayInput *dst, const AttributeType *data);
+
+    /** Next input to replay or NULL */
+    InputEntryType *nextInput() { return replay_; }
+    void skipInput() { replay_ = replay_->next; }
+
+ private:
+    unsigned pageSize(unsigned r, uint64_t off) {
+        uint64_t rest = regions_[r].length - off;
+        return rest < HISTORY_PAGE_BYTES
+            ? static_cast<unsigned>(rest) : HISTORY_PAGE_BYTES;
+    }
+    void captureRegions(const DmiRegionType *region, unsigned total);
+    void restorePages(UndoPageType *list);
+    void freePages(UndoPageType **list);
+    void clearMarks();
+    void removeOldest();
+    void truncateInputs();
+    void trim();
+
+ private:
+    struct RegionType {
+        uint8_t *ptr;
+        uint8_t *saved;         // page was saved since the latest checkpoint
+        uint64_t length;
+    };
+
+    RegionType regions_[HISTORY_REGION_MAX];
+    unsigned regionTotal_;
+    CheckpointType *oldest_;
+    CheckpointType *newest_;
+    UndoPageType *pending_;     // pages of the newest checkpoint
+    uint64_t pendingBytes_;
+    InputEntryType *inputs_;
+    InputEntryType *inputsTail_;
+    InputEntryType *replay_;
+    uint64_t inputSeq_;
+    uint64_t bytes_;
+    uint64_t budget_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SNAPSHOT_HISTORY_H__
@@ -0,0 +1,814 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Snapshot of the simulated platform.
+ */
+
+#include "snapshot.h"
+#include "coreservices/ibus.h"
+#include "coreservices/icpuriscv.h"
+#include <string.h>
+#include <string>
+#if defined(_WIN32) || defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <sys/types.h>
+    #include <sys/mman.h>
+#endif
+
+namespace debugger {
+
+/** Class registration in the Core */
+REGISTER_CLASS(SnapshotService)
+
+static const char SNAPSHOT_MAGIC[8] = {'R', 'V', 'S', 'N', 'A', 'P', 0, 0};
+
+static int seekFile(FILE *fp, uint64_t off) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return _fseeki64(fp, static_cast<__int64>(off), SEEK_SET);
+#else
+    return fseeko(fp, static_cast<off_t>(off), SEEK_SET);
+#endif
+}
+
+/** File size or 0 on error */
+static uint64_t fileSize(FILE *fp) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    if (_fseeki64(fp, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    __int64 sz = _ftelli64(fp);
+#else
+    if (fseeko(fp, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    off_t sz = ftello(fp);
+#endif
+    return sz < 0 ? 0 : static_cast<uint64_t>(sz);
+}
+
+static bool isInFile(uint64_t off, uint64_t len, uint64_t fsize) {
+    return off <= fsize && len <= fsize - off;
+}
+
+static bool isZeroPage(const uint8_t *p, unsigned sz) {
+    const uint64_t *p64 = reinterpret_cast<const uint64_t *>(p);
+    for (unsigned i = 0; i < sz / 8; i++) {
+        if (p64[i]) {
+            return false;
+        }
+    }
+    for (unsigned i = sz & ~7u; i < sz; i++) {
+        if (p[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SnapshotService::SnapshotService(const char *name)
+    : IService(name), IHap(HAP_ConfigDone) {
+    registerInterface(static_cast<ISnapshotControl *>(this));
+    registerInterface(static_cast<IInputRecorder *>(this));
+    registerInterface(static_cast<IReverseControl *>(this));
+    registerInterface(static_cast<IMemoryTrackListener *>(this));
+    registerInterface(static_cast<IHap *>(this));
+    registerAttribute("Clock", &clock_);
+    registerAttribute("CheckpointInterval", &checkpointInterval_);
+    registerAttribute("CheckpointBudget", &checkpointBudget_);
+
+    clock_.make_string("");
+    checkpointInterval_.make_uint64(0);
+    checkpointBudget_.make_uint64(64 << 20);
+    filename_.make_string("");
+    lastFile_.make_string("");
+    memset(unsaved_, 0, sizeof(unsaved_));
+    iclk_ = 0;
+    ihart_ = 0;
+    request_ = Request_None;
+    reverseSteps_ = 0;
+    status_ = Snapshot_Ok;
+    tracking_ = false;
+    trackedTotal_ = 0;
+    nextCheckpoint_ = ~0ull;
+    scheduled_ = ~0ull;
+    resetHistory_ = 0;
+    inputs_.make_list(0);
+    reverse_ = Reverse_None;
+    reverseFrom_ = 0;
+    reverseStart_ = 0;
+    reverseEnd_ = 0;
+
+    AttributeType t1;
+    RISCV_generate_name(&t1);
+    RISCV_event_create(&done_, t1.to_string());
+    RISCV_mutex_init(&mutexInput_);
+    RISCV_register_hap(static_cast<IHap *>(this));
+}
+
+SnapshotService::~SnapshotService() {
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        delete [] unsaved_[i];
+    }
+    RISCV_event_close(&done_);
+    RISCV_mutex_destroy(&mutexInput_);
+}
+
+void SnapshotService::postinitService() {
+    iclk_ = static_cast<IClock *>(
+        RISCV_get_service_iface(clock_.to_string(), IFACE_CLOCK));
+    if (!iclk_) {
+        RISCV_error("Can't find IClock interface %s", clock_.to_string());
+        return;
+    }
+    if (checkpointInterval_.to_uint64() == 0) {
+        return;
+    }
+    ihart_ = static_cast<IReplayHart *>(
+        RISCV_get_service_iface(clock_.to_string(), IFACE_REPLAY_HART));
+    if (!ihart_) {
+        RISCV_error("Reverse execution isn't supported by %s",
+                    clock_.to_string());
+    }
+}
+
+/**
+ * Writes are tracked from the start for the file snapshots, the first
+ * checkpoint is taken after the hart was started.
+ */
+void SnapshotService::hapTriggered(IFace *isrc, EHapType type,
+                                   const char *descr) {
+    startTracking();
+    resetHistory();
+}
+
+bool SnapshotService::save(const char *filename, bool wait) {
+    return request(Request_Save, filename, wait);
+}
+
+bool SnapshotService::restore(const char *filename, bool wait) {
+    return request(Request_Restore, filename, wait);
+}
+
+bool SnapshotService::reverseStep(uint64_t steps) {
+    reverseSteps_ = steps;
+    return request(Request_ReverseStep, "", true);
+}
+
+bool SnapshotService::reverseContinue() {
+    return request(Request_ReverseContinue, "", true);
+}
+
+/**
+ * Platform state is consistent only at the instruction boundary, so the
+ * request is executed by the step callback in the CPU thread. It works
+ * for the halted CPU too. Requests are rejected while other harts run.
+ */
+bool SnapshotService::request(ERequest req, const char *filename, bool wait) {
+    if (!iclk_ || status_ == Snapshot_Busy) {
+        return false;
+    }
+    filename_.make_string(filename);
+    RISCV_event_clear(&done_);
+    status_ = Snapshot_Busy;
+    request_ = req;
+    iclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                iclk_->getStepCounter());
+    if (!wait) {
+        return true;
+    }
+    RISCV_event_wait(&done_);
+    return status_ == Snapshot_Ok;
+}
+
+/**
+ * The same callback executes requests, applies inputs and maintains the
+ * history, so there's at most one pending history callback (scheduled_).
+ */
+void SnapshotService::stepCallback(uint64_t t) {
+    if (t >= scheduled_) {
+        scheduled_ = ~0ull;
+    }
+    if (RISCV_atomic_xchg64(&resetHistory_, 0)) {
+        clearHistory(0);
+    }
+    if (request_ != Request_None) {
+        executeRequest(t);
+        t = iclk_->getStepCounter();
+    }
+    applyInputs(t);
+    updateHistory(t);
+}
+
+void SnapshotService::executeRequest(uint64_t t) {
+    ERequest req = request_;
+    bool ok;
+    request_ = Request_None;
+    if (isOtherHartRunning()) {
+        finish(false);
+        return;
+    }
+    switch (req) {
+    case Request_Save:
+        finish(saveFile(filename_.to_string()));
+        break;
+    case Request_Restore:
+        ok = restoreFile(filename_.to_string());
+        // Memory and the CPU queue were replaced
+        clearHistory(iclk_->getStepCounter());
+        finish(ok);
+        break;
+    case Request_ReverseStep:
+    case Request_ReverseContinue:
+        if (history_.isEmpty()) {
+            RISCV_error("No checkpoints to reverse execution", NULL);
+            finish(false);
+            break;
+        }
+        reverseFrom_ = t;
+        if (req == Request_ReverseStep) {
+            seek(reverseSteps_ < t ? t - reverseSteps_ : 0);
+        } else {
+            searchBefore(t);
+        }
+        break;
+    default:;
+    }
+}
+
+/** Other harts would modify memory while it is being saved or replaced */
+bool SnapshotService::isOtherHartRunning() {
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_CPU_RISCV, &lstServ);
+    for (unsigned i = 0; i < lstServ.size(); i++) {
+        IService *iserv = static_cast<IService *>(lstServ[i].to_iface());
+        ICpuRiscV *icpu = static_cast<ICpuRiscV *>(
+                            iserv->getInterface(IFACE_CPU_RISCV));
+        if (strcmp(iserv->getObjName(), clock_.to_string()) == 0
+            || icpu->isHalted()) {
+            continue;
+        }
+        RISCV_error("Halt '%s' before the snapshot request",
+                    iserv->getObjName());
+        return true;
+    }
+    return false;
+}
+
+void SnapshotService::finish(bool ok) {
+    status_ = ok ? Snapshot_Ok : Snapshot_Error;
+    RISCV_event_set(&done_);
+}
+
+/** Any thread: input is applied and logged by the step callback */
+void SnapshotService::putInput(IReplayInput *dst, const AttributeType *data) {
+    if (!isRecording()) {
+        dst->replayInput(data);
+        return;
+    }
+    AttributeType item;
+    item.make_list(2);
+    item[0u].make_iface(dst);
+    item[1] = *data;
+    RISCV_mutex_lock(&mutexInput_);
+    inputs_.add_to_list(&item);
+    RISCV_mutex_unlock(&mutexInput_);
+    iclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                iclk_->getStepCounter());
+}
+
+/** CPU thread only */
+void SnapshotService::recordInput(IReplayInput *dst,
+                                  const AttributeType *data) {
+    if (isRecording()) {
+        history_.addInput(iclk_->getStepCounter(), dst, data);
+    }
+}
+
+/**
+ * Called by the hart thread right after reset, so the callback time is
+ * counted from the zero step.
+ */
+void SnapshotService::resetHistory() {
+    if (!iclk_ || !isRecording()
+        || RISCV_atomic_xchg64(&resetHistory_, 1) != 0) {
+        return;
+    }
+    iclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                checkpointInterval_.to_uint64());
+}
+
+/** Inputs arrived during the reverse execution wait for its end */
+void SnapshotService::applyInputs(uint64_t t) {
+    if (reverse_ != Reverse_None) {
+        return;
+    }
+    AttributeType list;
+    RISCV_mutex_lock(&mutexInput_);
+    if (inputs_.size()) {
+        list = inputs_;
+        inputs_.make_list(0);
+    }
+    RISCV_mutex_unlock(&mutexInput_);
+    for (unsigned i = 0; i < list.size(); i++) {
+        IReplayInput *dst = static_cast<IReplayInput *>(list[i][0u].to_iface());
+        history_.addInput(t, dst, &list[i][1]);
+        dst->replayInput(&list[i][1]);
+    }
+}
+
+/**
+ * Logged inputs are replayed at the same steps, checkpoints are re-taken
+ * during the replay. Rollback moves the step counter back, so the loop
+ * repeats until nothing is due.
+ */
+void SnapshotService::updateHistory(uint64_t t) {
+    while (1) {
+        InputEntryType *e = history_.nextInput();
+        if (e && e->step <= t) {
+            history_.skipInput();
+            e->dst->replayInput(&e->data);
+            continue;
+        }
+        if (t >= nextCheckpoint_) {
+            takeCheckpoint(t);
+        }
+        if (reverse_ != Reverse_None && t >= reverseEnd_) {
+            updateReverse(t);
+            t = iclk_->getStepCounter();
+            applyInputs(t);
+            continue;
+        }
+        break;
+    }
+    scheduleNext();
+}
+
+void SnapshotService::scheduleNext() {
+    uint64_t next = nextCheckpoint_;
+    InputEntryType *e = history_.nextInput();
+    if (e && e->step < next) {
+        next = e->step;
+    }
+    if (reverse_ != Reverse_None && reverseEnd_ < next) {
+        next = reverseEnd_;
+    }
+    if (next < scheduled_) {
+        scheduled_ = next;
+        iclk_->registerStepCallback(static_cast<IClockListener *>(this),
+                                    next);
+    }
+}
+
+void SnapshotService::clearHistory(uint64_t t) {
+    history_.clear();
+    scheduled_ = ~0ull;
+    nextCheckpoint_ = ~0ull;
+    if (isRecording()) {
+        nextCheckpoint_ = t + checkpointInterval_.to_uint64();
+    }
+}
+
+void SnapshotService::takeCheckpoint(uint64_t t) {
+    DmiRegionType dmi[SECTION_MAX];
+    startTracking();
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        dmi[i] = tracked_[i].dmi;
+    }
+    AttributeType states;
+    saveStates(&states);
+    history_.setBudget(checkpointBudget_.to_uint64());
+    history_.addCheckpoint(t, dmi, trackedTotal_, &states);
+    clearDirty();
+    nextCheckpoint_ = t + checkpointInterval_.to_uint64();
+}
+
+/** All pages are unsaved until the first file is written or restored */
+void SnapshotService::startTracking() {
+    if (tracking_) {
+        return;
+    }
+    tracking_ = true;
+    unsigned total = getRegions(tracked_);
+    for (unsigned i = 0; i < total; i++) {
+        size_t pages = static_cast<size_t>(
+            (tracked_[i].dmi.length + PAGE_BYTES - 1) / PAGE_BYTES);
+        unsaved_[i] = new uint8_t[pages];
+        memset(unsaved_[i], 1, pages);
+    }
+    trackedTotal_ = total;
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        tracked_[i].imem->setTrackListener(
+            static_cast<IMemoryTrackListener *>(this));
+    }
+}
+
+/**
+ * Next write into each page is reported again. Harts drop the granted
+ * write pointers before they execute the next instruction.
+ */
+void SnapshotService::clearDirty() {
+    AttributeType lstBus;
+    RISCV_get_services_with_iface(IFACE_BUS, &lstBus);
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        tracked_[i].imem->clearDirty();
+        for (unsigned n = 0; n < lstBus.size(); n++) {
+            IService *iserv = static_cast<IService *>(lstBus[n].to_iface());
+            IBus *ibus = static_cast<IBus *>(iserv->getInterface(IFACE_BUS));
+            ibus->invalidate_direct_mem_ptr(tracked_[i].dmi.addr,
+                                            tracked_[i].dmi.length);
+        }
+    }
+}
+
+/** Called with the bus lock of the memory, writes come from the CPU thread */
+void SnapshotService::pageWrite(IMemoryTracker *imem, uint64_t off) {
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        if (tracked_[i].imem == imem) {
+            unsaved_[i][off / PAGE_BYTES] = 1;
+            history_.pageWrite(i, off);
+            return;
+        }
+    }
+}
+
+/**
+ * CPU queue is restored without this service callbacks. Restored pages
+ * aren't reported as writes, so the next save creates a new file.
+ */
+void SnapshotService::rollback(CheckpointType *cp) {
+    history_.rollback(cp);
+    lastFile_.make_string("");
+    clearDirty();
+    restoreStates(&cp->state);
+    nextCheckpoint_ = cp->step + checkpointInterval_.to_uint64();
+    scheduled_ = ~0ull;
+}
+
+void SnapshotService::seek(uint64_t target) {
+    CheckpointType *cp = history_.find(target);
+    if (!cp) {
+        cp = history_.oldest();
+        target = cp->step;
+        RISCV_info("Reached the oldest checkpoint [%" RV_PRI64 "d]", target);
+    }
+    reverse_ = Reverse_Seek;
+    reverseEnd_ = target;
+    rollback(cp);
+    ihart_->startReplay(target);
+}
+
+/**
+ * Replay from the latest checkpoint before 'end' finds the last hit in
+ * this interval. Without hits the previous interval is searched.
+ */
+void SnapshotService::searchBefore(uint64_t end) {
+    CheckpointType *cp = end ? history_.find(end - 1) : 0;
+    if (!cp) {
+        RISCV_info("Reached the oldest checkpoint [%" RV_PRI64 "d]",
+                   history_.oldest()->step);
+        seek(history_.oldest()->step);
+        return;
+    }
+    reverse_ = Reverse_Search;
+    reverseStart_ = cp->step;
+    reverseEnd_ = end;
+    rollback(cp);
+    ihart_->startReplay(end);
+}
+
+void SnapshotService::updateReverse(uint64_t t) {
+    uint64_t hit;
+    bool found = ihart_->stopReplay(&hit);
+    if (reverse_ == Reverse_Search) {
+        if (found) {
+            seek(hit);
+        } else {
+            searchBefore(reverseStart_);
+        }
+        return;
+    }
+    reverse_ = Reverse_None;
+    RISCV_info("Reversed from [%" RV_PRI64 "d] to [%" RV_PRI64 "d]",
+               reverseFrom_, t);
+    finish(true);
+}
+
+/** Writable memory with the tracked writes, ROM is loaded by InitFile */
+unsigned SnapshotService::getRegions(RegionType *region) {
+    AttributeType lstServ;
+    unsigned total = 0;
+    RISCV_get_services_with_iface(IFACE_MEMORY_TRACKER, &lstServ);
+    for (unsigned i = 0; i < lstServ.size(); i++) {
+        IService *iserv = static_cast<IService *>(lstServ[i].to_iface());
+        IMemoryTracker *imem = static_cast<IMemoryTracker *>(
+                            iserv->getInterface(IFACE_MEMORY_TRACKER));
+        DmiRegionType dmi;
+        if (!imem->getMemory(&dmi)) {
+            continue;
+        }
+        if (total == SECTION_MAX) {
+            RISCV_error("Too many memory regions, '%s' skipped",
+                        iserv->getObjName());
+            continue;
+        }
+        region[total].name = iserv->getObjName();
+        region[total].imem = imem;
+        region[total].dmi = dmi;
+        total++;
+    }
+    return total;
+}
+
+void SnapshotService::saveStates(AttributeType *states) {
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SNAPSHOT, &lstServ);
+    states->make_dict();
+    for (unsigned i = 0; i < lstServ.size(); i++) {
+        IService *iserv = static_cast<IService *>(lstServ[i].to_iface());
+        ISnapshot *isnap = static_cast<ISnapshot *>(
+                            iserv->getInterface(IFACE_SNAPSHOT));
+        AttributeType t1;
+        isnap->saveState(&t1);
+        (*states)[iserv->getObjName()] = t1;
+    }
+}
+
+void SnapshotService::restoreStates(const AttributeType *states) {
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SNAPSHOT, &lstServ);
+    for (unsigned i = 0; i < lstServ.size(); i++) {
+        IService *iserv = static_cast<IService *>(lstServ[i].to_iface());
+        ISnapshot *isnap = static_cast<ISnapshot *>(
+                            iserv->getInterface(IFACE_SNAPSHOT));
+        if (!states->has_key(iserv->getObjName())) {
+            RISCV_error("State of '%s' not found", iserv->getObjName());
+            continue;
+        }
+        isnap->restoreState(&(*states)[iserv->getObjName()]);
+    }
+}
+
+bool SnapshotService::isSameLayout(const SnapshotHeaderType *a,
+                                   const SnapshotHeaderType *b) {
+    if (memcmp(a->magic, b->magic, sizeof(a->magic)) != 0
+        || a->version != b->version
+        || a->section_total != b->section_total) {
+        return false;
+    }
+    return memcmp(a->section, b->section,
+                  a->section_total * sizeof(SnapshotSectionType)) == 0;
+}
+
+bool SnapshotService::saveFile(const char *filename) {
+    uint64_t t_start = RISCV_get_time_ms();
+    const RegionType *region = tracked_;
+    unsigned total = trackedTotal_;
+
+    SnapshotHeaderType hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = FILE_VERSION;
+    hdr.section_total = total;
+    uint64_t off = SECTION_ALIGN;
+    for (unsigned i = 0; i < total; i++) {
+        SnapshotSectionType &sec = hdr.section[i];
+        strncpy(sec.name, region[i].name, sizeof(sec.name) - 1);
+        sec.addr = region[i].dmi.addr;
+        sec.length = region[i].dmi.length;
+        sec.offset = off;
+        off += (sec.length + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1);
+    }
+
+    AttributeType states;
+    saveStates(&states);
+    std::string text(states.to_config());
+    hdr.state_offset = off;
+    hdr.state_length = text.size();
+
+    // The last file with the same layout: update it in place
+    SnapshotHeaderType old;
+    bool incremental = false;
+    FILE *fp = 0;
+    if (strcmp(filename, lastFile_.to_string()) == 0) {
+        fp = fopen(filename, "r+b");
+    }
+    if (fp) {
+        incremental = fread(&old, 1, sizeof(old), fp) == sizeof(old)
+                    && isSameLayout(&old, &hdr);
+        if (!incremental) {
+            fclose(fp);
+            fp = NULL;
+        }
+    }
+    // Otherwise create new file. Renaming keeps the old file alive while
+    // it is still mapped by the previous restore.
+    std::string tmpname(filename);
+    if (!incremental) {
+        tmpname += ".tmp";
+        fp = fopen(tmpname.c_str(), "w+b");
+        if (!fp) {
+            RISCV_error("Can't create file '%s'", tmpname.c_str());
+            return false;
+        }
+    }
+
+    uint64_t written = 0;
+    uint64_t length = 0;
+    for (unsigned i = 0; i < total; i++) {
+        written += writeSection(fp, &hdr.section[i], region[i].dmi.ptr,
+                                incremental ? unsaved_[i] : 0);
+        length += hdr.section[i].length;
+    }
+    seekFile(fp, hdr.state_offset);
+    fwrite(text.c_str(), 1, text.size(), fp);
+    seekFile(fp, 0);
+    bool ok = fwrite(&hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok && !incremental) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+        remove(filename);
+#endif
+        ok = rename(tmpname.c_str(), filename) == 0;
+    }
+    if (!ok) {
+        RISCV_error("Can't write file '%s'", filename);
+        return false;
+    }
+    markSaved(filename);
+    RISCV_info("Snapshot '%s': %" RV_PRI64 "d of %" RV_PRI64 "d KB "
+               "written in %" RV_PRI64 "d ms",
+               filename, written >> 10, length >> 10,
+               RISCV_get_time_ms() - t_start);
+    return true;
+}
+
+/**
+ * Memory and the file are equal, the next writes are reported again.
+ */
+void SnapshotService::markSaved(const char *filename) {
+    lastFile_.make_string(filename);
+    for (unsigned i = 0; i < trackedTotal_; i++) {
+        memset(unsaved_[i], 0, static_cast<size_t>(
+            (tracked_[i].dmi.length + PAGE_BYTES - 1) / PAGE_BYTES));
+    }
+    clearDirty();
+}
+
+/**
+ * Only unsaved pages are written into the existing file, zero pages of
+ * the new file (unsaved == 0) are left as holes.
+ */
+uint64_t SnapshotService::writeSection(FILE *fp,
+                                       const SnapshotSectionType *sec,
+                                       const uint8_t *ptr,
+                                       const uint8_t *unsaved) {
+    uint64_t written = 0;
+    for (uint64_t off = 0; off < sec->length; off += PAGE_BYTES) {
+        unsigned sz = PAGE_BYTES;
+        if (sec->length - off < PAGE_BYTES) {
+            sz = static_cast<unsigned>(sec->length - off);
+        }
+        if (unsaved) {
+            if (!unsaved[off / PAGE_BYTES]) {
+                continue;
+            }
+        } else if (isZeroPage(&ptr[off], sz)) {
+            continue;
+        }
+        seekFile(fp, sec->offset + off);
+        fwrite(&ptr[off], 1, sz, fp);
+        written += sz;
+    }
+    return written;
+}
+
+bool SnapshotService::restoreFile(const char *filename) {
+    uint64_t t_start = RISCV_get_time_ms();
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        RISCV_error("File '%s' not found", filename);
+        return false;
+    }
+    SnapshotHeaderType hdr;
+    if (fread(&hdr, 1, sizeof(hdr), fp) != sizeof(hdr)
+        || memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic)) != 0
+        || hdr.version != FILE_VERSION || hdr.section_total > SECTION_MAX) {
+        RISCV_error("Wrong snapshot file '%s'", filename);
+        fclose(fp);
+        return false;
+    }
+
+    // Check layout and ranges before anything is modified. Truncated file
+    // can't be detected by the mapped section until its page is accessed.
+    const RegionType *region = tracked_;
+    unsigned total = trackedTotal_;
+    uint64_t fsize = fileSize(fp);
+    uint8_t *ptr[SECTION_MAX];
+    if (!isInFile(hdr.state_offset, hdr.state_length, fsize)) {
+        RISCV_error("Snapshot file '%s' is truncated", filename);
+        fclose(fp);
+        return false;
+    }
+    for (unsigned i = 0; i < hdr.section_total; i++) {
+        SnapshotSectionType &sec = hdr.section[i];
+        sec.name[sizeof(sec.name) - 1] = '\0';
+        ptr[i] = 0;
+        if (!isInFile(sec.offset, sec.length, fsize)) {
+            RISCV_error("Section '%s' is out of file '%s'",
+                        sec.name, filename);
+            fclose(fp);
+            return false;
+        }
+        for (unsigned n = 0; n < total; n++) {
+            if (strncmp(sec.name, region[n].name, sizeof(sec.name) - 1) == 0
+                && sec.addr == region[n].dmi.addr
+                && sec.length == region[n].dmi.length) {
+                ptr[i] = region[n].dmi.ptr;
+                break;
+            }
+        }
+        if (!ptr[i]) {
+            RISCV_error("Memory '%s' doesn't match snapshot", sec.name);
+            fclose(fp);
+            return false;
+        }
+    }
+    char *text = new char[hdr.state_length + 1];
+    if (!readAt(fp, hdr.state_offset, text, hdr.state_length)) {
+        RISCV_error("Can't read models state from '%s'", filename);
+        delete [] text;
+        fclose(fp);
+        return false;
+    }
+    text[hdr.state_length] = '\0';
+
+    for (unsigned i = 0; i < hdr.section_total; i++) {
+        if (!loadSection(fp, &hdr.section[i], ptr[i])) {
+            // Models keep running state with the partially loaded memory
+            RISCV_error("Can't load '%s' section, memory is inconsistent, "
+                        "models state isn't restored", hdr.section[i].name);
+            lastFile_.make_string("");
+            delete [] text;
+            fclose(fp);
+            return false;
+        }
+    }
+    fclose(fp);
+
+    AttributeType states;
+    states.from_config(text);
+    delete [] text;
+    restoreStates(&states);
+    markSaved(filename);
+
+    RISCV_info("Snapshot '%s' restored in %" RV_PRI64 "d ms",
+               filename, RISCV_get_time_ms() - t_start);
+    return true;
+}
+
+bool SnapshotService::readAt(FILE *fp, uint64_t off, void *buf, uint64_t sz) {
+    if (seekFile(fp, off) != 0) {
+        return false;
+    }
+    return fread(buf, 1, static_cast<size_t>(sz), fp) == sz;
+}
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+bool SnapshotService::loadSection(FILE *fp, const SnapshotSectionType *sec,
+                                  uint8_t *ptr) {
+    return readAt(fp, sec->offset, ptr, sec->length);
+}
+#else
+/**
+ * Whole pages are replaced by the private file view, so they are read on
+ * demand and the restore time doesn't depend on the memory size.
+ */
+bool SnapshotService::loadSection(FILE *fp, const SnapshotSectionType *sec,
+                                  uint8_t *ptr) {
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t maplen = sec->length & ~(page - 1);
+    if ((reinterpret_cast<uint64_t>(ptr) & (page - 1)) != 0
+        || (sec->offset & (page - 1)) != 0) {
+        maplen = 0;
+    }
+    if (maplen) {
+        void *p = mmap(ptr, maplen, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED, fileno(fp),
+                       static_cast<off_t>(sec->offset));
+        if (p == MAP_FAILED) {
+            maplen = 0;
+        }
+    }
+    if (maplen == sec->length) {
+        return true;
+    }
+    return readAt(fp, sec->offset + maplen, &ptr[maplen],
+                  sec->length - maplen);
+}
+#endif
+
+}  // namespace debugger
@@ -0,0 +1,181 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Snapshot of the simulated platform.
+ *
+ * @details    File starts with the header and sections table, writable
+ *             memory regions follow as raw arrays aligned to 64 KB and the
+ *             models state is stored at the end in the config form.
+ *             The file written or restored last is updated in place and
+ *             only the pages modified since then are written.
+ *             On restore sections are mapped copy-on-write into memory
+ *             when the host allows.
+ *             Reverse execution restores the nearest in-memory checkpoint
+ *             and replays the logged inputs up to the requested step.
+ */
+
+#ifndef __DEBUGGER_SNAPSHOT_SERVICE_H__
+#define __DEBUGGER_SNAPSHOT_SERVICE_H__
+
+#include "api_core.h"
+#include "iclass.h"
+#include "iservice.h"
+#include "ihap.h"
+#include "coreservices/imemop.h"
+#include "coreservices/imemtracker.h"
+#include "coreservices/iclock.h"
+#include "coreservices/iclklistener.h"
+#include "coreservices/isnapshot.h"
+#include "coreservices/ireplay.h"
+#include "history.h"
+#include <stdio.h>
+
+namespace debugger {
+
+class SnapshotService : public IService,
+                        public ISnapshotControl,
+                        public IInputRecorder,
+                        public IReverseControl,
+                        public IMemoryTrackListener,
+                        public IClockListener,
+                        public IHap {
+public:
+    explicit SnapshotService(const char *name);
+    virtual ~SnapshotService();
+
+    /** IService interface */
+    virtual void postinitService();
+
+    /** ISnapshotControl */
+    virtual bool save(const char *filename, bool wait);
+    virtual bool restore(const char *filename, bool wait);
+    virtual int getStatus() { return status_; }
+
+    /** IInputRecorder */
+    virtual void putInput(IReplayInput *dst, const AttributeType *data);
+    virtual void recordInput(IReplayInput *dst, const AttributeType *data);
+    virtual void resetHistory();
+
+    /** IReverseControl */
+    virtual bool reverseStep(uint64_t steps);
+    virtual bool reverseContinue();
+
+    /** IMemoryTrackListener: undo page is saved for the history */
+    virtual void pageWrite(IMemoryTracker *imem, uint64_t off);
+
+    /** IClockListener: request is executed on the CPU thread */
+    virtual void stepCallback(uint64_t t);
+
+    /** IHap */
+    virtual void hapTriggered(IFace *isrc, EHapType type, const char *descr);
+
+private:
+    static const uint32_t FILE_VERSION = 1;
+    static const unsigned SECTION_MAX = 64;
+    static const uint64_t SECTION_ALIGN = 1 << 16;
+    static const unsigned PAGE_BYTES = 1 << 12;
+
+    struct SnapshotSectionType {
+        char name[48];
+        uint64_t addr;
+        uint64_t length;
+        uint64_t offset;
+    };
+
+    struct SnapshotHeaderType {
+        char magic[8];
+        uint32_t version;
+        uint32_t section_total;
+        uint64_t state_offset;
+        uint64_t state_length;
+        SnapshotSectionType section[SECTION_MAX];
+    };
+
+    struct RegionType {
+        const char *name;
+        IMemoryTracker *imem;
+        DmiRegionType dmi;
+    };
+
+    enum ERequest {
+        Request_None,
+        Request_Save,
+        Request_Restore,
+        Request_ReverseStep,
+        Request_ReverseContinue
+    };
+
+    enum EReverse {
+        Reverse_None,
+        Reverse_Search,     // looking for the latest hit before the end
+        Reverse_Seek        // moving to the end step
+    };
+
+    bool isRecording() {
+        return ihart_ && checkpointInterval_.to_uint64() != 0;
+    }
+    bool request(ERequest req, const char *filename, bool wait);
+    void executeRequest(uint64_t t);
+    void finish(bool ok);
+    void applyInputs(uint64_t t);
+    void updateHistory(uint64_t t);
+    void scheduleNext();
+    void clearHistory(uint64_t t);
+    void takeCheckpoint(uint64_t t);
+    void startTracking();
+    void clearDirty();
+    void markSaved(const char *filename);
+    bool isOtherHartRunning();
+    void rollback(CheckpointType *cp);
+    void seek(uint64_t target);
+    void searchBefore(uint64_t end);
+    void updateReverse(uint64_t t);
+    unsigned getRegions(RegionType *region);
+    void saveStates(AttributeType *states);
+    void restoreStates(const AttributeType *states);
+
+    bool saveFile(const char *filename);
+    bool restoreFile(const char *filename);
+    bool isSameLayout(const SnapshotHeaderType *a,
+                      const SnapshotHeaderType *b);
+    uint64_t writeSection(FILE *fp, const SnapshotSectionType *sec,
+                          const uint8_t *ptr, const uint8_t *unsaved);
+    bool loadSection(FILE *fp, const SnapshotSectionType *sec, uint8_t *ptr);
+    bool readAt(FILE *fp, uint64_t off, void *buf, uint64_t sz);
+
+private:
+    AttributeType clock_;
+    AttributeType checkpointInterval_;
+    AttributeType checkpointBudget_;
+    IClock *iclk_;
+    IReplayHart *ihart_;
+    AttributeType filename_;
+    volatile ERequest request_;
+    uint64_t reverseSteps_;
+    volatile int status_;
+    event_def done_;
+
+    bool tracking_;
+    RegionType tracked_[SECTION_MAX];   // memories reporting writes to us
+    unsigned trackedTotal_;
+    uint8_t *unsaved_[SECTION_MAX];     // pages modified since lastFile_
+    AttributeType lastFile_;
+    ReplayHistoryType history_;
+    uint64_t nextCheckpoint_;
+    uint64_t scheduled_;            // nearest registered step callback
+    volatile int64_t resetHistory_;
+    mutex_def mutexInput_;
+    AttributeType inputs_;          // [IReplayInput, data] not applied yet
+
+    EReverse reverse_;
+    uint64_t reverseFrom_;          // step of the request
+    uint64_t reverseStart_;         // checkpoint of the current search
+    uint64_t reverseEnd_;
+};
+
+DECLARE_CLASS(SnapshotService)
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SNAPSHOT_SERVICE_H__
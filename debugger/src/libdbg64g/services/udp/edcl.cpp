@@ -93,6 +93,15 @@ int EdclService::read(uint64_t addr, int bytes, uint8_t *obuf) {
                     rsp.control.response.seqidx,
                     rsp.control.response.len);
 
+        // Access error is reported with the request sequence id
+        if (rsp.control.response.nak
+            && rsp.control.response.seqidx == req.control.request.seqidx) {
+            RISCV_error("EDCL read error [%08x]", req.address);
+            seq_cnt_.make_uint64(seq_cnt_.to_uint64() + 1);
+            rd_bytes = TAP_ERROR;
+            break;
+        }
+
         // Retry with new sequence counter.
         if (rsp.control.response.nak) {
             RISCV_info("Sequence counter detected %d. Re-sending transaction.",
@@ -166,6 +175,15 @@ int EdclService::write(uint64_t addr, int bytes, uint8_t *ibuf) {
                     rsp.control.response.seqidx,
                     req.control.request.len);
 
+        // Access error is reported with the request sequence id
+        if (rsp.control.response.nak
+            && rsp.control.response.seqidx == req.control.request.seqidx) {
+            RISCV_error("EDCL write error [%08x]", req.address);
+            seq_cnt_.make_uint64(seq_cnt_.to_uint64() + 1);
+            wr_bytes = -1;
+            break;
+        }
+
         // Retry with new sequence counter.
         if (rsp.control.response.nak) {
             RISCV_info("Sequence counter detected %d. Re-sending transaction.",
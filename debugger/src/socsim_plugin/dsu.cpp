@@ -17,27 +17,60 @@ DSU::DSU(const char *name)  : IService(name) {
     registerAttribute("Length", &length_);
     registerAttribute("CPU", &cpu_);
     registerAttribute("Bus", &bus_);
+    registerAttribute("SnapshotFile", &snapshotFile_);
 
     baseAddress_.make_uint64(0);
     length_.make_uint64(0);
     cpu_.make_string("");
+    snapshotFile_.make_string("snapshot.bin");
+    isnapshot_ = 0;
     soft_reset_ = 0x0;  // Active LOW
+    cpu_selector_ = 0;
+    icpu_ = 0;
+    memset(&burst_, 0, sizeof(burst_));
 }
 
 DSU::~DSU() {
 }
 
 void DSU::postinitService() {
-    icpu_ = static_cast<ICpuRiscV *>(
-        RISCV_get_service_iface(cpu_.to_string(), IFACE_CPU_RISCV));
-    if (!icpu_) {
-        RISCV_error("Can't find ICpuRiscV interface %s", cpu_.to_string());
+    AttributeType names;
+    if (cpu_.is_list()) {
+        names = cpu_;
+    } else {
+        names.make_list(1);
+        names[0u] = cpu_;
+    }
+    icpuList_.make_list(0);
+    for (unsigned i = 0; i < names.size(); i++) {
+        ICpuRiscV *icpu = static_cast<ICpuRiscV *>(
+            RISCV_get_service_iface(names[i].to_string(), IFACE_CPU_RISCV));
+        if (!icpu) {
+            RISCV_error("Can't find ICpuRiscV interface %s",
+                        names[i].to_string());
+            continue;
+        }
+        AttributeType t1(icpu);
+        icpuList_.add_to_list(&t1);
+    }
+    icpu_ = 0;
+    if (icpuList_.size()) {
+        icpu_ = static_cast<ICpuRiscV *>(icpuList_[0u].to_iface());
     }
     ibus_ = static_cast<IBus *>(
         RISCV_get_service_iface(bus_.to_string(), IFACE_BUS));
     if (!ibus_) {
         RISCV_error("Can't find IBus interface %s", bus_.to_string());
     }
+
+    // Snapshot service is optional
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_SNAPSHOT_CONTROL, &lstServ);
+    if (lstServ.size() != 0) {
+        IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        isnapshot_ = static_cast<ISnapshotControl *>(
+                        iserv->getInterface(IFACE_SNAPSHOT_CONTROL));
+    }
 }
 
 void DSU::b_transport(Axi4TransactionType *trans) {
@@ -107,6 +140,57 @@ void DSU::nb_transport(Axi4TransactionType *trans, IAxi4NbResponse *cb) {
     }
 }
 
+void DSU::nb_transport_burst(Axi4BurstTransactionType *trans,
+                             IAxi4NbResponse *cb) {
+    burst_.trans = trans;
+    burst_.cb = cb;
+    burst_.off = 0;
+    burst_.beat.action = trans->action;
+    burst_.beat.xsize = trans->xsize;
+    burst_.beat.wstrb = (1u << trans->xsize) - 1;
+    burst_.beat.source_idx = trans->source_idx;
+    trans->response = MemResp_Valid;
+    nextBeat();
+}
+
+/**
+ * Beat answered synchronously (local registers) is continued in the loop
+ * to avoid recursion, otherwise the CPU thread continues the burst.
+ */
+void DSU::nextBeat() {
+    Axi4BurstTransactionType *trans = burst_.trans;
+    while (burst_.off < trans->len) {
+        burst_.beat.addr = trans->addr + burst_.off;
+        if (trans->action == MemAction_Write) {
+            memcpy(burst_.beat.wpayload.b8, &trans->payload[burst_.off],
+                   trans->xsize);
+        }
+        burst_.state = Beat_Issued;
+        nb_transport(&burst_.beat, static_cast<IAxi4NbResponse *>(this));
+        if (RISCV_atomic_cmpxchg32(&burst_.state, Beat_Issued, Beat_Returned)
+            == Beat_Issued) {
+            return;
+        }
+    }
+    burst_.cb->nb_response_burst(trans);
+}
+
+void DSU::nb_response(Axi4TransactionType *trans) {
+    Axi4BurstTransactionType *burst = burst_.trans;
+    if (burst->action == MemAction_Read) {
+        memcpy(&burst->payload[burst_.off], trans->rpayload.b8, trans->xsize);
+    }
+    if (trans->response == MemResp_Error) {
+        burst->response = MemResp_Error;
+    }
+    burst_.off += trans->xsize;
+    if (RISCV_atomic_cmpxchg32(&burst_.state, Beat_Issued, Beat_Completed)
+        == Beat_Issued) {
+        return;
+    }
+    nextBeat();
+}
+
 void DSU::nb_response_debug_port(DebugPortTransactionType *trans) {
     nb_trans_.p_axi_trans->response = MemResp_Valid;
     if (nb_trans_.p_axi_trans->xsize == 4
@@ -119,21 +203,34 @@ void DSU::nb_response_debug_port(DebugPortTransactionType *trans) {
 }
 
 void DSU::readLocal(uint64_t off, Axi4TransactionType *trans) {
+    BusUtilType util[CFG_NASTI_MASTER_TOTAL];
+    if ((off >> 3) >= 8 && (off >> 3) <= 13) {
+        ibus_->bus_utilization(util);
+    }
     switch (off >> 3) {
     case 0:
         trans->rpayload.b64[0] = soft_reset_;
         break;
+    case 3:
+        trans->rpayload.b64[0] = cpu_selector_;
+        break;
+    case 4:
+        trans->rpayload.b64[0] = Snapshot_Error;
+        if (isnapshot_) {
+            trans->rpayload.b64[0] = isnapshot_->getStatus();
+        }
+        break;
     case 8:
-        trans->rpayload.b64[0] = ibus_->bus_utilization()[0].w_cnt;
+        trans->rpayload.b64[0] = util[0].w_cnt;
         break;
     case 9:
-        trans->rpayload.b64[0] = ibus_->bus_utilization()[0].r_cnt;
+        trans->rpayload.b64[0] = util[0].r_cnt;
         break;
     case 12:
-        trans->rpayload.b64[0] = ibus_->bus_utilization()[2].w_cnt;
+        trans->rpayload.b64[0] = util[2].w_cnt;
         break;
     case 13:
-        trans->rpayload.b64[0] = ibus_->bus_utilization()[2].r_cnt;
+        trans->rpayload.b64[0] = util[2].r_cnt;
         break;
     default:
         trans->rpayload.b64[0] = 0;
@@ -155,14 +252,34 @@ void DSU::writeLocal(uint64_t off, Axi4TransactionType *trans) {
         wdata64_ = trans->wpayload.b64[0];
     }
     switch (off >> 3) {
-    case 0: // soft reset
-        if (wdata64_ & 0x1) {
-            icpu_->raiseSignal(CPU_SIGNAL_RESET);
-        } else {
-            icpu_->lowerSignal(CPU_SIGNAL_RESET);
+    case 0: // soft reset of all harts
+        for (unsigned i = 0; i < icpuList_.size(); i++) {
+            ICpuRiscV *icpu =
+                static_cast<ICpuRiscV *>(icpuList_[i].to_iface());
+            if (wdata64_ & 0x1) {
+                icpu->raiseSignal(CPU_SIGNAL_RESET);
+            } else {
+                icpu->lowerSignal(CPU_SIGNAL_RESET);
+            }
         }
         soft_reset_ = wdata64_;
         break;
+    case 3: // debug port of the selected hart
+        if (wdata64_ < icpuList_.size()) {
+            cpu_selector_ = wdata64_;
+            icpu_ = static_cast<ICpuRiscV *>(
+                        icpuList_[cpu_selector_].to_iface());
+        }
+        break;
+    case 4: // snapshot request is executed by the CPU thread later
+        if (!isnapshot_) {
+            RISCV_error("Snapshot service not found", NULL);
+        } else if (wdata64_ == 1) {
+            isnapshot_->save(snapshotFile_.to_string(), false);
+        } else if (wdata64_ == 2) {
+            isnapshot_->restore(snapshotFile_.to_string(), false);
+        }
+        break;
     default:;
     }
 }
@@ -8,6 +8,10 @@
  *             non-blocking it allows to interact with SystemC in the
  *             same manner as with the Functional model.
  * @note       CPU Functional model must implement non-blocking interface
+ *
+ *             Non-blocking burst (EDCL frame) is executed beat by beat
+ *             inside of DSU, each beat response from the CPU thread
+ *             starts the next one without returning to the initiator.
  */
 
 #ifndef __DEBUGGER_SOCSIM_PLUGIN_DSU_H__
@@ -19,12 +23,14 @@
 #include "coreservices/iwire.h"
 #include "coreservices/icpuriscv.h"
 #include "coreservices/ibus.h"
+#include "coreservices/isnapshot.h"
 
 namespace debugger {
 
 class DSU : public IService, 
             public IMemoryOperation,
-            public IDbgNbResponse {
+            public IDbgNbResponse,
+            public IAxi4NbResponse {
 public:
     DSU(const char *name);
     ~DSU();
@@ -36,8 +42,9 @@ public:
     virtual void b_transport(Axi4TransactionType *trans);
     virtual void nb_transport(Axi4TransactionType *trans,
                               IAxi4NbResponse *cb);
+    virtual void nb_transport_burst(Axi4BurstTransactionType *trans,
+                                    IAxi4NbResponse *cb);
 
-    
     virtual uint64_t getBaseAddress() {
         return baseAddress_.to_uint64();
     }
@@ -48,7 +55,12 @@ public:
     /** IDbgNbResponse */
     virtual void nb_response_debug_port(DebugPortTransactionType *trans);
 
+    /** IAxi4NbResponse: beat of the burst is finished */
+    virtual void nb_response(Axi4TransactionType *trans);
+
 private:
+    void nextBeat();
+
     void readLocal(uint64_t off, Axi4TransactionType *trans);
     void writeLocal(uint64_t off, Axi4TransactionType *trans);
 
@@ -57,7 +69,11 @@ private:
     AttributeType length_;
     AttributeType cpu_;
     AttributeType bus_;
-    ICpuRiscV *icpu_;
+    AttributeType icpuList_;
+    AttributeType snapshotFile_;
+    ISnapshotControl *isnapshot_;
+    ICpuRiscV *icpu_;           // selected hart
+    uint64_t cpu_selector_;
     IBus *ibus_;
     uint64_t shifter32_;
     uint64_t wdata64_;
@@ -68,6 +84,19 @@ private:
         IAxi4NbResponse *iaxi_cb;
         DebugPortTransactionType dbg_trans;
     } nb_trans_;
+
+    enum EBeatState {
+        Beat_Issued,        // waiting response
+        Beat_Completed,     // response was received before return
+        Beat_Returned       // nb_transport returned before response
+    };
+    struct burst_type {
+        Axi4BurstTransactionType *trans;
+        IAxi4NbResponse *cb;
+        uint32_t off;
+        Axi4TransactionType beat;
+        volatile int32_t state;
+    } burst_;
 };
 
 DECLARE_CLASS(DSU)
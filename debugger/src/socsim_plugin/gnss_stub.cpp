@@ -13,6 +13,7 @@ namespace debugger {
 GNSSStub::GNSSStub(const char *name)  : IService(name) {
     registerInterface(static_cast<IMemoryOperation *>(this));
     registerInterface(static_cast<IClockListener *>(this));
+    registerInterface(static_cast<ISnapshot *>(this));
     registerAttribute("BaseAddress", &baseAddress_);
     registerAttribute("Length", &length_);
     registerAttribute("IrqLine", &irqLine_);
@@ -83,5 +84,19 @@ void GNSSStub::stepCallback(uint64_t t) {
     }
 }
 
+void GNSSStub::saveState(AttributeType *state) {
+    state->make_dict();
+    (*state)["regs"].make_data(sizeof(regs_), &regs_);
+}
+
+void GNSSStub::restoreState(const AttributeType *state) {
+    const AttributeType &regs = (*state)["regs"];
+    if (regs.size() != sizeof(regs_)) {
+        RISCV_error("Wrong registers size in snapshot", NULL);
+        return;
+    }
+    memcpy(&regs_, regs.data(), sizeof(regs_));
+}
+
 }  // namespace debugger
 
@@ -11,6 +11,7 @@
 #include "iclass.h"
 #include "iservice.h"
 #include "coreservices/imemop.h"
+#include "coreservices/isnapshot.h"
 #include "coreservices/iclklistener.h"
 #include "coreservices/iclock.h"
 #include "coreservices/iwire.h"
@@ -19,7 +20,8 @@ namespace debugger {
 
 class GNSSStub : public IService, 
                  public IMemoryOperation,
-                 public IClockListener {
+                 public IClockListener,
+                 public ISnapshot {
 public:
     GNSSStub(const char *name);
     ~GNSSStub();
@@ -40,6 +42,10 @@ public:
     /** IClockListener */
     virtual void stepCallback(uint64_t t);
 
+    /** ISnapshot */
+    virtual void saveState(AttributeType *state);
+    virtual void restoreState(const AttributeType *state);
+
 private:
     uint64_t OFFSET(void *addr) {
         return reinterpret_cast<uint64_t>(addr)
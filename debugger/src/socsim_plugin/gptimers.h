@@ -11,6 +11,7 @@
 #include "iclass.h"
 #include "iservice.h"
 #include "coreservices/imemop.h"
+#include "coreservices/isnapshot.h"
 #include "coreservices/iclklistener.h"
 #include "coreservices/iclock.h"
 #include "coreservices/iwire.h"
@@ -19,7 +20,8 @@ namespace debugger {
 
 class GPTimers : public IService, 
                  public IMemoryOperation,
-                 public IClockListener {
+                 public IClockListener,
+                 public ISnapshot {
 public:
     GPTimers(const char *name);
     ~GPTimers();
@@ -40,6 +42,10 @@ public:
     /** IClockListener */
     virtual void stepCallback(uint64_t t);
 
+    /** ISnapshot */
+    virtual void saveState(AttributeType *state);
+    virtual void restoreState(const AttributeType *state);
+
 private:
     AttributeType baseAddress_;
     AttributeType length_;
@@ -18,6 +18,7 @@ Greth::Greth(const char *name)
     registerInterface(static_cast<IThread *>(this));
     registerInterface(static_cast<IMemoryOperation *>(this));
     registerInterface(static_cast<IAxi4NbResponse *>(this));
+    registerInterface(static_cast<IReplayInput *>(this));
     registerAttribute("BaseAddress", &baseAddress_);
     registerAttribute("Length", &length_);
     registerAttribute("IrqLine", &irqLine_);
@@ -38,6 +39,8 @@ Greth::Greth(const char *name)
 
     memset(txbuf_, 0, sizeof(txbuf_));
     seq_cnt_ = 35;
+    irecorder_ = 0;
+    writePending_ = false;
     RISCV_event_create(&event_tap_, "event_tap");
 }
 Greth::~Greth() {
@@ -77,6 +80,14 @@ void Greth::postinitService() {
         RISCV_error("CPUs not found", NULL);
     }
 
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_INPUT_RECORDER, &lstServ);
+    if (lstServ.size() != 0) {
+        IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        irecorder_ = static_cast<IInputRecorder *>(
+                            iserv->getInterface(IFACE_INPUT_RECORDER));
+    }
+
     // Get global settings:
     const AttributeType *glb = RISCV_get_global_settings();
     if ((*glb)["SimEnable"].to_bool()) {
@@ -89,7 +100,6 @@ void Greth::postinitService() {
 
 void Greth::busyLoop() {
     int bytes;
-    uint32_t *tbuf;
     UdpEdclCommonType req;
     RISCV_info("Ethernet thread was started", NULL);
     trans_.source_idx = CFG_NASTI_MASTER_ETHMAC;          // Hardcoded in VHDL value
@@ -111,32 +121,41 @@ void Greth::busyLoop() {
 
         trans_.addr = req.address;
         trans_.xsize = 4;
+        trans_.len = req.control.request.len & ~0x3u;
         if (req.control.request.write == 0) {
             trans_.action = MemAction_Read;
-            tbuf = reinterpret_cast<uint32_t *>(&txbuf_[10]);
+            trans_.payload = &txbuf_[10];
             bytes = sizeof(UdpEdclCommonType) + req.control.request.len;
         } else {
             trans_.action = MemAction_Write;
-            trans_.wstrb = (1 << trans_.xsize) - 1;
-            tbuf = reinterpret_cast<uint32_t *>(&rxbuf_[10]);
+            trans_.payload = &rxbuf_[10];
             bytes = sizeof(UdpEdclCommonType);
         }
-        for (unsigned i = 0; i < req.control.request.len / 4u; i++) {
-            if (trans_.action == MemAction_Write) {
-                trans_.wpayload.b32[0] = *tbuf;
+        trans_.response = MemResp_Valid;
+        if (trans_.len && isMemoryWrite()) {
+            // Logged with the frame sequence id to find the live write
+            AttributeType t1;
+            t1.make_list(3);
+            t1[0u].make_uint64(trans_.addr);
+            t1[1].make_data(trans_.len, trans_.payload);
+            t1[2].make_uint64(seq_cnt_);
+            RISCV_event_clear(&event_tap_);
+            writePending_ = true;
+            irecorder_->putInput(static_cast<IReplayInput *>(this), &t1);
+            if (RISCV_event_wait_ms(&event_tap_, 500) != 0) {
+                RISCV_error("CPU queue callback timeout", NULL);
             }
+        } else if (trans_.len) {
+            // Whole frame is one burst, slave splits it if needed
             RISCV_event_clear(&event_tap_);
-            ibus_->nb_transport(&trans_, this);
+            ibus_->nb_transport_burst(&trans_, this);
             if (RISCV_event_wait_ms(&event_tap_, 500) != 0) {
                 RISCV_error("CPU queue callback timeout", NULL);
-            } else if (trans_.action == MemAction_Read) {
-                *tbuf = trans_.rpayload.b32[0];
             }
-            tbuf++;
-            trans_.addr += 4;
         }
 
-        req.control.response.nak = 0;
+        // NAK with the request sequence id reports the access error
+        req.control.response.nak = trans_.response == MemResp_Error;
         req.control.response.seqidx = seq_cnt_;
         write32(&txbuf_[2], req.control.word);
 
@@ -145,10 +164,45 @@ void Greth::busyLoop() {
     }
 }
 
+/**
+ * Only writes into memory are logged for the reverse execution, device
+ * registers are accessed directly.
+ */
+bool Greth::isMemoryWrite() {
+    DmiRegionType dmi;
+    if (!irecorder_ || trans_.action != MemAction_Write
+        || !ibus_->get_direct_mem_ptr(trans_.addr, &dmi)
+        || !dmi.write_allowed) {
+        return false;
+    }
+    return trans_.addr + trans_.len <= dmi.addr + dmi.length;
+}
+
+/** Called from the CPU thread for the live and replayed writes */
+void Greth::replayInput(const AttributeType *data) {
+    Axi4BurstTransactionType trans;
+    trans.action = MemAction_Write;
+    trans.addr = (*data)[0u].to_uint64();
+    trans.xsize = 4;
+    trans.len = (*data)[1].size();
+    trans.payload = const_cast<uint8_t *>((*data)[1].data());
+    trans.source_idx = CFG_NASTI_MASTER_ETHMAC;
+    ibus_->b_transport_burst(&trans);
+    if (writePending_ && (*data)[2].to_uint64() == seq_cnt_) {
+        trans_.response = trans.response;
+        writePending_ = false;
+        RISCV_event_set(&event_tap_);
+    }
+}
+
 void Greth::nb_response(Axi4TransactionType *trans) {
     RISCV_event_set(&event_tap_);
 }
 
+void Greth::nb_response_burst(Axi4BurstTransactionType *trans) {
+    RISCV_event_set(&event_tap_);
+}
+
 void Greth::b_transport(Axi4TransactionType *trans) {
     RISCV_error("ETH Slave registers not implemented", NULL);
 }
@@ -17,6 +17,7 @@
 #include "coreservices/iudp.h"
 #include "coreservices/irawlistener.h"
 #include "coreservices/iwire.h"
+#include "coreservices/ireplay.h"
 
 namespace debugger {
 
@@ -60,7 +61,8 @@ struct UdpEdclCommonType {
 class Greth : public IService, 
               public IThread,
               public IMemoryOperation,
-              public IAxi4NbResponse {
+              public IAxi4NbResponse,
+              public IReplayInput {
 public:
     Greth(const char *name);
     virtual ~Greth();
@@ -80,6 +82,10 @@ public:
 
     /** IAxi4NbResponse */
     virtual void nb_response(Axi4TransactionType *trans);
+    virtual void nb_response_burst(Axi4BurstTransactionType *trans);
+
+    /** IReplayInput: logged write into memory */
+    virtual void replayInput(const AttributeType *data);
 
 protected:
     /** IThread interface */
@@ -89,6 +95,7 @@ private:
     void write32(uint8_t *buf, uint32_t v);
     uint32_t read32(uint8_t *buf);
     void sendNAK(UdpEdclCommonType *req);
+    bool isMemoryWrite();
 
 private:
     AttributeType baseAddress_;
@@ -104,13 +111,15 @@ private:
     IClock *iclk0_;
     IUdp *itransport_;
     IWire *iwire_;
+    IInputRecorder *irecorder_;
 
     uint8_t rxbuf_[1<<12];
     uint8_t txbuf_[1<<12];
     uint32_t seq_cnt_ : 14;
 
-    Axi4TransactionType trans_;
+    Axi4BurstTransactionType trans_;
     event_def event_tap_;
+    volatile bool writePending_;    // logged write wasn't applied yet
 
     greth_map regs_;
 };
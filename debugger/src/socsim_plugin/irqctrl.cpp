@@ -13,6 +13,7 @@ namespace debugger {
 IrqController::IrqController(const char *name)  : IService(name) {
     registerInterface(static_cast<IMemoryOperation *>(this));
     registerInterface(static_cast<IWire *>(this));
+    registerInterface(static_cast<ISnapshot *>(this));
     registerAttribute("BaseAddress", &baseAddress_);
     registerAttribute("Length", &length_);
     registerAttribute("CPU", &cpu_);
@@ -213,5 +214,22 @@ void IrqController::raiseLine(int idx) {
     }
 }
 
+void IrqController::saveState(AttributeType *state) {
+    state->make_dict();
+    (*state)["regs"].make_data(sizeof(regs_), &regs_);
+    (*state)["irq_wait_unlock"].make_uint64(irq_wait_unlock);
+}
+
+void IrqController::restoreState(const AttributeType *state) {
+    const AttributeType &regs = (*state)["regs"];
+    if (regs.size() != sizeof(regs_)) {
+        RISCV_error("Wrong registers size in snapshot", NULL);
+        return;
+    }
+    memcpy(&regs_, regs.data(), sizeof(regs_));
+    irq_wait_unlock = static_cast<uint32_t>(
+                        (*state)["irq_wait_unlock"].to_uint64());
+}
+
 }  // namespace debugger
 
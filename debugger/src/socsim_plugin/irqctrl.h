@@ -11,6 +11,7 @@
 #include "iclass.h"
 #include "iservice.h"
 #include "coreservices/imemop.h"
+#include "coreservices/isnapshot.h"
 #include "coreservices/iwire.h"
 #include "coreservices/icpuriscv.h"
 
@@ -18,7 +19,8 @@ namespace debugger {
 
 class IrqController : public IService, 
                       public IMemoryOperation,
-                      public IWire {
+                      public IWire,
+                      public ISnapshot {
 public:
     IrqController(const char *name);
     ~IrqController();
@@ -41,6 +43,10 @@ public:
     virtual void lowerLine() {}
     virtual void setLevel(bool level) {}
 
+    /** ISnapshot */
+    virtual void saveState(AttributeType *state);
+    virtual void restoreState(const AttributeType *state);
+
 private:
     AttributeType baseAddress_;
     AttributeType length_;
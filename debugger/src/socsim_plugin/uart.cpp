@@ -24,6 +24,8 @@ static const uint32_t UART_CONTROL_PARITY_ENA = 0x00008000;
 UART::UART(const char *name)  : IService(name) {
     registerInterface(static_cast<IMemoryOperation *>(this));
     registerInterface(static_cast<ISerial *>(this));
+    registerInterface(static_cast<ISnapshot *>(this));
+    registerInterface(static_cast<IReplayInput *>(this));
     registerAttribute("BaseAddress", &baseAddress_);
     registerAttribute("Length", &length_);
     registerAttribute("IrqLine", &irqLine_);
@@ -41,6 +43,7 @@ UART::UART(const char *name)  : IService(name) {
     p_rx_wr_ = rxfifo_;
     p_rx_rd_ = rxfifo_;
     rx_total_ = 0;
+    irecorder_ = 0;
 }
 
 UART::~UART() {
@@ -52,9 +55,36 @@ void UART::postinitService() {
     if (!iwire_) {
         RISCV_error("Can't find IWire interface %s", irqctrl_.to_string());
     }
+
+    AttributeType lstServ;
+    RISCV_get_services_with_iface(IFACE_INPUT_RECORDER, &lstServ);
+    if (lstServ.size() != 0) {
+        IService *iserv = static_cast<IService *>(lstServ[0u].to_iface());
+        irecorder_ = static_cast<IInputRecorder *>(
+                            iserv->getInterface(IFACE_INPUT_RECORDER));
+    }
 }
 
+/**
+ * Received data is logged for the reverse execution and put into FIFO by
+ * the CPU thread, so characters that don't fit into FIFO are lost later.
+ */
 int UART::writeData(const char *buf, int sz) {
+    if (!irecorder_) {
+        return receiveData(buf, sz);
+    }
+    AttributeType t1;
+    t1.make_data(sz, buf);
+    irecorder_->putInput(static_cast<IReplayInput *>(this), &t1);
+    return sz;
+}
+
+void UART::replayInput(const AttributeType *data) {
+    receiveData(reinterpret_cast<const char *>(data->data()),
+                static_cast<int>(data->size()));
+}
+
+int UART::receiveData(const char *buf, int sz) {
     if (sz > (RX_FIFO_SIZE - rx_total_)) {
         sz = (RX_FIFO_SIZE - rx_total_);
     }
@@ -159,5 +189,33 @@ void UART::b_transport(Axi4TransactionType *trans) {
     }
 }
 
+void UART::saveState(AttributeType *state) {
+    char rx[RX_FIFO_SIZE];
+    char *p = p_rx_rd_;
+    for (int i = 0; i < rx_total_; i++) {
+        rx[i] = *p;
+        if ((++p) >= (rxfifo_ + RX_FIFO_SIZE)) {
+            p = rxfifo_;
+        }
+    }
+    state->make_dict();
+    (*state)["regs"].make_data(sizeof(regs_), &regs_);
+    (*state)["rxfifo"].make_data(rx_total_, rx);
+}
+
+void UART::restoreState(const AttributeType *state) {
+    const AttributeType &regs = (*state)["regs"];
+    const AttributeType &rx = (*state)["rxfifo"];
+    if (regs.size() != sizeof(regs_) || rx.size() > RX_FIFO_SIZE) {
+        RISCV_error("Wrong registers size in snapshot", NULL);
+        return;
+    }
+    memcpy(&regs_, regs.data(), sizeof(regs_));
+    memcpy(rxfifo_, rx.data(), rx.size());
+    rx_total_ = static_cast<int>(rx.size());
+    p_rx_rd_ = rxfifo_;
+    p_rx_wr_ = rxfifo_ + (rx_total_ % RX_FIFO_SIZE);
+}
+
 }  // namespace debugger
 
@@ -11,16 +11,20 @@
 #include "iclass.h"
 #include "iservice.h"
 #include "coreservices/imemop.h"
+#include "coreservices/isnapshot.h"
 #include "coreservices/iserial.h"
 #include "coreservices/iwire.h"
 #include "coreservices/irawlistener.h"
+#include "coreservices/ireplay.h"
 #include <string>
 
 namespace debugger {
 
 class UART : public IService, 
              public IMemoryOperation,
-             public ISerial {
+             public ISerial,
+             public ISnapshot,
+             public IReplayInput {
 public:
     UART(const char *name);
     ~UART();
@@ -43,6 +47,16 @@ public:
     virtual void registerRawListener(IFace *listener);
     virtual void unregisterRawListener(IFace *listener);
 
+    /** ISnapshot */
+    virtual void saveState(AttributeType *state);
+    virtual void restoreState(const AttributeType *state);
+
+    /** IReplayInput */
+    virtual void replayInput(const AttributeType *data);
+
+private:
+    int receiveData(const char *buf, int sz);
+
 private:
     AttributeType baseAddress_;
     AttributeType length_;
@@ -50,6 +64,7 @@ private:
     AttributeType irqctrl_;
     AttributeType listeners_;  // non-registering attribute
     IWire *iwire_;
+    IInputRecorder *irecorder_;
 
     std::string input_;
     static const int RX_FIFO_SIZE = 16;
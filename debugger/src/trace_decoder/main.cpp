@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @copyright  Copyright 2017 GNSS Sensor Ltd. All right reserved.
+ * @author     Sergey Khabarov - sergeykhbr@gmail.com
+ * @brief      Convert binary execution trace into the text format.
+ *
+ * @details    Output is the same as the text trace files generated earlier
+ *             by functional and SystemC models, so they can be compared
+ *             with 'diff' utility:
+ *                 trace_decoder river_func_regs.bin river_func_regs.log
+ */
+
+#include <stdio.h>
+#include "api_types.h"
+#include "riscv-isa.h"
+#include "bintrace.h"
+
+using namespace debugger;
+
+int main(int argc, char* argv[]) {
+    BinTraceReader reader;
+    BinTraceRecordType rec;
+    FILE *out = stdout;
+
+    if (argc < 2) {
+        printf("Usage: trace_decoder <input.bin> [output.log]\n");
+        return 1;
+    }
+    if (!reader.open(argv[1])) {
+        printf("Can't open trace file '%s'\n", argv[1]);
+        return 1;
+    }
+    if (argc > 2) {
+        out = fopen(argv[2], "w");
+        if (!out) {
+            printf("Can't create file '%s'\n", argv[2]);
+            return 1;
+        }
+    }
+
+    while (reader.next(&rec)) {
+        switch (rec.type) {
+        case BinTrace_Regs:
+            fprintf(out, "%8" RV_PRI64 "d [%08x] %08x: ",
+                    rec.step, static_cast<uint32_t>(rec.pc), rec.instr);
+            if (rec.mask == 0) {
+                fprintf(out, "-\n");
+            }
+            for (int i = 0; i < 32; i++) {
+                if ((rec.mask >> i) & 0x1) {
+                    fprintf(out, "%3s <= %016" RV_PRI64 "x\n",
+                            IREGS_NAMES[i], rec.regs[i]);
+                }
+            }
+            break;
+        case BinTrace_MemRead:
+        case BinTrace_MemWrite:
+            fprintf(out, "%08x: [%08x] %s %016" RV_PRI64 "x\n",
+                    static_cast<uint32_t>(rec.pc),
+                    static_cast<uint32_t>(rec.addr),
+                    rec.type == BinTrace_MemWrite ? "<=" : "=>", rec.value);
+            break;
+        default:;
+        }
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
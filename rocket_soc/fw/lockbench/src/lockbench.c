@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * @file
+ * @author   Sergey Khabarov
+ * @brief    Spinlock contention benchmark.
+ * @details  All harts increment shared counters in three phases: under the
+ *           AMOSWAP spinlock, under the LR/SC spinlock and by lock-free
+ *           AMOADD. Hart 0 prints duration of each phase in clock cycles and
+ *           checks that no increment was lost.
+ ****************************************************************************/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include "axi_maps.h"
+#include "maps/map_gptimers.h"
+
+#ifndef LOCKBENCH_HARTS
+#define LOCKBENCH_HARTS 2
+#endif
+
+#define ITERATIONS 100000
+
+static const uint32_t START_MAGIC = 0xcafef00d;
+
+extern char _end;
+
+volatile uint32_t start_flag;
+volatile uint32_t barrier_cnt;
+volatile uint32_t amo_lock;
+volatile uint32_t lrsc_lock;
+volatile uint64_t amo_counter;
+volatile uint64_t lrsc_counter;
+volatile uint64_t fetch_add_counter;
+
+/**
+ * @name sbrk
+ * @brief Increase program data space.
+ * @details Malloc and related functions depend on this.
+ */
+char *sbrk(int incr) {
+    return &_end;
+}
+
+void print_uart(const char *buf, int sz) {
+    uart_map *uart = (uart_map *)ADDR_NASTI_SLAVE_UART1;
+    for (int i = 0; i < sz; i++) {
+        while (uart->status & UART_STATUS_TX_FULL) {}
+        uart->data = buf[i];
+    }
+}
+
+static uint64_t get_clock() {
+    return ((gptimers_map *)ADDR_NASTI_SLAVE_GPTIMERS)->highcnt;
+}
+
+/** Wait until all harts reach barrier with the specified index */
+static void barrier(uint32_t idx) {
+    __atomic_fetch_add(&barrier_cnt, 1, __ATOMIC_ACQ_REL);
+    while (barrier_cnt < idx * LOCKBENCH_HARTS) {}
+}
+
+static void amo_lock_acquire(volatile uint32_t *lock) {
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        while (*lock) {}
+    }
+}
+
+static void lrsc_lock_acquire(volatile uint32_t *lock) {
+    uint32_t busy, fail;
+    asm volatile (
+        "1: lr.w.aq %0, (%2)\n"
+        "   bnez %0, 1b\n"
+        "   sc.w %1, %3, (%2)\n"
+        "   bnez %1, 1b\n"
+        : "=&r"(busy), "=&r"(fail)
+        : "r"(lock), "r"(1)
+        : "memory");
+}
+
+static void lock_release(volatile uint32_t *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static void report(const char *name, uint64_t clocks, uint64_t value) {
+    char ss[128];
+    int ss_len;
+    uint64_t expected = (uint64_t)ITERATIONS * LOCKBENCH_HARTS;
+    ss_len = sprintf(ss, "%-10s %10ld clocks, counter %ld %s\n",
+                     name, (long)clocks, (long)value,
+                     value == expected ? "OK" : "FAILED");
+    print_uart(ss, ss_len);
+}
+
+void lockbench(uint64_t hartid) {
+    uint64_t t[4];
+
+    if (hartid == 0) {
+        barrier_cnt = 0;
+        amo_lock = 0;
+        lrsc_lock = 0;
+        amo_counter = 0;
+        lrsc_counter = 0;
+        fetch_add_counter = 0;
+        __atomic_store_n(&start_flag, START_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        while (start_flag != START_MAGIC) {}
+    }
+
+    barrier(1);
+    t[0] = get_clock();
+    for (int i = 0; i < ITERATIONS; i++) {
+        amo_lock_acquire(&amo_lock);
+        amo_counter++;
+        lock_release(&amo_lock);
+    }
+
+    barrier(2);
+    t[1] = get_clock();
+    for (int i = 0; i < ITERATIONS; i++) {
+        lrsc_lock_acquire(&lrsc_lock);
+        lrsc_counter++;
+        lock_release(&lrsc_lock);
+    }
+
+    barrier(3);
+    t[2] = get_clock();
+    for (int i = 0; i < ITERATIONS; i++) {
+        __atomic_fetch_add(&fetch_add_counter, 1, __ATOMIC_RELAXED);
+    }
+
+    barrier(4);
+    t[3] = get_clock();
+    if (hartid != 0) {
+        return;
+    }
+    report("amoswap", t[1] - t[0], amo_counter);
+    report("lr/sc", t[2] - t[1], lrsc_counter);
+    report("amoadd", t[3] - t[2], fetch_add_counter);
+}